@@ -102,6 +102,11 @@ VideoFrame* decodeGetOutput(DecodeHandler p)
     return NULL;
 }
 
+const VideoSeiInfo* decodeGetSei(DecodeHandler p, const VideoFrame* frame)
+{
+    return (p ? ((IVideoDecoder*)p)->getSei(frame) : NULL);
+}
+
 const VideoFormatInfo* decodeGetFormatInfo(DecodeHandler p)
 {
     return (p ? ((IVideoDecoder*)p)->getFormatInfo() : NULL);
@@ -42,6 +42,9 @@ YamiStatus decodeDecode(DecodeHandler p, VideoDecodeBuffer* buffer);
 
 VideoFrame* decodeGetOutput(DecodeHandler p);
 
+/* sei messages of a frame from decodeGetOutput, valid until it is freed */
+const VideoSeiInfo* decodeGetSei(DecodeHandler p, const VideoFrame* frame);
+
 const VideoFormatInfo* decodeGetFormatInfo(DecodeHandler p);
 
 void releaseDecoder(DecodeHandler p);
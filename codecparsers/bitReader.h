@@ -17,23 +17,74 @@
 #ifndef bitReader_h
 #define bitReader_h
 
+#include <assert.h>
 #include <stdint.h>
 #include <algorithm> /*std::min*/
 
+#define LOAD8BYTESDATA_BE(x) \
+    (((uint64_t)((const uint8_t*)(x))[0] << 56) | \
+     ((uint64_t)((const uint8_t*)(x))[1] << 48) | \
+     ((uint64_t)((const uint8_t*)(x))[2] << 40) | \
+     ((uint64_t)((const uint8_t*)(x))[3] << 32) | \
+     ((uint64_t)((const uint8_t*)(x))[4] << 24) | \
+     ((uint64_t)((const uint8_t*)(x))[5] << 16) | \
+     ((uint64_t)((const uint8_t*)(x))[6] <<  8) | \
+     ((uint64_t)((const uint8_t*)(x))[7]))
+
 namespace YamiParser {
 
-class BitReader {
+/* A refill policy tells BitReaderT how to move source bytes to the cache.
+ * It has two static functions:
+ *   uint32_t load(const uint8_t* stream, const uint8_t* p, uint32_t nbytes,
+ *                 unsigned long int& cache);
+ *       load nbytes from p to cache, return how many of them are kept
+ *   bool skip(const uint8_t* stream, uint32_t size, uint32_t& offset,
+ *             uint32_t nbytes, uint32_t& dropped);
+ *       move offset over nbytes kept bytes, add the dropped ones to dropped,
+ *       return false if there is not enough data.
+ * Everything is static, so calls from the reader are inlined.
+ */
+
+/* use the bytes as they are */
+struct RawBytePolicy {
+    static inline uint32_t load(const uint8_t*, const uint8_t* p,
+        uint32_t nbytes, unsigned long int& cache)
+    {
+        unsigned long int tmp = 0;
+        if (nbytes == 8)
+            tmp = LOAD8BYTESDATA_BE(p);
+        else {
+            for (uint32_t i = 0; i < nbytes; i++) {
+                tmp <<= 8;
+                tmp |= p[i];
+            }
+        }
+        cache = tmp;
+        return nbytes;
+    }
+
+    static inline bool skip(const uint8_t*, uint32_t size, uint32_t& offset,
+        uint32_t nbytes, uint32_t&)
+    {
+        if (size - offset < nbytes)
+            return false;
+        offset += nbytes;
+        return true;
+    }
+};
+
+template <class RefillPolicy>
+class BitReaderT {
 public:
     static const uint32_t CACHEBYTES;
-    BitReader(const uint8_t* data, uint32_t size);
-    virtual ~BitReader() {}
+    BitReaderT(const uint8_t* data, uint32_t size);
 
     /* Read specified bits(<= 8*sizeof(uint32_t)) as a uint32_t to v */
     /* if not enough data, it will return false, eat all data and keep v untouched */
-    bool read(uint32_t& v, uint32_t nbits);
+    inline bool read(uint32_t& v, uint32_t nbits);
     /* Read specified bits(<= 8*sizeof(uint32_t)) as a uint32_t return value */
     /* will return 0 if not enough data*/
-    uint32_t read(uint32_t nbits);
+    inline uint32_t read(uint32_t nbits);
 
     /*TODO: change to this to read, and change read to readBits */
     template <class T>
@@ -45,12 +96,13 @@ public:
     inline bool readT(bool& v);
 
     /*read the next nbits bits from the bitstream but not advance the bitstream pointer*/
-    uint32_t peek(uint32_t nbits) const;
+    inline uint32_t peek(uint32_t nbits) const;
 
     /* this version will check read beyond boundary */
     template <class T>
-    bool peek(T& v, uint32_t nbits) const;
+    inline bool peek(T& v, uint32_t nbits) const;
 
+    /* whole bytes are skipped without loading them to cache */
     bool skip(uint32_t nbits);
 
     /* Get the total bits that had been read from bitstream, and the return
@@ -71,20 +123,94 @@ public:
     }
 
 protected:
-    virtual void loadDataToCache(uint32_t nbytes);
+    /* load next CACHEBYTES(or the remaining) bytes to cache */
+    inline void reload();
 
     const uint8_t* m_stream; /*a pointer to source data*/
     uint32_t m_size; /*the size of source data in bytes*/
     unsigned long int m_cache; /*the buffer which load less than or equal to 8 bytes*/
     uint32_t m_loadBytes; /*the total bytes of data read from source data*/
     uint32_t m_bitsInCache; /*the remaining bits in cache*/
+    uint32_t m_droppedBytes; /*the loaded bytes dropped by RefillPolicy*/
 private:
     inline uint32_t extractBitsFromCache(uint32_t nbits);
-    inline void reload();
+    inline bool peekBits(uint32_t& v, uint32_t nbits) const;
 };
 
+typedef BitReaderT<RawBytePolicy> BitReader;
+
+template <class RefillPolicy>
+const uint32_t BitReaderT<RefillPolicy>::CACHEBYTES = sizeof(unsigned long int);
+
+template <class RefillPolicy>
+BitReaderT<RefillPolicy>::BitReaderT(const uint8_t* pdata, uint32_t size)
+    : m_stream(pdata)
+    , m_size(size)
+    , m_cache(0)
+    , m_loadBytes(0)
+    , m_bitsInCache(0)
+    , m_droppedBytes(0)
+{
+    assert(pdata && size);
+}
+
+template <class RefillPolicy>
+void BitReaderT<RefillPolicy>::reload()
+{
+    assert(m_size >= m_loadBytes);
+    uint32_t remainingBytes = m_size - m_loadBytes;
+    if (remainingBytes > 0) {
+        uint32_t nbytes = std::min(remainingBytes, CACHEBYTES);
+        uint32_t kept = RefillPolicy::load(m_stream, m_stream + m_loadBytes, nbytes, m_cache);
+        m_loadBytes += nbytes;
+        m_bitsInCache = kept << 3;
+        m_droppedBytes += nbytes - kept;
+    }
+}
+
+template <class RefillPolicy>
+uint32_t BitReaderT<RefillPolicy>::extractBitsFromCache(uint32_t nbits)
+{
+    if (!nbits)
+        return 0;
+    uint32_t tmp = 0;
+    tmp = m_cache << ((CACHEBYTES << 3) - m_bitsInCache) >> ((CACHEBYTES << 3) - nbits);
+    m_bitsInCache -= nbits;
+    return tmp;
+}
+
+template <class RefillPolicy>
+bool BitReaderT<RefillPolicy>::read(uint32_t& v, uint32_t nbits)
+{
+    assert(nbits <= (CACHEBYTES << 3));
+
+    if (nbits <= m_bitsInCache) {
+        v = extractBitsFromCache(nbits);
+        return true;
+    }
+    /*not enough bits, need to save remaining bits
+      in current cache and then reload more bits*/
+    uint32_t toBeReadBits = nbits - m_bitsInCache;
+    uint32_t tmp = extractBitsFromCache(m_bitsInCache);
+    reload();
+    if (toBeReadBits > m_bitsInCache)
+        return false;
+    v = static_cast<uint64_t>(tmp) << toBeReadBits | extractBitsFromCache(toBeReadBits);
+    return true;
+}
+
+template <class RefillPolicy>
+uint32_t BitReaderT<RefillPolicy>::read(uint32_t nbits)
+{
+    uint32_t res;
+    if (read(res, nbits))
+        return res;
+    return 0;
+}
+
+template <class RefillPolicy>
 template <class T>
-bool BitReader::readT(T& v, uint32_t nbits)
+bool BitReaderT<RefillPolicy>::readT(T& v, uint32_t nbits)
 {
     uint32_t tmp;
     if (!read(tmp, nbits))
@@ -93,22 +219,89 @@ bool BitReader::readT(T& v, uint32_t nbits)
     return true;
 }
 
+template <class RefillPolicy>
 template <class T>
-bool BitReader::readT(T& v)
+bool BitReaderT<RefillPolicy>::readT(T& v)
 {
     return readT(v, sizeof(v) << 3);
 }
 
-bool BitReader::readT(bool& v)
+template <class RefillPolicy>
+bool BitReaderT<RefillPolicy>::readT(bool& v)
 {
     return readT(v, 1);
 }
 
+/* same as read, but the bits after the cache go to a local copy */
+template <class RefillPolicy>
+bool BitReaderT<RefillPolicy>::peekBits(uint32_t& v, uint32_t nbits) const
+{
+    const uint32_t cacheBits = CACHEBYTES << 3;
+    assert(nbits <= cacheBits);
+
+    if (!nbits) {
+        v = 0;
+        return true;
+    }
+    if (nbits <= m_bitsInCache) {
+        v = m_cache << (cacheBits - m_bitsInCache) >> (cacheBits - nbits);
+        return true;
+    }
+
+    uint32_t toBeReadBits = nbits - m_bitsInCache;
+    uint32_t tmp = 0;
+    if (m_bitsInCache)
+        tmp = m_cache << (cacheBits - m_bitsInCache) >> (cacheBits - m_bitsInCache);
+
+    uint32_t remainingBytes = m_size - m_loadBytes;
+    if (!remainingBytes)
+        return false;
+    unsigned long int next;
+    uint32_t nbytes = std::min(remainingBytes, CACHEBYTES);
+    uint32_t bits = RefillPolicy::load(m_stream, m_stream + m_loadBytes, nbytes, next) << 3;
+    if (toBeReadBits > bits)
+        return false;
+    v = static_cast<uint64_t>(tmp) << toBeReadBits
+        | (next << (cacheBits - bits) >> (cacheBits - toBeReadBits));
+    return true;
+}
+
+template <class RefillPolicy>
+uint32_t BitReaderT<RefillPolicy>::peek(uint32_t nbits) const
+{
+    uint32_t v;
+    if (peekBits(v, nbits))
+        return v;
+    return 0;
+}
+
+template <class RefillPolicy>
 template <class T>
-bool BitReader::peek(T& v, uint32_t nbits) const
+bool BitReaderT<RefillPolicy>::peek(T& v, uint32_t nbits) const
 {
-    BitReader tmp(*this);
-    return tmp.readT(v, nbits);
+    uint32_t tmp;
+    if (!peekBits(tmp, nbits))
+        return false;
+    v = tmp;
+    return true;
+}
+
+template <class RefillPolicy>
+bool BitReaderT<RefillPolicy>::skip(uint32_t nbits)
+{
+    if (nbits <= m_bitsInCache) {
+        m_bitsInCache -= nbits;
+        return true;
+    }
+    nbits -= m_bitsInCache;
+    m_bitsInCache = 0;
+
+    if (!RefillPolicy::skip(m_stream, m_size, m_loadBytes, nbits >> 3, m_droppedBytes)) {
+        m_loadBytes = m_size;
+        return false;
+    }
+    uint32_t tmp;
+    return read(tmp, nbits & 7);
 }
 
 } /*namespace YamiParser*/
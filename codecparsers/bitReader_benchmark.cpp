@@ -0,0 +1,239 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "bitReader.h"
+
+// library headers
+#include "nalReader.h"
+
+// system libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+using namespace YamiParser;
+
+namespace {
+
+/* The virtual reader we had before BitReaderT, kept here as reference.
+ * peek() copies the reader and skip() reads 32 bits a time. Like before,
+ * the copy in peek() is sliced, so nal peeks load raw bytes. */
+class LegacyBitReader {
+public:
+    static const uint32_t CACHEBYTES = sizeof(unsigned long int);
+    LegacyBitReader(const uint8_t* data, uint32_t size)
+        : m_stream(data)
+        , m_size(size)
+        , m_cache(0)
+        , m_loadBytes(0)
+        , m_bitsInCache(0)
+    {
+    }
+    virtual ~LegacyBitReader() {}
+
+    bool read(uint32_t& v, uint32_t nbits)
+    {
+        if (nbits <= m_bitsInCache) {
+            v = extractBitsFromCache(nbits);
+            return true;
+        }
+        uint32_t toBeReadBits = nbits - m_bitsInCache;
+        uint32_t tmp = extractBitsFromCache(m_bitsInCache);
+        reload();
+        if (toBeReadBits > m_bitsInCache)
+            return false;
+        v = tmp << toBeReadBits | extractBitsFromCache(toBeReadBits);
+        return true;
+    }
+
+    uint32_t read(uint32_t nbits)
+    {
+        uint32_t res;
+        if (read(res, nbits))
+            return res;
+        return 0;
+    }
+
+    uint32_t peek(uint32_t nbits) const
+    {
+        LegacyBitReader tmp(*this);
+        return tmp.read(nbits);
+    }
+
+    bool skip(uint32_t nbits)
+    {
+        uint32_t tmp;
+        while (nbits > 32) {
+            if (!read(tmp, 32))
+                return false;
+            nbits -= 32;
+        }
+        return read(tmp, nbits);
+    }
+
+    bool end() const
+    {
+        return ((uint64_t)m_loadBytes << 3) - m_bitsInCache >= ((uint64_t)m_size << 3);
+    }
+
+protected:
+    virtual void loadDataToCache(uint32_t nbytes)
+    {
+        RawBytePolicy::load(m_stream, m_stream + m_loadBytes, nbytes, m_cache);
+        m_loadBytes += nbytes;
+        m_bitsInCache = nbytes << 3;
+    }
+
+    const uint8_t* m_stream;
+    uint32_t m_size;
+    unsigned long int m_cache;
+    uint32_t m_loadBytes;
+    uint32_t m_bitsInCache;
+
+private:
+    uint32_t extractBitsFromCache(uint32_t nbits)
+    {
+        if (!nbits)
+            return 0;
+        uint32_t tmp = m_cache << ((CACHEBYTES << 3) - m_bitsInCache) >> ((CACHEBYTES << 3) - nbits);
+        m_bitsInCache -= nbits;
+        return tmp;
+    }
+    void reload()
+    {
+        uint32_t remainingBytes = m_size - m_loadBytes;
+        if (remainingBytes > 0)
+            loadDataToCache(std::min(remainingBytes, CACHEBYTES));
+    }
+};
+
+class LegacyNalReader : public LegacyBitReader {
+public:
+    LegacyNalReader(const uint8_t* data, uint32_t size)
+        : LegacyBitReader(data, size)
+    {
+    }
+
+protected:
+    virtual void loadDataToCache(uint32_t nbytes)
+    {
+        uint32_t kept = EpbStrippingPolicy::load(m_stream, m_stream + m_loadBytes, nbytes, m_cache);
+        m_loadBytes += nbytes;
+        m_bitsInCache = kept << 3;
+    }
+};
+
+uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* widths like a header parser reads them: mostly flags and small fields */
+const uint32_t WIDTHS[] = { 1, 1, 1, 2, 3, 4, 1, 8, 1, 5, 16, 1, 2, 32, 1, 7 };
+const uint32_t NUM_WIDTHS = sizeof(WIDTHS) / sizeof(WIDTHS[0]);
+
+template <class Reader>
+uint32_t readLoop(const std::vector<uint8_t>& data)
+{
+    Reader reader(&data[0], data.size());
+    uint32_t sum = 0;
+    for (uint32_t i = 0; !reader.end(); i++)
+        sum += reader.read(WIDTHS[i % NUM_WIDTHS]);
+    return sum;
+}
+
+/* vc1 and jpeg peek before they read */
+template <class Reader>
+uint32_t peekLoop(const std::vector<uint8_t>& data)
+{
+    Reader reader(&data[0], data.size());
+    uint32_t sum = 0;
+    for (uint32_t i = 0; !reader.end(); i++) {
+        uint32_t nbits = WIDTHS[i % NUM_WIDTHS];
+        sum += reader.peek(nbits);
+        sum += reader.read(nbits);
+    }
+    return sum;
+}
+
+template <class Reader>
+uint32_t skipLoop(const std::vector<uint8_t>& data)
+{
+    Reader reader(&data[0], data.size());
+    uint32_t sum = 0;
+    while (reader.skip(1021))
+        sum += reader.read(3);
+    return sum;
+}
+
+typedef uint32_t (*Loop)(const std::vector<uint8_t>& data);
+
+double measure(Loop loop, const std::vector<uint8_t>& data, uint32_t loops)
+{
+    uint32_t sum = 0;
+    uint64_t start = nowNs();
+    for (uint32_t i = 0; i < loops; i++)
+        sum += loop(data);
+    uint64_t ns = nowNs() - start;
+    /*keep the loop from being optimized out*/
+    if (sum == 0x12345678)
+        printf(" ");
+    return (double)data.size() * loops * 1000 / ns;
+}
+
+void report(const char* name, Loop legacy, Loop current,
+    const std::vector<uint8_t>& data, uint32_t loops)
+{
+    double oldSpeed = measure(legacy, data, loops);
+    double newSpeed = measure(current, data, loops);
+    printf("%-16s %12.1f %12.1f %8.2fx\n", name, oldSpeed, newSpeed, newSpeed / oldSpeed);
+}
+
+} // namespace
+
+int main()
+{
+    const uint32_t size = 1 << 20;
+    const uint32_t loops = 64;
+    std::vector<uint8_t> data(size);
+    std::vector<uint8_t> nal(size);
+
+    srand(0);
+    for (uint32_t i = 0; i < size; i++) {
+        data[i] = rand() % 256;
+        /*some emulation prevention bytes for the nal readers*/
+        nal[i] = (rand() % 64) ? data[i] : 0;
+        if (i >= 2 && !nal[i - 1] && !nal[i - 2])
+            nal[i] = 3;
+    }
+
+    printf("%-16s %12s %12s %9s\n", "case", "old MB/s", "new MB/s", "speedup");
+    report("read", readLoop<LegacyBitReader>, readLoop<BitReader>, data, loops);
+    report("peek+read", peekLoop<LegacyBitReader>, peekLoop<BitReader>, data, loops);
+    report("skip", skipLoop<LegacyBitReader>, skipLoop<BitReader>, data, loops);
+    report("nal read", readLoop<LegacyNalReader>, readLoop<NalReader>, nal, loops);
+    report("nal peek+read", peekLoop<LegacyNalReader>, peekLoop<NalReader>, nal, loops);
+    report("nal skip", skipLoop<LegacyNalReader>, skipLoop<NalReader>, nal, loops);
+    return 0;
+}
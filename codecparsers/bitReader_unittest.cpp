@@ -26,6 +26,7 @@
 
 // system libraries
 #include <limits>
+#include <stdlib.h>
 #include <vector>
 
 namespace YamiParser {
@@ -73,4 +74,41 @@ BITREADER_TEST(NoOverflow)
     EXPECT_EQ(0u, reader.getRemainingBitsCount());
 }
 
+BITREADER_TEST(PeekAndSkip)
+{
+    std::vector<uint8_t> data(1000);
+
+    srand(0xabcd);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = rand() % 256;
+    for (int round = 0; round < 100; round++) {
+        BitReader reader(&data[0], data.size());
+        BitReader ref(&data[0], data.size());
+        while (!ref.end()) {
+            uint32_t nbits = rand() % 33;
+            uint32_t v, peeked, refV;
+            if (rand() % 4) {
+                bool ok = reader.peek(peeked, nbits);
+                ASSERT_EQ(ok, ref.read(refV, nbits));
+                if (!ok)
+                    break;
+                ASSERT_EQ(refV, peeked);
+                ASSERT_EQ(refV, reader.peek(nbits));
+                ASSERT_TRUE(reader.read(v, nbits));
+                ASSERT_EQ(refV, v);
+            } else {
+                /*large skips go over whole bytes*/
+                nbits = rand() % 300;
+                bool ok = true;
+                for (uint32_t n = nbits; n && ok; n -= std::min(n, 32u))
+                    ok = ref.read(refV, std::min(n, 32u));
+                ASSERT_EQ(ok, reader.skip(nbits));
+                if (!ok)
+                    break;
+            }
+            ASSERT_EQ(ref.getPos(), reader.getPos());
+        }
+    }
+}
+
 } // namespace YamiParser
@@ -21,34 +21,110 @@
 #include "bitWriter.h"
 #include "common/log.h"
 #include <assert.h>
+#include <algorithm>
 
 namespace YamiParser {
 
-const uint32_t CACHEBYTES = sizeof(unsigned long int);
-const uint32_t CACHEBITS = sizeof(unsigned long int) * 8;
+const uint32_t CACHEBITS = sizeof(uint64_t) * 8;
 
-// clip to keep lowest n bits
-#define CLIPBITS(value, n) ((value) & ((1 << (n)) - 1));
+/* the bytes need emulation prevention are 0x00, 0x01, 0x02 and 0x03,
+   a word without zero byte is safe unless it starts with them */
+static inline bool hasZeroByte(uint64_t v)
+{
+    return (v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL;
+}
 
 BitWriter::BitWriter(uint32_t size)
     : m_cache(0)
     , m_bitsInCache(0)
+    , m_buffer(NULL)
+    , m_capacity(0)
+    , m_bytes(0)
+    , m_external(false)
+    , m_overflow(false)
+    , m_emulationPrevention(false)
+    , m_zeroBytes(0)
 {
     m_bs.reserve(size);
 }
 
+BitWriter::BitWriter(uint8_t* buffer, uint32_t size)
+    : m_cache(0)
+    , m_bitsInCache(0)
+    , m_buffer(buffer)
+    , m_capacity(buffer ? size : 0)
+    , m_bytes(0)
+    , m_external(true)
+    , m_overflow(false)
+    , m_emulationPrevention(false)
+    , m_zeroBytes(0)
+{
+}
+
 uint8_t* BitWriter::getBitWriterData()
 {
-    uint8_t* buf;
     flushCache();
 
-    buf = m_bs.size() ? static_cast<uint8_t*>(&m_bs[0]) : NULL;
-    return buf;
+    if (m_overflow || !m_bytes)
+        return NULL;
+    return m_buffer;
+}
+
+bool BitWriter::reserve(uint32_t numBytes)
+{
+    if (m_bytes + numBytes <= m_capacity)
+        return true;
+    if (m_external) {
+        if (!m_overflow)
+            ERROR("Write Bits Error: buffer overflow");
+        m_overflow = true;
+        return false;
+    }
+    /* grow to the reserved capacity first, then double it */
+    m_bs.resize(std::max<size_t>(m_bs.capacity(), m_bytes + numBytes));
+    m_buffer = &m_bs[0];
+    m_capacity = m_bs.size();
+    return true;
+}
+
+void BitWriter::putByte(uint8_t byte)
+{
+    if (m_emulationPrevention) {
+        if (m_zeroBytes >= 2 && byte <= 3) {
+            if (reserve(1))
+                m_buffer[m_bytes++] = 0x03;
+            m_zeroBytes = 0;
+        }
+        m_zeroBytes = byte ? 0 : m_zeroBytes + 1;
+    }
+    if (reserve(1))
+        m_buffer[m_bytes++] = byte;
+}
+
+/* the cache is full, store it as a whole word if we can */
+void BitWriter::flushWord()
+{
+    assert(m_bitsInCache == CACHEBITS);
+
+    if (!m_emulationPrevention
+        || (!hasZeroByte(m_cache) && !(m_zeroBytes >= 2 && (m_cache >> 56) <= 3))) {
+        if (reserve(sizeof(m_cache))) {
+            for (uint32_t i = 0; i < sizeof(m_cache); i++)
+                m_buffer[m_bytes + i] = static_cast<uint8_t>(m_cache >> (CACHEBITS - (i + 1) * 8));
+            m_bytes += sizeof(m_cache);
+        }
+        m_zeroBytes = 0;
+    } else {
+        for (uint32_t i = 0; i < sizeof(m_cache); i++)
+            putByte(static_cast<uint8_t>(m_cache >> (CACHEBITS - (i + 1) * 8)));
+    }
+    m_cache = 0;
+    m_bitsInCache = 0;
 }
 
 void BitWriter::flushCache()
 {
-    uint8_t tmp, i, bytesInCache;
+    uint32_t i, bytesInCache;
 
     // make sure m_bitsInCache is byte aligned, else trailing bits should be
     // padded
@@ -59,23 +135,17 @@ void BitWriter::flushCache()
 
     bytesInCache = m_bitsInCache / 8;
 
-    for (i = 0; i < bytesInCache; i++) {
-        tmp = static_cast<uint8_t>(m_cache >> (m_bitsInCache - (i + 1) * 8));
-        m_bs.push_back(tmp);
-    }
+    for (i = 0; i < bytesInCache; i++)
+        putByte(static_cast<uint8_t>(m_cache >> (m_bitsInCache - (i + 1) * 8)));
 
     m_cache = 0;
     m_bitsInCache = 0;
 }
 
-bool BitWriter::writeBits(uint32_t value, uint32_t numBits)
+/* numBits must be less than CACHEBITS, value must fit in numBits */
+void BitWriter::putBits(uint64_t value, uint32_t numBits)
 {
-    if (value >= (uint64_t)1 << numBits) {
-        ERROR("Write Bits Error: value overflow");
-        return false;
-    }
-
-    ASSERT((m_bitsInCache <= CACHEBITS) && (numBits <= CACHEBITS));
+    assert(m_bitsInCache < CACHEBITS && numBits < CACHEBITS);
 
     uint32_t bitLeft = CACHEBITS - m_bitsInCache;
 
@@ -83,14 +153,49 @@ bool BitWriter::writeBits(uint32_t value, uint32_t numBits)
         m_cache = (m_cache << numBits | value);
         m_bitsInCache += numBits;
     } else {
-        m_cache = ((m_cache << bitLeft) | (value >> (numBits - bitLeft)));
+        uint32_t remaining = numBits - bitLeft;
+        m_cache = ((m_cache << bitLeft) | (value >> remaining));
         m_bitsInCache = CACHEBITS;
-        flushCache();
-        m_cache = value;
-        m_bitsInCache = numBits - bitLeft;
+        flushWord();
+        m_cache = value & ((1ULL << remaining) - 1);
+        m_bitsInCache = remaining;
     }
+}
 
-    return true;
+bool BitWriter::writeBits(uint32_t value, uint32_t numBits)
+{
+    if (numBits > 32 || value >= (uint64_t)1 << numBits) {
+        ERROR("Write Bits Error: value overflow");
+        return false;
+    }
+
+    putBits(value, numBits);
+    return !m_overflow;
+}
+
+bool BitWriter::writeUe(uint32_t value)
+{
+    /* codeNum + 1 has numBits bits, it goes after numBits - 1 zeros */
+    uint64_t code = static_cast<uint64_t>(value) + 1;
+    if (code > 0xffffffff) {
+        ERROR("Write Bits Error: ue(v) overflow");
+        return false;
+    }
+    uint32_t numBits = 32 - __builtin_clz(static_cast<uint32_t>(code));
+    putBits(code, 2 * numBits - 1);
+    return !m_overflow;
+}
+
+bool BitWriter::writeSe(int32_t value)
+{
+    /* 1, -1, 2, -2 ... map to 1, 2, 3, 4 ... */
+    uint64_t codeNum = value > 0 ? (static_cast<uint64_t>(value) << 1) - 1
+                                 : static_cast<uint64_t>(-static_cast<int64_t>(value)) << 1;
+    if (codeNum > 0xffffffff) {
+        ERROR("Write Bits Error: se(v) overflow");
+        return false;
+    }
+    return writeUe(static_cast<uint32_t>(codeNum));
 }
 
 bool BitWriter::writeBytes(uint8_t* data, uint32_t numBytes)
@@ -98,15 +203,18 @@ bool BitWriter::writeBytes(uint8_t* data, uint32_t numBytes)
     if (!data || !numBytes)
         return false;
 
-    if ((m_bitsInCache % 8) == 0) {
+    if ((m_bitsInCache % 8) == 0 && !m_emulationPrevention) {
         flushCache();
-        m_bs.insert(m_bs.end(), data, data + numBytes);
+        if (!reserve(numBytes))
+            return false;
+        std::copy(data, data + numBytes, m_buffer + m_bytes);
+        m_bytes += numBytes;
     } else {
         for (uint32_t i = 0; i < numBytes; i++)
-            writeBits(data[i], 8);
+            putBits(data[i], 8);
     }
 
-    return true;
+    return !m_overflow;
 }
 
 void BitWriter::writeToBytesAligned(bool bit)
@@ -122,4 +230,12 @@ void BitWriter::writeToBytesAligned(bool bit)
     }
 }
 
+void BitWriter::enableEmulationPrevention(bool enable)
+{
+    assert(!(m_bitsInCache % 8));
+    flushCache();
+    m_emulationPrevention = enable;
+    m_zeroBytes = 0;
+}
+
 } /*namespace YamiParser*/
@@ -31,22 +31,37 @@ public:
        */
     BitWriter(uint32_t size = BIT_WRITER_DEFAULT_BUFFER_SIZE);
 
+    /* write to caller's memory, like a mapped va buffer, and never
+     * allocate. writes fail once size bytes are used up */
+    BitWriter(uint8_t* buffer, uint32_t size);
+
     /* Write a value with numBits into bitstream */
     bool writeBits(uint32_t value, uint32_t numBits);
 
     /* Write an array with numBytes into bitstream */
     bool writeBytes(uint8_t* data, uint32_t numBytes);
 
+    /* Write an unsigned Exp-Golomb code, ue(v) */
+    bool writeUe(uint32_t value);
+
+    /* Write a signed Exp-Golomb code, se(v) */
+    bool writeSe(int32_t value);
+
     /* Pad some zeros to make sure bitsteam byte aligned */
     void writeToBytesAligned(bool bit = false);
 
+    /* insert emulation prevention byte 0x03 to bytes written after this.
+     * it must be called at a byte aligned position, after the nal header */
+    void enableEmulationPrevention(bool enable = true);
+
     /* get encoded bitstream buffer */
     uint8_t* getBitWriterData();
 
-    /* get encoded bits count */
+    /* get encoded bits count, it includes the inserted emulation
+     * prevention bytes once the cache is flushed by getBitWriterData() */
     uint64_t getCodedBitsCount() const
     {
-        return static_cast<uint64_t>(m_bs.size() * 8) + m_bitsInCache;
+        return (static_cast<uint64_t>(m_bytes) << 3) + m_bitsInCache;
     }
 
 protected:
@@ -54,8 +69,22 @@ protected:
 
     std::vector<uint8_t> m_bs; /* encoded bitstream buffer */
 
-    long int m_cache; /* a 32 or 64 bits cache buffer */
+    uint64_t m_cache; /* a 64 bits cache buffer */
     uint32_t m_bitsInCache; /* used bits in cache*/
+
+private:
+    inline void putBits(uint64_t value, uint32_t numBits);
+    inline bool reserve(uint32_t numBytes);
+    inline void putByte(uint8_t byte);
+    void flushWord();
+
+    uint8_t* m_buffer; /* m_bs data or caller's memory */
+    uint32_t m_capacity; /* size of m_buffer */
+    uint32_t m_bytes; /* bytes written to m_buffer */
+    bool m_external; /* m_buffer is caller's memory */
+    bool m_overflow; /* caller's memory is used up */
+    bool m_emulationPrevention;
+    uint32_t m_zeroBytes; /* continuous zero bytes written */
 };
 
 } /*namespace YamiParser*/
@@ -22,7 +22,12 @@
 #include "bitWriter.h"
 
 // library headers
+#include "bitReader.h"
 #include "common/unittest.h"
+#include "nalReader.h"
+
+// system libraries
+#include <stdlib.h>
 
 namespace YamiParser {
 
@@ -57,4 +62,111 @@ BITWriter_TEST(Writer_Simple)
     EXPECT_EQ(bitsSum, Writer.getCodedBitsCount());
 }
 
+BITWriter_TEST(WriteUeSe)
+{
+    BitWriter writer(16);
+    std::vector<uint32_t> ues;
+    std::vector<int32_t> ses;
+
+    srand(1);
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint32_t v = rand() >> (rand() % 31);
+        ues.push_back(v);
+        ses.push_back(i & 1 ? v >> 1 : -(int32_t)(v >> 1));
+    }
+    ues.push_back(0xfffffffe);
+    ses.push_back(0x7fffffff);
+    ses.push_back(-0x7fffffff);
+    /* NalReader strips emulation prevention bytes */
+    writer.enableEmulationPrevention();
+    for (size_t i = 0; i < ues.size(); i++) {
+        EXPECT_TRUE(writer.writeUe(ues[i]));
+        EXPECT_TRUE(writer.writeSe(ses[i]));
+    }
+    EXPECT_TRUE(writer.writeSe(ses.back()));
+    EXPECT_FALSE(writer.writeUe(0xffffffff));
+    EXPECT_FALSE(writer.writeSe(-0x7fffffff - 1));
+
+    uint8_t* data = writer.getBitWriterData();
+    ASSERT_TRUE(data);
+    NalReader reader(data, writer.getCodedBitsCount() / 8);
+    for (size_t i = 0; i < ues.size(); i++) {
+        uint32_t ue;
+        int32_t se;
+        ASSERT_TRUE(reader.readUe(ue));
+        EXPECT_EQ(ues[i], ue);
+        ASSERT_TRUE(reader.readSe(se));
+        EXPECT_EQ(ses[i], se);
+    }
+    int32_t se;
+    ASSERT_TRUE(reader.readSe(se));
+    EXPECT_EQ(ses.back(), se);
+    EXPECT_GT(8u, reader.getRemainingBitsCount());
+}
+
+BITWriter_TEST(EmulationPrevention)
+{
+    BitWriter writer;
+    std::vector<uint8_t> payload;
+
+    srand(2);
+    for (uint32_t i = 0; i < 4096; i++)
+        payload.push_back((rand() % 4) ? rand() % 4 : rand() % 256);
+
+    /* start code and nal header are written as they are */
+    EXPECT_TRUE(writer.writeBits(1, 32));
+    EXPECT_TRUE(writer.writeBits(0x65, 8));
+    writer.enableEmulationPrevention();
+    EXPECT_TRUE(writer.writeBits(0, 3));
+    for (size_t i = 0; i < payload.size(); i++)
+        EXPECT_TRUE(writer.writeBits(payload[i], 8));
+    EXPECT_TRUE(writer.writeBits(0, 5));
+
+    uint8_t* data = writer.getBitWriterData();
+    uint32_t size = writer.getCodedBitsCount() / 8;
+    ASSERT_TRUE(data);
+    EXPECT_EQ(0u, data[0]);
+    EXPECT_EQ(0u, data[1]);
+    EXPECT_EQ(0u, data[2]);
+    EXPECT_EQ(1u, data[3]);
+    EXPECT_EQ(0x65, data[4]);
+
+    /* no 0x000000, 0x000001 or 0x000002 in the payload */
+    uint32_t zeros = 0;
+    for (uint32_t i = 5; i < size; i++) {
+        EXPECT_FALSE(zeros >= 2 && data[i] <= 2);
+        zeros = data[i] ? 0 : zeros + 1;
+    }
+
+    NalReader reader(data + 5, size - 5);
+    EXPECT_EQ(0u, reader.read(3));
+    for (size_t i = 0; i < payload.size(); i++)
+        ASSERT_EQ(payload[i], reader.read(8));
+    EXPECT_EQ(0u, reader.read(5));
+    EXPECT_TRUE(reader.end());
+}
+
+BITWriter_TEST(CallerMemory)
+{
+    uint8_t buffer[12];
+    BitWriter writer(buffer, sizeof(buffer));
+
+    EXPECT_TRUE(writer.writeBits(0x12345678, 32));
+    EXPECT_TRUE(writer.writeBits(0x9abcdef0, 32));
+    EXPECT_TRUE(writer.writeUe(0));
+    EXPECT_EQ(buffer, writer.getBitWriterData());
+    EXPECT_EQ(72u, writer.getCodedBitsCount());
+    EXPECT_EQ(0x12, buffer[0]);
+    EXPECT_EQ(0xf0, buffer[7]);
+    EXPECT_EQ(0x80, buffer[8]);
+
+    uint8_t bytes[] = { 1, 2, 3 };
+    EXPECT_TRUE(writer.writeBytes(bytes, sizeof(bytes)));
+    EXPECT_EQ(96u, writer.getCodedBitsCount());
+
+    /* the buffer is full now */
+    EXPECT_FALSE(writer.writeBytes(bytes, 1));
+    EXPECT_EQ(NULL, writer.getBitWriterData());
+}
+
 } // namespace YamiParser
@@ -19,6 +19,7 @@
 #endif
 
 #include "h264Parser.h"
+#include "common/common_def.h"
 
 #include <math.h>
 
@@ -314,8 +315,41 @@ bool Parser::vuiParameters(SharedPtr<SPS>& sps, NalReader& br)
     return true;
 }
 
+bool Parser::peekSpsId(const NalUnit* nalu, uint32_t& id)
+{
+    NalReader br(nalu->m_data + nalu->m_nalUnitHeaderBytes,
+        nalu->m_size - nalu->m_nalUnitHeaderBytes);
+    //profile_idc, constraint_set flags and level_idc
+    return br.skip(24) && br.readUe(id);
+}
+
+bool Parser::peekPpsId(const NalUnit* nalu, uint32_t& id)
+{
+    NalReader br(nalu->m_data + nalu->m_nalUnitHeaderBytes,
+        nalu->m_size - nalu->m_nalUnitHeaderBytes);
+    return br.readUe(id);
+}
+
+bool Parser::peekFirstMbInSlice(const NalUnit* nalu, uint32_t& firstMb)
+{
+    NalReader br(nalu->m_data + nalu->m_nalUnitHeaderBytes,
+        nalu->m_size - nalu->m_nalUnitHeaderBytes);
+    return br.readUe(firstMb);
+}
+
 bool Parser::parseSps(SharedPtr<SPS>& sps, const NalUnit* nalu)
 {
+    uint32_t id;
+    if (!peekSpsId(nalu, id))
+        return false;
+    SharedPtr<SPS> cached = m_spsCache.find(id, nalu->m_data, nalu->m_size);
+    if (cached) {
+        sps = cached;
+        return true;
+    }
+    if (!sps)
+        sps.reset(new SPS());
+
     NalReader br(nalu->m_data + nalu->m_nalUnitHeaderBytes,
         nalu->m_size - nalu->m_nalUnitHeaderBytes);
 
@@ -500,6 +534,9 @@ bool Parser::parseSps(SharedPtr<SPS>& sps, const NalUnit* nalu)
     }
 
     m_spsMap[sps->sps_id] = sps;
+    m_spsCache.add(sps->sps_id, nalu->m_data, nalu->m_size, sps);
+    //cached pps may point to the old sps
+    m_ppsCache.clear();
 
     return true;
 }
@@ -510,6 +547,17 @@ bool Parser::parsePps(SharedPtr<PPS>& pps, const NalUnit* nalu)
     bool pic_scaling_matrix_present_flag;
     int32_t qp_bd_offset;
 
+    uint32_t id;
+    if (!peekPpsId(nalu, id))
+        return false;
+    SharedPtr<PPS> cached = m_ppsCache.find(id, nalu->m_data, nalu->m_size);
+    if (cached) {
+        pps = cached;
+        return true;
+    }
+    if (!pps)
+        pps.reset(new PPS());
+
     NalReader br(nalu->m_data + nalu->m_nalUnitHeaderBytes,
         nalu->m_size - nalu->m_nalUnitHeaderBytes);
 
@@ -646,6 +694,7 @@ bool Parser::parsePps(SharedPtr<PPS>& pps, const NalUnit* nalu)
     }
 
     m_ppsMap[pps->pps_id] = pps;
+    m_ppsCache.add(pps->pps_id, nalu->m_data, nalu->m_size, pps);
 
     return true;
 error:
@@ -673,6 +722,72 @@ Parser::searchSps(uint8_t id) const
     return res;
 }
 
+uint32_t Parser::getCacheHits() const
+{
+    return m_spsCache.hits() + m_ppsCache.hits();
+}
+
+uint32_t Parser::getCacheMisses() const
+{
+    return m_spsCache.misses() + m_ppsCache.misses();
+}
+
+bool Parser::parseRecoveryPoint(SeiRecoveryPoint* point, const SeiMessage& message)
+{
+    NalReader br(message.payload, message.payloadBytes);
+    READ_UE(point->recovery_frame_cnt);
+    READ(point->exact_match_flag);
+    READ(point->broken_link_flag);
+    READ_BITS(point->changing_slice_group_idc, 2);
+    return true;
+}
+
+bool Parser::parsePicTiming(SeiPicTiming* timing, const SeiMessage& message,
+    const SharedPtr<SPS>& sps)
+{
+    //NumClockTS of Table D-1
+    static const uint8_t numClockTs[9] = { 1, 1, 1, 2, 2, 3, 3, 2, 3 };
+    const VUIParameters& vui = sps->m_vui;
+    const HRDParameters* hrd = NULL;
+
+    if (sps->vui_parameters_present_flag) {
+        if (vui.nal_hrd_parameters_present_flag)
+            hrd = &vui.nal_hrd_parameters;
+        else if (vui.vcl_hrd_parameters_present_flag)
+            hrd = &vui.vcl_hrd_parameters;
+    }
+
+    NalReader br(message.payload, message.payloadBytes);
+    timing->cpb_removal_delay = timing->dpb_output_delay = 0;
+    if (hrd) {
+        READ_BITS(timing->cpb_removal_delay, hrd->cpb_removal_delay_length_minus1 + 1);
+        READ_BITS(timing->dpb_output_delay, hrd->dpb_output_delay_length_minus1 + 1);
+    }
+    timing->m_numClockTs = 0;
+    if (!sps->vui_parameters_present_flag || !vui.pic_struct_present_flag)
+        return true;
+    READ_BITS(timing->pic_struct, 4);
+    if (timing->pic_struct >= N_ELEMENTS(numClockTs)) {
+        ERROR("invalid pic_struct %d", timing->pic_struct);
+        return false;
+    }
+    timing->m_numClockTs = numClockTs[timing->pic_struct];
+    for (uint32_t i = 0; i < timing->m_numClockTs; i++) {
+        READ(timing->clock_timestamp_flag[i]);
+        if (!timing->clock_timestamp_flag[i])
+            continue;
+        SeiClockTimestamp* ts = &timing->clock_timestamp[i];
+        READ_BITS(ts->ct_type, 2);
+        READ(ts->units_field_based_flag);
+        if (!parseClockTimestamp(ts, br, 8))
+            return false;
+        ts->time_offset_length = hrd ? hrd->time_offset_length : 24;
+        if (!parseTimeOffset(ts, br))
+            return false;
+    }
+    return true;
+}
+
 bool SliceHeader::refPicListModification(NalReader& br, RefPicListModification* pm0,
     RefPicListModification* pm1, bool is_mvc)
 {
@@ -837,6 +952,9 @@ bool SliceHeader::parseHeader(Parser* nalparser, NalUnit* nalu)
     //and have valid defaults
     num_ref_idx_l0_active_minus1 = m_pps->num_ref_idx_l0_active_minus1;
     num_ref_idx_l1_active_minus1 = m_pps->num_ref_idx_l1_active_minus1;
+    //7.4.3, inferred to be 0 when not present
+    field_pic_flag = false;
+    bottom_field_flag = false;
 
     if (sps->separate_colour_plane_flag == 1)
         READ_BITS(colour_plane_id, 2);
@@ -30,6 +30,8 @@
 #define h264parser_h
 
 #include "nalReader.h"
+#include "paramSetCache.h"
+#include "seiParser.h"
 #include "VideoCommonDefs.h"
 
 #include <map>
@@ -419,6 +421,25 @@ public:
     uint32_t m_emulationPreventionBytes;
 };
 
+//D.1.8
+struct SeiRecoveryPoint {
+    uint32_t recovery_frame_cnt;
+    bool exact_match_flag;
+    bool broken_link_flag;
+    uint8_t changing_slice_group_idc;
+};
+
+//D.1.3
+struct SeiPicTiming {
+    uint32_t cpb_removal_delay;
+    uint32_t dpb_output_delay;
+    uint8_t pic_struct;
+    //NumClockTS of Table D-1, 0 if pic_struct is not present
+    uint8_t m_numClockTs;
+    bool clock_timestamp_flag[3];
+    SeiClockTimestamp clock_timestamp[3];
+};
+
 class Parser {
 public:
     enum {
@@ -430,12 +451,30 @@ public:
     typedef std::map<uint8_t, SharedPtr<SPS> > SpsMap;
     typedef std::map<uint8_t, SharedPtr<PPS> > PpsMap;
 
+    /* if nalu has the same bytes as a parsed one, sps/pps is set to the
+     * parsed one. else a null sps/pps is allocated before parsing */
     bool parseSps(SharedPtr<SPS>& sps, const NalUnit* nalu);
     bool parsePps(SharedPtr<PPS>& pps, const NalUnit* nalu);
 
+    /* the ids to look up the parameter set caches, and the first field
+     * of a slice, read without a full parse */
+    static bool peekSpsId(const NalUnit* nalu, uint32_t& id);
+    static bool peekPpsId(const NalUnit* nalu, uint32_t& id);
+    static bool peekFirstMbInSlice(const NalUnit* nalu, uint32_t& firstMb);
+
     inline SharedPtr<PPS> searchPps(uint8_t id) const;
     inline SharedPtr<SPS> searchSps(uint8_t id) const;
 
+    /* parameter sets found in cache, and the ones need parsing */
+    uint32_t getCacheHits() const;
+    uint32_t getCacheMisses() const;
+
+    /* payloads of the messages from SeiReader. pic_timing needs the
+     * active sps for the length of its fields */
+    bool parseRecoveryPoint(SeiRecoveryPoint* point, const SeiMessage& message);
+    bool parsePicTiming(SeiPicTiming* timing, const SeiMessage& message,
+        const SharedPtr<SPS>& sps);
+
 private:
     bool hrdParameters(HRDParameters* hrd, NalReader& nr);
     bool vuiParameters(SharedPtr<SPS>& sps, NalReader& nr);
@@ -443,6 +482,8 @@ private:
     static const uint8_t EXTENDED_SAR;
     SpsMap m_spsMap;
     PpsMap m_ppsMap;
+    ParamSetCache<SPS> m_spsCache;
+    ParamSetCache<PPS> m_ppsCache;
 };
 
 }
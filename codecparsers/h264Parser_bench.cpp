@@ -0,0 +1,200 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "h264Parser.h"
+
+// library headers
+#include "common/nalreader.h"
+#include "parserBench.h"
+
+// system libraries
+#include <stdlib.h>
+
+namespace YamiParser {
+namespace H264 {
+
+    using YamiMediaCodec::NalReader;
+
+    /* 1920x1088, cavlc, an idr and p pictures with 8 slices each.
+     * The whole annex b stream is split by NalReader and every nal is parsed,
+     * like VaapiDecoderH264::decode() does. */
+    class H264ParserBench : public ParserBench {
+    public:
+        const char* unit() const { return "nal"; }
+
+        bool setUp()
+        {
+            writeSps();
+            writePps();
+            for (uint32_t pic = 0; pic < PICTURES; pic++) {
+                for (uint32_t s = 0; s < SLICES; s++)
+                    writeSlice(pic, s * MBS / SLICES);
+            }
+            return true;
+        }
+
+        bool run(uint64_t& bytes, uint64_t& units)
+        {
+            NalReader reader(&m_stream[0], m_stream.size());
+            const uint8_t* nal;
+            int32_t size;
+            NalUnit nalu;
+            bool ok = true;
+            while (ok && reader.read(nal, size)) {
+                ok = nalu.parseNalUnit(nal, size);
+                if (!ok)
+                    break;
+                switch (nalu.nal_unit_type) {
+                case NAL_SPS:
+                    ok = m_parser.parseSps(m_sps, &nalu);
+                    break;
+                case NAL_PPS:
+                    ok = m_parser.parsePps(m_pps, &nalu);
+                    break;
+                case NAL_SLICE_IDR:
+                case NAL_SLICE_NONIDR: {
+                    SliceHeader slice;
+                    ok = slice.parseHeader(&m_parser, &nalu);
+                    break;
+                }
+                default:
+                    break;
+                }
+                units++;
+            }
+            bytes += m_stream.size();
+            return ok;
+        }
+
+    private:
+        static const uint32_t WIDTH_IN_MBS = 120;
+        static const uint32_t HEIGHT_IN_MBS = 68;
+        static const uint32_t MBS = WIDTH_IN_MBS * HEIGHT_IN_MBS;
+        static const uint32_t NUM_REFS = 4;
+        static const uint32_t PICTURES = 30;
+        static const uint32_t SLICES = 8;
+        static const uint32_t SLICE_DATA_BYTES = 4096;
+
+        void writeSps()
+        {
+            BitWriter bw;
+            bw.writeBits(0x67, 8);
+            bw.enableEmulationPrevention();
+            bw.writeBits(77, 8); //main profile
+            bw.writeBits(0, 8); //constraint flags and reserved_zero_2bits
+            bw.writeBits(40, 8); //level_idc
+            bw.writeUe(0); //sps_id
+            bw.writeUe(0); //log2_max_frame_num_minus4
+            bw.writeUe(0); //pic_order_cnt_type
+            bw.writeUe(2); //log2_max_pic_order_cnt_lsb_minus4
+            bw.writeUe(NUM_REFS);
+            bw.writeBits(0, 1); //gaps_in_frame_num_value_allowed_flag
+            bw.writeUe(WIDTH_IN_MBS - 1);
+            bw.writeUe(HEIGHT_IN_MBS - 1);
+            bw.writeBits(1, 1); //frame_mbs_only_flag
+            bw.writeBits(1, 1); //direct_8x8_inference_flag
+            bw.writeBits(0, 1); //frame_cropping_flag
+            bw.writeBits(0, 1); //vui_parameters_present_flag
+            appendNal(m_stream, bw);
+        }
+
+        void writePps()
+        {
+            BitWriter bw;
+            bw.writeBits(0x68, 8);
+            bw.enableEmulationPrevention();
+            bw.writeUe(0); //pps_id
+            bw.writeUe(0); //sps_id
+            bw.writeBits(0, 1); //entropy_coding_mode_flag
+            bw.writeBits(0, 1); //pic_order_present_flag
+            bw.writeUe(0); //num_slice_groups_minus1
+            bw.writeUe(0); //num_ref_idx_l0_active_minus1
+            bw.writeUe(0); //num_ref_idx_l1_active_minus1
+            bw.writeBits(1, 1); //weighted_pred_flag
+            bw.writeBits(0, 2); //weighted_bipred_idc
+            bw.writeSe(0); //pic_init_qp_minus26
+            bw.writeSe(0); //pic_init_qs_minus26
+            bw.writeSe(0); //chroma_qp_index_offset
+            bw.writeBits(1, 1); //deblocking_filter_control_present_flag
+            bw.writeBits(0, 1); //constrained_intra_pred_flag
+            bw.writeBits(0, 1); //redundant_pic_cnt_present_flag
+            appendNal(m_stream, bw);
+        }
+
+        /* the first picture is idr, the others are weighted p */
+        void writeSlice(uint32_t pic, uint32_t firstMb)
+        {
+            BitWriter bw(SLICE_DATA_BYTES + 256);
+            bool idr = !pic;
+            bw.writeBits(idr ? 0x65 : 0x41, 8);
+            bw.enableEmulationPrevention();
+            bw.writeUe(firstMb);
+            bw.writeUe(idr ? 7 : 5); //all slices of the picture are I or P
+            bw.writeUe(0); //pps_id
+            bw.writeBits(pic & 0xf, 4); //frame_num
+            if (idr)
+                bw.writeUe(0); //idr_pic_id
+            bw.writeBits((pic * 2) & 0x3f, 6); //pic_order_cnt_lsb
+            if (!idr) {
+                bw.writeBits(1, 1); //num_ref_idx_active_override_flag
+                bw.writeUe(NUM_REFS - 1);
+                bw.writeBits(1, 1); //ref_pic_list_modification_flag_l0
+                bw.writeUe(0); //modification_of_pic_nums_idc
+                bw.writeUe(0); //abs_diff_pic_num_minus1
+                bw.writeUe(3);
+                bw.writeUe(6); //luma_log2_weight_denom
+                bw.writeUe(6); //chroma_log2_weight_denom
+                for (uint32_t i = 0; i < NUM_REFS; i++) {
+                    bw.writeBits(1, 1);
+                    bw.writeSe(60 + i);
+                    bw.writeSe(-3);
+                    bw.writeBits(1, 1);
+                    for (uint32_t j = 0; j < 2; j++) {
+                        bw.writeSe(64 - i);
+                        bw.writeSe(2);
+                    }
+                }
+                bw.writeBits(0, 1); //adaptive_ref_pic_marking_mode_flag
+            }
+            else {
+                bw.writeBits(0, 1); //no_output_of_prior_pics_flag
+                bw.writeBits(0, 1); //long_term_reference_flag
+            }
+            bw.writeSe(2); //slice_qp_delta
+            bw.writeUe(0); //disable_deblocking_filter_idc
+            bw.writeSe(1);
+            bw.writeSe(-1);
+            writePayload(bw, SLICE_DATA_BYTES);
+            appendNal(m_stream, bw);
+        }
+
+        std::vector<uint8_t> m_stream;
+        Parser m_parser;
+        SharedPtr<SPS> m_sps;
+        SharedPtr<PPS> m_pps;
+
+        static const bool s_registered;
+    };
+
+    const bool H264ParserBench::s_registered = ParserBenchFactory::register_<H264ParserBench>("h264");
+
+} // namespace H264
+} // namespace YamiParser
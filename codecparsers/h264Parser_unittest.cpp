@@ -22,6 +22,7 @@
 #include "h264Parser.h"
 
 // library headers
+#include "bitWriter.h"
 #include "common/Array.h"
 #include "common/unittest.h"
 #include "common/nalreader.h"
@@ -211,5 +212,132 @@ namespace H264 {
         ASSERT_FALSE(HasFailure());
     }
 
+    H264_PARSER_TEST(ParamSetCache)
+    {
+        const uint8_t* nal;
+        int32_t size;
+        NalUnit spsNalu, ppsNalu;
+        NalReader nr(&g_SimpleH264[0], g_SimpleH264.size());
+        Parser parser;
+        SharedPtr<SPS> sps, sps2;
+        SharedPtr<PPS> pps, pps2;
+
+        ASSERT_TRUE(nr.read(nal, size));
+        ASSERT_TRUE(spsNalu.parseNalUnit(nal, size));
+        ASSERT_TRUE(nr.read(nal, size));
+        ASSERT_TRUE(ppsNalu.parseNalUnit(nal, size));
+
+        ASSERT_TRUE(parser.parseSps(sps, &spsNalu));
+        ASSERT_TRUE(parser.parsePps(pps, &ppsNalu));
+        EXPECT_EQ(0u, parser.getCacheHits());
+        EXPECT_EQ(2u, parser.getCacheMisses());
+
+        //repeated ones are not parsed again
+        ASSERT_TRUE(parser.parseSps(sps2, &spsNalu));
+        ASSERT_TRUE(parser.parsePps(pps2, &ppsNalu));
+        EXPECT_EQ(sps, sps2);
+        EXPECT_EQ(pps, pps2);
+        EXPECT_EQ(2u, parser.getCacheHits());
+        EXPECT_EQ(2u, parser.getCacheMisses());
+
+        //a new sps with same id, the pps needs to point to it
+        std::vector<uint8_t> data(spsNalu.m_data, spsNalu.m_data + spsNalu.m_size);
+        data[3] = 41; //level_idc
+        NalUnit newSpsNalu;
+        ASSERT_TRUE(newSpsNalu.parseNalUnit(&data[0], data.size()));
+        sps2.reset();
+        ASSERT_TRUE(parser.parseSps(sps2, &newSpsNalu));
+        EXPECT_NE(sps, sps2);
+        EXPECT_EQ(41, sps2->level_idc);
+
+        pps2.reset();
+        ASSERT_TRUE(parser.parsePps(pps2, &ppsNalu));
+        EXPECT_NE(pps, pps2);
+        EXPECT_EQ(sps2, pps2->m_sps);
+        EXPECT_EQ(2u, parser.getCacheHits());
+        EXPECT_EQ(4u, parser.getCacheMisses());
+    }
+
+    H264_PARSER_TEST(SeiRecoveryPoint)
+    {
+        BitWriter bw;
+        bw.writeUe(12); //recovery_frame_cnt
+        bw.writeBits(1, 1); //exact_match_flag
+        bw.writeBits(0, 1); //broken_link_flag
+        bw.writeBits(2, 2); //changing_slice_group_idc
+        bw.writeToBytesAligned();
+
+        SeiMessage message;
+        message.payloadType = SEI_RECOVERY_POINT;
+        message.payload = bw.getBitWriterData();
+        message.payloadSize = message.payloadBytes = bw.getCodedBitsCount() / 8;
+        Parser parser;
+        SeiRecoveryPoint point;
+        ASSERT_TRUE(parser.parseRecoveryPoint(&point, message));
+        EXPECT_EQ(12u, point.recovery_frame_cnt);
+        EXPECT_TRUE(point.exact_match_flag);
+        EXPECT_FALSE(point.broken_link_flag);
+        EXPECT_EQ(2, point.changing_slice_group_idc);
+    }
+
+    H264_PARSER_TEST(SeiPicTiming)
+    {
+        SharedPtr<SPS> sps(new SPS);
+        memset(sps.get(), 0, sizeof(SPS));
+        sps->vui_parameters_present_flag = true;
+        sps->m_vui.nal_hrd_parameters_present_flag = true;
+        sps->m_vui.nal_hrd_parameters.cpb_removal_delay_length_minus1 = 23;
+        sps->m_vui.nal_hrd_parameters.dpb_output_delay_length_minus1 = 4;
+        sps->m_vui.nal_hrd_parameters.time_offset_length = 0;
+        sps->m_vui.pic_struct_present_flag = true;
+
+        BitWriter bw;
+        bw.writeBits(100, 24); //cpb_removal_delay
+        bw.writeBits(2, 5); //dpb_output_delay
+        bw.writeBits(3, 4); //pic_struct, top bottom, two clock timestamps
+        bw.writeBits(0, 1); //clock_timestamp_flag[0]
+        bw.writeBits(1, 1); //clock_timestamp_flag[1]
+        bw.writeBits(1, 2); //ct_type
+        bw.writeBits(0, 1); //nuit_field_based_flag
+        bw.writeBits(4, 5); //counting_type
+        bw.writeBits(1, 1); //full_timestamp_flag
+        bw.writeBits(0, 1); //discontinuity_flag
+        bw.writeBits(1, 1); //cnt_dropped_flag
+        bw.writeBits(29, 8); //n_frames
+        bw.writeBits(59, 6);
+        bw.writeBits(59, 6);
+        bw.writeBits(23, 5);
+        bw.writeBits(1, 1);
+        bw.writeToBytesAligned();
+
+        SeiMessage message;
+        message.payloadType = SEI_PIC_TIMING;
+        message.payload = bw.getBitWriterData();
+        message.payloadSize = message.payloadBytes = bw.getCodedBitsCount() / 8;
+        Parser parser;
+        SeiPicTiming timing;
+        ASSERT_TRUE(parser.parsePicTiming(&timing, message, sps));
+        EXPECT_EQ(100u, timing.cpb_removal_delay);
+        EXPECT_EQ(2u, timing.dpb_output_delay);
+        EXPECT_EQ(3, timing.pic_struct);
+        ASSERT_EQ(2, timing.m_numClockTs);
+        EXPECT_FALSE(timing.clock_timestamp_flag[0]);
+        ASSERT_TRUE(timing.clock_timestamp_flag[1]);
+        const SeiClockTimestamp& ts = timing.clock_timestamp[1];
+        EXPECT_EQ(1, ts.ct_type);
+        EXPECT_TRUE(ts.cnt_dropped_flag);
+        EXPECT_EQ(29, ts.n_frames);
+        EXPECT_EQ(59, ts.seconds_value);
+        EXPECT_EQ(59, ts.minutes_value);
+        EXPECT_EQ(23, ts.hours_value);
+        EXPECT_EQ(0, ts.time_offset_value);
+
+        //no pic_struct, only the delays
+        sps->m_vui.pic_struct_present_flag = false;
+        ASSERT_TRUE(parser.parsePicTiming(&timing, message, sps));
+        EXPECT_EQ(100u, timing.cpb_removal_delay);
+        EXPECT_EQ(0, timing.m_numClockTs);
+    }
+
 } // namespace H264
 } // namespace YamiParser
@@ -181,6 +181,13 @@ bool SliceHeader::isISlice() const
     return slice_type == 2;
 }
 
+const ShortTermRefPicSet* SliceHeader::getStRps() const
+{
+    if (!short_term_ref_pic_set_sps_flag)
+        return &short_term_ref_pic_sets;
+    return &pps->sps->short_term_ref_pic_set[short_term_ref_pic_set_idx];
+}
+
 // Find the first occurrence of the subsequence position in the string src.
 // @src, the pointer to source data.
 // @size, the lenght of source data in bytes.
@@ -219,6 +226,45 @@ bool NalUnit::parseNaluHeader(const uint8_t* data, size_t size)
 
 uint8_t Parser::EXTENDED_SAR = 255;
 
+uint32_t Parser::getCacheHits() const
+{
+    return m_vpsCache.hits() + m_spsCache.hits() + m_ppsCache.hits();
+}
+
+uint32_t Parser::getCacheMisses() const
+{
+    return m_vpsCache.misses() + m_spsCache.misses() + m_ppsCache.misses();
+}
+
+bool Parser::parseRecoveryPoint(SeiRecoveryPoint* point, const SeiMessage& message)
+{
+    NalReader br(message.payload, message.payloadBytes);
+    READ_SE(point->recovery_poc_cnt);
+    READ(point->exact_match_flag);
+    READ(point->broken_link_flag);
+    return true;
+}
+
+bool Parser::parseTimeCode(SeiTimeCode* timeCode, const SeiMessage& message)
+{
+    NalReader br(message.payload, message.payloadBytes);
+    READ_BITS(timeCode->num_clock_ts, 2);
+    for (uint32_t i = 0; i < timeCode->num_clock_ts; i++) {
+        READ(timeCode->clock_timestamp_flag[i]);
+        if (!timeCode->clock_timestamp_flag[i])
+            continue;
+        SeiClockTimestamp* ts = &timeCode->clock_timestamp[i];
+        ts->ct_type = 0;
+        READ(ts->units_field_based_flag);
+        if (!parseClockTimestamp(ts, br, 9))
+            return false;
+        READ_BITS(ts->time_offset_length, 5);
+        if (!parseTimeOffset(ts, br))
+            return false;
+    }
+    return true;
+}
+
 SharedPtr<VPS> Parser::getVps(uint8_t id) const
 {
     SharedPtr<VPS> res;
@@ -669,8 +715,11 @@ bool Parser::stRefPicSet(ShortTermRefPicSet* stRef, NalReader& br,
     if (stRpsIdx != 0)
         READ(stRef->inter_ref_pic_set_prediction_flag);
     if (stRef->inter_ref_pic_set_prediction_flag) {
-        if (stRpsIdx == sps->num_short_term_ref_pic_sets)
+        if (stRpsIdx == sps->num_short_term_ref_pic_sets) {
             READ_UE(stRef->delta_idx_minus1);
+            if (stRef->delta_idx_minus1 >= stRpsIdx)
+                return false;
+        }
         // 7-57
         refRpsIdx = stRpsIdx - (stRef->delta_idx_minus1 + 1);
         READ(stRef->delta_rps_sign);
@@ -770,6 +819,12 @@ bool Parser::stRefPicSet(ShortTermRefPicSet* stRef, NalReader& br,
 
     stRef->NumDeltaPocs = stRef->NumPositivePics + stRef->NumNegativePics;
 
+    stRef->NumUsedByCurrPic = 0;
+    for (i = 0; i < stRef->NumNegativePics; i++)
+        stRef->NumUsedByCurrPic += stRef->UsedByCurrPicS0[i];
+    for (i = 0; i < stRef->NumPositivePics; i++)
+        stRef->NumUsedByCurrPic += stRef->UsedByCurrPicS1[i];
+
     return true;
 }
 
@@ -844,9 +899,61 @@ bool Parser::predWeightTable(SliceHeader* slice, NalReader& br)
     return true;
 }
 
+bool Parser::peekVpsId(const NalUnit* nalu, uint32_t& id)
+{
+    NalReader br(nalu->m_data + NalUnit::NALU_HEAD_SIZE,
+        nalu->m_size - NalUnit::NALU_HEAD_SIZE);
+    return br.read(id, 4);
+}
+
+bool Parser::peekSpsId(const NalUnit* nalu, uint32_t& id)
+{
+    NalReader br(nalu->m_data + NalUnit::NALU_HEAD_SIZE,
+        nalu->m_size - NalUnit::NALU_HEAD_SIZE);
+    uint32_t maxSubLayersMinus1;
+    //sps_video_parameter_set_id, then sps_temporal_id_nesting_flag after
+    //the sub layers
+    if (!br.skip(4) || !br.read(maxSubLayersMinus1, 3) || !br.skip(1))
+        return false;
+    //7.3.3, the general profile, tier and level are 96 bits, a sub layer
+    //has 88 bits of profile and 8 bits of level when present
+    if (!br.skip(96))
+        return false;
+    uint32_t subLayerBits = 0;
+    for (uint32_t i = 0; i < maxSubLayersMinus1; i++) {
+        uint32_t profilePresent, levelPresent;
+        if (!br.read(profilePresent, 1) || !br.read(levelPresent, 1))
+            return false;
+        subLayerBits += profilePresent * 88 + levelPresent * 8;
+    }
+    if (maxSubLayersMinus1 > 0)
+        subLayerBits += 2 * (8 - maxSubLayersMinus1);
+    return br.skip(subLayerBits) && br.readUe(id);
+}
+
+bool Parser::peekPpsId(const NalUnit* nalu, uint32_t& id)
+{
+    NalReader br(nalu->m_data + NalUnit::NALU_HEAD_SIZE,
+        nalu->m_size - NalUnit::NALU_HEAD_SIZE);
+    return br.readUe(id);
+}
+
+bool Parser::peekFirstSliceSegmentInPic(const NalUnit* nalu, bool& first)
+{
+    NalReader br(nalu->m_data + NalUnit::NALU_HEAD_SIZE,
+        nalu->m_size - NalUnit::NALU_HEAD_SIZE);
+    return br.readT(first);
+}
+
 // 7.3.2.1 Video parameter set RBSP syntax
 bool Parser::parseVps(const NalUnit* nalu)
 {
+    uint32_t id;
+    if (!peekVpsId(nalu, id))
+        return false;
+    if (m_vpsCache.find(id, nalu->m_data, nalu->m_size))
+        return true;
+
     SharedPtr<VPS> vps(new VPS());
 
     NalReader br(nalu->m_data + NalUnit::NALU_HEAD_SIZE,
@@ -925,14 +1032,31 @@ bool Parser::parseVps(const NalUnit* nalu)
     }
     br.rbspTrailingBits();
     m_vps[vps->vps_id] = vps;
+    m_vpsCache.add(vps->vps_id, nalu->m_data, nalu->m_size, vps);
+    // cached sps and pps may point to the old vps
+    m_spsCache.clear();
+    m_ppsCache.clear();
 
     return true;
 }
 
-// 7.3.2.2 Sequence parameter set RBSP syntax
 bool Parser::parseSps(const NalUnit* nalu)
 {
-    SharedPtr<SPS> sps(new SPS());
+    SharedPtr<SPS> sps;
+    return parseSps(nalu, sps);
+}
+
+// 7.3.2.2 Sequence parameter set RBSP syntax
+bool Parser::parseSps(const NalUnit* nalu, SharedPtr<SPS>& sps)
+{
+    uint32_t id;
+    if (!peekSpsId(nalu, id))
+        return false;
+    sps = m_spsCache.find(id, nalu->m_data, nalu->m_size);
+    if (sps)
+        return true;
+
+    sps.reset(new SPS());
     SharedPtr<VPS> vps;
     // Table 6-1
     uint8_t subWidthC[5] = { 1, 2, 2, 1, 1 };
@@ -1078,6 +1202,9 @@ bool Parser::parseSps(const NalUnit* nalu)
     // maybe add in the future.
 
     m_sps[sps->sps_id] = sps;
+    m_spsCache.add(sps->sps_id, nalu->m_data, nalu->m_size, sps);
+    // cached pps may point to the old sps
+    m_ppsCache.clear();
 
     return true;
 }
@@ -1085,6 +1212,12 @@ bool Parser::parseSps(const NalUnit* nalu)
 // 7.3.2.3 Picture parameter set RBSP syntax
 bool Parser::parsePps(const NalUnit* nalu)
 {
+    uint32_t id;
+    if (!peekPpsId(nalu, id))
+        return false;
+    if (m_ppsCache.find(id, nalu->m_data, nalu->m_size))
+        return true;
+
     SharedPtr<PPS> pps(new PPS());
     SharedPtr<SPS> sps;
 
@@ -1265,6 +1398,7 @@ bool Parser::parsePps(const NalUnit* nalu)
     }
 
     m_pps[pps->pps_id] = pps;
+    m_ppsCache.add(pps->pps_id, nalu->m_data, nalu->m_size, pps);
 
     return true;
 }
@@ -1275,7 +1409,6 @@ bool Parser::parseSlice(const NalUnit* nalu, SliceHeader* slice)
     uint32_t nbits;
     SharedPtr<PPS> pps;
     SharedPtr<SPS> sps;
-    ShortTermRefPicSet* stRPS = NULL;
     uint32_t UsedByCurrPicLt[16] = {0};
     int32_t numPicTotalCurr = 0;
 
@@ -1338,9 +1471,17 @@ bool Parser::parseSlice(const NalUnit* nalu, SliceHeader* slice)
                         sps->num_short_term_ref_pic_sets, sps.get()))
                     return false;
             }
-            else if (sps->num_short_term_ref_pic_sets > 1) {
-                nbits = ceil(log2(sps->num_short_term_ref_pic_sets));
-                READ_BITS(slice->short_term_ref_pic_set_idx, nbits);
+            else {
+                // the sets in sps are derived once in parseSps, slices
+                // referring to them only read the index
+                if (!sps->num_short_term_ref_pic_sets)
+                    return false;
+                if (sps->num_short_term_ref_pic_sets > 1) {
+                    nbits = ceil(log2(sps->num_short_term_ref_pic_sets));
+                    READ_BITS(slice->short_term_ref_pic_set_idx, nbits);
+                    if (slice->short_term_ref_pic_set_idx >= sps->num_short_term_ref_pic_sets)
+                        return false;
+                }
             }
             if (sps->long_term_ref_pics_present_flag) {
                 if (sps->num_long_term_ref_pics_sps > 0) {
@@ -1402,18 +1543,7 @@ bool Parser::parseSlice(const NalUnit* nalu, SliceHeader* slice)
                 return false;
 
             // according to 7-55
-            if (!slice->short_term_ref_pic_set_sps_flag)
-                stRPS = &slice->short_term_ref_pic_sets;
-            else
-                stRPS = &sps->short_term_ref_pic_set[slice->short_term_ref_pic_set_idx];
-            for (uint32_t i = 0; i < stRPS->NumNegativePics; i++) {
-                if (stRPS->UsedByCurrPicS0[i])
-                    numPicTotalCurr++;
-            }
-            for (uint32_t i = 0; i < stRPS->NumPositivePics; i++) {
-                if (stRPS->UsedByCurrPicS1[i])
-                    numPicTotalCurr++;
-            }
+            numPicTotalCurr = slice->getStRps()->NumUsedByCurrPic;
             for (uint32_t i = 0;
                  i < (slice->num_long_term_sps + slice->num_long_term_pics); i++) {
                 if (UsedByCurrPicLt[i])
@@ -27,6 +27,8 @@
 #define h265Parser_h
 
 #include "nalReader.h"
+#include "paramSetCache.h"
+#include "seiParser.h"
 #include "VideoCommonDefs.h"
 
 #include <map>
@@ -166,6 +168,8 @@ namespace H265 {
         uint8_t UsedByCurrPicS1[16];
         int32_t DeltaPocS0[16];
         int32_t DeltaPocS1[16];
+        //the short-term part of NumPicTotalCurr in 7-55
+        uint8_t NumUsedByCurrPic;
     };
 
     struct VuiParameters {
@@ -498,6 +502,10 @@ namespace H265 {
         bool isPSlice() const;
         bool isISlice() const;
 
+        /* the derived short-term rps of this slice, it points to the one
+         * in sps when short_term_ref_pic_set_sps_flag is set */
+        const ShortTermRefPicSet* getStRps() const;
+
         uint8_t pps_id; //slice_pic_parameter_set_id
         bool first_slice_segment_in_pic_flag;
         bool no_output_of_prior_pics_flag;
@@ -558,13 +566,44 @@ namespace H265 {
         std::vector<uint32_t> entry_point_offset_minus1;
     };
 
+    //D.2.8
+    struct SeiRecoveryPoint {
+        int32_t recovery_poc_cnt;
+        bool exact_match_flag;
+        bool broken_link_flag;
+    };
+
+    //D.2.27
+    struct SeiTimeCode {
+        uint8_t num_clock_ts;
+        bool clock_timestamp_flag[3];
+        SeiClockTimestamp clock_timestamp[3];
+    };
+
     class Parser {
     public:
         bool parseVps(const NalUnit* nalu);
         bool parseSps(const NalUnit* nalu);
+        /* sps is the one parsed or found in cache, valid if return true */
+        bool parseSps(const NalUnit* nalu, SharedPtr<SPS>& sps);
         bool parsePps(const NalUnit* nalu);
         bool parseSlice(const NalUnit* nalu, SliceHeader* slice);
 
+        /* the ids to look up the parameter set caches, and the first flag
+         * of a slice segment, read without a full parse */
+        static bool peekVpsId(const NalUnit* nalu, uint32_t& id);
+        static bool peekSpsId(const NalUnit* nalu, uint32_t& id);
+        static bool peekPpsId(const NalUnit* nalu, uint32_t& id);
+        static bool peekFirstSliceSegmentInPic(const NalUnit* nalu, bool& first);
+
+        /* parameter sets found in cache, and the ones need parsing */
+        uint32_t getCacheHits() const;
+        uint32_t getCacheMisses() const;
+
+        /* payloads of the messages from SeiReader */
+        bool parseRecoveryPoint(SeiRecoveryPoint* point, const SeiMessage& message);
+        bool parseTimeCode(SeiTimeCode* timeCode, const SeiMessage& message);
+
     private:
         static uint8_t EXTENDED_SAR;
 
@@ -593,6 +632,9 @@ namespace H265 {
         VpsMap m_vps;
         SpsMap m_sps;
         PpsMap m_pps;
+        ParamSetCache<VPS> m_vpsCache;
+        ParamSetCache<SPS> m_spsCache;
+        ParamSetCache<PPS> m_ppsCache;
 
         friend class H265ParserTest;
     };
@@ -0,0 +1,292 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "h265Parser.h"
+
+// library headers
+#include "common/nalreader.h"
+#include "parserBench.h"
+
+namespace YamiParser {
+namespace H265 {
+
+    using YamiMediaCodec::NalReader;
+
+    /* 1920x1088 main profile, 64x64 ctbs, wavefront on, so every slice has
+     * entry points. An idr and p pictures with 4 slices each, the parameter
+     * sets are repeated before every picture like in a broadcast stream. */
+    class H265ParserBench : public ParserBench {
+    public:
+        const char* unit() const { return "nal"; }
+
+        bool setUp()
+        {
+            for (uint32_t pic = 0; pic < PICTURES; pic++) {
+                writeVps();
+                writeSps();
+                writePps();
+                for (uint32_t s = 0; s < SLICES; s++)
+                    writeSlice(pic, s);
+            }
+            return true;
+        }
+
+        bool run(uint64_t& bytes, uint64_t& units)
+        {
+            NalReader reader(&m_stream[0], m_stream.size());
+            const uint8_t* nal;
+            int32_t size;
+            NalUnit nalu;
+            bool ok = true;
+            while (ok && reader.read(nal, size)) {
+                ok = nalu.parseNaluHeader(nal, size);
+                if (!ok)
+                    break;
+                switch (nalu.nal_unit_type) {
+                case NalUnit::VPS_NUT:
+                    ok = m_parser.parseVps(&nalu);
+                    break;
+                case NalUnit::SPS_NUT:
+                    ok = m_parser.parseSps(&nalu);
+                    break;
+                case NalUnit::PPS_NUT:
+                    ok = m_parser.parsePps(&nalu);
+                    break;
+                default:
+                    if (nalu.nal_unit_type <= NalUnit::RSV_IRAP_VCL23) {
+                        SliceHeader slice;
+                        ok = m_parser.parseSlice(&nalu, &slice);
+                    }
+                    break;
+                }
+                units++;
+            }
+            bytes += m_stream.size();
+            return ok;
+        }
+
+    private:
+        static const uint32_t WIDTH = 1920;
+        static const uint32_t HEIGHT = 1088;
+        static const uint32_t CTB_COLUMNS = 30;
+        static const uint32_t CTB_ROWS = 17;
+        static const uint32_t PICTURES = 30;
+        static const uint32_t SLICES = 4;
+        static const uint32_t SLICE_DATA_BYTES = 8192;
+
+        static void writeNalHeader(BitWriter& bw, uint8_t type)
+        {
+            bw.writeBits(0, 1); //forbidden_zero_bit
+            bw.writeBits(type, 6);
+            bw.writeBits(0, 6); //nuh_layer_id
+            bw.writeBits(1, 3); //nuh_temporal_id_plus1
+            bw.enableEmulationPrevention();
+        }
+
+        /* main profile, level 4.1, no sub layers */
+        static void writeProfileTierLevel(BitWriter& bw)
+        {
+            bw.writeBits(0, 2); //general_profile_space
+            bw.writeBits(0, 1); //general_tier_flag
+            bw.writeBits(1, 5); //general_profile_idc
+            bw.writeBits(0x60000000, 32); //compatible with main and main 10
+            bw.writeBits(0x9, 4); //progressive, frame only
+            bw.writeBits(0, 32); //general_reserved_zero_43bits
+            bw.writeBits(0, 11);
+            bw.writeBits(0, 1); //general_inbld_flag
+            bw.writeBits(123, 8); //general_level_idc
+        }
+
+        void writeVps()
+        {
+            BitWriter bw;
+            writeNalHeader(bw, NalUnit::VPS_NUT);
+            bw.writeBits(0, 4); //vps_id
+            bw.writeBits(1, 1); //vps_base_layer_internal_flag
+            bw.writeBits(1, 1); //vps_base_layer_available_flag
+            bw.writeBits(0, 6); //vps_max_layers_minus1
+            bw.writeBits(0, 3); //vps_max_sub_layers_minus1
+            bw.writeBits(1, 1); //vps_temporal_id_nesting_flag
+            bw.writeBits(0xffff, 16);
+            writeProfileTierLevel(bw);
+            bw.writeBits(0, 1); //vps_sub_layer_ordering_info_present_flag
+            bw.writeUe(4); //vps_max_dec_pic_buffering_minus1
+            bw.writeUe(0); //vps_max_num_reorder_pics
+            bw.writeUe(0); //vps_max_latency_increase_plus1
+            bw.writeBits(0, 6); //vps_max_layer_id
+            bw.writeUe(0); //vps_num_layer_sets_minus1
+            bw.writeBits(0, 1); //vps_timing_info_present_flag
+            bw.writeBits(0, 1); //vps_extension_flag
+            appendNal(m_stream, bw);
+        }
+
+        void writeSps()
+        {
+            BitWriter bw;
+            writeNalHeader(bw, NalUnit::SPS_NUT);
+            bw.writeBits(0, 4); //vps_id
+            bw.writeBits(0, 3); //sps_max_sub_layers_minus1
+            bw.writeBits(1, 1); //sps_temporal_id_nesting_flag
+            writeProfileTierLevel(bw);
+            bw.writeUe(0); //sps_id
+            bw.writeUe(1); //chroma_format_idc
+            bw.writeUe(WIDTH);
+            bw.writeUe(HEIGHT);
+            bw.writeBits(1, 1); //conformance_window_flag
+            bw.writeUe(0);
+            bw.writeUe(0);
+            bw.writeUe(0);
+            bw.writeUe(4); //1080 lines
+            bw.writeUe(0); //bit_depth_luma_minus8
+            bw.writeUe(0); //bit_depth_chroma_minus8
+            bw.writeUe(4); //log2_max_pic_order_cnt_lsb_minus4
+            bw.writeBits(0, 1); //sps_sub_layer_ordering_info_present_flag
+            bw.writeUe(4); //sps_max_dec_pic_buffering_minus1
+            bw.writeUe(0); //sps_max_num_reorder_pics
+            bw.writeUe(0); //sps_max_latency_increase_plus1
+            bw.writeUe(0); //log2_min_luma_coding_block_size_minus3
+            bw.writeUe(3); //log2_diff_max_min_luma_coding_block_size
+            bw.writeUe(0); //log2_min_transform_block_size_minus2
+            bw.writeUe(3); //log2_diff_max_min_transform_block_size
+            bw.writeUe(1); //max_transform_hierarchy_depth_inter
+            bw.writeUe(1); //max_transform_hierarchy_depth_intra
+            bw.writeBits(0, 1); //scaling_list_enabled_flag
+            bw.writeBits(1, 1); //amp_enabled_flag
+            bw.writeBits(1, 1); //sample_adaptive_offset_enabled_flag
+            bw.writeBits(0, 1); //pcm_enabled_flag
+            /*two sets: one and two previous pictures*/
+            bw.writeUe(2); //num_short_term_ref_pic_sets
+            for (uint32_t i = 0; i < 2; i++) {
+                if (i)
+                    bw.writeBits(0, 1); //inter_ref_pic_set_prediction_flag
+                bw.writeUe(i + 1); //num_negative_pics
+                bw.writeUe(0); //num_positive_pics
+                for (uint32_t j = 0; j <= i; j++) {
+                    bw.writeUe(0); //delta_poc_s0_minus1
+                    bw.writeBits(1, 1); //used_by_curr_pic_s0_flag
+                }
+            }
+            bw.writeBits(0, 1); //long_term_ref_pics_present_flag
+            bw.writeBits(1, 1); //sps_temporal_mvp_enabled_flag
+            bw.writeBits(1, 1); //strong_intra_smoothing_enabled_flag
+            bw.writeBits(0, 1); //vui_parameters_present_flag
+            bw.writeBits(0, 1); //sps_extension_present_flag
+            appendNal(m_stream, bw);
+        }
+
+        void writePps()
+        {
+            BitWriter bw;
+            writeNalHeader(bw, NalUnit::PPS_NUT);
+            bw.writeUe(0); //pps_id
+            bw.writeUe(0); //sps_id
+            bw.writeBits(0, 1); //dependent_slice_segments_enabled_flag
+            bw.writeBits(0, 1); //output_flag_present_flag
+            bw.writeBits(0, 3); //num_extra_slice_header_bits
+            bw.writeBits(1, 1); //sign_data_hiding_enabled_flag
+            bw.writeBits(1, 1); //cabac_init_present_flag
+            bw.writeUe(1); //num_ref_idx_l0_default_active_minus1
+            bw.writeUe(0); //num_ref_idx_l1_default_active_minus1
+            bw.writeSe(0); //init_qp_minus26
+            bw.writeBits(0, 1); //constrained_intra_pred_flag
+            bw.writeBits(0, 1); //transform_skip_enabled_flag
+            bw.writeBits(1, 1); //cu_qp_delta_enabled_flag
+            bw.writeUe(1); //diff_cu_qp_delta_depth
+            bw.writeSe(0); //pps_cb_qp_offset
+            bw.writeSe(0); //pps_cr_qp_offset
+            bw.writeBits(1, 1); //pps_slice_chroma_qp_offsets_present_flag
+            bw.writeBits(0, 1); //weighted_pred_flag
+            bw.writeBits(0, 1); //weighted_bipred_flag
+            bw.writeBits(0, 1); //transquant_bypass_enabled_flag
+            bw.writeBits(0, 1); //tiles_enabled_flag
+            bw.writeBits(1, 1); //entropy_coding_sync_enabled_flag
+            bw.writeBits(1, 1); //pps_loop_filter_across_slices_enabled_flag
+            bw.writeBits(1, 1); //deblocking_filter_control_present_flag
+            bw.writeBits(1, 1); //deblocking_filter_override_enabled_flag
+            bw.writeBits(0, 1); //pps_deblocking_filter_disabled_flag
+            bw.writeSe(0); //pps_beta_offset_div2
+            bw.writeSe(0); //pps_tc_offset_div2
+            bw.writeBits(0, 1); //pps_scaling_list_data_present_flag
+            bw.writeBits(0, 1); //lists_modification_present_flag
+            bw.writeUe(0); //log2_parallel_merge_level_minus2
+            bw.writeBits(0, 1); //slice_segment_header_extension_present_flag
+            bw.writeBits(0, 1); //pps_extension_present_flag
+            appendNal(m_stream, bw);
+        }
+
+        /* the first picture is idr, the others are p */
+        void writeSlice(uint32_t pic, uint32_t index)
+        {
+            BitWriter bw(SLICE_DATA_BYTES + 256);
+            bool idr = !pic;
+            uint32_t firstRow = index * CTB_ROWS / SLICES;
+            uint32_t rows = (index + 1) * CTB_ROWS / SLICES - firstRow;
+            writeNalHeader(bw, idr ? NalUnit::IDR_W_RADL : NalUnit::TRAIL_R);
+            bw.writeBits(!index, 1); //first_slice_segment_in_pic_flag
+            if (idr)
+                bw.writeBits(0, 1); //no_output_of_prior_pics_flag
+            bw.writeUe(0); //pps_id
+            if (index)
+                bw.writeBits(firstRow * CTB_COLUMNS, 9); //slice_segment_address
+            bw.writeUe(idr ? 2 : 1); //slice_type
+            if (!idr) {
+                bw.writeBits(pic & 0xff, 8); //slice_pic_order_cnt_lsb
+                bw.writeBits(1, 1); //short_term_ref_pic_set_sps_flag
+                bw.writeBits(pic > 1, 1); //short_term_ref_pic_set_idx
+                bw.writeBits(1, 1); //slice_temporal_mvp_enabled_flag
+            }
+            bw.writeBits(1, 1); //slice_sao_luma_flag
+            bw.writeBits(1, 1); //slice_sao_chroma_flag
+            if (!idr) {
+                bw.writeBits(1, 1); //num_ref_idx_active_override_flag
+                bw.writeUe(pic > 1); //num_ref_idx_l0_active_minus1
+                bw.writeBits(0, 1); //cabac_init_flag
+                if (pic > 1)
+                    bw.writeUe(0); //collocated_ref_idx
+                bw.writeUe(0); //five_minus_max_num_merge_cand
+            }
+            bw.writeSe(-2); //slice_qp_delta
+            bw.writeSe(1); //slice_cb_qp_offset
+            bw.writeSe(-1); //slice_cr_qp_offset
+            bw.writeBits(0, 1); //deblocking_filter_override_flag
+            bw.writeBits(1, 1); //slice_loop_filter_across_slices_enabled_flag
+            /*one entry point per ctb row*/
+            bw.writeUe(rows - 1); //num_entry_point_offsets
+            bw.writeUe(15); //offset_len_minus1
+            for (uint32_t i = 0; i < rows - 1; i++)
+                bw.writeBits(SLICE_DATA_BYTES / rows - 1, 16);
+            /*byte_alignment()*/
+            bw.writeBits(1, 1);
+            bw.writeToBytesAligned();
+            writePayload(bw, SLICE_DATA_BYTES);
+            appendNal(m_stream, bw);
+        }
+
+        std::vector<uint8_t> m_stream;
+        Parser m_parser;
+
+        static const bool s_registered;
+    };
+
+    const bool H265ParserBench::s_registered = ParserBenchFactory::register_<H265ParserBench>("h265");
+
+} // namespace H265
+} // namespace YamiParser
@@ -22,6 +22,7 @@
 #include "h265Parser.h"
 
 // library headers
+#include "bitWriter.h"
 #include "common/Array.h"
 #include "common/unittest.h"
 #include "common/nalreader.h"
@@ -177,6 +178,16 @@ namespace H265 {
             EXPECT_EQ(2, slice.slice_type);
             EXPECT_EQ(0, slice.cr_qp_offset);
         }
+
+        SharedPtr<SPS> getSps(const Parser& parser, uint8_t id)
+        {
+            return parser.getSps(id);
+        }
+
+        SharedPtr<PPS> getPps(const Parser& parser, uint8_t id)
+        {
+            return parser.getPps(id);
+        }
     };
 
 #define H265_PARSER_TEST(name) TEST_F(H265ParserTest, name)
@@ -208,5 +219,133 @@ namespace H265 {
         ASSERT_FALSE(HasFailure());
     }
 
+    H265_PARSER_TEST(ParamSetCache)
+    {
+        const uint8_t* nal;
+        int32_t size;
+        NalUnit nalu[3];
+        NalReader nr(&g_SimpleH265[0], g_SimpleH265.size());
+        Parser parser;
+
+        for (int i = 0; i < 3; i++) {
+            ASSERT_TRUE(nr.read(nal, size));
+            ASSERT_TRUE(nalu[i].parseNaluHeader(nal, size));
+        }
+        EXPECT_TRUE(parser.parseVps(&nalu[0]));
+        EXPECT_TRUE(parser.parseSps(&nalu[1]));
+        EXPECT_TRUE(parser.parsePps(&nalu[2]));
+        SharedPtr<SPS> sps = getSps(parser, 0);
+        SharedPtr<PPS> pps = getPps(parser, 0);
+        EXPECT_EQ(0u, parser.getCacheHits());
+        EXPECT_EQ(3u, parser.getCacheMisses());
+
+        //repeated ones are not parsed again
+        EXPECT_TRUE(parser.parseVps(&nalu[0]));
+        EXPECT_TRUE(parser.parseSps(&nalu[1]));
+        EXPECT_TRUE(parser.parsePps(&nalu[2]));
+        EXPECT_EQ(sps, getSps(parser, 0));
+        EXPECT_EQ(pps, getPps(parser, 0));
+        EXPECT_EQ(3u, parser.getCacheHits());
+        EXPECT_EQ(3u, parser.getCacheMisses());
+    }
+
+    H265_PARSER_TEST(StRpsDerivedOnce)
+    {
+        const uint8_t* nal;
+        int32_t size;
+        NalUnit nalu[4];
+        NalReader nr(&g_SimpleH265[0], g_SimpleH265.size());
+        Parser parser;
+
+        for (int i = 0; i < 4; i++) {
+            ASSERT_TRUE(nr.read(nal, size));
+            ASSERT_TRUE(nalu[i].parseNaluHeader(nal, size));
+        }
+        EXPECT_TRUE(parser.parseVps(&nalu[0]));
+        EXPECT_TRUE(parser.parseSps(&nalu[1]));
+        EXPECT_TRUE(parser.parsePps(&nalu[2]));
+
+        SharedPtr<SPS> sps = getSps(parser, 0);
+        ASSERT_TRUE(!!sps);
+        for (uint32_t i = 0; i < sps->num_short_term_ref_pic_sets; i++) {
+            const ShortTermRefPicSet& rps = sps->short_term_ref_pic_set[i];
+            uint32_t used = 0;
+            for (uint32_t j = 0; j < rps.NumNegativePics; j++)
+                used += rps.UsedByCurrPicS0[j];
+            for (uint32_t j = 0; j < rps.NumPositivePics; j++)
+                used += rps.UsedByCurrPicS1[j];
+            EXPECT_EQ(used, rps.NumUsedByCurrPic);
+        }
+
+        SliceHeader slice;
+        EXPECT_TRUE(parser.parseSlice(&nalu[3], &slice));
+        EXPECT_EQ(&slice.short_term_ref_pic_sets, slice.getStRps());
+
+        //slices using the sps sets get them without a copy
+        slice.short_term_ref_pic_set_sps_flag = true;
+        slice.short_term_ref_pic_set_idx = 0;
+        EXPECT_EQ(&sps->short_term_ref_pic_set[0], slice.getStRps());
+    }
+
+    H265_PARSER_TEST(SeiRecoveryPoint)
+    {
+        BitWriter bw;
+        bw.writeSe(-3); //recovery_poc_cnt
+        bw.writeBits(0, 1); //exact_match_flag
+        bw.writeBits(1, 1); //broken_link_flag
+        bw.writeToBytesAligned();
+
+        SeiMessage message;
+        message.payloadType = SEI_RECOVERY_POINT;
+        message.payload = bw.getBitWriterData();
+        message.payloadSize = message.payloadBytes = bw.getCodedBitsCount() / 8;
+        Parser parser;
+        SeiRecoveryPoint point;
+        ASSERT_TRUE(parser.parseRecoveryPoint(&point, message));
+        EXPECT_EQ(-3, point.recovery_poc_cnt);
+        EXPECT_FALSE(point.exact_match_flag);
+        EXPECT_TRUE(point.broken_link_flag);
+    }
+
+    H265_PARSER_TEST(SeiTimeCode)
+    {
+        BitWriter bw;
+        bw.writeBits(1, 2); //num_clock_ts
+        bw.writeBits(1, 1); //clock_timestamp_flag
+        bw.writeBits(0, 1); //units_field_based_flag
+        bw.writeBits(0, 5); //counting_type
+        bw.writeBits(0, 1); //full_timestamp_flag
+        bw.writeBits(0, 1); //discontinuity_flag
+        bw.writeBits(0, 1); //cnt_dropped_flag
+        bw.writeBits(300, 9); //n_frames
+        bw.writeBits(1, 1); //seconds_flag
+        bw.writeBits(10, 6);
+        bw.writeBits(1, 1); //minutes_flag
+        bw.writeBits(20, 6);
+        bw.writeBits(0, 1); //hours_flag
+        bw.writeBits(8, 5); //time_offset_length
+        bw.writeBits(0x7f, 8);
+        bw.writeToBytesAligned();
+
+        SeiMessage message;
+        message.payloadType = SEI_TIME_CODE;
+        message.payload = bw.getBitWriterData();
+        message.payloadSize = message.payloadBytes = bw.getCodedBitsCount() / 8;
+        Parser parser;
+        SeiTimeCode timeCode;
+        ASSERT_TRUE(parser.parseTimeCode(&timeCode, message));
+        ASSERT_EQ(1, timeCode.num_clock_ts);
+        ASSERT_TRUE(timeCode.clock_timestamp_flag[0]);
+        const SeiClockTimestamp& ts = timeCode.clock_timestamp[0];
+        EXPECT_EQ(300, ts.n_frames);
+        EXPECT_TRUE(ts.seconds_flag);
+        EXPECT_EQ(10, ts.seconds_value);
+        EXPECT_TRUE(ts.minutes_flag);
+        EXPECT_EQ(20, ts.minutes_value);
+        EXPECT_FALSE(ts.hours_flag);
+        EXPECT_EQ(8, ts.time_offset_length);
+        EXPECT_EQ(127, ts.time_offset_value);
+    }
+
 } // namespace H265
 } // namespace YamiParser
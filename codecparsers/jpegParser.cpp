@@ -46,6 +46,11 @@
 #include <algorithm>
 #include <cstring>
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define JPEGPARSER_USE_SIMD
+#include <immintrin.h>
+#endif
+
 namespace YamiParser {
 namespace JPEG {
 
@@ -221,6 +226,94 @@ Defaults::Defaults()
     }
 }
 
+const uint8_t* findMarkerC(const uint8_t* start, const uint8_t* end)
+{
+    const uint8_t* p = start;
+    while (end - p >= 2) {
+        p = static_cast<const uint8_t*>(std::memchr(p, 0xFF, end - p - 1));
+        if (!p)
+            break;
+        if (p[1])
+            return p;
+        p += 2; // stuffed 0xFF00
+    }
+    return end;
+}
+
+#ifdef JPEGPARSER_USE_SIMD
+
+/*
+ * 0xFF is rare in entropy-coded data, so most blocks are skipped on the
+ * first compare.  Blocks with 0xFF check the next bytes on all positions at
+ * once, so 0xFF00 stuffing does not leave the loop.
+ */
+__attribute__((target("sse2")))
+static const uint8_t* findMarkerSSE2(const uint8_t* start, const uint8_t* end)
+{
+    const __m128i ff = _mm_set1_epi8(-1);
+    const __m128i zero = _mm_setzero_si128();
+    const uint8_t* p = start;
+
+    // we test 16 positions a time, and the last one needs 1 more byte
+    while (end - p >= 16 + 1) {
+        __m128i b0 = _mm_loadu_si128((const __m128i*)p);
+        __m128i f = _mm_cmpeq_epi8(b0, ff);
+        if (_mm_movemask_epi8(f)) {
+            __m128i b1 = _mm_loadu_si128((const __m128i*)(p + 1));
+            __m128i m = _mm_andnot_si128(_mm_cmpeq_epi8(b1, zero), f);
+            int mask = _mm_movemask_epi8(m);
+            if (mask)
+                return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return findMarkerC(p, end);
+}
+
+__attribute__((target("avx2")))
+static const uint8_t* findMarkerAVX2(const uint8_t* start, const uint8_t* end)
+{
+    const __m256i ff = _mm256_set1_epi8(-1);
+    const __m256i zero = _mm256_setzero_si256();
+    const uint8_t* p = start;
+
+    while (end - p >= 32 + 1) {
+        __m256i b0 = _mm256_loadu_si256((const __m256i*)p);
+        __m256i f = _mm256_cmpeq_epi8(b0, ff);
+        if (_mm256_movemask_epi8(f)) {
+            __m256i b1 = _mm256_loadu_si256((const __m256i*)(p + 1));
+            __m256i m = _mm256_andnot_si256(_mm256_cmpeq_epi8(b1, zero), f);
+            uint32_t mask = _mm256_movemask_epi8(m);
+            if (mask)
+                return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return findMarkerC(p, end);
+}
+
+#endif // JPEGPARSER_USE_SIMD
+
+typedef const uint8_t* (*MarkerFinder)(const uint8_t* start, const uint8_t* end);
+
+static MarkerFinder selectMarkerFinder()
+{
+#ifdef JPEGPARSER_USE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return findMarkerAVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return findMarkerSSE2;
+#endif
+    return findMarkerC;
+}
+
+const uint8_t* findMarker(const uint8_t* start, const uint8_t* end)
+{
+    static const MarkerFinder finder = selectMarkerFinder();
+    return finder(start, end);
+}
+
 Parser::Parser(const uint8_t* data, const uint32_t size)
     : m_input(data, size)
     , m_data(data)
@@ -235,6 +328,7 @@ Parser::Parser(const uint8_t* data, const uint32_t size)
     , m_arithDCU()
     , m_arithACK()
     , m_callbacks()
+    , m_scanLayout(NULL)
     , m_sawSOI(false)
     , m_sawEOI(false)
     , m_restartInterval(0)
@@ -308,19 +402,22 @@ bool Parser::firstMarker()
 
 bool Parser::nextMarker()
 {
-    const uint8_t* const end = m_data + m_size - 1;
+    const uint8_t* const end = m_data + m_size;
     const uint8_t* const start = m_data + currentBytePosition();
-    const uint8_t* current = start;
     const uint8_t* match;
 
-    do {
-        match = std::find(current, end, 0xFF);
-        if (match == end)
-            return false;
-        if (*(match + 1) < 0xFF && *(match + 1) >= M_SOF0)
-            break;
-        current = match + 1;
-    } while (true);
+    if (m_scanLayout && m_current.marker == M_SOS) {
+        match = skipScanData(start, end);
+    } else {
+        match = start;
+        while ((match = findMarker(match, end)) != end) {
+            if (match[1] < 0xFF && match[1] >= M_SOF0)
+                break;
+            ++match;
+        }
+    }
+    if (match == end)
+        return false;
 
     skipBytes(std::distance(start, match) + 1);
 
@@ -331,6 +428,49 @@ bool Parser::nextMarker()
     return true;
 }
 
+/*
+ * Walk the entropy-coded data from start to the next marker that is not
+ * RSTn, and record the scan and its restart intervals.
+ * @return the 0xFF of the marker, or end if there is none
+ */
+const uint8_t* Parser::skipScanData(const uint8_t* start, const uint8_t* end)
+{
+    std::vector<Range>& intervals = m_scanLayout->intervals;
+    ScanData scan;
+    scan.header = m_scanHeader;
+    scan.firstInterval = intervals.size();
+
+    const uint8_t* interval = start;
+    const uint8_t* p = start;
+    while ((p = findMarker(p, end)) != end) {
+        const uint8_t c = p[1];
+        if (c >= M_RST0 && c <= M_RST7) {
+            Range range;
+            range.offset = interval - m_data;
+            range.size = p - interval;
+            intervals.push_back(range);
+            p += 2;
+            interval = p;
+        } else if (c < 0xFF && c >= M_SOF0) {
+            break;
+        } else {
+            ++p; // fill byte or reserved, not a marker
+        }
+    }
+
+    Range range;
+    range.offset = interval - m_data;
+    range.size = p - interval;
+    intervals.push_back(range);
+
+    scan.range.offset = start - m_data;
+    scan.range.size = p - start;
+    scan.numIntervals = intervals.size() - scan.firstInterval;
+    m_scanLayout->scans.push_back(scan);
+
+    return p;
+}
+
 bool Parser::parse()
 {
     while (true) {
@@ -453,6 +593,9 @@ bool Parser::parseSOI()
 
     m_sawSOI = true;
 
+    if (m_scanLayout)
+        m_scanLayout->clear();
+
     return true;
 }
 
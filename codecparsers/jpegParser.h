@@ -142,6 +142,52 @@ struct ScanHeader {
 
 typedef std::array<uint8_t, NUM_ARITH_TBLS> ArithmeticTable;
 
+/**
+ * A byte range of the JPEG data
+ */
+struct Range {
+    Range() : offset(0), size(0) { }
+
+    uint32_t offset;
+    uint32_t size;
+};
+
+/**
+ * The entropy-coded data of a scan.  Its restart intervals are
+ * ScanLayout::intervals[firstInterval, firstInterval + numIntervals).
+ */
+struct ScanData {
+    ScanHeader::Shared header;
+    Range range; // RSTn markers included
+    uint32_t firstInterval;
+    uint32_t numIntervals;
+};
+
+/**
+ * Byte ranges of all scans and restart intervals of an image.  It is
+ * cleared on SOI, so the storage is reused when the same layout is given
+ * to the parser of the next image.
+ */
+struct ScanLayout {
+    void clear()
+    {
+        scans.clear();
+        intervals.clear();
+    }
+
+    std::vector<ScanData> scans;
+    std::vector<Range> intervals; // RSTn markers excluded
+};
+
+/**
+ * @return the first 0xFF followed by a non-zero byte in [start, end), i.e.
+ * the next marker, RSTn or fill byte.  Stuffed 0xFF00 is skipped.  Returns
+ * end if there is none.
+ */
+const uint8_t* findMarker(const uint8_t* start, const uint8_t* end);
+/* plain C version of findMarker, used when no SIMD is available */
+const uint8_t* findMarkerC(const uint8_t* start, const uint8_t* end);
+
 class Defaults {
 public:
     static const Defaults& instance() { return s_instance; }
@@ -205,6 +251,13 @@ public:
      */
     void registerStartOfFrameCallback(const Callback&);
 
+    /**
+     * Skip the entropy-coded data of each scan in one pass and record the
+     * scan and restart interval ranges to layout.  RSTn markers are not
+     * reported to the callbacks in this mode.  Pass NULL to turn it off.
+     */
+    void setScanLayout(ScanLayout* layout) { m_scanLayout = layout; }
+
     /**
      * @return the most current Segment parsed by the parse() method.
      */
@@ -221,6 +274,7 @@ private:
 
     bool firstMarker();
     bool nextMarker();
+    const uint8_t* skipScanData(const uint8_t* start, const uint8_t* end);
     bool skipBytes(const uint32_t);
     uint32_t currentBytePosition() const { return m_input.getPos() >> 3; }
     CallbackResult notifyCallbacks() const;
@@ -254,6 +308,8 @@ private:
 
     Callbacks m_callbacks;
 
+    ScanLayout* m_scanLayout;
+
     bool m_sawSOI;
     bool m_sawEOI;
 
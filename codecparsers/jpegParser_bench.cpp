@@ -0,0 +1,193 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "jpegParser.h"
+
+// library headers
+#include "parserBench.h"
+
+// system libraries
+#include <stdlib.h>
+
+namespace YamiParser {
+namespace JPEG {
+
+    /* 1920x1088 baseline 4:2:0 images with a restart marker after every mcu
+     * row, like the ones from hardware encoders and ip cameras. A new
+     * Parser is created for each image, like the jpeg decoder does. */
+    class JPEGParserBench : public ParserBench {
+    public:
+        JPEGParserBench(bool layout = false)
+            : m_layout(layout)
+        {
+        }
+
+        const char* unit() const { return "image"; }
+
+        bool setUp()
+        {
+            m_images.resize(IMAGES);
+            for (uint32_t i = 0; i < IMAGES; i++)
+                writeImage(m_images[i]);
+            return true;
+        }
+
+        bool run(uint64_t& bytes, uint64_t& units)
+        {
+            for (uint32_t i = 0; i < m_images.size(); i++) {
+                const std::vector<uint8_t>& image = m_images[i];
+                Parser parser(&image[0], image.size());
+                if (m_layout)
+                    parser.setScanLayout(&m_scanLayout);
+                if (!parser.parse())
+                    return false;
+                bytes += image.size();
+                units++;
+            }
+            return true;
+        }
+
+    private:
+        static const uint32_t IMAGES = 8;
+        static const uint32_t WIDTH = 1920;
+        static const uint32_t HEIGHT = 1088;
+        static const uint32_t MCU_ROWS = HEIGHT / 16;
+        static const uint32_t BYTES_PER_ROW = 2048;
+
+        static void writeMarker(std::vector<uint8_t>& image, uint8_t marker)
+        {
+            image.push_back(0xff);
+            image.push_back(marker);
+        }
+
+        static void write16(std::vector<uint8_t>& image, uint16_t value)
+        {
+            image.push_back(value >> 8);
+            image.push_back(value & 0xff);
+        }
+
+        /* the bit counts of the tables in Annex K, with made up values */
+        static void writeHuffTable(std::vector<uint8_t>& image, uint8_t index, bool ac)
+        {
+            static const uint8_t dcBits[] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+            static const uint8_t acBits[] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+            const uint8_t* bits = ac ? acBits : dcBits;
+            uint32_t count = 0;
+            image.push_back((ac ? 0x10 : 0) | index);
+            for (uint32_t i = 0; i < 16; i++) {
+                image.push_back(bits[i]);
+                count += bits[i];
+            }
+            for (uint32_t i = 0; i < count; i++)
+                image.push_back(ac ? i + 1 : i);
+        }
+
+        /* random bytes with 0xff stuffed */
+        static void writeEntropyData(std::vector<uint8_t>& image, uint32_t bytes)
+        {
+            for (uint32_t i = 0; i < bytes; i++) {
+                uint8_t b = rand() % 256;
+                image.push_back(b);
+                if (b == 0xff)
+                    image.push_back(0);
+            }
+        }
+
+        static void writeImage(std::vector<uint8_t>& image)
+        {
+            image.clear();
+            writeMarker(image, M_SOI);
+
+            writeMarker(image, M_DQT);
+            write16(image, 2 + 2 * 65);
+            for (uint32_t t = 0; t < 2; t++) {
+                image.push_back(t);
+                for (uint32_t i = 0; i < 64; i++)
+                    image.push_back(1 + (i + t) % 64);
+            }
+
+            writeMarker(image, M_SOF0);
+            write16(image, 8 + 3 * 3);
+            image.push_back(8); //precision
+            write16(image, HEIGHT);
+            write16(image, WIDTH);
+            image.push_back(3);
+            for (uint32_t c = 0; c < 3; c++) {
+                image.push_back(c + 1);
+                image.push_back(c ? 0x11 : 0x22);
+                image.push_back(c ? 1 : 0);
+            }
+
+            std::vector<uint8_t> tables;
+            for (uint32_t t = 0; t < 2; t++) {
+                writeHuffTable(tables, t, false);
+                writeHuffTable(tables, t, true);
+            }
+            writeMarker(image, M_DHT);
+            write16(image, 2 + tables.size());
+            image.insert(image.end(), tables.begin(), tables.end());
+
+            writeMarker(image, M_DRI);
+            write16(image, 4);
+            write16(image, WIDTH / 16);
+
+            writeMarker(image, M_SOS);
+            write16(image, 6 + 2 * 3);
+            image.push_back(3);
+            for (uint32_t c = 0; c < 3; c++) {
+                image.push_back(c + 1);
+                image.push_back(c ? 0x11 : 0x00);
+            }
+            image.push_back(0); //Ss
+            image.push_back(63); //Se
+            image.push_back(0); //Ah and Al
+            for (uint32_t row = 0; row < MCU_ROWS; row++) {
+                if (row)
+                    writeMarker(image, M_RST0 + (row - 1) % 8);
+                writeEntropyData(image, BYTES_PER_ROW);
+            }
+            writeMarker(image, M_EOI);
+        }
+
+        bool m_layout;
+        std::vector<std::vector<uint8_t> > m_images;
+        ScanLayout m_scanLayout;
+
+        static const bool s_registered;
+    };
+
+    /* the same images, with the scan data skipped in one pass */
+    class JPEGParserLayoutBench : public JPEGParserBench {
+    public:
+        JPEGParserLayoutBench()
+            : JPEGParserBench(true)
+        {
+        }
+
+    private:
+        static const bool s_registered;
+    };
+
+    const bool JPEGParserBench::s_registered = ParserBenchFactory::register_<JPEGParserBench>("jpeg");
+    const bool JPEGParserLayoutBench::s_registered = ParserBenchFactory::register_<JPEGParserLayoutBench>("jpeg.layout");
+
+} // namespace JPEG
+} // namespace YamiParser
@@ -26,6 +26,7 @@
 
 // system headers
 #include <limits>
+#include <stdlib.h>
 
 namespace YamiParser {
 namespace JPEG {
@@ -523,5 +524,117 @@ JPEG_PARSER_TEST(Parse_SimpleTruncated)
     }
 }
 
+static const uint8_t* findMarkerRef(const uint8_t* start, const uint8_t* end)
+{
+    for (const uint8_t* p = start; end - p >= 2; ++p) {
+        if (p[0] == 0xFF && p[1])
+            return p;
+    }
+    return end;
+}
+
+JPEG_PARSER_TEST(FindMarker_Random)
+{
+    std::vector<uint8_t> data(4096);
+    srand(0);
+    for (size_t i(0); i < data.size(); ++i) {
+        // plenty of 0xFF00, some 0xFF, RSTn and markers
+        int r = rand() % 64;
+        data[i] = (r == 0) ? 0xFF : (r == 1) ? 0x00 : (r == 2) ? 0xD3 : rand() % 256;
+    }
+
+    const uint8_t* begin = &data[0];
+    const uint8_t* end = begin + data.size();
+    for (size_t i(0); i < 200; ++i) {
+        const uint8_t* p = begin + rand() % data.size();
+        const uint8_t* e = p + rand() % (end - p + 1);
+        EXPECT_EQ(findMarkerRef(p, e), findMarker(p, e));
+        EXPECT_EQ(findMarkerRef(p, e), findMarkerC(p, e));
+    }
+
+    // walk all of them, like the parser does
+    const uint8_t* p = begin;
+    const uint8_t* q = begin;
+    while (true) {
+        p = findMarker(p, end);
+        q = findMarkerRef(q, end);
+        ASSERT_EQ(q, p);
+        if (p == end)
+            break;
+        ++p;
+        ++q;
+    }
+}
+
+JPEG_PARSER_TEST(FindMarker_Stuffing)
+{
+    const uint8_t data[] = {
+        0x12, 0xFF, 0x00, 0x34, 0xFF, 0x00, 0x56, 0x78,
+        0x9a, 0xbc, 0xde, 0xf0, 0xFF, 0x00, 0x11, 0x22,
+        0x33, 0xFF, 0x00, 0x44, 0xFF, 0xD9 };
+
+    EXPECT_EQ(data + 20, findMarker(data, data + sizeof(data)));
+    // the last 0xFF has no next byte
+    EXPECT_EQ(data + 21, findMarker(data, data + 21));
+}
+
+JPEG_PARSER_TEST(Parse_ScanLayout)
+{
+    Parser parser(&g_SimpleJPEG[0], g_SimpleJPEG.size());
+    ScanLayout layout;
+    parser.setScanLayout(&layout);
+
+    EXPECT_TRUE(parser.parse());
+
+    ASSERT_EQ(1u, layout.scans.size());
+    const ScanData& scan = layout.scans[0];
+    EXPECT_EQ(parser.scanHeader(), scan.header);
+    // SOS at 610 with 12 bytes, EOI at 843
+    EXPECT_EQ(623u, scan.range.offset);
+    EXPECT_EQ(842u - 623u, scan.range.size);
+    EXPECT_EQ(0u, scan.firstInterval);
+    ASSERT_EQ(1u, scan.numIntervals);
+    EXPECT_EQ(623u, layout.intervals[0].offset);
+    EXPECT_EQ(scan.range.size, layout.intervals[0].size);
+
+    checkSimpleJPEG(parser);
+    ASSERT_FALSE(HasFailure());
+}
+
+JPEG_PARSER_TEST(Parse_ScanLayoutRestartIntervals)
+{
+    // put RST0 and RST1 into the entropy-coded data
+    std::vector<uint8_t> data(g_SimpleJPEG.begin(), g_SimpleJPEG.end());
+    const uint8_t rst0[] = { 0xFF, M_RST0 };
+    const uint8_t rst1[] = { 0xFF, M_RST1 };
+    data.insert(data.begin() + 700, rst1, rst1 + 2);
+    data.insert(data.begin() + 650, rst0, rst0 + 2);
+
+    Parser parser(&data[0], data.size());
+    Results results;
+    parser.registerCallback(M_RST0,
+        std::bind(&simpleCallback, std::ref(results), std::ref(parser)));
+    ScanLayout layout;
+    // stale entries from the last image are dropped on SOI
+    layout.intervals.resize(3);
+    parser.setScanLayout(&layout);
+
+    EXPECT_TRUE(parser.parse());
+    EXPECT_EQ(M_EOI, parser.current().marker);
+    EXPECT_TRUE(results.empty());
+
+    ASSERT_EQ(1u, layout.scans.size());
+    EXPECT_EQ(623u, layout.scans[0].range.offset);
+    EXPECT_EQ(842u + 4 - 623u, layout.scans[0].range.size);
+    ASSERT_EQ(3u, layout.scans[0].numIntervals);
+    ASSERT_EQ(3u, layout.intervals.size());
+    EXPECT_EQ(623u, layout.intervals[0].offset);
+    EXPECT_EQ(650u - 623u, layout.intervals[0].size);
+    EXPECT_EQ(652u, layout.intervals[1].offset);
+    EXPECT_EQ(702u - 652u, layout.intervals[1].size);
+    EXPECT_EQ(704u, layout.intervals[2].offset);
+    EXPECT_EQ(846u - 704u, layout.intervals[2].size);
+}
+
 } // namespace JPEG
 } // namespace YamiParser
@@ -31,6 +31,8 @@
 
 // config.h defines macros for log.h to define log levels
 #include "common/log.h"
+#include "common/common_def.h"
+#include "common/nalreader.h"
 #include "mpeg2_parser.h"
 
 namespace YamiParser {
@@ -177,25 +179,55 @@ namespace MPEG2 {
     }
 
     bool Parser::parseSlice(const StreamHeader* shdr)
+    {
+        return parseSliceHeader(shdr->nalData, shdr->nalSize, m_slice);
+    }
+
+    static inline bool isSliceCode(uint8_t code)
+    {
+        return code >= MPEG2_SLICE_START_CODE_MIN
+            && code <= MPEG2_SLICE_START_CODE_MAX;
+    }
+
+    bool Parser::parseSlices(const StreamHeader* shdr, std::vector<Slice>& slices)
+    {
+        const uint8_t* end = shdr->data + shdr->streamSize;
+        const uint8_t* nal = shdr->nalData;
+        const uint8_t* next;
+
+        slices.clear();
+        while (1) {
+            next = YamiMediaCodec::findStartCode(nal, end);
+            slices.resize(slices.size() + 1);
+            if (!parseSliceHeader(nal, next - nal, slices.back()))
+                return false;
+            // a start code without the code byte ends the buffer
+            if (end - next <= 3 || !isSliceCode(next[3]))
+                break;
+            nal = next + 3;
+        }
+        return true;
+    }
+
+    bool Parser::parseSliceHeader(const uint8_t* nalData, int32_t nalSize,
+                                  Slice& slice)
     {
         uint32_t verticalSize;
-        int32_t nalSize = shdr->nalSize;
-        const uint8_t* nalData = shdr->nalData;
 	bool marker;
 
-        if (shdr->nalSize < kStartCodeSize + 1) {
+        if (nalSize < kStartCodeSize + 1) {
             ERROR("Incomplete slice header");
             return false;
         }
 
-        memset(&m_slice, 0, sizeof(Slice));
+        memset(&slice, 0, sizeof(Slice));
 
-        m_slice.sliceData = nalData;
-        m_slice.sliceDataSize = nalSize;
+        slice.sliceData = nalData;
+        slice.sliceDataSize = nalSize;
 
         BitReader bitReader(nalData, nalSize);
         bitReaderInit(&bitReader);
-        m_slice.verticalPosition = nalData[0];
+        slice.verticalPosition = nalData[0];
 
         SKIP_BYTE_OR_RETURN(); // skip start code
 
@@ -207,27 +239,27 @@ namespace MPEG2 {
         if (verticalSize > 2800) {
             // really big picture
             READ_BITS_OR_RETURN(
-                3, &(m_slice.slice_vertical_position_extension));
-            m_slice.macroblockRow
-                = (m_slice.slice_vertical_position_extension << 7)
-                  + m_slice.verticalPosition - 1;
+                3, &(slice.slice_vertical_position_extension));
+            slice.macroblockRow
+                = (slice.slice_vertical_position_extension << 7)
+                  + slice.verticalPosition - 1;
         } else {
-            m_slice.macroblockRow = m_slice.verticalPosition - 1;
+            slice.macroblockRow = slice.verticalPosition - 1;
         }
 
-        READ_BITS_OR_RETURN(5, &(m_slice.quantiser_scale_code));
+        READ_BITS_OR_RETURN(5, &(slice.quantiser_scale_code));
         PEEK_BOOL_OR_RETURN(&marker);
         if (marker) {
             // read more intra bits
-            READ_FLAG_OR_RETURN(&(m_slice.intra_slice_flag));
-            READ_FLAG_OR_RETURN(&(m_slice.intra_slice));
-            READ_BITS_OR_RETURN(7, &(m_slice.reserved_bits));
+            READ_FLAG_OR_RETURN(&(slice.intra_slice_flag));
+            READ_FLAG_OR_RETURN(&(slice.intra_slice));
+            READ_BITS_OR_RETURN(7, &(slice.reserved_bits));
 
             PEEK_BOOL_OR_RETURN(&marker);
             while (marker) {
                 // extra_information_slice
-                READ_FLAG_OR_RETURN(&(m_slice.extra_bit_slice));
-                if (!m_slice.extra_bit_slice) {
+                READ_FLAG_OR_RETURN(&(slice.extra_bit_slice));
+                if (!slice.extra_bit_slice) {
                     ERROR("Bad extra bit slice");
                     bitReaderDeInit();
                     return false;
@@ -237,9 +269,9 @@ namespace MPEG2 {
             }
         }
 
-        READ_FLAG_OR_RETURN(&(m_slice.extra_bit_slice));
+        READ_FLAG_OR_RETURN(&(slice.extra_bit_slice));
 
-        if (m_slice.extra_bit_slice) {
+        if (slice.extra_bit_slice) {
             ERROR("Bad extra bit slice");
             bitReaderDeInit();
             return false;
@@ -249,61 +281,68 @@ namespace MPEG2 {
         // as long as the first macroblock_icrement is known
 
         // sliceHeaderSize is given in bits
-        m_slice.sliceHeaderSize = bitReaderCurrentPosition();
+        slice.sliceHeaderSize = bitReaderCurrentPosition();
 
-        if (!calculateMBColumn())
+        if (!calculateMBColumn(slice))
             return false;
 
 
         DEBUG("slice header size                  : %ld",
-              m_slice.sliceHeaderSize);
+              slice.sliceHeaderSize);
         DEBUG("slice number                       : %x",
-              m_slice.verticalPosition);
+              slice.verticalPosition);
         DEBUG("slice_vertical_position_extension  : %x",
-              m_slice.slice_vertical_position_extension);
+              slice.slice_vertical_position_extension);
         DEBUG("quantiser_scale_code               : %x",
-              m_slice.quantiser_scale_code);
+              slice.quantiser_scale_code);
         DEBUG("intra_slice_flag                   : %x",
-              m_slice.intra_slice_flag);
+              slice.intra_slice_flag);
         DEBUG("intra_slice                        : %x",
-              m_slice.intra_slice);
+              slice.intra_slice);
         DEBUG("extra_bit_slice                    : %x",
-              m_slice.extra_bit_slice);
+              slice.extra_bit_slice);
         DEBUG("slice size                         : %ld",
-              m_slice.sliceDataSize);
+              slice.sliceDataSize);
         DEBUG("size left on buffer                : %d", nalSize);
         DEBUG("slice data                         : %p",
-              m_slice.sliceData);
+              slice.sliceData);
         DEBUG("macroblockRow                      : %d",
-              m_slice.macroblockRow);
+              slice.macroblockRow);
         DEBUG("macroblockColumn                   : %d",
-              m_slice.macroblockColumn);
+              slice.macroblockColumn);
 
         bitReaderDeInit();
         return true;
     }
 
-    bool Parser::calculateMBColumn()
+    bool Parser::calculateMBColumn(Slice& slice)
     {
-        uint32_t bitsToParse;
-        uint32_t mbVLC, mbINC = 0, totalMBINC = 0;
+        // one peek of the longest code per macroblock_address_increment,
+        // the codes of table B-1 are matched against its top bits
+        const uint32_t maxBits = 11;
+        uint32_t bits, code, i;
+        uint32_t mbINC, totalMBINC = 0;
         do {
-            for (uint8_t i = 0; i < 34; i++) {
-                bitsToParse = kVLCTable[i][0];
-                PEEK_BITS_OR_RETURN(bitsToParse, &mbVLC);
-                if (mbVLC == kVLCTable[i][1]) {
-                    mbINC = kVLCTable[i][2];
+            bits = std::min<uint64_t>(maxBits,
+                m_bitReader->getRemainingBitsCount());
+            PEEK_BITS_OR_RETURN(bits, &code);
+            code <<= maxBits - bits;
+            for (i = 0; i < N_ELEMENTS(kVLCTable); i++) {
+                if (kVLCTable[i][0] <= bits
+                    && code >> (maxBits - kVLCTable[i][0]) == kVLCTable[i][1])
                     break;
-                }
             }
+            if (i == N_ELEMENTS(kVLCTable))
+                RETURN_ERROR(macroblock_address_increment);
+            mbINC = kVLCTable[i][2];
             if (mbINC == 255)
                 totalMBINC += 33;
             else
                 totalMBINC += mbINC;
-            SKIP_BITS_OR_RETURN(bitsToParse);
+            SKIP_BITS_OR_RETURN(kVLCTable[i][0]);
         } while (mbINC == 255);
 
-        m_slice.macroblockColumn = totalMBINC - 1;
+        slice.macroblockColumn = totalMBINC - 1;
         return true;
     }
 
@@ -36,6 +36,7 @@
 // system headers
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 
 namespace YamiParser {
 namespace MPEG2 {
@@ -321,6 +322,14 @@ namespace MPEG2 {
         // bit parsed.
         bool parseSlice(const StreamHeader* shdr);
 
+        // parseSlices will parse the slice at nalData and every slice after
+        // it in a single pass, up to the first start code which is not a
+        // slice one or the end of the stream data. Start codes are found
+        // with a vectorized scan and each Slice has its macroblock column,
+        // so a client can fill all slice parameters of a picture at once.
+        // The last slice ends where the client should go on reading.
+        bool parseSlices(const StreamHeader* shdr, std::vector<Slice>& slices);
+
         // nextStartCodeNew will update with next start code and return true if one
         // is found,
         bool nextStartCode(const StreamHeader* shdr, StartCodeType& start_code);
@@ -350,7 +359,9 @@ namespace MPEG2 {
                                       const uint8_t defaultMatrix[]);
 
         bool readQuantMatrix(bool& loadMatrix, uint8_t matrix[]);
-        bool calculateMBColumn();
+        bool parseSliceHeader(const uint8_t* nalData, int32_t nalSize,
+                              Slice& slice);
+        bool calculateMBColumn(Slice& slice);
 
         // bitReader functions
 
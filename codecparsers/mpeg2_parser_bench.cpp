@@ -0,0 +1,145 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "mpeg2_parser.h"
+
+// library headers
+#include "common/nalreader.h"
+#include "parserBench.h"
+
+// system libraries
+#include <stdlib.h>
+
+namespace YamiParser {
+namespace MPEG2 {
+
+    using YamiMediaCodec::NalReader;
+
+    /* 1920x1088 intra pictures, one slice per macroblock row. The stream is
+     * walked like VaapiDecoderMPEG2::decode(): headers one by one, and the
+     * slices of a picture in one parseSlices() call. */
+    class MPEG2ParserBench : public ParserBench {
+    public:
+        const char* unit() const { return "header"; }
+
+        bool setUp()
+        {
+            static const uint8_t sequenceHeader[]
+                = { 0xb3, 0x78, 0x04, 0x40, 0x34, 0xff, 0xff, 0xe0, 0x18 };
+            static const uint8_t sequenceExtension[]
+                = { 0xb5, 0x14, 0x8a, 0x00, 0x01, 0x00, 0x00 };
+            static const uint8_t gopHeader[] = { 0xb8, 0x00, 0x08, 0x06, 0x00 };
+            static const uint8_t pictureHeader[] = { 0x00, 0x00, 0x0f, 0xff, 0xf8 };
+            static const uint8_t pictureCodingExtension[]
+                = { 0xb5, 0x8f, 0xff, 0xf3, 0x41, 0x80 };
+
+            append(sequenceHeader, sizeof(sequenceHeader));
+            append(sequenceExtension, sizeof(sequenceExtension));
+            append(gopHeader, sizeof(gopHeader));
+            for (uint32_t pic = 0; pic < PICTURES; pic++) {
+                append(pictureHeader, sizeof(pictureHeader));
+                append(pictureCodingExtension, sizeof(pictureCodingExtension));
+                for (uint32_t row = 0; row < MB_ROWS; row++)
+                    writeSlice(row);
+            }
+            return true;
+        }
+
+        bool run(uint64_t& bytes, uint64_t& units)
+        {
+            StreamHeader shdr;
+            shdr.data = &m_stream[0];
+            shdr.streamSize = m_stream.size();
+            NalReader reader(shdr.data, shdr.streamSize);
+            bool ok = true;
+            while (ok && reader.read(shdr.nalData, shdr.nalSize)) {
+                uint8_t code = shdr.nalData[0];
+                switch (code) {
+                case MPEG2_SEQUENCE_HEADER_CODE:
+                    ok = m_parser.parseSequenceHeader(&shdr);
+                    break;
+                case MPEG2_EXTENSION_START_CODE:
+                    if ((shdr.nalData[1] >> 4) == kSequence)
+                        ok = m_parser.parseSequenceExtension(&shdr);
+                    else
+                        ok = m_parser.parsePictureCodingExtension(&shdr);
+                    break;
+                case MPEG2_GROUP_START_CODE:
+                    ok = m_parser.parseGOPHeader(&shdr);
+                    break;
+                case MPEG2_PICTURE_START_CODE:
+                    ok = m_parser.parsePictureHeader(&shdr);
+                    break;
+                default:
+                    ok = m_parser.parseSlices(&shdr, m_slices);
+                    if (ok) {
+                        const Slice& last = m_slices.back();
+                        const uint8_t* next = last.sliceData + last.sliceDataSize;
+                        reader = NalReader(next, shdr.data + shdr.streamSize - next);
+                        units += m_slices.size() - 1;
+                    }
+                    break;
+                }
+                units++;
+            }
+            bytes += m_stream.size();
+            return ok;
+        }
+
+    private:
+        static const uint32_t MB_ROWS = 68;
+        static const uint32_t PICTURES = 30;
+        static const uint32_t SLICE_DATA_BYTES = 1024;
+
+        void append(const uint8_t* data, uint32_t size)
+        {
+            static const uint8_t startCode[] = { 0, 0, 1 };
+            m_stream.insert(m_stream.end(), startCode, startCode + sizeof(startCode));
+            m_stream.insert(m_stream.end(), data, data + size);
+        }
+
+        /* no emulation prevention in mpeg2, the payload has no zero byte
+         * so it never looks like a start code */
+        void writeSlice(uint32_t row)
+        {
+            BitWriter bw(SLICE_DATA_BYTES + 16);
+            bw.writeBits(row + 1, 8); //slice_vertical_position
+            bw.writeBits(8, 5); //quantiser_scale_code
+            bw.writeBits(0, 1); //extra_bit_slice
+            bw.writeBits(1, 1); //macroblock_address_increment
+            for (uint32_t i = 0; i < SLICE_DATA_BYTES; i++)
+                bw.writeBits(1 + rand() % 255, 8);
+            bw.writeToBytesAligned(true);
+            const uint8_t* data = bw.getBitWriterData();
+            append(data, bw.getCodedBitsCount() / 8);
+        }
+
+        std::vector<uint8_t> m_stream;
+        Parser m_parser;
+        std::vector<Slice> m_slices;
+
+        static const bool s_registered;
+    };
+
+    const bool MPEG2ParserBench::s_registered = ParserBenchFactory::register_<MPEG2ParserBench>("mpeg2");
+
+} // namespace MPEG2
+} // namespace YamiParser
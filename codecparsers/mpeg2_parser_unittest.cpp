@@ -199,5 +199,53 @@ namespace MPEG2 {
         EXPECT_TRUE(parser.parseSlice(&streamParser));
         checkParamsSlice(parser);
     }
+
+    MPEG2_PARSER_TEST(ParseSlices)
+    {
+        Parser parser;
+        StreamHeader streamParser;
+        std::vector<Slice> slices;
+        const uint8_t startCode[] = { 0x00, 0x00, 0x01 };
+        // row 1, starts at column 34 with an escaped address increment
+        const uint8_t secondSlice[] = { 0x02, 0x08, 0x04, 0x3f, 0xff, 0xff };
+        const uint8_t pictureStartCode[] = { 0x00, 0x00, 0x01, 0x00 };
+
+        std::vector<uint8_t> stream;
+        stream.insert(stream.end(), startCode, startCode + sizeof(startCode));
+        stream.insert(stream.end(), SliceArray.begin(), SliceArray.end());
+        stream.insert(stream.end(), startCode, startCode + sizeof(startCode));
+        stream.insert(stream.end(), secondSlice,
+                      secondSlice + sizeof(secondSlice));
+        size_t pictureOffset = stream.size();
+        stream.insert(stream.end(), pictureStartCode,
+                      pictureStartCode + sizeof(pictureStartCode));
+
+        streamParser.data = &stream[0];
+        streamParser.streamSize = stream.size();
+        streamParser.nalData = &stream[sizeof(startCode)];
+
+        ASSERT_TRUE(parser.parseSlices(&streamParser, slices));
+        ASSERT_EQ(2u, slices.size());
+
+        EXPECT_EQ(&stream[sizeof(startCode)], slices[0].sliceData);
+        EXPECT_EQ(SliceArray.size(), slices[0].sliceDataSize);
+        EXPECT_EQ(14u, slices[0].sliceHeaderSize);
+        EXPECT_EQ(0u, slices[0].macroblockRow);
+        EXPECT_EQ(0u, slices[0].macroblockColumn);
+
+        EXPECT_EQ(sizeof(secondSlice), slices[1].sliceDataSize);
+        EXPECT_EQ(&stream[pictureOffset], slices[1].sliceData + slices[1].sliceDataSize);
+        EXPECT_EQ(14u, slices[1].sliceHeaderSize);
+        EXPECT_EQ(1u, slices[1].quantiser_scale_code);
+        EXPECT_EQ(1u, slices[1].macroblockRow);
+        EXPECT_EQ(34u, slices[1].macroblockColumn);
+
+        // the slice is the last thing in the buffer
+        streamParser.streamSize = pictureOffset;
+        streamParser.nalData = slices[1].sliceData;
+        ASSERT_TRUE(parser.parseSlices(&streamParser, slices));
+        ASSERT_EQ(1u, slices.size());
+        EXPECT_EQ(sizeof(secondSlice), slices[0].sliceDataSize);
+    }
 } // namespace MPEG2 
 } // namespace YamiParser
@@ -29,52 +29,83 @@ uint32_t getHalfCeil(uint32_t n)
     return ((n + 1) >> 1);
 }
 
-NalReader::NalReader(const uint8_t *pdata, uint32_t size)
-    : BitReader(pdata, size)
-    , m_epb(0)
-{
-}
-
-inline bool NalReader::isEmulationBytes(const uint8_t *p) const
+uint32_t EpbStrippingPolicy::loadSlow(const uint8_t* stream, const uint8_t* p,
+    uint32_t nbytes, unsigned long int& cache)
 {
-    return *p == 0x03
-            && (p - m_stream) >= 2
-            && *(p - 1) == 0x00 && *(p - 2) == 0x00;
-}
-
-void NalReader::loadDataToCache(uint32_t nbytes)
-{
-    const uint8_t *pStart = m_stream + m_loadBytes;
     /*the numbers of emulation prevention three byte in current load block*/
     uint32_t epb = 0;
 
     unsigned long int tmp = 0;
     for (uint32_t i = 0; i < nbytes; i++) {
-        if(!isEmulationBytes(pStart + i)) {
+        if (!isEmulationBytes(stream, p + i)) {
             tmp <<= 8;
-            tmp |= pStart[i];
+            tmp |= p[i];
         } else {
             epb++;
         }
     }
-    m_cache = tmp;
-    m_loadBytes += nbytes;
-    m_bitsInCache = (nbytes - epb) << 3;
-    m_epb += epb;
+    cache = tmp;
+    return nbytes - epb;
 }
 
-/*according to 9.1 of h264 spec*/
-bool NalReader::readUe(uint32_t& v)
+bool EpbStrippingPolicy::skip(const uint8_t* stream, uint32_t size, uint32_t& offset,
+    uint32_t nbytes, uint32_t& dropped)
 {
-    int32_t leadingZeroBits = -1;
-
-    for (uint32_t b = 0; !b; leadingZeroBits++) {
-        if (!read(b, 1))
+    while (nbytes) {
+        if (offset >= size)
             return false;
+        /*jump over the blocks without 0x03*/
+        if (nbytes >= 8 && size - offset >= 8
+            && !mayHaveEmulationBytes(stream + offset, 8)) {
+            offset += 8;
+            nbytes -= 8;
+            continue;
+        }
+        if (isEmulationBytes(stream, stream + offset))
+            dropped++;
+        else
+            nbytes--;
+        offset++;
     }
+    return true;
+}
+
+template class BitReaderT<EpbStrippingPolicy>;
+
+NalReader::NalReader(const uint8_t *pdata, uint32_t size)
+    : BitReaderT<EpbStrippingPolicy>(pdata, size)
+    , m_stopByte(0)
+    , m_stopByteSearched(false)
+{
+}
+
+bool NalReader::readUeSlow(uint32_t& v)
+{
+    uint32_t leadingZeroBits = 0;
+
+    /*the leading zeros may cross the cache boundary*/
+    while (true) {
+        if (!m_bitsInCache) {
+            reload();
+            if (!m_bitsInCache)
+                return false;
+        }
+        uint64_t bits = static_cast<uint64_t>(m_cache) << (64 - m_bitsInCache);
+        if (bits) {
+            uint32_t zeros = __builtin_clzll(bits);
+            leadingZeroBits += zeros;
+            /*eat the zeros and the one*/
+            m_bitsInCache -= zeros + 1;
+            break;
+        }
+        leadingZeroBits += m_bitsInCache;
+        m_bitsInCache = 0;
+    }
+    if (leadingZeroBits > 31)
+        return false;
     if (!read(v, leadingZeroBits))
         return false;
-    v = (1 << leadingZeroBits) - 1 + v;
+    v = (1u << leadingZeroBits) - 1 + v;
     return true;
 }
 
@@ -105,29 +136,52 @@ int32_t NalReader::readSe()
     return res;
 }
 
+void NalReader::searchStopByte() const
+{
+    /*only zero bytes(rbsp_alignment_zero_bit, cabac_zero_word) and
+      emulation prevention bytes can follow the stop bit*/
+    m_stopByte = m_size;
+    for (uint32_t i = m_size; i > 0; i--) {
+        const uint8_t* p = m_stream + i - 1;
+        if (*p && !isEmulationBytes(p)) {
+            m_stopByte = i - 1;
+            break;
+        }
+    }
+    m_stopByteSearched = true;
+}
+
 bool NalReader::moreRbspData() const
 {
-    BitReader tmp(*this);
-    uint32_t remainingBits = (m_size << 3) - ((m_loadBytes << 3) - m_bitsInCache);
-    if(remainingBits == 0)
-        return false;
+    if (!m_stopByteSearched)
+        searchStopByte();
 
-    /* If next bit is equal to 0, that means there is more data in RBSP before the
-     * rbsp_trailing_bits() syntax structure.
-     * If next bit is equal to 1 and existing another one bit equal to 1 in the
-     * remaining bits means more data, otherwise means no more data.
-     */
-    uint8_t nextBit = tmp.read(1);
-    if(nextBit == 0)
-        return true;
+    /* no stop bit, all remaining bits are zero */
+    if (m_stopByte == m_size)
+        return m_bitsInCache || m_loadBytes < m_size;
 
-    while(--remainingBits) {
-        nextBit = tmp.read(1);
-        if(nextBit)
+    /* stop bit is not in cache yet */
+    if (m_loadBytes <= m_stopByte) {
+        if (m_bitsInCache)
             return true;
+        /* the next bit is in the first byte not being emulation prevention
+         * byte, it's the stop bit only if that is the stop byte and 0x80 */
+        uint32_t i = m_loadBytes;
+        while (i < m_stopByte && isEmulationBytes(m_stream + i))
+            i++;
+        return i < m_stopByte || m_stream[m_stopByte] != 0x80;
     }
 
-    return false;
+    /* The stop bit is the last one bit in the cache. The cache only holds
+     * the last few bytes, so counting the bits after it is cheap.
+     * If the next bit is before the stop bit, we have more data.
+     */
+    uint32_t bitsAfterStopBit = __builtin_ctz(m_stream[m_stopByte]);
+    for (uint32_t i = m_stopByte + 1; i < m_loadBytes; i++) {
+        if (!isEmulationBytes(m_stream + i))
+            bitsAfterStopBit += 8;
+    }
+    return m_bitsInCache > bitsAfterStopBit + 1;
 }
 
 void NalReader::rbspTrailingBits()
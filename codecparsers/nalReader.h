@@ -20,15 +20,55 @@
 #include "common/log.h"
 #include "bitReader.h"
 
+#include <string.h>
+
 namespace YamiParser {
 
-class NalReader : public BitReader
+/* strip emulation prevention bytes(00 00 03) while loading */
+struct EpbStrippingPolicy {
+    static inline bool isEmulationBytes(const uint8_t* stream, const uint8_t* p)
+    {
+        return *p == 0x03
+            && (p - stream) >= 2
+            && *(p - 1) == 0x00 && *(p - 2) == 0x00;
+    }
+
+    /*an emulation prevention byte is a 0x03, if we have no 0x03 in the
+      next nbytes, we can load them as they are*/
+    static inline bool mayHaveEmulationBytes(const uint8_t* p, uint32_t nbytes)
+    {
+        if (nbytes == sizeof(uint64_t)) {
+            uint64_t v;
+            memcpy(&v, p, sizeof(v));
+            /*a byte of v ^ 0x0303... is zero only if it was 0x03*/
+            v ^= 0x0303030303030303ULL;
+            return (v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL;
+        }
+        return memchr(p, 0x03, nbytes) != NULL;
+    }
+
+    static inline uint32_t load(const uint8_t* stream, const uint8_t* p,
+        uint32_t nbytes, unsigned long int& cache)
+    {
+        if (!mayHaveEmulationBytes(p, nbytes))
+            return RawBytePolicy::load(stream, p, nbytes, cache);
+        return loadSlow(stream, p, nbytes, cache);
+    }
+
+    static uint32_t loadSlow(const uint8_t* stream, const uint8_t* p,
+        uint32_t nbytes, unsigned long int& cache);
+
+    static bool skip(const uint8_t* stream, uint32_t size, uint32_t& offset,
+        uint32_t nbytes, uint32_t& dropped);
+};
+
+class NalReader : public BitReaderT<EpbStrippingPolicy>
 {
 public:
     NalReader(const uint8_t *data, uint32_t size);
 
     /*parse Exp-Golomb coding*/
-    bool readUe(uint32_t& v);
+    inline bool readUe(uint32_t& v);
     inline bool readUe(uint8_t& v);
     inline bool readUe(uint16_t& v);
     uint32_t readUe();
@@ -39,14 +79,42 @@ public:
 
     bool moreRbspData() const;
     void rbspTrailingBits();
-    uint32_t getEpbCnt() { return m_epb; }
+    uint32_t getEpbCnt() { return m_droppedBytes; }
 private:
-    void loadDataToCache(uint32_t nbytes);
-    inline bool isEmulationBytes(const uint8_t *p) const;
+    inline bool isEmulationBytes(const uint8_t *p) const
+    {
+        return EpbStrippingPolicy::isEmulationBytes(m_stream, p);
+    }
+    /*find the byte holding rbsp_stop_one_bit, m_size if there is none*/
+    void searchStopByte() const;
+    /*readUe for the codeword which is not entirely in cache*/
+    bool readUeSlow(uint32_t& v);
 
-    uint32_t m_epb; /*the number of emulation prevention bytes*/
+    /*byte index of the rbsp_stop_one_bit, searched on first moreRbspData()*/
+    mutable uint32_t m_stopByte;
+    mutable bool m_stopByteSearched;
 };
 
+/*according to 9.1 of h264 spec, the codeword is leadingZeroBits zeros,
+  a one and leadingZeroBits info bits, so it equals codeNum + 1*/
+bool NalReader::readUe(uint32_t& v)
+{
+    if (m_bitsInCache) {
+        /*move the unread bits in cache to msb*/
+        uint64_t bits = static_cast<uint64_t>(m_cache) << (64 - m_bitsInCache);
+        if (bits) {
+            uint32_t leadingZeroBits = __builtin_clzll(bits);
+            uint32_t len = (leadingZeroBits << 1) + 1;
+            if (len <= m_bitsInCache) {
+                v = static_cast<uint32_t>((bits >> (64 - len)) - 1);
+                m_bitsInCache -= len;
+                return true;
+            }
+        }
+    }
+    return readUeSlow(v);
+}
+
 bool NalReader::readUe(uint8_t& v)
 {
     uint32_t tmp;
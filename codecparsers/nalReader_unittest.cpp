@@ -24,10 +24,62 @@
 // library headers
 #include "common/unittest.h"
 
+// system libraries
+#include <stdlib.h>
+#include <vector>
+
 namespace YamiParser {
 
 class NalReaderTest
     : public ::testing::Test {
+protected:
+    /*the bit by bit readUe we had before, used as reference*/
+    static bool refReadUe(NalReader& reader, uint32_t& v)
+    {
+        int32_t leadingZeroBits = -1;
+
+        for (uint32_t b = 0; !b; leadingZeroBits++) {
+            if (!reader.read(b, 1))
+                return false;
+        }
+        /*codeNum does not fit in 32 bits, the old code had undefined
+          behavior here*/
+        if (leadingZeroBits > 31)
+            return false;
+        if (!reader.read(v, leadingZeroBits))
+            return false;
+        v = (1 << leadingZeroBits) - 1 + v;
+        return true;
+    }
+
+    static bool refReadSe(NalReader& reader, int32_t& v)
+    {
+        uint32_t codeNum;
+        if (!refReadUe(reader, codeNum))
+            return false;
+        int32_t ceil = (codeNum + 1) >> 1;
+        v = (codeNum & 1) ? ceil : -ceil;
+        return true;
+    }
+
+    /*random data with plenty of zeros, so long codewords and
+      emulation prevention bytes show up*/
+    static void fillRandom(std::vector<uint8_t>& data)
+    {
+        for (size_t i = 0; i < data.size(); i++) {
+            switch (rand() % 4) {
+            case 0:
+                data[i] = 0;
+                break;
+            case 1:
+                data[i] = 3;
+                break;
+            default:
+                data[i] = rand() % 256;
+                break;
+            }
+        }
+    }
 };
 
 #define NALREADER_TEST(name) \
@@ -55,4 +107,214 @@ NALREADER_TEST(ReadBeyondBoundary)
     EXPECT_EQ(0, reader.readSe());
 }
 
+NALREADER_TEST(ReadUeMatchesBitByBit)
+{
+    std::vector<uint8_t> data(512);
+
+    srand(0x1234);
+    for (int round = 0; round < 200; round++) {
+        fillRandom(data);
+        NalReader reader(&data[0], data.size());
+        NalReader ref(&data[0], data.size());
+
+        while (!ref.end()) {
+            uint32_t u = 0, refU = 0;
+            int32_t s = 0, refS = 0;
+            bool ret, refRet;
+            switch (rand() % 3) {
+            case 0:
+                refRet = refReadUe(ref, refU);
+                ret = reader.readUe(u);
+                EXPECT_EQ(refU, u);
+                break;
+            case 1:
+                refRet = refReadSe(ref, refS);
+                ret = reader.readSe(s);
+                EXPECT_EQ(refS, s);
+                break;
+            default: {
+                uint32_t nbits = rand() % 33;
+                refRet = ref.read(refU, nbits);
+                ret = reader.read(u, nbits);
+                EXPECT_EQ(refU, u);
+                break;
+            }
+            }
+            ASSERT_EQ(refRet, ret);
+            ASSERT_EQ(ref.getPos(), reader.getPos());
+            ASSERT_EQ(ref.getEpbCnt(), reader.getEpbCnt());
+        }
+        EXPECT_TRUE(reader.end());
+    }
+}
+
+NALREADER_TEST(ReadUeLongCodeword)
+{
+    /*codeNum = 2^31 - 1 + 0x7654321 crossing a cache boundary:
+      31 zeros, a one, then 31 info bits, starting at bit 20*/
+    const uint8_t data[] = {
+        0xff, 0xff, 0xf0, 0x00, 0x00, 0x00, 0x10, 0xec,
+        0xa8, 0x64, 0x20
+    };
+    NalReader reader(data, sizeof(data));
+    uint8_t u8 = 0;
+    uint16_t u16 = 0;
+    uint32_t u = 0;
+
+    EXPECT_EQ(0xfffffu, reader.read(20));
+    EXPECT_TRUE(reader.readUe(u));
+    EXPECT_EQ(0x7fffffffu + 0x7654321, u);
+    EXPECT_EQ(83u, reader.getPos());
+
+    /*1, 010, 011 as ue(v) = 0, 1, 2 in the narrow versions*/
+    const uint8_t small[] = { 0xa6, 0x00 };
+    NalReader narrow(small, sizeof(small));
+    EXPECT_TRUE(narrow.readUe(u8));
+    EXPECT_EQ(0u, u8);
+    EXPECT_TRUE(narrow.readUe(u16));
+    EXPECT_EQ(1u, u16);
+    int8_t s8 = 0;
+    EXPECT_TRUE(narrow.readSe(s8));
+    EXPECT_EQ(-1, s8);
+}
+
+NALREADER_TEST(EmulationPreventionBytes)
+{
+    std::vector<uint8_t> data(333);
+
+    srand(0x4321);
+    for (int round = 0; round < 200; round++) {
+        fillRandom(data);
+
+        /*strip the emulation prevention bytes by hand*/
+        std::vector<uint8_t> rbsp;
+        for (size_t i = 0; i < data.size(); i++) {
+            if (i >= 2 && data[i] == 0x03 && !data[i - 1] && !data[i - 2])
+                continue;
+            rbsp.push_back(data[i]);
+        }
+        uint32_t epb = data.size() - rbsp.size();
+
+        NalReader reader(&data[0], data.size());
+        BitReader ref(&rbsp[0], rbsp.size());
+        while (!ref.end()) {
+            uint32_t nbits = rand() % 33;
+            uint32_t v = 0, refV = 0;
+            bool ret = ref.read(refV, nbits);
+            ASSERT_EQ(ret, reader.read(v, nbits));
+            /*the position after a failed read depends on the cache size*/
+            if (!ret)
+                break;
+            ASSERT_EQ(refV, v);
+            /*slice data offset depends on this*/
+            ASSERT_EQ(ref.getPos(), reader.getPos() - (reader.getEpbCnt() << 3));
+        }
+        EXPECT_EQ(epb, reader.getEpbCnt());
+    }
+}
+
+NALREADER_TEST(MoreRbspData)
+{
+    std::vector<uint8_t> data;
+
+    srand(0x8888);
+    for (int round = 0; round < 500; round++) {
+        data.resize(1 + rand() % 40);
+        fillRandom(data);
+        /*rbsp trailing bits, cabac_zero_words sometimes*/
+        data.back() = 0x80 >> (rand() % 8) | (rand() % 2);
+        if (rand() % 2) {
+            for (int n = rand() % 4; n >= 0; n--) {
+                data.push_back(0x00);
+                data.push_back(0x00);
+                data.push_back(0x03);
+            }
+        }
+
+        /*the last one bit of the stripped data is the stop bit*/
+        std::vector<uint8_t> rbsp;
+        for (size_t i = 0; i < data.size(); i++) {
+            if (i >= 2 && data[i] == 0x03 && !data[i - 1] && !data[i - 2])
+                continue;
+            rbsp.push_back(data[i]);
+        }
+        uint32_t stopBit = 0;
+        for (uint32_t i = 0; i < rbsp.size() << 3; i++) {
+            if (rbsp[i >> 3] & (0x80 >> (i & 7)))
+                stopBit = i;
+        }
+
+        NalReader reader(&data[0], data.size());
+        while (true) {
+            uint32_t pos = reader.getPos() - (reader.getEpbCnt() << 3);
+            ASSERT_EQ(pos < stopBit, reader.moreRbspData());
+            if (pos >= stopBit)
+                break;
+            uint32_t v;
+            ASSERT_TRUE(reader.read(v, 1 + rand() % std::min(16u, stopBit - pos)));
+        }
+    }
+}
+
+NALREADER_TEST(MoreRbspDataTrailingZeros)
+{
+    /*ue(v) 2, the stop bit, then a cabac_zero_word*/
+    const uint8_t pps[] = { 0x70, 0x00, 0x00, 0x03 };
+    NalReader reader(pps, sizeof(pps));
+
+    EXPECT_TRUE(reader.moreRbspData());
+    EXPECT_EQ(2u, reader.readUe());
+    EXPECT_FALSE(reader.moreRbspData());
+    reader.rbspTrailingBits();
+    EXPECT_FALSE(reader.moreRbspData());
+
+    /*an emulation prevention byte just before the stop byte*/
+    const uint8_t epb[] = { 0x00, 0x00, 0x03, 0x80 };
+    NalReader epbReader(epb, sizeof(epb));
+    EXPECT_TRUE(epbReader.moreRbspData());
+    EXPECT_EQ(0u, epbReader.read(16));
+    EXPECT_FALSE(epbReader.moreRbspData());
+
+    const uint8_t zeros[] = { 0x00, 0x00 };
+    NalReader zeroReader(zeros, sizeof(zeros));
+    EXPECT_TRUE(zeroReader.moreRbspData());
+    zeroReader.skip(16);
+    EXPECT_FALSE(zeroReader.moreRbspData());
+}
+
+NALREADER_TEST(PeekAndSkipEmulationPreventionBytes)
+{
+    std::vector<uint8_t> data(400);
+
+    srand(0x600d);
+    for (int round = 0; round < 200; round++) {
+        fillRandom(data);
+        NalReader reader(&data[0], data.size());
+        NalReader ref(&data[0], data.size());
+        while (true) {
+            uint32_t nbits = rand() % 33;
+            uint32_t peeked, refV;
+            if (rand() % 2) {
+                bool ok = reader.peek(peeked, nbits);
+                ASSERT_EQ(ok, ref.read(refV, nbits));
+                if (!ok)
+                    break;
+                ASSERT_EQ(refV, peeked);
+                ASSERT_TRUE(reader.skip(nbits));
+            } else {
+                nbits = rand() % 200;
+                bool ok = true;
+                for (uint32_t n = nbits; n && ok; n -= std::min(n, 32u))
+                    ok = ref.read(refV, std::min(n, 32u));
+                ASSERT_EQ(ok, reader.skip(nbits));
+                if (!ok)
+                    break;
+            }
+            /*the cache may cover different bytes, but rbsp position is same*/
+            ASSERT_EQ(ref.getPos() - (ref.getEpbCnt() << 3),
+                reader.getPos() - (reader.getEpbCnt() << 3));
+        }
+    }
+}
+
 } // namespace YamiParser
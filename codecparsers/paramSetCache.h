@@ -0,0 +1,98 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef paramSetCache_h
+#define paramSetCache_h
+
+#include "VideoCommonDefs.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace YamiParser {
+
+/* Streams often repeat the same parameter sets before every key frame.
+ * ParamSetCache keeps the bytes of each parameter set we parsed, by id,
+ * so the parser can give out the parsed one again when the bytes match.
+ * The id comes early in the nal, the parser reads it and only the bytes
+ * of that one slot are compared.
+ */
+template <class T>
+class ParamSetCache {
+public:
+    ParamSetCache()
+        : m_hits(0)
+        , m_misses(0)
+    {
+    }
+
+    /* return the parameter set with id parsed from the same bytes, or null */
+    SharedPtr<T> find(uint32_t id, const uint8_t* data, uint32_t size)
+    {
+        if (id < m_entries.size()) {
+            const Entry& e = m_entries[id];
+            size = trimTrailingZeros(data, size);
+            if (e.paramSet && e.bytes.size() == size
+                && (!size || !memcmp(&e.bytes[0], data, size))) {
+                m_hits++;
+                return e.paramSet;
+            }
+        }
+        m_misses++;
+        return SharedPtr<T>();
+    }
+
+    /* paramSet was parsed from data, it replaces the one with same id */
+    void add(uint32_t id, const uint8_t* data, uint32_t size, const SharedPtr<T>& paramSet)
+    {
+        size = trimTrailingZeros(data, size);
+        if (id >= m_entries.size())
+            m_entries.resize(id + 1);
+        Entry& e = m_entries[id];
+        e.bytes.assign(data, data + size);
+        e.paramSet = paramSet;
+    }
+
+    /* parameter sets depend on an updated one need parsing again */
+    void clear() { m_entries.clear(); }
+
+    uint32_t hits() const { return m_hits; }
+    uint32_t misses() const { return m_misses; }
+
+private:
+    struct Entry {
+        std::vector<uint8_t> bytes;
+        SharedPtr<T> paramSet;
+    };
+
+    /* trailing_zero_8bits may differ between copies of the same nal */
+    static uint32_t trimTrailingZeros(const uint8_t* data, uint32_t size)
+    {
+        while (size && !data[size - 1])
+            size--;
+        return size;
+    }
+
+    /* indexed by id */
+    std::vector<Entry> m_entries;
+    uint32_t m_hits;
+    uint32_t m_misses;
+};
+
+} /*namespace YamiParser*/
+
+#endif
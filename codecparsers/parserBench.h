@@ -0,0 +1,59 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef parserBench_h
+#define parserBench_h
+
+#include "bitWriter.h"
+#include "common/factory.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace YamiParser {
+
+/* One case of the parser throughput suite.
+ * setUp() generates the stream once, run() parses all of it once and
+ * returns what it went through. The runner calls run() until the time is
+ * up and reports MB/s and ns per unit. Cases register themselves with
+ * ParserBenchFactory, keyed by the name used in reports and baselines. */
+class ParserBench {
+public:
+    virtual ~ParserBench() {}
+
+    /* what one unit is: "nal", "frame", "header"... */
+    virtual const char* unit() const = 0;
+
+    /* build the stream, return false if it can't be parsed */
+    virtual bool setUp() = 0;
+
+    /* parse the stream once, add the bytes and units parsed.
+     * return false if anything failed to parse */
+    virtual bool run(uint64_t& bytes, uint64_t& units) = 0;
+};
+
+typedef Factory<ParserBench> ParserBenchFactory;
+
+/* 00 00 01 and the nal in bw, rbsp trailing bits are added */
+void appendNal(std::vector<uint8_t>& stream, BitWriter& bw);
+
+/* random bytes, like entropy coded data. Write them after
+ * enableEmulationPrevention() if the codec needs it */
+void writePayload(BitWriter& bw, uint32_t bytes);
+
+} /*namespace YamiParser*/
+
+#endif
@@ -0,0 +1,289 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "parserBench.h"
+
+// system libraries
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+
+namespace YamiParser {
+
+void appendNal(std::vector<uint8_t>& stream, BitWriter& bw)
+{
+    static const uint8_t startCode[] = { 0, 0, 1 };
+    bw.writeBits(1, 1); //rbsp_stop_one_bit
+    bw.writeToBytesAligned();
+    const uint8_t* data = bw.getBitWriterData();
+    stream.insert(stream.end(), startCode, startCode + sizeof(startCode));
+    stream.insert(stream.end(), data, data + bw.getCodedBitsCount() / 8);
+}
+
+void writePayload(BitWriter& bw, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++)
+        bw.writeBits(rand() % 256, 8);
+}
+
+} /*namespace YamiParser*/
+
+using namespace YamiParser;
+
+namespace {
+
+/* rounds per case, the best one is reported */
+const uint32_t ROUNDS = 5;
+
+struct Result {
+    std::string name;
+    std::string unit;
+    double mbPerSecond;
+    double nsPerUnit;
+};
+
+typedef std::map<std::string, double> Baseline;
+
+uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void usage(const char* app)
+{
+    printf("usage: %s [options]\n", app);
+    printf("   --list             list the cases\n");
+    printf("   --filter <text>    only run the cases with text in the name\n");
+    printf("   --time <ms>        time per case, default 500\n");
+    printf("   --json             print the results as json\n");
+    printf("   --baseline <file>  compare to the json output of an earlier run\n");
+    printf("   --threshold <pct>  ns per unit slower than this is a regression, default 10\n");
+}
+
+bool measure(const std::string& name, uint64_t budgetNs, Result& result)
+{
+    ParserBench* bench = ParserBenchFactory::create(name);
+    if (!bench)
+        return false;
+    bool ok = bench->setUp();
+    uint64_t bytes = 0, units = 0;
+    /*warm up, and make sure the stream parses*/
+    if (ok)
+        ok = bench->run(bytes, units);
+    if (ok && (!bytes || !units)) {
+        fprintf(stderr, "%s: nothing parsed\n", name.c_str());
+        ok = false;
+    }
+
+    double best = 0;
+    uint64_t bestUnits = 0;
+    uint64_t bestBytes = 0;
+    for (uint32_t r = 0; ok && r < ROUNDS; r++) {
+        bytes = units = 0;
+        uint64_t start = nowNs();
+        uint64_t ns;
+        do {
+            ok = bench->run(bytes, units);
+            ns = nowNs() - start;
+        } while (ok && ns < budgetNs / ROUNDS);
+        /*keep the fastest round, it has the least noise*/
+        if (!best || ns * bestBytes < best * bytes) {
+            best = ns;
+            bestUnits = units;
+            bestBytes = bytes;
+        }
+    }
+    result.unit = bench->unit();
+    delete bench;
+    if (!ok) {
+        fprintf(stderr, "%s: parse failed\n", name.c_str());
+        return false;
+    }
+
+    result.name = name;
+    /*bytes per ns * 1000 = MB/s*/
+    result.mbPerSecond = bestBytes * 1000 / best;
+    result.nsPerUnit = best / bestUnits;
+    return true;
+}
+
+/* read the lines written by printJson(), one case per line */
+bool loadBaseline(const char* path, Baseline& baseline)
+{
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "can't open baseline %s\n", path);
+        return false;
+    }
+    char line[1024];
+    while (fgets(line, sizeof(line), fp)) {
+        char name[256];
+        const char* ns = strstr(line, "\"ns_per_unit\":");
+        if (sscanf(line, " { \"name\": \"%255[^\"]\"", name) != 1 || !ns)
+            continue;
+        baseline[name] = atof(ns + strlen("\"ns_per_unit\":"));
+    }
+    fclose(fp);
+    if (baseline.empty()) {
+        fprintf(stderr, "no result in baseline %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+/* ns per unit change to the baseline in percent, false if it's a new case */
+bool compareToBaseline(const Result& r, const Baseline& baseline, double& base, double& change)
+{
+    Baseline::const_iterator it = baseline.find(r.name);
+    if (it == baseline.end())
+        return false;
+    base = it->second;
+    change = (r.nsPerUnit / base - 1) * 100;
+    return true;
+}
+
+void printJson(const std::vector<Result>& results)
+{
+    printf("{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        printf("    { \"name\": \"%s\", \"unit\": \"%s\", \"mb_per_s\": %.2f, \"ns_per_unit\": %.2f }%s\n",
+            r.name.c_str(), r.unit.c_str(), r.mbPerSecond, r.nsPerUnit,
+            i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+/* return the number of regressions */
+uint32_t printTable(const std::vector<Result>& results, const Baseline& baseline, double threshold)
+{
+    uint32_t regressions = 0;
+    bool compare = !baseline.empty();
+    printf("%-16s %8s %12s %12s", "case", "unit", "MB/s", "ns/unit");
+    if (compare)
+        printf(" %12s %9s", "base ns/unit", "change");
+    printf("\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        printf("%-16s %8s %12.1f %12.1f", r.name.c_str(), r.unit.c_str(), r.mbPerSecond, r.nsPerUnit);
+        double base, change;
+        if (compare) {
+            if (!compareToBaseline(r, baseline, base, change)) {
+                printf(" %12s %9s", "-", "new");
+            }
+            else {
+                printf(" %12.1f %+8.1f%%", base, change);
+                if (change > threshold) {
+                    printf("  REGRESSION");
+                    regressions++;
+                }
+            }
+        }
+        printf("\n");
+    }
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* filter = NULL;
+    const char* baselinePath = NULL;
+    uint64_t timeMs = 500;
+    double threshold = 10;
+    bool json = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(arg, "--list")) {
+            ParserBenchFactory::Keys keys = ParserBenchFactory::keys();
+            for (size_t k = 0; k < keys.size(); k++)
+                printf("%s\n", keys[k].c_str());
+            return 0;
+        }
+        else if (!strcmp(arg, "--json")) {
+            json = true;
+        }
+        else if (!strcmp(arg, "--filter") && hasValue) {
+            filter = argv[++i];
+        }
+        else if (!strcmp(arg, "--time") && hasValue) {
+            timeMs = strtoul(argv[++i], NULL, 0);
+        }
+        else if (!strcmp(arg, "--baseline") && hasValue) {
+            baselinePath = argv[++i];
+        }
+        else if (!strcmp(arg, "--threshold") && hasValue) {
+            threshold = atof(argv[++i]);
+        }
+        else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    Baseline baseline;
+    if (baselinePath && !loadBaseline(baselinePath, baseline))
+        return -1;
+
+    /*same stream for every run*/
+    srand(0);
+    std::vector<Result> results;
+    bool failed = false;
+    ParserBenchFactory::Keys keys = ParserBenchFactory::keys();
+    for (size_t k = 0; k < keys.size(); k++) {
+        if (filter && keys[k].find(filter) == std::string::npos)
+            continue;
+        Result result;
+        if (measure(keys[k], timeMs * 1000000, result))
+            results.push_back(result);
+        else
+            failed = true;
+    }
+
+    uint32_t regressions = 0;
+    if (json)
+        printJson(results);
+    else
+        regressions = printTable(results, baseline, threshold);
+    if (json && !baseline.empty()) {
+        /*keep stdout valid json, the comparison goes to stderr*/
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            double base, change;
+            if (compareToBaseline(r, baseline, base, change) && change > threshold) {
+                fprintf(stderr, "%s regressed: %.1f ns/%s, baseline %.1f\n",
+                    r.name.c_str(), r.nsPerUnit, r.unit.c_str(), base);
+                regressions++;
+            }
+        }
+    }
+    if (regressions)
+        fprintf(stderr, "%u case(s) regressed more than %.1f%%\n", regressions, threshold);
+    return (failed || regressions) ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "seiParser.h"
+
+#include <string.h>
+
+#define READ(f)                             \
+    do {                                    \
+        if (!br.readT(f)) {                 \
+            ERROR("failed to read %s", #f); \
+            return false;                   \
+        }                                   \
+    } while (0)
+
+#define READ_BITS(f, bits)                              \
+    do {                                                \
+        if (!br.readT(f, bits)) {                       \
+            ERROR("failed to read %d to %s", bits, #f); \
+            return false;                               \
+        }                                               \
+    } while (0)
+
+namespace YamiParser {
+
+SeiReader::SeiReader(const uint8_t* data, uint32_t size)
+    : m_data(data)
+    , m_size(size)
+    , m_pos(0)
+    , m_zeros(0)
+{
+    /*drop the trailing zero bytes, the last byte left is the rbsp stop bit*/
+    while (m_size && !m_data[m_size - 1])
+        m_size--;
+}
+
+bool SeiReader::readByte(uint8_t& b)
+{
+    if (m_pos < m_size && m_zeros >= 2 && m_data[m_pos] == 0x03) {
+        m_pos++;
+        m_zeros = 0;
+    }
+    if (m_pos >= m_size)
+        return false;
+    b = m_data[m_pos++];
+    m_zeros = b ? 0 : m_zeros + 1;
+    return true;
+}
+
+bool SeiReader::skipBytes(uint32_t n)
+{
+    if (n > m_size - m_pos)
+        return false;
+    /*no 0x03 means no emulation prevention byte, we can jump over*/
+    if (!memchr(m_data + m_pos, 0x03, n)) {
+        m_pos += n;
+        uint32_t zeros = 0;
+        while (zeros < n && zeros < 2 && !m_data[m_pos - 1 - zeros])
+            zeros++;
+        m_zeros = (zeros == n) ? m_zeros + zeros : zeros;
+        return true;
+    }
+    uint8_t b;
+    while (n--) {
+        if (!readByte(b))
+            return false;
+    }
+    return true;
+}
+
+bool SeiReader::readFFCoded(uint32_t& v)
+{
+    uint8_t b;
+    v = 0;
+    do {
+        if (!readByte(b))
+            return false;
+        v += b;
+    } while (b == 0xff);
+    return true;
+}
+
+bool SeiReader::next(SeiMessage& message)
+{
+    /*only the byte with rbsp_stop_one_bit left*/
+    if (m_pos + 1 >= m_size)
+        return false;
+    if (!readFFCoded(message.payloadType) || !readFFCoded(message.payloadSize))
+        return false;
+    /*an emulation prevention byte right before the payload*/
+    if (m_pos < m_size && m_zeros >= 2 && m_data[m_pos] == 0x03) {
+        m_pos++;
+        m_zeros = 0;
+    }
+    uint32_t start = m_pos;
+    if (!skipBytes(message.payloadSize))
+        return false;
+    message.payload = m_data + start;
+    message.payloadBytes = m_pos - start;
+    return true;
+}
+
+bool parseMasteringDisplayColourVolume(SeiMasteringDisplayColourVolume* mdcv,
+    const SeiMessage& message)
+{
+    NalReader br(message.payload, message.payloadBytes);
+    for (uint32_t c = 0; c < 3; c++) {
+        READ(mdcv->display_primaries_x[c]);
+        READ(mdcv->display_primaries_y[c]);
+    }
+    READ(mdcv->white_point_x);
+    READ(mdcv->white_point_y);
+    READ(mdcv->max_display_mastering_luminance);
+    READ(mdcv->min_display_mastering_luminance);
+    return true;
+}
+
+bool parseContentLightLevelInfo(SeiContentLightLevelInfo* cll,
+    const SeiMessage& message)
+{
+    NalReader br(message.payload, message.payloadBytes);
+    READ(cll->max_content_light_level);
+    READ(cll->max_pic_average_light_level);
+    return true;
+}
+
+bool parseClockTimestamp(SeiClockTimestamp* ts, NalReader& br, uint32_t nFramesBits)
+{
+    READ_BITS(ts->counting_type, 5);
+    READ(ts->full_timestamp_flag);
+    READ(ts->discontinuity_flag);
+    READ(ts->cnt_dropped_flag);
+    READ_BITS(ts->n_frames, nFramesBits);
+    if (ts->full_timestamp_flag) {
+        ts->seconds_flag = ts->minutes_flag = ts->hours_flag = true;
+        READ_BITS(ts->seconds_value, 6);
+        READ_BITS(ts->minutes_value, 6);
+        READ_BITS(ts->hours_value, 5);
+        return true;
+    }
+    ts->minutes_flag = ts->hours_flag = false;
+    READ(ts->seconds_flag);
+    if (ts->seconds_flag) {
+        READ_BITS(ts->seconds_value, 6);
+        READ(ts->minutes_flag);
+        if (ts->minutes_flag) {
+            READ_BITS(ts->minutes_value, 6);
+            READ(ts->hours_flag);
+            if (ts->hours_flag)
+                READ_BITS(ts->hours_value, 5);
+        }
+    }
+    return true;
+}
+
+bool parseTimeOffset(SeiClockTimestamp* ts, NalReader& br)
+{
+    uint32_t len = ts->time_offset_length;
+    ts->time_offset_value = 0;
+    if (!len)
+        return true;
+    uint32_t v;
+    READ_BITS(v, len);
+    /*sign extend*/
+    if (len < 32 && (v >> (len - 1)))
+        v |= ~0u << len;
+    ts->time_offset_value = static_cast<int32_t>(v);
+    return true;
+}
+
+} /*namespace YamiParser*/
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef seiParser_h
+#define seiParser_h
+
+#include "nalReader.h"
+
+#include <stdint.h>
+
+namespace YamiParser {
+
+/* payloadType of Annex D, h264 and h265 use the same values */
+enum SeiPayloadType {
+    SEI_BUFFERING_PERIOD = 0,
+    SEI_PIC_TIMING = 1,
+    SEI_USER_DATA_REGISTERED_ITU_T_T35 = 4,
+    SEI_USER_DATA_UNREGISTERED = 5,
+    SEI_RECOVERY_POINT = 6,
+    SEI_TIME_CODE = 136, //h265 only
+    SEI_MASTERING_DISPLAY_COLOUR_VOLUME = 137,
+    SEI_CONTENT_LIGHT_LEVEL_INFO = 144,
+};
+
+/* one sei_message(), the payload is left in the nal unit as it is */
+struct SeiMessage {
+    uint32_t payloadType;
+    uint32_t payloadSize; //in rbsp bytes
+    const uint8_t* payload;
+    uint32_t payloadBytes; //payloadSize plus the emulation prevention bytes
+};
+
+/* Walks the sei_message()s of a sei rbsp. Only payload type and size are
+ * read, the payload is skipped over, so the messages nobody asked for cost
+ * a search for emulation prevention bytes at most. */
+class SeiReader {
+public:
+    /* data and size are the nal unit without its header */
+    SeiReader(const uint8_t* data, uint32_t size);
+
+    /* false at the rbsp trailing bits or on a truncated message */
+    bool next(SeiMessage& message);
+
+private:
+    /* the next rbsp byte, emulation prevention bytes are dropped */
+    inline bool readByte(uint8_t& b);
+    bool skipBytes(uint32_t n);
+    /* type and size are coded as a run of 0xff and a last byte */
+    bool readFFCoded(uint32_t& v);
+
+    const uint8_t* m_data;
+    uint32_t m_size;
+    uint32_t m_pos;
+    /* the zero bytes right before m_pos */
+    uint32_t m_zeros;
+};
+
+/* D.1.29 and D.2.28 */
+struct SeiMasteringDisplayColourVolume {
+    uint16_t display_primaries_x[3];
+    uint16_t display_primaries_y[3];
+    uint16_t white_point_x;
+    uint16_t white_point_y;
+    uint32_t max_display_mastering_luminance;
+    uint32_t min_display_mastering_luminance;
+};
+
+/* D.1.31 and D.2.35 */
+struct SeiContentLightLevelInfo {
+    uint16_t max_content_light_level;
+    uint16_t max_pic_average_light_level;
+};
+
+/* clock timestamp of h264 pic_timing and h265 time_code */
+struct SeiClockTimestamp {
+    uint8_t ct_type; //h264 only
+    bool units_field_based_flag;
+    uint8_t counting_type;
+    bool full_timestamp_flag;
+    bool discontinuity_flag;
+    bool cnt_dropped_flag;
+    uint16_t n_frames;
+    bool seconds_flag;
+    uint8_t seconds_value;
+    bool minutes_flag;
+    uint8_t minutes_value;
+    bool hours_flag;
+    uint8_t hours_value;
+    uint8_t time_offset_length;
+    int32_t time_offset_value;
+};
+
+bool parseMasteringDisplayColourVolume(SeiMasteringDisplayColourVolume* mdcv,
+    const SeiMessage& message);
+bool parseContentLightLevelInfo(SeiContentLightLevelInfo* cll,
+    const SeiMessage& message);
+
+/* from counting_type to the hours, the part h264 and h265 have in common.
+ * n_frames is 8 bits in h264 and 9 bits in h265 */
+bool parseClockTimestamp(SeiClockTimestamp* ts, NalReader& br, uint32_t nFramesBits);
+
+/* time_offset_value, a signed integer of time_offset_length bits */
+bool parseTimeOffset(SeiClockTimestamp* ts, NalReader& br);
+
+} /*namespace YamiParser*/
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "seiParser.h"
+
+// library headers
+#include "bitWriter.h"
+#include "common/unittest.h"
+
+namespace YamiParser {
+
+/* the payload of a message, with emulation prevention */
+static void writeMessage(BitWriter& bw, uint32_t type, const std::vector<uint8_t>& payload)
+{
+    for (; type >= 0xff; type -= 0xff)
+        bw.writeBits(0xff, 8);
+    bw.writeBits(type, 8);
+    uint32_t size = payload.size();
+    for (; size >= 0xff; size -= 0xff)
+        bw.writeBits(0xff, 8);
+    bw.writeBits(size, 8);
+    for (size_t i = 0; i < payload.size(); i++)
+        bw.writeBits(payload[i], 8);
+}
+
+static void writeTrailingBits(BitWriter& bw)
+{
+    bw.writeBits(1, 1);
+    bw.writeToBytesAligned();
+}
+
+TEST(SeiReaderTest, TypesAndSizes)
+{
+    BitWriter bw;
+    bw.enableEmulationPrevention();
+    writeMessage(bw, SEI_RECOVERY_POINT, std::vector<uint8_t>(3, 0x55));
+    writeMessage(bw, SEI_MASTERING_DISPLAY_COLOUR_VOLUME, std::vector<uint8_t>(300, 0x11));
+    writeMessage(bw, SEI_USER_DATA_UNREGISTERED, std::vector<uint8_t>());
+    writeTrailingBits(bw);
+    const uint8_t* data = bw.getBitWriterData();
+    uint32_t size = bw.getCodedBitsCount() / 8;
+
+    SeiReader reader(data, size);
+    SeiMessage message;
+    ASSERT_TRUE(reader.next(message));
+    EXPECT_EQ(SEI_RECOVERY_POINT, message.payloadType);
+    EXPECT_EQ(3u, message.payloadSize);
+    EXPECT_EQ(3u, message.payloadBytes);
+    EXPECT_EQ(data + 2, message.payload);
+    EXPECT_EQ(0x55, message.payload[0]);
+
+    ASSERT_TRUE(reader.next(message));
+    EXPECT_EQ(SEI_MASTERING_DISPLAY_COLOUR_VOLUME, message.payloadType);
+    EXPECT_EQ(300u, message.payloadSize);
+    EXPECT_EQ(300u, message.payloadBytes);
+
+    ASSERT_TRUE(reader.next(message));
+    EXPECT_EQ(SEI_USER_DATA_UNREGISTERED, message.payloadType);
+    EXPECT_EQ(0u, message.payloadSize);
+
+    EXPECT_FALSE(reader.next(message));
+}
+
+TEST(SeiReaderTest, EmulationPrevention)
+{
+    static const uint8_t zeros[] = { 0, 0, 0, 0, 1, 0, 0, 2 };
+    BitWriter bw;
+    bw.enableEmulationPrevention();
+    writeMessage(bw, SEI_USER_DATA_UNREGISTERED,
+        std::vector<uint8_t>(zeros, zeros + sizeof(zeros)));
+    writeMessage(bw, SEI_RECOVERY_POINT, std::vector<uint8_t>(1, 0x80));
+    writeTrailingBits(bw);
+    //cabac_zero_words after the rbsp
+    bw.writeBits(0, 16);
+    const uint8_t* data = bw.getBitWriterData();
+    uint32_t size = bw.getCodedBitsCount() / 8;
+
+    SeiReader reader(data, size);
+    SeiMessage message;
+    ASSERT_TRUE(reader.next(message));
+    EXPECT_EQ(SEI_USER_DATA_UNREGISTERED, message.payloadType);
+    EXPECT_EQ(sizeof(zeros), message.payloadSize);
+    //00 00 03 00 00 03 01 00 00 03 02
+    EXPECT_EQ(sizeof(zeros) + 3, message.payloadBytes);
+
+    ASSERT_TRUE(reader.next(message));
+    EXPECT_EQ(SEI_RECOVERY_POINT, message.payloadType);
+    EXPECT_EQ(1u, message.payloadSize);
+    EXPECT_EQ(0x80, message.payload[0]);
+
+    EXPECT_FALSE(reader.next(message));
+}
+
+TEST(SeiReaderTest, Truncated)
+{
+    BitWriter bw;
+    writeMessage(bw, SEI_RECOVERY_POINT, std::vector<uint8_t>(8, 0x55));
+    const uint8_t* data = bw.getBitWriterData();
+
+    SeiReader reader(data, 6);
+    SeiMessage message;
+    EXPECT_FALSE(reader.next(message));
+}
+
+TEST(SeiParserTest, MasteringDisplayAndLightLevel)
+{
+    BitWriter bw;
+    //bt.2020 primaries, in g, b, r order
+    bw.writeBits(8500, 16);
+    bw.writeBits(39850, 16);
+    bw.writeBits(6550, 16);
+    bw.writeBits(2300, 16);
+    bw.writeBits(35400, 16);
+    bw.writeBits(14600, 16);
+    bw.writeBits(15635, 16);
+    bw.writeBits(16450, 16);
+    bw.writeBits(10000000, 32);
+    bw.writeBits(50, 32);
+    bw.writeBits(1000, 16);
+    bw.writeBits(400, 16);
+    bw.writeToBytesAligned();
+
+    SeiMessage message;
+    message.payload = bw.getBitWriterData();
+    message.payloadBytes = bw.getCodedBitsCount() / 8;
+    SeiMasteringDisplayColourVolume mdcv;
+    ASSERT_TRUE(parseMasteringDisplayColourVolume(&mdcv, message));
+    EXPECT_EQ(8500, mdcv.display_primaries_x[0]);
+    EXPECT_EQ(39850, mdcv.display_primaries_y[0]);
+    EXPECT_EQ(35400, mdcv.display_primaries_x[2]);
+    EXPECT_EQ(14600, mdcv.display_primaries_y[2]);
+    EXPECT_EQ(15635, mdcv.white_point_x);
+    EXPECT_EQ(16450, mdcv.white_point_y);
+    EXPECT_EQ(10000000u, mdcv.max_display_mastering_luminance);
+    EXPECT_EQ(50u, mdcv.min_display_mastering_luminance);
+
+    message.payload += 24;
+    message.payloadBytes -= 24;
+    SeiContentLightLevelInfo cll;
+    ASSERT_TRUE(parseContentLightLevelInfo(&cll, message));
+    EXPECT_EQ(1000, cll.max_content_light_level);
+    EXPECT_EQ(400, cll.max_pic_average_light_level);
+
+    //too short
+    message.payloadBytes = 3;
+    EXPECT_FALSE(parseContentLightLevelInfo(&cll, message));
+}
+
+TEST(SeiParserTest, ClockTimestamp)
+{
+    BitWriter bw;
+    //full timestamp, 01:02:03 frame 4
+    bw.writeBits(4, 5); //counting_type
+    bw.writeBits(1, 1); //full_timestamp_flag
+    bw.writeBits(0, 1); //discontinuity_flag
+    bw.writeBits(1, 1); //cnt_dropped_flag
+    bw.writeBits(4, 9);
+    bw.writeBits(3, 6);
+    bw.writeBits(2, 6);
+    bw.writeBits(1, 5);
+    //seconds only, time offset -2 in 5 bits
+    bw.writeBits(0, 5);
+    bw.writeBits(0, 1);
+    bw.writeBits(1, 1);
+    bw.writeBits(0, 1);
+    bw.writeBits(25, 8);
+    bw.writeBits(1, 1); //seconds_flag
+    bw.writeBits(59, 6);
+    bw.writeBits(0, 1); //minutes_flag
+    bw.writeBits(0x1e, 5);
+    bw.writeToBytesAligned();
+
+    NalReader br(bw.getBitWriterData(), bw.getCodedBitsCount() / 8);
+    SeiClockTimestamp ts;
+    ASSERT_TRUE(parseClockTimestamp(&ts, br, 9));
+    EXPECT_EQ(4, ts.counting_type);
+    EXPECT_TRUE(ts.full_timestamp_flag);
+    EXPECT_TRUE(ts.cnt_dropped_flag);
+    EXPECT_TRUE(ts.hours_flag);
+    EXPECT_EQ(4, ts.n_frames);
+    EXPECT_EQ(3, ts.seconds_value);
+    EXPECT_EQ(2, ts.minutes_value);
+    EXPECT_EQ(1, ts.hours_value);
+
+    ASSERT_TRUE(parseClockTimestamp(&ts, br, 8));
+    EXPECT_FALSE(ts.full_timestamp_flag);
+    EXPECT_TRUE(ts.discontinuity_flag);
+    EXPECT_EQ(25, ts.n_frames);
+    EXPECT_TRUE(ts.seconds_flag);
+    EXPECT_EQ(59, ts.seconds_value);
+    EXPECT_FALSE(ts.minutes_flag);
+    EXPECT_FALSE(ts.hours_flag);
+    ts.time_offset_length = 5;
+    ASSERT_TRUE(parseTimeOffset(&ts, br));
+    EXPECT_EQ(-2, ts.time_offset_value);
+}
+
+} // namespace YamiParser
@@ -0,0 +1,250 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "h264Parser.h"
+
+// library headers
+#include "bitWriter.h"
+#include "common/workerpool.h"
+
+// system libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+using namespace YamiParser;
+using namespace YamiParser::H264;
+using YamiMediaCodec::WorkerPool;
+
+namespace {
+
+/* 1920x1088, one slice can be as small as one mb row */
+const uint32_t WIDTH_IN_MBS = 120;
+const uint32_t HEIGHT_IN_MBS = 68;
+const uint32_t NUM_REFS = 4;
+const uint32_t SLICE_DATA_BYTES = 512;
+
+uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+typedef std::vector<uint8_t> Nal;
+
+void beginNal(BitWriter& bw, uint8_t header)
+{
+    bw.writeBits(header, 8);
+    bw.enableEmulationPrevention();
+}
+
+void endNal(BitWriter& bw, Nal& nal)
+{
+    bw.writeBits(1, 1); //rbsp_stop_one_bit
+    bw.writeToBytesAligned();
+    const uint8_t* data = bw.getBitWriterData();
+    nal.assign(data, data + bw.getCodedBitsCount() / 8);
+}
+
+void writeSps(Nal& nal)
+{
+    BitWriter bw;
+    beginNal(bw, 0x67);
+    bw.writeBits(77, 8); //main profile
+    bw.writeBits(0, 8); //constraint flags and reserved_zero_2bits
+    bw.writeBits(40, 8); //level_idc
+    bw.writeUe(0); //sps_id
+    bw.writeUe(0); //log2_max_frame_num_minus4
+    bw.writeUe(0); //pic_order_cnt_type
+    bw.writeUe(2); //log2_max_pic_order_cnt_lsb_minus4
+    bw.writeUe(NUM_REFS);
+    bw.writeBits(0, 1); //gaps_in_frame_num_value_allowed_flag
+    bw.writeUe(WIDTH_IN_MBS - 1);
+    bw.writeUe(HEIGHT_IN_MBS - 1);
+    bw.writeBits(1, 1); //frame_mbs_only_flag
+    bw.writeBits(1, 1); //direct_8x8_inference_flag
+    bw.writeBits(0, 1); //frame_cropping_flag
+    bw.writeBits(0, 1); //vui_parameters_present_flag
+    endNal(bw, nal);
+}
+
+void writePps(Nal& nal)
+{
+    BitWriter bw;
+    beginNal(bw, 0x68);
+    bw.writeUe(0); //pps_id
+    bw.writeUe(0); //sps_id
+    bw.writeBits(0, 1); //entropy_coding_mode_flag
+    bw.writeBits(0, 1); //pic_order_present_flag
+    bw.writeUe(0); //num_slice_groups_minus1
+    bw.writeUe(0); //num_ref_idx_l0_active_minus1
+    bw.writeUe(0); //num_ref_idx_l1_active_minus1
+    bw.writeBits(1, 1); //weighted_pred_flag
+    bw.writeBits(0, 2); //weighted_bipred_idc
+    bw.writeSe(0); //pic_init_qp_minus26
+    bw.writeSe(0); //pic_init_qs_minus26
+    bw.writeSe(0); //chroma_qp_index_offset
+    bw.writeBits(1, 1); //deblocking_filter_control_present_flag
+    bw.writeBits(0, 1); //constrained_intra_pred_flag
+    bw.writeBits(0, 1); //redundant_pic_cnt_present_flag
+    endNal(bw, nal);
+}
+
+/* a weighted p slice, it has one of the longer headers */
+void writeSlice(Nal& nal, uint32_t firstMb, uint32_t frameNum)
+{
+    BitWriter bw;
+    beginNal(bw, 0x41);
+    bw.writeUe(firstMb);
+    bw.writeUe(5); //P, all slices of the picture are P
+    bw.writeUe(0); //pps_id
+    bw.writeBits(frameNum & 0xf, 4);
+    bw.writeBits((frameNum * 2) & 0x3f, 6); //pic_order_cnt_lsb
+    bw.writeBits(1, 1); //num_ref_idx_active_override_flag
+    bw.writeUe(NUM_REFS - 1);
+    bw.writeBits(1, 1); //ref_pic_list_modification_flag_l0
+    bw.writeUe(0); //modification_of_pic_nums_idc
+    bw.writeUe(0); //abs_diff_pic_num_minus1
+    bw.writeUe(3);
+    bw.writeUe(6); //luma_log2_weight_denom
+    bw.writeUe(6); //chroma_log2_weight_denom
+    for (uint32_t i = 0; i < NUM_REFS; i++) {
+        bw.writeBits(1, 1);
+        bw.writeSe(60 + i);
+        bw.writeSe(-3);
+        bw.writeBits(1, 1);
+        for (uint32_t j = 0; j < 2; j++) {
+            bw.writeSe(64 - i);
+            bw.writeSe(2);
+        }
+    }
+    bw.writeBits(0, 1); //adaptive_ref_pic_marking_mode_flag
+    bw.writeSe(2); //slice_qp_delta
+    bw.writeUe(0); //disable_deblocking_filter_idc
+    bw.writeSe(1);
+    bw.writeSe(-1);
+    for (uint32_t i = 0; i < SLICE_DATA_BYTES; i++)
+        bw.writeBits(rand() % 256, 8);
+    endNal(bw, nal);
+}
+
+struct Batch {
+    std::vector<NalUnit> nalus;
+    std::vector<SharedPtr<SliceHeader> > slices;
+    Parser* parser;
+    uint32_t failed;
+};
+
+bool parseOne(Batch& batch, uint32_t index)
+{
+    SharedPtr<SliceHeader>& slice = batch.slices[index];
+    slice.reset(new SliceHeader);
+    memset(slice.get(), 0, sizeof(SliceHeader));
+    return slice->parseHeader(batch.parser, &batch.nalus[index]);
+}
+
+/* same as VaapiDecoderH264::parseBatchedSlice */
+void parseJob(Batch& batch, uint32_t index)
+{
+    if (!parseOne(batch, index))
+        batch.slices[index].reset();
+}
+
+double serial(Batch& batch, uint32_t loops)
+{
+    uint64_t start = nowNs();
+    for (uint32_t l = 0; l < loops; l++) {
+        for (uint32_t i = 0; i < batch.nalus.size(); i++) {
+            if (!parseOne(batch, i))
+                batch.failed++;
+        }
+    }
+    return (double)(nowNs() - start) / loops / 1000;
+}
+
+double parallel(Batch& batch, WorkerPool& pool, uint32_t loops)
+{
+    WorkerPool::Job job = std::bind(parseJob, std::ref(batch), std::placeholders::_1);
+    uint64_t start = nowNs();
+    for (uint32_t l = 0; l < loops; l++) {
+        pool.run(job, batch.nalus.size());
+        for (uint32_t i = 0; i < batch.slices.size(); i++) {
+            if (!batch.slices[i])
+                batch.failed++;
+        }
+    }
+    return (double)(nowNs() - start) / loops / 1000;
+}
+
+} // namespace
+
+int main()
+{
+    static const uint32_t slicesPerPicture[] = { 1, 4, 8, 16, 34, 68 };
+    const uint32_t loops = 2000;
+
+    srand(0);
+    Parser parser;
+    Nal nal;
+    NalUnit nalu;
+    SharedPtr<SPS> sps;
+    SharedPtr<PPS> pps;
+    std::vector<Nal> paramSets(2);
+    writeSps(paramSets[0]);
+    writePps(paramSets[1]);
+    if (!nalu.parseNalUnit(&paramSets[0][0], paramSets[0].size())
+        || !parser.parseSps(sps, &nalu)
+        || !nalu.parseNalUnit(&paramSets[1][0], paramSets[1].size())
+        || !parser.parsePps(pps, &nalu)) {
+        fprintf(stderr, "parse parameter sets failed\n");
+        return -1;
+    }
+
+    WorkerPool pool(WorkerPool::suggestThreads(3));
+    printf("%u worker threads + the calling one\n", pool.getThreadCount());
+    printf("%8s %14s %14s %9s\n", "slices", "serial us/pic", "pool us/pic", "speedup");
+    for (size_t s = 0; s < sizeof(slicesPerPicture) / sizeof(slicesPerPicture[0]); s++) {
+        uint32_t count = slicesPerPicture[s];
+        uint32_t rows = HEIGHT_IN_MBS / count;
+        std::vector<Nal> nals(count);
+        Batch batch;
+        batch.parser = &parser;
+        batch.failed = 0;
+        batch.slices.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            writeSlice(nals[i], i * rows * WIDTH_IN_MBS, 1);
+            nalu.parseNalUnit(&nals[i][0], nals[i].size());
+            batch.nalus.push_back(nalu);
+        }
+
+        double serialUs = serial(batch, loops);
+        double poolUs = parallel(batch, pool, loops);
+        if (batch.failed) {
+            fprintf(stderr, "%u slices failed to parse\n", batch.failed);
+            return -1;
+        }
+        printf("%8u %14.2f %14.2f %8.2fx\n", count, serialUs, poolUs, serialUs / poolUs);
+    }
+    return 0;
+}
@@ -0,0 +1,853 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "streamIndex.h"
+
+#include "common/Functional.h"
+#include "common/log.h"
+#include "common/nalreader.h"
+#include "common/workerpool.h"
+#ifdef __BUILD_H264_DECODER__
+#include "h264Parser.h"
+#endif
+#ifdef __BUILD_H265_DECODER__
+#include "h265Parser.h"
+#endif
+#ifdef __BUILD_MPEG2_DECODER__
+#include "mpeg2_parser.h"
+#endif
+#ifdef __BUILD_VP8_DECODER__
+#include "vp8_parser.h"
+#endif
+#ifdef __BUILD_VP9_DECODER__
+#include "vp9parser.h"
+#endif
+
+#include <algorithm>
+#include <map>
+#include <string.h>
+
+namespace YamiParser {
+
+using YamiMediaCodec::findStartCode;
+using YamiMediaCodec::WorkerPool;
+using std::placeholders::_1;
+
+static const uint32_t DEFAULT_CHUNK_SIZE = 4 * 1024 * 1024;
+static const uint32_t START_CODE_SIZE = 3;
+static const uint32_t IVF_FILE_HEADER_SIZE = 32;
+static const uint32_t IVF_FRAME_HEADER_SIZE = 12;
+
+/* run of a chunk: no unit since last picture data */
+static const uint64_t NO_RUN = UINT64_MAX;
+/* run of a chunk: the run begins in the chunks before */
+static const uint64_t RUN_FROM_PREV = UINT64_MAX - 1;
+
+static const char INDEX_MAGIC[] = { 'Y', 'I', 'D', 'X' };
+static const uint8_t INDEX_VERSION = 1;
+
+/* picture_structure of mpeg2 */
+static const uint8_t MPEG2_BOTTOM_FIELD = 2;
+static const uint8_t MPEG2_FRAME_PICTURE = 3;
+
+/* a parameter set or a picture a chunk scan found, in stream order.
+ * pictures are the random access ones and the ones which may be fields */
+struct StreamIndex::Event {
+    bool isPicture;
+    bool randomAccess;
+    /* not in Chunk::frames, merge() counts it if it is not a second field */
+    bool mayBeField;
+    uint8_t type; //frame type or parameter set type
+    uint8_t id; //parameter set id, or mpeg2 picture_structure
+    /* picture: start of its run, NO_RUN or RUN_FROM_PREV. param set: data */
+    uint64_t offset;
+    /* picture: the unit begins the access unit. param set: data end */
+    uint64_t end;
+    /* picture: bytes of the unit at end, without start code */
+    uint32_t size;
+    /* frames counted before the picture in the chunk, ivf pts */
+    int64_t pts;
+};
+
+struct StreamIndex::Chunk {
+    std::vector<Event> events;
+    /* access units began in the chunk, but the ones which may be fields */
+    int64_t frames;
+    /* the units at chunk end not followed by picture data */
+    uint64_t trailingRun;
+    /* first unit of the chunk, if no picture data is before it */
+    uint64_t firstRun;
+};
+
+/* what a unit means for the index */
+struct UnitInfo {
+    enum Kind {
+        /* may begin an access unit, like sei or aud */
+        PREFIX,
+        /* belongs to current picture, like a slice */
+        PICTURE_DATA,
+        /* first unit of a picture */
+        PICTURE_START,
+        PARAM_SET,
+    };
+    Kind kind;
+    bool randomAccess;
+    bool mayBeField;
+    uint8_t type; //frame type or parameter set type
+    uint8_t id; //parameter set id, or mpeg2 picture_structure
+};
+
+/* what tells the second field of a pair */
+struct FieldPicture {
+    bool field;
+    bool bottom;
+    uint16_t frameNum;
+    bool idr;
+    uint32_t idrPicId;
+};
+
+/* h264 7.4.1.2.4 and mpeg2 6.1.1.4, the second field follows the first
+ * one with the other parity. h264 fields of a pair share frame_num, and
+ * idr_pic_id if the second one is an idr */
+static bool isSecondField(const FieldPicture& first, const FieldPicture& second)
+{
+    return first.field && second.field && first.bottom != second.bottom
+        && first.frameNum == second.frameNum
+        && (!second.idr || (first.idr && first.idrPicId == second.idrPicId));
+}
+
+static bool isSupported(StreamIndex::Codec codec)
+{
+    switch (codec) {
+#ifdef __BUILD_H264_DECODER__
+    case StreamIndex::CODEC_H264:
+        return true;
+#endif
+#ifdef __BUILD_H265_DECODER__
+    case StreamIndex::CODEC_H265:
+        return true;
+#endif
+#ifdef __BUILD_MPEG2_DECODER__
+    case StreamIndex::CODEC_MPEG2:
+        return true;
+#endif
+#ifdef __BUILD_VP8_DECODER__
+    case StreamIndex::CODEC_VP8:
+        return true;
+#endif
+#ifdef __BUILD_VP9_DECODER__
+    case StreamIndex::CODEC_VP9:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+#ifdef __BUILD_H264_DECODER__
+static bool classifyH264(const uint8_t* unit, uint32_t size, UnitInfo& info)
+{
+    H264::NalUnit nalu;
+    uint32_t v;
+    if (!nalu.parseNalUnit(unit, size))
+        return false;
+    info.randomAccess = false;
+    info.type = nalu.nal_unit_type;
+    switch (nalu.nal_unit_type) {
+    case H264::NAL_SLICE_NONIDR:
+    case H264::NAL_SLICE_DPA:
+    case H264::NAL_SLICE_IDR:
+        if (!H264::Parser::peekFirstMbInSlice(&nalu, v))
+            return false;
+        info.kind = v ? UnitInfo::PICTURE_DATA : UnitInfo::PICTURE_START;
+        info.randomAccess = nalu.m_idrPicFlag;
+        //the sps tells if it is a field, merge() has it
+        info.mayBeField = true;
+        info.type = StreamIndex::FRAME_IDR;
+        return true;
+    case H264::NAL_SLICE_DPB:
+    case H264::NAL_SLICE_DPC:
+    case H264::NAL_SEQ_END:
+    case H264::NAL_FILLER_DATA:
+    case H264::NAL_SLICE_AUX:
+    case H264::NAL_SLICE_EXT:
+        info.kind = UnitInfo::PICTURE_DATA;
+        return true;
+    case H264::NAL_SPS:
+        info.kind = UnitInfo::PARAM_SET;
+        if (!H264::Parser::peekSpsId(&nalu, v) || v > MAX_SPS_ID)
+            return false;
+        info.id = v;
+        return true;
+    case H264::NAL_PPS:
+        info.kind = UnitInfo::PARAM_SET;
+        if (!H264::Parser::peekPpsId(&nalu, v) || v > MAX_PPS_ID)
+            return false;
+        info.id = v;
+        return true;
+    default:
+        info.kind = UnitInfo::PREFIX;
+        return true;
+    }
+}
+
+/* return true if unit is a sps of field pictures */
+static bool parseH264ParamSet(H264::Parser& parser, const uint8_t* unit, uint32_t size)
+{
+    H264::NalUnit nalu;
+    if (!nalu.parseNalUnit(unit, size))
+        return false;
+    if (nalu.nal_unit_type == H264::NAL_SPS) {
+        SharedPtr<H264::SPS> sps;
+        return parser.parseSps(sps, &nalu) && !sps->frame_mbs_only_flag;
+    }
+    SharedPtr<H264::PPS> pps;
+    parser.parsePps(pps, &nalu);
+    return false;
+}
+
+static void parseH264Picture(H264::Parser& parser, const uint8_t* unit, uint32_t size,
+    FieldPicture& picture)
+{
+    H264::NalUnit nalu;
+    H264::SliceHeader slice;
+    if (!nalu.parseNalUnit(unit, size) || !slice.parseHeader(&parser, &nalu))
+        return;
+    picture.field = slice.field_pic_flag;
+    picture.bottom = slice.bottom_field_flag;
+    picture.frameNum = slice.frame_num;
+    picture.idr = nalu.m_idrPicFlag;
+    picture.idrPicId = slice.idr_pic_id;
+}
+#endif
+
+#ifdef __BUILD_H265_DECODER__
+static bool classifyH265(const uint8_t* unit, uint32_t size, UnitInfo& info)
+{
+    typedef H265::NalUnit NalUnit;
+    NalUnit nalu;
+    uint32_t v;
+    if (!nalu.parseNaluHeader(unit, size))
+        return false;
+    uint8_t type = nalu.nal_unit_type;
+    info.randomAccess = false;
+    info.type = type;
+    if (type <= NalUnit::CRA_NUT) {
+        bool first;
+        if (!H265::Parser::peekFirstSliceSegmentInPic(&nalu, first))
+            return false;
+        info.kind = first ? UnitInfo::PICTURE_START : UnitInfo::PICTURE_DATA;
+        if (type >= NalUnit::BLA_W_LP) {
+            info.randomAccess = true;
+            if (type <= NalUnit::BLA_N_LP)
+                info.type = StreamIndex::FRAME_BLA;
+            else if (type <= NalUnit::IDR_N_LP)
+                info.type = StreamIndex::FRAME_IDR;
+            else
+                info.type = StreamIndex::FRAME_CRA;
+        }
+        return true;
+    }
+    switch (type) {
+    case NalUnit::VPS_NUT:
+        info.kind = UnitInfo::PARAM_SET;
+        if (!H265::Parser::peekVpsId(&nalu, v))
+            return false;
+        info.id = v;
+        return true;
+    case NalUnit::SPS_NUT:
+        info.kind = UnitInfo::PARAM_SET;
+        if (!H265::Parser::peekSpsId(&nalu, v) || v > H265::MAXSPSCOUNT)
+            return false;
+        info.id = v;
+        return true;
+    case NalUnit::PPS_NUT:
+        info.kind = UnitInfo::PARAM_SET;
+        if (!H265::Parser::peekPpsId(&nalu, v) || v > H265::MAXPPSCOUNT)
+            return false;
+        info.id = v;
+        return true;
+    case NalUnit::EOS_NUT:
+    case NalUnit::EOB_NUT:
+    case NalUnit::FD_NUT:
+    case NalUnit::SUFFIX_SEI_NUT:
+        info.kind = UnitInfo::PICTURE_DATA;
+        return true;
+    default:
+        //the reserved vcl types
+        if (type < NalUnit::VPS_NUT)
+            info.kind = UnitInfo::PICTURE_DATA;
+        else
+            info.kind = UnitInfo::PREFIX;
+        return true;
+    }
+}
+#endif
+
+#ifdef __BUILD_MPEG2_DECODER__
+/* the mpeg2 sequence header takes the extensions and user data after it,
+ * even if they are in next chunk. p is the start code after the header */
+static const uint8_t* getSequenceEnd(const uint8_t* unitEnd, const uint8_t* p,
+    const uint8_t* end)
+{
+    while (p + START_CODE_SIZE < end
+        && (p[START_CODE_SIZE] == MPEG2::MPEG2_EXTENSION_START_CODE
+               || p[START_CODE_SIZE] == MPEG2::MPEG2_USER_DATA_START_CODE)) {
+        const uint8_t* unit = p + START_CODE_SIZE;
+        p = findStartCode(unit, end);
+        unitEnd = p;
+        while (unitEnd > unit && !unitEnd[-1])
+            unitEnd--;
+    }
+    return unitEnd;
+}
+
+/* picture_structure of the picture coding extension at start code p,
+ * a frame if there is no extension like in mpeg1 */
+static uint8_t getPictureStructure(MPEG2::Parser& parser, const uint8_t* p,
+    const uint8_t* end)
+{
+    if (p + START_CODE_SIZE >= end
+        || p[START_CODE_SIZE] != MPEG2::MPEG2_EXTENSION_START_CODE)
+        return MPEG2_FRAME_PICTURE;
+    MPEG2::StreamHeader shdr;
+    shdr.nalData = p + START_CODE_SIZE;
+    shdr.nalSize = findStartCode(shdr.nalData, end) - shdr.nalData;
+    if (!parser.parsePictureCodingExtension(&shdr))
+        return MPEG2_FRAME_PICTURE;
+    return parser.getPictureCodingExtension()->picture_structure;
+}
+
+/* next is the start code after unit */
+static bool classifyMpeg2(MPEG2::Parser& parser, const uint8_t* unit, uint32_t size,
+    const uint8_t* next, const uint8_t* end, UnitInfo& info)
+{
+    MPEG2::StreamHeader shdr;
+    MPEG2::StartCodeType code;
+    shdr.nalData = unit;
+    shdr.nalSize = size;
+    parser.nextStartCode(&shdr, code);
+    info.randomAccess = false;
+    info.type = code;
+    if (code == MPEG2::MPEG2_PICTURE_START_CODE) {
+        if (!parser.parsePictureHeader(&shdr))
+            return false;
+        info.kind = UnitInfo::PICTURE_START;
+        info.randomAccess = parser.getPictureHeader()->picture_coding_type == MPEG2::kIFrame;
+        info.type = StreamIndex::FRAME_I;
+        info.id = getPictureStructure(parser, next, end);
+        info.mayBeField = info.id != MPEG2_FRAME_PICTURE;
+    } else if (code <= MPEG2::MPEG2_SLICE_START_CODE_MAX
+        || code == MPEG2::MPEG2_SEQUENCE_END_CODE) {
+        info.kind = UnitInfo::PICTURE_DATA;
+    } else if (code == MPEG2::MPEG2_SEQUENCE_HEADER_CODE) {
+        info.kind = UnitInfo::PARAM_SET;
+        info.id = 0;
+    } else {
+        info.kind = UnitInfo::PREFIX;
+    }
+    return true;
+}
+#endif
+
+StreamIndex::StreamIndex()
+    : m_codec(CODEC_H264)
+    , m_chunkSize(DEFAULT_CHUNK_SIZE)
+{
+}
+
+void StreamIndex::setChunkSize(uint32_t size)
+{
+    m_chunkSize = size ? size : DEFAULT_CHUNK_SIZE;
+}
+
+void StreamIndex::scanUnits(uint32_t index, const uint8_t* data, size_t size,
+    std::vector<Chunk>& chunks) const
+{
+    Chunk& chunk = chunks[index];
+    const uint8_t* end = data + size;
+    uint64_t chunkEnd = std::min<uint64_t>(size, (uint64_t)(index + 1) * m_chunkSize);
+    uint64_t run = index ? RUN_FROM_PREV : NO_RUN;
+#ifdef __BUILD_MPEG2_DECODER__
+    MPEG2::Parser mpeg2;
+#endif
+
+    chunk.frames = 0;
+    chunk.firstRun = NO_RUN;
+    const uint8_t* p = findStartCode(data + (uint64_t)index * m_chunkSize, end);
+    //a unit belongs to the chunk its start code begins in
+    while (p < end && (uint64_t)(p - data) < chunkEnd) {
+        const uint8_t* unit = p + START_CODE_SIZE;
+        const uint8_t* next = findStartCode(unit, end);
+        const uint8_t* unitEnd = next;
+        //the zeros are trailing_zero_8bits or zero_byte of next start code
+        while (unitEnd > unit && !unitEnd[-1])
+            unitEnd--;
+        uint64_t offset = p - data;
+        p = next;
+
+        uint32_t unitSize = unitEnd - unit;
+        if (!unitSize)
+            continue;
+        UnitInfo info = UnitInfo();
+        bool valid = false;
+        switch (m_codec) {
+#ifdef __BUILD_H264_DECODER__
+        case CODEC_H264:
+            valid = classifyH264(unit, unitSize, info);
+            break;
+#endif
+#ifdef __BUILD_H265_DECODER__
+        case CODEC_H265:
+            valid = classifyH265(unit, unitSize, info);
+            break;
+#endif
+#ifdef __BUILD_MPEG2_DECODER__
+        case CODEC_MPEG2:
+            valid = classifyMpeg2(mpeg2, unit, unitSize, next, end, info);
+            break;
+#endif
+        default:
+            break;
+        }
+        if (!valid) {
+            DEBUG("skip broken unit at %lu", (unsigned long)offset);
+            continue;
+        }
+
+        if (info.kind == UnitInfo::PARAM_SET) {
+            Event event;
+            event.isPicture = false;
+            event.randomAccess = false;
+            event.mayBeField = false;
+            event.type = info.type;
+            event.id = info.id;
+            event.offset = unit - data;
+            event.end = unitEnd - data;
+            event.size = 0;
+            event.pts = 0;
+#ifdef __BUILD_MPEG2_DECODER__
+            if (m_codec == CODEC_MPEG2)
+                event.end = getSequenceEnd(unitEnd, next, end) - data;
+#endif
+            chunk.events.push_back(event);
+        }
+        if (info.kind == UnitInfo::PICTURE_START) {
+            if (info.randomAccess || info.mayBeField) {
+                Event event;
+                event.isPicture = true;
+                event.randomAccess = info.randomAccess;
+                event.mayBeField = info.mayBeField;
+                event.type = info.type;
+                event.id = info.id;
+                event.offset = run;
+                event.end = offset;
+                event.size = unitSize;
+                event.pts = chunk.frames;
+                chunk.events.push_back(event);
+            }
+            if (!info.mayBeField)
+                chunk.frames++;
+        }
+        if (info.kind == UnitInfo::PICTURE_START || info.kind == UnitInfo::PICTURE_DATA)
+            run = NO_RUN;
+        else if (run == NO_RUN)
+            run = offset;
+        else if (run == RUN_FROM_PREV && chunk.firstRun == NO_RUN)
+            chunk.firstRun = offset;
+    }
+    chunk.trailingRun = run;
+}
+
+bool StreamIndex::parseIvf(const uint8_t* data, size_t size,
+    std::vector<uint64_t>& frames) const
+{
+    if (size < IVF_FILE_HEADER_SIZE || memcmp(data, "DKIF", 4))
+        return false;
+    static const char* fourccs[] = { "VP80", "VP90" };
+    if (memcmp(data + 8, fourccs[m_codec == CODEC_VP9], 4)) {
+        ERROR("ivf fourcc does not match the codec");
+        return false;
+    }
+    uint64_t pos = data[6] | (data[7] << 8);
+    //jump over the frames by their sizes
+    while (pos + IVF_FRAME_HEADER_SIZE <= size) {
+        const uint8_t* h = data + pos;
+        uint32_t frameSize = h[0] | (h[1] << 8) | (h[2] << 16) | ((uint32_t)h[3] << 24);
+        if (pos + IVF_FRAME_HEADER_SIZE + frameSize > size)
+            break;
+        frames.push_back(pos);
+        pos += IVF_FRAME_HEADER_SIZE + frameSize;
+    }
+    return true;
+}
+
+#ifdef __BUILD_VP8_DECODER__
+static bool isVp8KeyFrame(Vp8Parser& parser, const uint8_t* frame, uint32_t size)
+{
+    Vp8FrameHeader header;
+    return parser.ParseFrame(frame, size, &header) == VP8_PARSER_OK
+        && header.IsKeyframe();
+}
+#endif
+
+#ifdef __BUILD_VP9_DECODER__
+/* a key frame is the first frame of its superframe */
+static bool isVp9KeyFrame(const Vp9Parser& parser, const uint8_t* data, uint32_t size)
+{
+    Vp9SuperFrame superFrame(data, size);
+    const uint8_t* frame;
+    uint32_t frameSize;
+    Vp9FrameInfo info;
+    return superFrame.isValid() && superFrame.next(frame, frameSize)
+        && parser.probe(info, frame, frameSize)
+        && !info.show_existing_frame && info.frame_type == VP9_KEY_FRAME;
+}
+#endif
+
+void StreamIndex::scanIvfFrames(uint32_t index, const uint8_t* data,
+    const std::vector<uint64_t>& frames, std::vector<Chunk>& chunks) const
+{
+    Chunk& chunk = chunks[index];
+    std::vector<uint64_t>::const_iterator it = std::lower_bound(frames.begin(),
+        frames.end(), (uint64_t)index * m_chunkSize);
+    std::vector<uint64_t>::const_iterator last = std::lower_bound(it,
+        frames.end(), (uint64_t)(index + 1) * m_chunkSize);
+#ifdef __BUILD_VP8_DECODER__
+    Vp8Parser vp8;
+#endif
+#ifdef __BUILD_VP9_DECODER__
+    Vp9Parser vp9;
+#endif
+
+    chunk.frames = 0;
+    chunk.trailingRun = NO_RUN;
+    chunk.firstRun = NO_RUN;
+    for (; it != last; ++it) {
+        const uint8_t* h = data + *it;
+        uint32_t frameSize = h[0] | (h[1] << 8) | (h[2] << 16) | ((uint32_t)h[3] << 24);
+        bool key = false;
+#ifdef __BUILD_VP8_DECODER__
+        if (m_codec == CODEC_VP8)
+            key = isVp8KeyFrame(vp8, h + IVF_FRAME_HEADER_SIZE, frameSize);
+#endif
+#ifdef __BUILD_VP9_DECODER__
+        if (m_codec == CODEC_VP9)
+            key = isVp9KeyFrame(vp9, h + IVF_FRAME_HEADER_SIZE, frameSize);
+#endif
+        if (!key)
+            continue;
+        Event event;
+        event.isPicture = true;
+        event.randomAccess = true;
+        event.mayBeField = false;
+        event.type = FRAME_KEY;
+        event.id = 0;
+        event.offset = *it;
+        event.end = *it;
+        event.size = frameSize;
+        event.pts = 0;
+        for (int i = 7; i >= 0; i--)
+            event.pts = (event.pts << 8) | h[4 + i];
+        chunk.events.push_back(event);
+    }
+}
+
+void StreamIndex::merge(const uint8_t* data, const std::vector<Chunk>& chunks)
+{
+    //parameter set in use, by type and id. std::map keeps vps, sps, pps order
+    std::map<uint16_t, uint16_t> active;
+    int64_t frames = 0;
+    uint64_t prevRun = NO_RUN;
+    //the last picture which may be a first field, and its frame number
+    FieldPicture lastField = FieldPicture();
+    int64_t lastFieldPts = -1;
+#ifdef __BUILD_H264_DECODER__
+    //h264 parameter sets to read the slices with, if a sps has fields
+    H264::Parser parser;
+    bool interlaced = false;
+#endif
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const Chunk& chunk = chunks[i];
+        //the run began in chunks before, or at the first unit of this one
+        uint64_t runFromPrev = (prevRun == NO_RUN) ? chunk.firstRun : prevRun;
+        //frames of the chunk counted here
+        int64_t fields = 0;
+        for (size_t j = 0; j < chunk.events.size(); j++) {
+            const Event& event = chunk.events[j];
+            if (!event.isPicture) {
+                uint16_t key = (event.type << 8) | event.id;
+                const uint8_t* begin = data + event.offset;
+                uint32_t bytes = event.end - event.offset;
+                std::map<uint16_t, uint16_t>::iterator it = active.find(key);
+                //most streams repeat the same parameter sets
+                if (it != active.end()) {
+                    const std::vector<uint8_t>& current = m_paramSets[it->second].data;
+                    if (current.size() == bytes && !memcmp(&current[0], begin, bytes))
+                        continue;
+                }
+#ifdef __BUILD_H264_DECODER__
+                if (m_codec == CODEC_H264 && parseH264ParamSet(parser, begin, bytes))
+                    interlaced = true;
+#endif
+                if (m_paramSets.size() > UINT16_MAX) {
+                    ERROR("too many parameter sets");
+                    continue;
+                }
+                ParamSet paramSet;
+                paramSet.type = event.type;
+                paramSet.id = event.id;
+                paramSet.data.assign(begin, begin + bytes);
+                active[key] = m_paramSets.size();
+                m_paramSets.push_back(paramSet);
+                continue;
+            }
+            int64_t pts = frames + fields + event.pts;
+            if (event.mayBeField) {
+                FieldPicture picture = FieldPicture();
+#ifdef __BUILD_H264_DECODER__
+                if (m_codec == CODEC_H264 && interlaced)
+                    parseH264Picture(parser, data + event.end + START_CODE_SIZE, event.size, picture);
+#endif
+                if (m_codec == CODEC_MPEG2) {
+                    picture.field = true;
+                    picture.bottom = event.id == MPEG2_BOTTOM_FIELD;
+                }
+                //the second field is in the frame and the entry of the first
+                bool second = lastFieldPts == pts - 1 && isSecondField(lastField, picture);
+                lastField = picture;
+                lastFieldPts = (picture.field && !second) ? pts : -1;
+                if (second)
+                    continue;
+                fields++;
+            }
+            if (!event.randomAccess)
+                continue;
+            bool needParamSets = m_codec != CODEC_VP8 && m_codec != CODEC_VP9;
+            if (needParamSets && active.empty())
+                continue;
+            Entry entry;
+            if (event.offset == RUN_FROM_PREV)
+                entry.offset = (runFromPrev == NO_RUN) ? event.end : runFromPrev;
+            else if (event.offset == NO_RUN)
+                entry.offset = event.end;
+            else
+                entry.offset = event.offset;
+            entry.pts = pts;
+            entry.frameType = event.type;
+            std::map<uint16_t, uint16_t>::const_iterator it;
+            for (it = active.begin(); it != active.end(); ++it)
+                entry.paramSets.push_back(it->second);
+            m_entries.push_back(entry);
+        }
+        frames += chunk.frames + fields;
+        prevRun = (chunk.trailingRun == RUN_FROM_PREV) ? runFromPrev : chunk.trailingRun;
+    }
+}
+
+bool StreamIndex::build(Codec codec, const uint8_t* data, size_t size, uint32_t threads)
+{
+    m_codec = codec;
+    m_entries.clear();
+    m_paramSets.clear();
+    if (!data || !size)
+        return false;
+    if (!isSupported(codec)) {
+        ERROR("the parser of codec %d is not built", codec);
+        return false;
+    }
+
+    bool ivf = (codec == CODEC_VP8 || codec == CODEC_VP9);
+    std::vector<uint64_t> frames;
+    if (ivf && !parseIvf(data, size, frames))
+        return false;
+
+    uint32_t count = (size + m_chunkSize - 1) / m_chunkSize;
+    std::vector<Chunk> chunks(count);
+    WorkerPool::Job job;
+    if (ivf)
+        job = std::bind(&StreamIndex::scanIvfFrames, this, _1, data, std::cref(frames), std::ref(chunks));
+    else
+        job = std::bind(&StreamIndex::scanUnits, this, _1, data, size, std::ref(chunks));
+    if (threads && count > 1) {
+        WorkerPool pool(threads);
+        pool.run(job, count);
+    } else {
+        for (uint32_t i = 0; i < count; i++)
+            job(i);
+    }
+    merge(data, chunks);
+    return true;
+}
+
+const StreamIndex::Entry* StreamIndex::findEntry(int64_t pts) const
+{
+    const Entry* found = NULL;
+    //ivf pts may be out of order, take the latest one not after pts
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        if (m_entries[i].pts <= pts && (!found || m_entries[i].pts >= found->pts))
+            found = &m_entries[i];
+    }
+    return found;
+}
+
+void StreamIndex::getStartData(const Entry& entry, std::vector<uint8_t>& data) const
+{
+    static const uint8_t startCode[] = { 0, 0, 0, 1 };
+    data.clear();
+    for (size_t i = 0; i < entry.paramSets.size(); i++) {
+        const ParamSet& paramSet = m_paramSets[entry.paramSets[i]];
+        data.insert(data.end(), startCode, startCode + sizeof(startCode));
+        data.insert(data.end(), paramSet.data.begin(), paramSet.data.end());
+    }
+}
+
+static void put(std::vector<uint8_t>& out, uint64_t v, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++)
+        out.push_back((v >> (i * 8)) & 0xff);
+}
+
+/*
+ * "YIDX" version(1) codec(1) reserved(2)
+ * paramSetCount(4), each: type(1) id(1) size(4) data
+ * entryCount(4), each: offset(8) pts(8) frameType(1) count(2) paramSet(2)...
+ */
+void StreamIndex::serialize(std::vector<uint8_t>& out) const
+{
+    size_t bytes = sizeof(INDEX_MAGIC) + 12;
+    for (size_t i = 0; i < m_paramSets.size(); i++)
+        bytes += 6 + m_paramSets[i].data.size();
+    for (size_t i = 0; i < m_entries.size(); i++)
+        bytes += 19 + 2 * m_entries[i].paramSets.size();
+    out.clear();
+    out.reserve(bytes);
+    for (size_t i = 0; i < sizeof(INDEX_MAGIC); i++)
+        out.push_back(INDEX_MAGIC[i]);
+    put(out, INDEX_VERSION, 1);
+    put(out, m_codec, 1);
+    put(out, 0, 2);
+    put(out, m_paramSets.size(), 4);
+    for (size_t i = 0; i < m_paramSets.size(); i++) {
+        const ParamSet& paramSet = m_paramSets[i];
+        put(out, paramSet.type, 1);
+        put(out, paramSet.id, 1);
+        put(out, paramSet.data.size(), 4);
+        out.insert(out.end(), paramSet.data.begin(), paramSet.data.end());
+    }
+    put(out, m_entries.size(), 4);
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        const Entry& entry = m_entries[i];
+        put(out, entry.offset, 8);
+        put(out, entry.pts, 8);
+        put(out, entry.frameType, 1);
+        put(out, entry.paramSets.size(), 2);
+        for (size_t j = 0; j < entry.paramSets.size(); j++)
+            put(out, entry.paramSets[j], 2);
+    }
+}
+
+/* reads little endian values with bound check */
+class IndexReader {
+public:
+    IndexReader(const uint8_t* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+        , m_pos(0)
+    {
+    }
+    template <class T>
+    bool read(T& v, uint32_t bytes)
+    {
+        if (m_size - m_pos < bytes)
+            return false;
+        uint64_t r = 0;
+        for (uint32_t i = 0; i < bytes; i++)
+            r |= (uint64_t)m_data[m_pos + i] << (i * 8);
+        m_pos += bytes;
+        v = static_cast<T>(r);
+        return true;
+    }
+    const uint8_t* take(size_t bytes)
+    {
+        if (m_size - m_pos < bytes)
+            return NULL;
+        m_pos += bytes;
+        return m_data + m_pos - bytes;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_pos;
+};
+
+bool StreamIndex::deserialize(const uint8_t* data, size_t size)
+{
+    m_entries.clear();
+    m_paramSets.clear();
+
+    IndexReader reader(data, size);
+    const uint8_t* magic = reader.take(sizeof(INDEX_MAGIC));
+    uint8_t version, codec;
+    uint16_t reserved;
+    uint32_t count;
+    if (!magic || memcmp(magic, INDEX_MAGIC, sizeof(INDEX_MAGIC))
+        || !reader.read(version, 1) || version != INDEX_VERSION
+        || !reader.read(codec, 1) || codec > CODEC_VP9
+        || !reader.read(reserved, 2) || !reader.read(count, 4))
+        goto fail;
+    m_codec = static_cast<Codec>(codec);
+    for (uint32_t i = 0; i < count; i++) {
+        ParamSet paramSet;
+        uint32_t bytes;
+        const uint8_t* p;
+        if (!reader.read(paramSet.type, 1) || !reader.read(paramSet.id, 1)
+            || !reader.read(bytes, 4) || !(p = reader.take(bytes)))
+            goto fail;
+        paramSet.data.assign(p, p + bytes);
+        m_paramSets.push_back(paramSet);
+    }
+    if (!reader.read(count, 4))
+        goto fail;
+    for (uint32_t i = 0; i < count; i++) {
+        Entry entry;
+        uint16_t n;
+        if (!reader.read(entry.offset, 8) || !reader.read(entry.pts, 8)
+            || !reader.read(entry.frameType, 1) || !reader.read(n, 2))
+            goto fail;
+        for (uint16_t j = 0; j < n; j++) {
+            uint16_t paramSet;
+            if (!reader.read(paramSet, 2) || paramSet >= m_paramSets.size())
+                goto fail;
+            entry.paramSets.push_back(paramSet);
+        }
+        m_entries.push_back(entry);
+    }
+    return true;
+fail:
+    ERROR("invalid stream index");
+    m_entries.clear();
+    m_paramSets.clear();
+    return false;
+}
+
+} /*namespace YamiParser*/
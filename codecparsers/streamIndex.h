@@ -0,0 +1,128 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef streamIndex_h
+#define streamIndex_h
+
+#include "common/NonCopyable.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace YamiParser {
+
+/**
+ * \class StreamIndex
+ * \brief random access points of a stream, for seeking
+ * <pre>
+ * build() scans an annex b h264/h265 stream, an mpeg2 elementary stream or
+ * an ivf file of vp8/vp9. Units and frames are told by the codec parsers,
+ * so a codec is indexed only if its decoder is built. The stream is cut into
+ * chunks scanned on a few threads, and the chunks are put together in order.
+ *
+ * h264 entries are idr frames and mpeg2 ones are I pictures. The fields of
+ * a pair are one frame, the entry is at the first field.
+ *
+ * To start decoding at an entry: flush() the decoder, send getStartData()
+ * in one VideoDecodeBuffer, then the stream from Entry::offset. flush()
+ * drops the pictures of the old position and the decoder starts over as at
+ * the stream start, so the leading pictures of an h265 cra are skipped.
+ * </pre>
+ */
+class StreamIndex {
+public:
+    enum Codec {
+        CODEC_H264,
+        CODEC_H265,
+        CODEC_MPEG2,
+        CODEC_VP8, //ivf file
+        CODEC_VP9, //ivf file
+    };
+
+    enum FrameType {
+        FRAME_IDR, //h264 and h265
+        FRAME_CRA,
+        FRAME_BLA,
+        FRAME_I, //mpeg2 I picture
+        FRAME_KEY, //vp8 and vp9 key frame
+    };
+
+    /* sps, pps and vps, or the mpeg2 sequence header with its extensions.
+     * data is without the leading start code */
+    struct ParamSet {
+        uint8_t type; //nal_unit_type, 0xb3 for mpeg2
+        uint8_t id;
+        std::vector<uint8_t> data;
+    };
+
+    struct Entry {
+        /* start code of the first unit of the access unit,
+         * or the frame header for ivf */
+        uint64_t offset;
+        /* ivf pts, or frame number in decode order for the others */
+        int64_t pts;
+        uint8_t frameType;
+        /* the parameter sets in use, as index of getParamSets() */
+        std::vector<uint16_t> paramSets;
+    };
+
+    StreamIndex();
+
+    /* the chunk size each thread scans, the default is 4MB */
+    void setChunkSize(uint32_t size);
+
+    /* scan data with threads more than the calling thread.
+     * return false if data is not of codec or the codec is not built,
+     * the index is empty then */
+    bool build(Codec codec, const uint8_t* data, size_t size, uint32_t threads = 0);
+
+    Codec getCodec() const { return m_codec; }
+    const std::vector<Entry>& getEntries() const { return m_entries; }
+    const std::vector<ParamSet>& getParamSets() const { return m_paramSets; }
+
+    /* the last entry at or before pts, NULL if none */
+    const Entry* findEntry(int64_t pts) const;
+
+    /* the parameter sets of entry, each after a 00 00 00 01 */
+    void getStartData(const Entry& entry, std::vector<uint8_t>& data) const;
+
+    /* the binary form, little endian */
+    void serialize(std::vector<uint8_t>& out) const;
+    bool deserialize(const uint8_t* data, size_t size);
+
+private:
+    struct Event;
+    struct Chunk;
+
+    void scanUnits(uint32_t index, const uint8_t* data, size_t size,
+        std::vector<Chunk>& chunks) const;
+    void scanIvfFrames(uint32_t index, const uint8_t* data,
+        const std::vector<uint64_t>& frames, std::vector<Chunk>& chunks) const;
+    void merge(const uint8_t* data, const std::vector<Chunk>& chunks);
+    bool parseIvf(const uint8_t* data, size_t size, std::vector<uint64_t>& frames) const;
+
+    Codec m_codec;
+    uint32_t m_chunkSize;
+    std::vector<Entry> m_entries;
+    std::vector<ParamSet> m_paramSets;
+
+    DISALLOW_COPY_AND_ASSIGN(StreamIndex);
+};
+
+} /*namespace YamiParser*/
+
+#endif
@@ -0,0 +1,598 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "streamIndex.h"
+
+// library headers
+#include "bitWriter.h"
+#include "common/common_def.h"
+#include "common/unittest.h"
+
+namespace YamiParser {
+
+#define UNIT(stream, unit) appendUnit(stream, unit, N_ELEMENTS(unit))
+
+static const uint8_t h264Aud[] = { 0x09, 0xf0 };
+static const uint8_t h264Sps[] = { 0x67, 0x42, 0x00, 0x1e, 0xab, 0xcd };
+static const uint8_t h264Pps[] = { 0x68, 0xce, 0x38, 0x80 };
+static const uint8_t h264Pps2[] = { 0x68, 0xce, 0x3c, 0x80 };
+static const uint8_t h264Idr[] = { 0x65, 0x88, 0x84 };
+static const uint8_t h264P[] = { 0x41, 0x9a };
+//first_mb_in_slice is not 0
+static const uint8_t h264PSecondSlice[] = { 0x41, 0x40 };
+
+#ifdef __BUILD_H265_DECODER__
+static const uint8_t h265Vps[] = { 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff };
+static const uint8_t h265Sps[] = {
+    0x42, 0x01, 0x01, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0xa0
+};
+//two sub layers with sub_layer_level_present_flag, sps id 2
+static const uint8_t h265SpsSubLayers[] = {
+    0x42, 0x01, 0x03, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x40, 0x00, 0x11, 0x70
+};
+static const uint8_t h265Pps[] = { 0x44, 0x01, 0xc1 };
+static const uint8_t h265Idr[] = { 0x26, 0x01, 0xaf };
+static const uint8_t h265Cra[] = { 0x2a, 0x01, 0xaf };
+static const uint8_t h265Trail[] = { 0x02, 0x01, 0xd0 };
+static const uint8_t h265TrailSecondSlice[] = { 0x02, 0x01, 0x50 };
+#endif
+
+#ifdef __BUILD_MPEG2_DECODER__
+static const uint8_t mpeg2Sequence[] = { 0xb3, 0x16, 0x01, 0x20, 0x13 };
+static const uint8_t mpeg2SequenceExtension[] = { 0xb5, 0x14, 0x8a, 0x00, 0x01 };
+static const uint8_t mpeg2Gop[] = { 0xb8, 0x00, 0x08, 0x00, 0x40 };
+static const uint8_t mpeg2PictureI[] = { 0x00, 0x00, 0x0f, 0xff, 0xf8 };
+static const uint8_t mpeg2PictureP[] = { 0x00, 0x00, 0x57, 0xff, 0xf8, 0x80 };
+static const uint8_t mpeg2Slice[] = { 0x01, 0x12, 0x34 };
+//picture coding extensions, picture_structure is in the third byte
+static const uint8_t mpeg2TopField[] = { 0xb5, 0x8f, 0xff, 0xf1, 0x80, 0x3f };
+static const uint8_t mpeg2BottomField[] = { 0xb5, 0x8f, 0xff, 0xf2, 0x00, 0x3f };
+static const uint8_t mpeg2FramePicture[] = { 0xb5, 0x8f, 0xff, 0xf3, 0x80, 0x3f };
+#endif
+
+#ifdef __BUILD_VP8_DECODER__
+//16x16, the first partition of 8 bytes
+static const uint8_t vp8KeyFrame[] = {
+    0x10, 0x01, 0x00, 0x9d, 0x01, 0x2a, 0x10, 0x00, 0x10, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5a, 0x5a
+};
+static const uint8_t vp8InterFrame[] = {
+    0x11, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x5a, 0x5a
+};
+#endif
+
+/* append unit after a 4 bytes start code, return the start code offset */
+static uint64_t appendUnit(std::vector<uint8_t>& stream, const uint8_t* unit, size_t size)
+{
+    static const uint8_t startCode[] = { 0, 0, 0, 1 };
+    stream.insert(stream.end(), startCode, startCode + N_ELEMENTS(startCode));
+    stream.insert(stream.end(), unit, unit + size);
+    //offset of the 3 bytes start code
+    return stream.size() - size - 3;
+}
+
+#if defined(__BUILD_VP8_DECODER__) || defined(__BUILD_VP9_DECODER__)
+static void appendLe(std::vector<uint8_t>& stream, uint64_t v, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++)
+        stream.push_back((v >> (i * 8)) & 0xff);
+}
+
+#define IVF_FRAME(stream, pts, frame) appendIvfFrame(stream, pts, frame, N_ELEMENTS(frame))
+
+static void appendIvfFrame(std::vector<uint8_t>& stream, int64_t pts,
+    const uint8_t* frame, size_t size)
+{
+    appendLe(stream, size, 4);
+    appendLe(stream, pts, 8);
+    stream.insert(stream.end(), frame, frame + size);
+}
+
+static void appendIvfHeader(std::vector<uint8_t>& stream, const char* fourcc)
+{
+    stream.insert(stream.end(), "DKIF", "DKIF" + 4);
+    appendLe(stream, 0, 2);
+    appendLe(stream, 32, 2);
+    stream.insert(stream.end(), fourcc, fourcc + 4);
+    stream.resize(stream.size() + 20);
+}
+#endif
+
+/* the index is the same however the stream is chunked */
+static void checkChunking(StreamIndex::Codec codec, const std::vector<uint8_t>& stream)
+{
+    StreamIndex index;
+    ASSERT_TRUE(index.build(codec, &stream[0], stream.size()));
+    std::vector<uint8_t> expected;
+    index.serialize(expected);
+
+    static const uint32_t chunkSizes[] = { 1, 2, 3, 5, 7, 16, 64 };
+    for (size_t i = 0; i < N_ELEMENTS(chunkSizes); i++) {
+        StreamIndex chunked;
+        chunked.setChunkSize(chunkSizes[i]);
+        ASSERT_TRUE(chunked.build(codec, &stream[0], stream.size(), 2));
+        std::vector<uint8_t> result;
+        chunked.serialize(result);
+        EXPECT_EQ(expected, result) << "chunk size " << chunkSizes[i];
+    }
+}
+
+class StreamIndexTest
+    : public ::testing::Test {
+};
+
+#define STREAMINDEX_TEST(name) \
+    TEST_F(StreamIndexTest, name)
+
+STREAMINDEX_TEST(H264)
+{
+    std::vector<uint8_t> stream;
+    uint64_t idr0 = UNIT(stream, h264Aud);
+    UNIT(stream, h264Sps);
+    UNIT(stream, h264Pps);
+    UNIT(stream, h264Idr);
+    UNIT(stream, h264Aud);
+    UNIT(stream, h264P);
+    UNIT(stream, h264PSecondSlice);
+    UNIT(stream, h264Aud);
+    UNIT(stream, h264P);
+    //same sps, new pps
+    uint64_t idr1 = UNIT(stream, h264Aud);
+    UNIT(stream, h264Sps);
+    UNIT(stream, h264Pps2);
+    UNIT(stream, h264Idr);
+    UNIT(stream, h264Aud);
+    UNIT(stream, h264P);
+
+    StreamIndex index;
+    ASSERT_TRUE(index.build(StreamIndex::CODEC_H264, &stream[0], stream.size()));
+    const std::vector<StreamIndex::ParamSet>& paramSets = index.getParamSets();
+    ASSERT_EQ(3u, paramSets.size());
+    EXPECT_EQ(7, paramSets[0].type);
+    EXPECT_EQ(8, paramSets[1].type);
+    EXPECT_EQ(8, paramSets[2].type);
+    EXPECT_EQ(std::vector<uint8_t>(h264Pps2, h264Pps2 + N_ELEMENTS(h264Pps2)), paramSets[2].data);
+
+    const std::vector<StreamIndex::Entry>& entries = index.getEntries();
+    ASSERT_EQ(2u, entries.size());
+    EXPECT_EQ(idr0, entries[0].offset);
+    EXPECT_EQ(0, entries[0].pts);
+    EXPECT_EQ(StreamIndex::FRAME_IDR, entries[0].frameType);
+    EXPECT_EQ(idr1, entries[1].offset);
+    EXPECT_EQ(3, entries[1].pts);
+    ASSERT_EQ(2u, entries[1].paramSets.size());
+    EXPECT_EQ(0u, entries[1].paramSets[0]);
+    EXPECT_EQ(2u, entries[1].paramSets[1]);
+
+    EXPECT_EQ(&entries[0], index.findEntry(2));
+    EXPECT_EQ(&entries[1], index.findEntry(3));
+    EXPECT_EQ(&entries[1], index.findEntry(100));
+    EXPECT_TRUE(NULL == index.findEntry(-1));
+
+    std::vector<uint8_t> startData, expected;
+    index.getStartData(entries[1], startData);
+    UNIT(expected, h264Sps);
+    UNIT(expected, h264Pps2);
+    EXPECT_EQ(expected, startData);
+
+    checkChunking(StreamIndex::CODEC_H264, stream);
+}
+
+STREAMINDEX_TEST(H264NoParamSets)
+{
+    std::vector<uint8_t> stream;
+    UNIT(stream, h264Idr);
+    UNIT(stream, h264P);
+
+    StreamIndex index;
+    ASSERT_TRUE(index.build(StreamIndex::CODEC_H264, &stream[0], stream.size()));
+    //nothing can be decoded from the idr
+    EXPECT_TRUE(index.getEntries().empty());
+}
+
+/* the nal unit of bw, with rbsp trailing bits */
+static void appendRbsp(std::vector<uint8_t>& stream, BitWriter& bw)
+{
+    bw.writeBits(1, 1);
+    bw.writeToBytesAligned();
+    const uint8_t* data = bw.getBitWriterData();
+    appendUnit(stream, data, bw.getCodedBitsCount() / 8);
+}
+
+/* sps and pps of field pictures, poc type 2 and cavlc */
+static uint64_t appendH264FieldParamSets(std::vector<uint8_t>& stream)
+{
+    uint64_t offset = stream.size() + 1;
+    BitWriter sps;
+    sps.writeBits(0x67, 8);
+    sps.enableEmulationPrevention();
+    sps.writeBits(77, 8); //profile_idc, main
+    sps.writeBits(0, 8); //constraint flags
+    sps.writeBits(30, 8); //level_idc
+    sps.writeUe(0); //seq_parameter_set_id
+    sps.writeUe(0); //log2_max_frame_num_minus4
+    sps.writeUe(2); //pic_order_cnt_type
+    sps.writeUe(1); //max_num_ref_frames
+    sps.writeBits(0, 1); //gaps_in_frame_num_value_allowed_flag
+    sps.writeUe(10); //pic_width_in_mbs_minus1
+    sps.writeUe(8); //pic_height_in_map_units_minus1
+    sps.writeBits(0, 1); //frame_mbs_only_flag
+    sps.writeBits(0, 1); //mb_adaptive_frame_field_flag
+    sps.writeBits(1, 1); //direct_8x8_inference_flag
+    sps.writeBits(0, 1); //frame_cropping_flag
+    sps.writeBits(0, 1); //vui_parameters_present_flag
+    appendRbsp(stream, sps);
+
+    BitWriter pps;
+    pps.writeBits(0x68, 8);
+    pps.enableEmulationPrevention();
+    pps.writeUe(0); //pic_parameter_set_id
+    pps.writeUe(0); //seq_parameter_set_id
+    pps.writeBits(0, 1); //entropy_coding_mode_flag
+    pps.writeBits(0, 1); //bottom_field_pic_order_in_frame_present_flag
+    pps.writeUe(0); //num_slice_groups_minus1
+    pps.writeUe(0); //num_ref_idx_l0_default_active_minus1
+    pps.writeUe(0); //num_ref_idx_l1_default_active_minus1
+    pps.writeBits(0, 3); //weighted_pred_flag, weighted_bipred_idc
+    pps.writeSe(0); //pic_init_qp_minus26
+    pps.writeSe(0); //pic_init_qs_minus26
+    pps.writeSe(0); //chroma_qp_index_offset
+    pps.writeBits(4, 3); //deblocking, constrained_intra_pred, redundant_pic_cnt
+    appendRbsp(stream, pps);
+    return offset;
+}
+
+/* an I field, idrPicId is for idr only */
+static uint64_t appendH264Field(std::vector<uint8_t>& stream, bool idr, bool bottom,
+    uint32_t frameNum, uint32_t idrPicId = 0)
+{
+    BitWriter bw;
+    bw.writeBits(idr ? 0x65 : 0x61, 8);
+    bw.enableEmulationPrevention();
+    bw.writeUe(0); //first_mb_in_slice
+    bw.writeUe(7); //slice_type, I
+    bw.writeUe(0); //pic_parameter_set_id
+    bw.writeBits(frameNum, 4);
+    bw.writeBits(1, 1); //field_pic_flag
+    bw.writeBits(bottom, 1); //bottom_field_flag
+    if (idr) {
+        bw.writeUe(idrPicId);
+        bw.writeBits(0, 2); //no_output_of_prior_pics_flag, long_term_reference_flag
+    } else {
+        bw.writeBits(0, 1); //adaptive_ref_pic_marking_mode_flag
+    }
+    bw.writeSe(0); //slice_qp_delta
+    bw.writeUe(1); //disable_deblocking_filter_idc
+    bw.writeBits(0xa5, 8); //slice data
+    uint64_t offset = stream.size() + 1;
+    appendRbsp(stream, bw);
+    return offset;
+}
+
+STREAMINDEX_TEST(H264FieldPair)
+{
+    std::vector<uint8_t> stream;
+    //the two fields of an idr frame make one entry and one frame
+    uint64_t idr0 = appendH264FieldParamSets(stream);
+    appendH264Field(stream, true, false, 0, 0);
+    appendH264Field(stream, true, true, 0, 0);
+    appendH264Field(stream, false, false, 1);
+    appendH264Field(stream, false, true, 1);
+    UNIT(stream, h264P);
+    //the next idr frame, bottom field first
+    uint64_t idr1 = UNIT(stream, h264Aud);
+    appendH264Field(stream, true, true, 0, 1);
+    appendH264Field(stream, true, false, 0, 1);
+    //two idr pictures of the same parity are not a pair
+    uint64_t idr2 = appendH264Field(stream, true, false, 0, 0);
+    uint64_t idr3 = appendH264Field(stream, true, false, 0, 0);
+    //nor an idr after a non idr field
+    appendH264Field(stream, false, true, 1);
+    uint64_t idr4 = appendH264Field(stream, true, false, 1, 1);
+
+    StreamIndex index;
+    ASSERT_TRUE(index.build(StreamIndex::CODEC_H264, &stream[0], stream.size()));
+    const std::vector<StreamIndex::Entry>& entries = index.getEntries();
+    ASSERT_EQ(5u, entries.size());
+    EXPECT_EQ(idr0, entries[0].offset);
+    EXPECT_EQ(0, entries[0].pts);
+    EXPECT_EQ(idr1, entries[1].offset);
+    EXPECT_EQ(3, entries[1].pts);
+    EXPECT_EQ(idr2, entries[2].offset);
+    EXPECT_EQ(4, entries[2].pts);
+    EXPECT_EQ(idr3, entries[3].offset);
+    EXPECT_EQ(5, entries[3].pts);
+    EXPECT_EQ(idr4, entries[4].offset);
+    EXPECT_EQ(7, entries[4].pts);
+
+    checkChunking(StreamIndex::CODEC_H264, stream);
+}
+
+#ifdef __BUILD_H265_DECODER__
+STREAMINDEX_TEST(H265)
+{
+    std::vector<uint8_t> stream;
+    uint64_t idr = UNIT(stream, h265Vps);
+    UNIT(stream, h265Sps);
+    UNIT(stream, h265Pps);
+    UNIT(stream, h265Idr);
+    UNIT(stream, h265Trail);
+    UNIT(stream, h265TrailSecondSlice);
+    UNIT(stream, h265Trail);
+    uint64_t cra = UNIT(stream, h265Cra);
+    UNIT(stream, h265Trail);
+
+    StreamIndex index;
+    ASSERT_TRUE(index.build(StreamIndex::CODEC_H265, &stream[0], stream.size()));
+    const std::vector<StreamIndex::ParamSet>& paramSets = index.getParamSets();
+    ASSERT_EQ(3u, paramSets.size());
+    EXPECT_EQ(32, paramSets[0].type);
+    EXPECT_EQ(33, paramSets[1].type);
+    EXPECT_EQ(34, paramSets[2].type);
+
+    const std::vector<StreamIndex::Entry>& entries = index.getEntries();
+    ASSERT_EQ(2u, entries.size());
+    EXPECT_EQ(idr, entries[0].offset);
+    EXPECT_EQ(StreamIndex::FRAME_IDR, entries[0].frameType);
+    EXPECT_EQ(cra, entries[1].offset);
+    EXPECT_EQ(3, entries[1].pts);
+    EXPECT_EQ(StreamIndex::FRAME_CRA, entries[1].frameType);
+    EXPECT_EQ(3u, entries[1].paramSets.size());
+
+    checkChunking(StreamIndex::CODEC_H265, stream);
+}
+
+STREAMINDEX_TEST(H265SpsId)
+{
+    std::vector<uint8_t> stream;
+    UNIT(stream, h265Vps);
+    UNIT(stream, h265SpsSubLayers);
+
+    StreamIndex index;
+    ASSERT_TRUE(index.build(StreamIndex::CODEC_H265, &stream[0], stream.size()));
+    const std::vector<StreamIndex::ParamSet>& paramSets = index.getParamSets();
+    ASSERT_EQ(2u, paramSets.size());
+    EXPECT_EQ(33, paramSets[1].type);
+    EXPECT_EQ(2, paramSets[1].id);
+}
+#endif
+
+#ifdef __BUILD_MPEG2_DECODER__
+STREAMINDEX_TEST(Mpeg2)
+{
+    std::vector<uint8_t> stream;
+    uint64_t first = UNIT(stream, mpeg2Sequence);
+    UNIT(stream, mpeg2SequenceExtension);
+    UNIT(stream, mpeg2Gop);
+    UNIT(stream, mpeg2PictureI);
+    UNIT(stream, mpeg2Slice);
+    UNIT(stream, mpeg2PictureP);
+    UNIT(stream, mpeg2Slice);
+    uint64_t second = UNIT(stream, mpeg2Sequence);
+    UNIT(stream, mpeg2SequenceExtension);
+    UNIT(stream, mpeg2PictureI);
+    UNIT(stream, mpeg2Slice);
+    //not a random access point without a sequence header
+    UNIT(stream, mpeg2PictureI);
+    UNIT(stream, mpeg2Slice);
+
+    StreamIndex index;
+    ASSERT_TRUE(index.build(StreamIndex::CODEC_MPEG2, &stream[0], stream.size()));
+    //the repeated sequence header is the same one
+    const std::vector<StreamIndex::ParamSet>& paramSets = index.getParamSets();
+    ASSERT_EQ(1u, paramSets.size());
+    std::vector<uint8_t> expected(mpeg2Sequence, mpeg2Sequence + N_ELEMENTS(mpeg2Sequence));
+    UNIT(expected, mpeg2SequenceExtension);
+    EXPECT_EQ(expected, paramSets[0].data);
+
+    const std::vector<StreamIndex::Entry>& entries = index.getEntries();
+    ASSERT_EQ(3u, entries.size());
+    EXPECT_EQ(first, entries[0].offset);
+    EXPECT_EQ(StreamIndex::FRAME_I, entries[0].frameType);
+    EXPECT_EQ(second, entries[1].offset);
+    EXPECT_EQ(2, entries[1].pts);
+    EXPECT_EQ(3, entries[2].pts);
+
+    checkChunking(StreamIndex::CODEC_MPEG2, stream);
+}
+
+STREAMINDEX_TEST(Mpeg2Fields)
+{
+    std::vector<uint8_t> stream;
+    //an I field pair makes one entry and one frame
+    uint64_t first = UNIT(stream, mpeg2Sequence);
+    UNIT(stream, mpeg2SequenceExtension);
+    UNIT(stream, mpeg2Gop);
+    UNIT(stream, mpeg2PictureI);
+    UNIT(stream, mpeg2TopField);
+    UNIT(stream, mpeg2Slice);
+    UNIT(stream, mpeg2PictureI);
+    UNIT(stream, mpeg2BottomField);
+    UNIT(stream, mpeg2Slice);
+    UNIT(stream, mpeg2PictureP);
+    UNIT(stream, mpeg2TopField);
+    UNIT(stream, mpeg2Slice);
+    UNIT(stream, mpeg2PictureP);
+    UNIT(stream, mpeg2BottomField);
+    UNIT(stream, mpeg2Slice);
+    uint64_t frame = UNIT(stream, mpeg2PictureI);
+    UNIT(stream, mpeg2FramePicture);
+    UNIT(stream, mpeg2Slice);
+    //bottom field first
+    uint64_t second = UNIT(stream, mpeg2Sequence);
+    UNIT(stream, mpeg2SequenceExtension);
+    UNIT(stream, mpeg2PictureI);
+    UNIT(stream, mpeg2BottomField);
+    UNIT(stream, mpeg2Slice);
+    UNIT(stream, mpeg2PictureI);
+    UNIT(stream, mpeg2TopField);
+    UNIT(stream, mpeg2Slice);
+    //fields of the same parity are not a pair
+    uint64_t third = UNIT(stream, mpeg2PictureI);
+    UNIT(stream, mpeg2TopField);
+    UNIT(stream, mpeg2Slice);
+    uint64_t fourth = UNIT(stream, mpeg2PictureI);
+    UNIT(stream, mpeg2TopField);
+    UNIT(stream, mpeg2Slice);
+
+    StreamIndex index;
+    ASSERT_TRUE(index.build(StreamIndex::CODEC_MPEG2, &stream[0], stream.size()));
+    const std::vector<StreamIndex::Entry>& entries = index.getEntries();
+    ASSERT_EQ(5u, entries.size());
+    EXPECT_EQ(first, entries[0].offset);
+    EXPECT_EQ(0, entries[0].pts);
+    EXPECT_EQ(frame, entries[1].offset);
+    EXPECT_EQ(2, entries[1].pts);
+    EXPECT_EQ(second, entries[2].offset);
+    EXPECT_EQ(3, entries[2].pts);
+    EXPECT_EQ(third, entries[3].offset);
+    EXPECT_EQ(4, entries[3].pts);
+    EXPECT_EQ(fourth, entries[4].offset);
+    EXPECT_EQ(5, entries[4].pts);
+
+    checkChunking(StreamIndex::CODEC_MPEG2, stream);
+}
+#endif
+
+#ifdef __BUILD_VP8_DECODER__
+STREAMINDEX_TEST(Vp8)
+{
+    std::vector<uint8_t> stream;
+    appendIvfHeader(stream, "VP80");
+    uint64_t key0 = stream.size();
+    IVF_FRAME(stream, 0, vp8KeyFrame);
+    IVF_FRAME(stream, 1, vp8InterFrame);
+    uint64_t key1 = stream.size();
+    IVF_FRAME(stream, 2, vp8KeyFrame);
+    IVF_FRAME(stream, 3, vp8InterFrame);
+
+    StreamIndex index;
+    EXPECT_FALSE(index.build(StreamIndex::CODEC_VP9, &stream[0], stream.size()));
+    ASSERT_TRUE(index.build(StreamIndex::CODEC_VP8, &stream[0], stream.size()));
+    const std::vector<StreamIndex::Entry>& entries = index.getEntries();
+    ASSERT_EQ(2u, entries.size());
+    EXPECT_EQ(key0, entries[0].offset);
+    EXPECT_EQ(key1, entries[1].offset);
+    EXPECT_EQ(2, entries[1].pts);
+    EXPECT_EQ(StreamIndex::FRAME_KEY, entries[1].frameType);
+    EXPECT_TRUE(index.getParamSets().empty());
+
+    checkChunking(StreamIndex::CODEC_VP8, stream);
+
+    stream[0] = 'X';
+    EXPECT_FALSE(index.build(StreamIndex::CODEC_VP8, &stream[0], stream.size()));
+    EXPECT_TRUE(index.getEntries().empty());
+}
+#endif
+
+#ifdef __BUILD_VP9_DECODER__
+/* the uncompressed header of a profile 0 frame until the frame size */
+static void appendVp9Frame(std::vector<uint8_t>& frame, bool key)
+{
+    BitWriter bw;
+    bw.writeBits(2, 2); //frame_marker
+    bw.writeBits(0, 2); //profile 0
+    bw.writeBits(0, 1); //show_existing_frame
+    bw.writeBits(!key, 1); //frame_type
+    bw.writeBits(1, 1); //show_frame
+    bw.writeBits(0, 1); //error_resilient_mode
+    bw.writeBits(0x498342, 24); //sync code of a key frame
+    bw.writeBits(1, 3); //color_space, bt601
+    bw.writeBits(0, 1); //color_range
+    bw.writeBits(15, 16); //frame_width_minus_1
+    bw.writeBits(15, 16); //frame_height_minus_1
+    bw.writeToBytesAligned();
+    const uint8_t* data = bw.getBitWriterData();
+    frame.insert(frame.end(), data, data + bw.getCodedBitsCount() / 8);
+    frame.insert(frame.end(), 4, 0);
+}
+
+STREAMINDEX_TEST(Vp9)
+{
+    std::vector<uint8_t> key, inter, superFrame;
+    appendVp9Frame(key, true);
+    appendVp9Frame(inter, false);
+    //the key frame and an inter frame, with the superframe index
+    superFrame = key;
+    superFrame.insert(superFrame.end(), inter.begin(), inter.end());
+    superFrame.push_back(0xc1);
+    superFrame.push_back(key.size());
+    superFrame.push_back(inter.size());
+    superFrame.push_back(0xc1);
+
+    std::vector<uint8_t> stream;
+    appendIvfHeader(stream, "VP90");
+    uint64_t key0 = stream.size();
+    appendIvfFrame(stream, 0, &key[0], key.size());
+    appendIvfFrame(stream, 1, &inter[0], inter.size());
+    uint64_t key1 = stream.size();
+    appendIvfFrame(stream, 2, &superFrame[0], superFrame.size());
+    appendIvfFrame(stream, 3, &inter[0], inter.size());
+
+    StreamIndex index;
+    ASSERT_TRUE(index.build(StreamIndex::CODEC_VP9, &stream[0], stream.size()));
+    const std::vector<StreamIndex::Entry>& entries = index.getEntries();
+    ASSERT_EQ(2u, entries.size());
+    EXPECT_EQ(key0, entries[0].offset);
+    EXPECT_EQ(key1, entries[1].offset);
+    EXPECT_EQ(2, entries[1].pts);
+    EXPECT_EQ(StreamIndex::FRAME_KEY, entries[1].frameType);
+
+    checkChunking(StreamIndex::CODEC_VP9, stream);
+}
+#endif
+
+STREAMINDEX_TEST(Serialize)
+{
+    std::vector<uint8_t> stream;
+    UNIT(stream, h264Sps);
+    UNIT(stream, h264Pps);
+    UNIT(stream, h264Idr);
+    UNIT(stream, h264P);
+    UNIT(stream, h264Pps2);
+    UNIT(stream, h264Idr);
+
+    StreamIndex index;
+    ASSERT_TRUE(index.build(StreamIndex::CODEC_H264, &stream[0], stream.size()));
+    std::vector<uint8_t> data;
+    index.serialize(data);
+
+    StreamIndex loaded;
+    ASSERT_TRUE(loaded.deserialize(&data[0], data.size()));
+    EXPECT_EQ(StreamIndex::CODEC_H264, loaded.getCodec());
+    ASSERT_EQ(index.getEntries().size(), loaded.getEntries().size());
+    ASSERT_EQ(index.getParamSets().size(), loaded.getParamSets().size());
+    std::vector<uint8_t> again;
+    loaded.serialize(again);
+    EXPECT_EQ(data, again);
+
+    for (size_t size = 0; size < data.size(); size++)
+        EXPECT_FALSE(loaded.deserialize(&data[0], size)) << "size " << size;
+    EXPECT_TRUE(loaded.getEntries().empty());
+
+    data[0] = 'X';
+    EXPECT_FALSE(loaded.deserialize(&data[0], data.size()));
+}
+
+} // namespace YamiParser
@@ -71,6 +71,12 @@ namespace VC1 {
         { 3, 3 }, { 1, 3 }, { 1, 4 }, { 0, 4 }
     };
 
+    /* Table 80: Norm-2/Diff-2 Code Table, the index is the 2-tuple
+       with the first bit in bit 0 */
+    static const VLCTable Norm2VLCTable[4] = {
+        { 0, 1 }, { 4, 3 }, { 5, 3 }, { 3, 2 }
+    };
+
     /* Table 81: Code table for 3x2 and 2x3 tiles */
     static const VLCTable Norm6VLCTable[64] = {
         { 1, 1 },
@@ -153,7 +159,7 @@ namespace VC1 {
     /* Table 40: BFRACTION VLC Table */
     static const VLCTable BFractionVLCTable[] = {
         {0x00, 3}, {0x01, 3},
-        {0x02, 3}, {0x02, 3},
+        {0x02, 3}, {0x03, 3},
         {0x04, 3}, {0x05, 3},
         {0x06, 3}, {0x70, 7},
         {0x71, 7}, {0x72, 7},
@@ -166,6 +172,71 @@ namespace VC1 {
         {0x7f, 7}
     };
 
+    static const VLCLookup ImodeVLCLookup(ImodeVLCTable, N_ELEMENTS(ImodeVLCTable));
+    static const VLCLookup Norm2VLCLookup(Norm2VLCTable, N_ELEMENTS(Norm2VLCTable));
+    static const VLCLookup Norm6VLCLookup(Norm6VLCTable, N_ELEMENTS(Norm6VLCTable));
+    static const VLCLookup BFractionVLCLookup(BFractionVLCTable, N_ELEMENTS(BFractionVLCTable));
+
+    /* byte b as 8 bytes of 0 or 1, msb first */
+    struct BitExpandTable {
+        BitExpandTable()
+        {
+            for (uint32_t b = 0; b < 256; b++) {
+                for (uint32_t i = 0; i < 8; i++)
+                    bytes[b][i] = (b >> (7 - i)) & 1;
+            }
+        }
+        uint8_t bytes[256][8];
+    };
+
+    static const BitExpandTable BitExpand;
+
+    VLCLookup::VLCLookup(const VLCTable* table, uint32_t tableLen)
+        : maxLength(0)
+    {
+        uint32_t i, j;
+        for (i = 0; i < tableLen; i++)
+            maxLength = std::max<uint32_t>(maxLength, table[i].codeLength);
+        Entry invalid = { 0, 0 };
+        entries.resize(1 << maxLength, invalid);
+        /*a code fills every entry it is a prefix of, the first one wins
+          like it did in the linear search*/
+        for (i = tableLen; i > 0; i--) {
+            const VLCTable& vlc = table[i - 1];
+            uint32_t shift = maxLength - vlc.codeLength;
+            Entry entry = { static_cast<uint8_t>(i - 1), static_cast<uint8_t>(vlc.codeLength) };
+            for (j = 0; j < (1u << shift); j++)
+                entries[(vlc.codeWord << shift) | j] = entry;
+        }
+    }
+
+    BitPlanes::BitPlanes()
+        : acpred(NULL)
+        , fieldtx(NULL)
+        , overflags(NULL)
+        , mvtypemb(NULL)
+        , skipmb(NULL)
+        , directmb(NULL)
+        , forwardmb(NULL)
+        , m_planeSize(0)
+    {
+    }
+
+    void BitPlanes::resize(uint32_t mbCount)
+    {
+        if (mbCount <= m_planeSize)
+            return;
+        m_planeSize = mbCount;
+        m_buffer.resize(mbCount * 7);
+        acpred = &m_buffer[0];
+        fieldtx = acpred + mbCount;
+        overflags = fieldtx + mbCount;
+        mvtypemb = overflags + mbCount;
+        skipmb = mvtypemb + mbCount;
+        directmb = skipmb + mbCount;
+        forwardmb = directmb + mbCount;
+    }
+
     Parser::Parser()
     {
         memset(&m_seqHdr, 0, sizeof(m_seqHdr));
@@ -209,11 +280,12 @@ namespace VC1 {
         bool ret = false;
         m_mbWidth = (m_seqHdr.coded_width + 15) >> 4;
         m_mbHeight = (m_seqHdr.coded_height + 15) >> 4;
-        mallocBitPlanes();
+        m_bitPlanes.resize(m_mbWidth * m_mbHeight);
         memset(&m_frameHdr, 0, sizeof(m_frameHdr));
-        if (!convertToRbdu(data, size))
+        if (!findFrameBdu(data, size))
             return false;
-        BitReader bitReader(&m_rbdu[0], m_rbdu.size());
+        /*the header is read from the ebdu directly*/
+        EbduReader bitReader(data, size);
         if (m_seqHdr.profile != PROFILE_ADVANCED) {
             ret = parseFrameHeaderSimpleMain(&bitReader);
         }
@@ -221,7 +293,7 @@ namespace VC1 {
             /* support advanced profile */
             ret = parseFrameHeaderAdvanced(&bitReader);
         }
-        m_frameHdr.macroblock_offset = bitReader.getPos();
+        m_frameHdr.macroblock_offset = bitReader.getRbduPos();
         return ret;
     }
 
@@ -233,11 +305,9 @@ namespace VC1 {
         return (pos == data + size) ? (-1) : (pos - data);
     }
 
-    bool Parser::convertToRbdu(uint8_t*& data, uint32_t& size)
+    bool Parser::findFrameBdu(uint8_t*& data, uint32_t& size)
     {
-        uint8_t* pos;
-        int32_t offset, i = 0;
-        const uint8_t startCode[] = { 0x00, 0x00, 0x03 };
+        int32_t offset;
 
         if (m_seqHdr.profile == PROFILE_ADVANCED) {
             while (1) {
@@ -256,22 +326,6 @@ namespace VC1 {
                 return false;
             }
         }
-        m_rbdu.clear();
-        /*extraction of rbdu from ebdu*/
-        while (1) {
-            pos = std::search(data + i, data + size, startCode, startCode + 3);
-            if (pos == data + size) {
-                m_rbdu.insert(m_rbdu.end(), data + i, pos);
-                break;
-            }
-            if (pos[3] <= 0x03) {
-                m_rbdu.insert(m_rbdu.end(), data + i, pos + 2);
-            }
-            else {
-                m_rbdu.insert(m_rbdu.end(), data + i, pos + 3);
-            }
-            i = pos - data + 3;
-        }
         return (size > 0);
     }
 
@@ -423,64 +477,68 @@ namespace VC1 {
     bool Parser::parseSliceHeader(uint8_t* data, uint32_t size)
     {
         bool temp;
-        BitReader* br;
+        EbduReader* br;
         bool ret = true;
         if (m_seqHdr.profile != PROFILE_ADVANCED)
             return false;
-        BitReader bitReader(data, size);
+        EbduReader bitReader(data, size);
         br = &bitReader;
         READ_BITS(m_sliceHdr.slice_addr, 9);
         READ(temp);
         if (temp)
             ret = parseFrameHeaderAdvanced(&bitReader);
 
-        m_sliceHdr.macroblock_offset = bitReader.getPos();
+        m_sliceHdr.macroblock_offset = bitReader.getRbduPos();
         return ret;
     }
 
-    void Parser::mallocBitPlanes()
+    bool Parser::decodeVLCTable(EbduReader* br, uint16_t* out, const VLCLookup& lookup)
     {
-        uint32_t size = m_mbHeight * m_mbWidth;
-        m_bitPlanes.acpred.resize(size);
-        m_bitPlanes.fieldtx.resize(size);
-        m_bitPlanes.overflags.resize(size);
-        m_bitPlanes.mvtypemb.resize(size);
-        m_bitPlanes.skipmb.resize(size);
-        m_bitPlanes.directmb.resize(size);
-        m_bitPlanes.forwardmb.resize(size);
+        /*the last code of a frame may be shorter than maxLength*/
+        uint32_t bits = std::min<uint64_t>(lookup.maxLength, br->getRemainingBitsCount());
+        uint32_t code;
+        PEEK(code, bits);
+        const VLCLookup::Entry& entry = lookup.entries[code << (lookup.maxLength - bits)];
+        if (!entry.length || entry.length > bits)
+            return false;
+        *out = entry.index;
+        SKIP(entry.length);
+        return true;
     }
 
-    bool Parser::decodeVLCTable(BitReader* br, uint16_t* out,
-        const VLCTable* table, uint32_t tableLen)
+    /* read n bits to n bytes of 0 or 1, a word at a time */
+    static bool readBitsToBytes(EbduReader* br, uint8_t* out, uint32_t n)
     {
-        uint32_t i = 0;
-        uint16_t numberOfBits = 0;
-        uint16_t codeWord = 0;
-        while (i < tableLen) {
-            if (numberOfBits != table[i].codeLength) {
-                numberOfBits = table[i].codeLength;
-                PEEK(codeWord, numberOfBits);
+        uint32_t bits;
+        while (n) {
+            uint32_t nbits = std::min(n, 32u);
+            READ_BITS(bits, nbits);
+            /*msb aligned, so the next byte to expand is always bits >> 24*/
+            bits <<= 32 - nbits;
+            n -= nbits;
+            for (; nbits >= 8; nbits -= 8) {
+                memcpy(out, BitExpand.bytes[bits >> 24], 8);
+                out += 8;
+                bits <<= 8;
             }
-            if (codeWord == table[i].codeWord) {
-                *out = i;
-                SKIP(numberOfBits);
-                break;
+            if (nbits) {
+                memcpy(out, BitExpand.bytes[bits >> 24], nbits);
+                out += nbits;
             }
-            i++;
         }
-        return (i < tableLen) ? true : false;
+        return true;
     }
 
     /* 8.7.3.6 Row-skip mode*/
-    bool Parser::decodeRowskipMode(BitReader* br, uint8_t* data, uint32_t width, uint32_t height)
+    bool Parser::decodeRowskipMode(EbduReader* br, uint8_t* data, uint32_t width, uint32_t height)
     {
-        uint32_t i, j;
+        uint32_t j;
         for (j = 0; j < height; j++) {
             bool rowSkip;
             READ(rowSkip);
             if (rowSkip) {
-                for (i = 0; i < width; i++)
-                    READ_BITS(data[i], 1);
+                if (!readBitsToBytes(br, data, width))
+                    return false;
             }
             else {
                 memset(data, 0, width);
@@ -491,64 +549,54 @@ namespace VC1 {
     }
 
     /* 8.7.3.7 Column-skip mode*/
-    bool Parser::decodeColskipMode(BitReader* br, uint8_t* data, uint32_t width, uint32_t height)
+    bool Parser::decodeColskipMode(EbduReader* br, uint8_t* data, uint32_t width, uint32_t height)
     {
-        uint32_t i, j;
+        uint32_t i, j, bits;
         for (i = 0; i < width; i++) {
             bool columnSkip;
+            uint8_t* out = data + i;
             READ(columnSkip);
             if (columnSkip) {
-                for (j = 0; j < height; j++)
-                    READ_BITS(data[j * m_mbWidth], 1);
+                for (j = 0; j < height; j += 32) {
+                    uint32_t nbits = std::min(height - j, 32u);
+                    READ_BITS(bits, nbits);
+                    bits <<= 32 - nbits;
+                    for (; nbits; nbits--) {
+                        *out = bits >> 31;
+                        out += m_mbWidth;
+                        bits <<= 1;
+                    }
+                }
             }
             else {
-                for (j = 0; j < height; j++)
-                    data[j * m_mbWidth] = 0;
+                for (j = 0; j < height; j++) {
+                    *out = 0;
+                    out += m_mbWidth;
+                }
             }
-            data++;
         }
         return true;
     }
 
-    /* Table 80: Norm-2/Diff-2 Code Table */
-    bool Parser::decodeNorm2Mode(BitReader* br, uint8_t* data, uint32_t width, uint32_t height)
+    bool Parser::decodeNorm2Mode(EbduReader* br, uint8_t* data, uint32_t width, uint32_t height)
     {
         uint32_t i;
-        bool temp;
+        uint16_t temp;
         uint8_t* out = data;
         if ((height * width) & 1) {
             READ_BITS(*out, 1);
             out++;
         }
         for (i = (height * width) & 1; i < height * width; i += 2) {
-            READ(temp);
-            if (temp == 0) {
-                *out++ = 0;
-                *out++ = 0;
-            }
-            else {
-                READ(temp);
-                if (temp) {
-                    *out++ = 1;
-                    *out++ = 1;
-                }
-                else {
-                    READ(temp);
-                    if (temp == 0) {
-                        *out++ = 1;
-                        *out++ = 0;
-                    }
-                    else {
-                        *out++ = 0;
-                        *out++ = 1;
-                    }
-                }
-            }
+            if (!decodeVLCTable(br, &temp, Norm2VLCLookup))
+                return false;
+            *out++ = temp & 1;
+            *out++ = temp >> 1;
         }
         return true;
     }
 
-    bool Parser::decodeNorm6Mode(BitReader* br, uint8_t* data, uint32_t width, uint32_t height)
+    bool Parser::decodeNorm6Mode(EbduReader* br, uint8_t* data, uint32_t width, uint32_t height)
     {
         uint32_t i = 0, j = 0;
         uint16_t temp;
@@ -557,7 +605,7 @@ namespace VC1 {
         if (is2x3Tiled) {
             for (j = 0; j < height; j += 3) {
                 for (i = width & 1; i < width; i += 2) {
-                    if (!decodeVLCTable(br, &temp, Norm6VLCTable, 64))
+                    if (!decodeVLCTable(br, &temp, Norm6VLCLookup))
                         return false;
                     out[i] = temp & 1;
                     out[i + 1] = (temp & 2) >> 1;
@@ -575,7 +623,7 @@ namespace VC1 {
             out += (height & 1) * width;
             for (j = height & 1; j < height; j += 2) {
                 for (i = width % 3; i < width; i += 3) {
-                    if (!decodeVLCTable(br, &temp, Norm6VLCTable, 64))
+                    if (!decodeVLCTable(br, &temp, Norm6VLCLookup))
                         return false;
                     out[i] = temp & 1;
                     out[i + 1] = (temp & 2) >> 1;
@@ -615,13 +663,13 @@ namespace VC1 {
             }
     }
 
-    bool Parser::decodeBitPlane(BitReader* br, uint8_t* data, bool* isRaw)
+    bool Parser::decodeBitPlane(EbduReader* br, uint8_t* data, bool* isRaw)
     {
         uint32_t i, invert;
         uint16_t mode;
         *isRaw = false;
         READ_BITS(invert, 1);
-        if (!decodeVLCTable(br, &mode, ImodeVLCTable, 7))
+        if (!decodeVLCTable(br, &mode, ImodeVLCLookup))
             return false;
         if (mode == IMODE_RAW) {
             *isRaw = true;
@@ -657,7 +705,7 @@ namespace VC1 {
 
     /*Table 24: VOPDQUANT in picture header(Refer to 7.1.1.31)*/
     /*7.1.1.31.6 Picture Quantizer Differential(PQDIFF)(3 bits)*/
-    bool Parser::parseVopdquant(BitReader* br, uint8_t dquant)
+    bool Parser::parseVopdquant(EbduReader* br, uint8_t dquant)
     {
         if (dquant == 2) {
             m_frameHdr.dq_frame = 0;
@@ -699,7 +747,7 @@ namespace VC1 {
         return true;
     }
 
-    int32_t Parser::getFirst01Bit(BitReader* br, bool val, uint32_t len)
+    int32_t Parser::getFirst01Bit(EbduReader* br, bool val, uint32_t len)
     {
         uint32_t i = 0;
         while (i < len) {
@@ -711,7 +759,7 @@ namespace VC1 {
         return i;
     }
 
-    uint8_t Parser::getMVMode(BitReader* br, uint8_t pQuant, bool isMvMode2)
+    uint8_t Parser::getMVMode(EbduReader* br, uint8_t pQuant, bool isMvMode2)
     {
         int32_t temp = 0;
         uint8_t MVMode = 0;
@@ -744,10 +792,10 @@ namespace VC1 {
         return MVMode;
     }
 
-    bool Parser::decodeBFraction(BitReader* br)
+    bool Parser::decodeBFraction(EbduReader* br)
     {
         uint16_t bfraction;
-        if (!decodeVLCTable(br, &bfraction, BFractionVLCTable, N_ELEMENTS(BFractionVLCTable)))
+        if (!decodeVLCTable(br, &bfraction, BFractionVLCLookup))
             return false;
 
         m_frameHdr.bfraction = bfraction;
@@ -761,7 +809,7 @@ namespace VC1 {
     /*Table 17: Progressive BI picture layer bitstream for Main Profile*/
     /*Table 19: Progressive P picture layer bitstream for Simple and Main Profile*/
     /*Table 21: Progressive B picture layer bitstream for Main Profile*/
-    bool Parser::parseFrameHeaderSimpleMain(BitReader* br)
+    bool Parser::parseFrameHeaderSimpleMain(EbduReader* br)
     {
         bool temp;
         m_frameHdr.interpfrm = 0;
@@ -847,10 +895,10 @@ namespace VC1 {
             if (m_frameHdr.mv_mode == MVMODE_MIXED_MV
                 || (m_frameHdr.mv_mode == MVMODE_INTENSITY_COMPENSATION
                        && m_frameHdr.mv_mode2 == MVMODE_MIXED_MV)) {
-                if (!decodeBitPlane(br, &m_bitPlanes.mvtypemb[0], &m_frameHdr.mv_type_mb))
+                if (!decodeBitPlane(br, m_bitPlanes.mvtypemb, &m_frameHdr.mv_type_mb))
                     return false;
             }
-            if (!decodeBitPlane(br, &m_bitPlanes.skipmb[0], &m_frameHdr.skip_mb))
+            if (!decodeBitPlane(br, m_bitPlanes.skipmb, &m_frameHdr.skip_mb))
                 return false;
 
             READ_BITS(m_frameHdr.mv_table, 2);
@@ -869,9 +917,9 @@ namespace VC1 {
         else if (m_frameHdr.picture_type == FRAME_B) {
             READ_BITS(m_frameHdr.mv_mode, 1);
             m_frameHdr.mv_mode = !(m_frameHdr.mv_mode);
-            if (!decodeBitPlane(br, &m_bitPlanes.directmb[0], &m_frameHdr.direct_mb))
+            if (!decodeBitPlane(br, m_bitPlanes.directmb, &m_frameHdr.direct_mb))
                 return false;
-            if (!decodeBitPlane(br, &m_bitPlanes.skipmb[0], &m_frameHdr.skip_mb))
+            if (!decodeBitPlane(br, m_bitPlanes.skipmb, &m_frameHdr.skip_mb))
                 return false;
             READ_BITS(m_frameHdr.mv_table, 2);
             READ_BITS(m_frameHdr.cbp_table, 2);
@@ -890,7 +938,7 @@ namespace VC1 {
 
     /* 9.1.1.43 P Reference Distance*/
     /* Table 106: REFDIST VLC Table*/
-    bool Parser::getRefDist(BitReader* br, uint8_t& refDist)
+    bool Parser::getRefDist(EbduReader* br, uint8_t& refDist)
     {
         uint32_t vlcSize;
         PEEK(vlcSize, 2);
@@ -910,7 +958,7 @@ namespace VC1 {
     /*Table 83: Interlaced Frame P picture layer bitstream for Advanced Profile*/
     /*Table 84: Interlaced Frame B picture layer bitstream for Advanced Profile*/
     /*Table 85: Picture Layer bitstream for Field 1 of Interlace Field Picture for Advanced Profile*/
-    bool Parser::parseFrameHeaderAdvanced(BitReader* br)
+    bool Parser::parseFrameHeaderAdvanced(EbduReader* br)
     {
         uint32_t temp;
         if (m_seqHdr.interlace) {
@@ -996,16 +1044,16 @@ namespace VC1 {
         if ((m_frameHdr.picture_type == FRAME_I)
             || (m_frameHdr.picture_type == FRAME_BI)) {
             if (m_frameHdr.fcm == FRAME_INTERLACE) {
-                if (!decodeBitPlane(br, &m_bitPlanes.fieldtx[0], &m_frameHdr.fieldtx))
+                if (!decodeBitPlane(br, m_bitPlanes.fieldtx, &m_frameHdr.fieldtx))
                     return false;
             }
-            if (!decodeBitPlane(br, &m_bitPlanes.acpred[0], &m_frameHdr.ac_pred))
+            if (!decodeBitPlane(br, m_bitPlanes.acpred, &m_frameHdr.ac_pred))
                 return false;
 
             if ((m_entryPointHdr.overlap) && m_frameHdr.pquant <= 8) {
                 m_frameHdr.condover = getFirst01Bit(br, 0, 2);
                 if (m_frameHdr.condover == 2) {
-                    if (!decodeBitPlane(br, &m_bitPlanes.overflags[0], &m_frameHdr.overflags))
+                    if (!decodeBitPlane(br, m_bitPlanes.overflags, &m_frameHdr.overflags))
                         return false;
                 }
             }
@@ -1057,14 +1105,14 @@ namespace VC1 {
                     if (m_frameHdr.mv_mode == MVMODE_MIXED_MV
                         || (m_frameHdr.mv_mode == MVMODE_INTENSITY_COMPENSATION
                                && m_frameHdr.mv_mode2 == MVMODE_MIXED_MV)) {
-                        if (!decodeBitPlane(br, &m_bitPlanes.mvtypemb[0], &m_frameHdr.mv_type_mb))
+                        if (!decodeBitPlane(br, m_bitPlanes.mvtypemb, &m_frameHdr.mv_type_mb))
                             return false;
                     }
                 }
             }
 
             if (m_frameHdr.fcm != FIELD_INTERLACE) {
-                if (!decodeBitPlane(br, &m_bitPlanes.skipmb[0], &m_frameHdr.skip_mb))
+                if (!decodeBitPlane(br, m_bitPlanes.skipmb, &m_frameHdr.skip_mb))
                     return false;
             }
 
@@ -1111,13 +1159,13 @@ namespace VC1 {
                 m_frameHdr.mv_mode = !(m_frameHdr.mv_mode);
             }
             if (m_frameHdr.fcm == FIELD_INTERLACE) {
-                if (!decodeBitPlane(br, &m_bitPlanes.forwardmb[0], &m_frameHdr.forwardmb))
+                if (!decodeBitPlane(br, m_bitPlanes.forwardmb, &m_frameHdr.forwardmb))
                     return false;
             }
             else {
-                if (!decodeBitPlane(br, &m_bitPlanes.directmb[0], &m_frameHdr.direct_mb))
+                if (!decodeBitPlane(br, m_bitPlanes.directmb, &m_frameHdr.direct_mb))
                     return false;
-                if (!decodeBitPlane(br, &m_bitPlanes.skipmb[0], &m_frameHdr.skip_mb))
+                if (!decodeBitPlane(br, m_bitPlanes.skipmb, &m_frameHdr.skip_mb))
                     return false;
             }
             if (m_frameHdr.fcm != PROGRESSIVE) {
@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include "bitReader.h"
+#include "nalReader.h"
+#include "common/NonCopyable.h"
 #include <vector>
 
 namespace YamiParser {
@@ -145,14 +147,23 @@ namespace VC1 {
         HrdParam hrd_param;
     };
 
+    /* all planes live in one buffer, it is only reallocated when
+       the macroblock count grows, so frames reuse it */
     struct BitPlanes {
-        std::vector<uint8_t> acpred;
-        std::vector<uint8_t> fieldtx;
-        std::vector<uint8_t> overflags;
-        std::vector<uint8_t> mvtypemb;
-        std::vector<uint8_t> skipmb;
-        std::vector<uint8_t> directmb;
-        std::vector<uint8_t> forwardmb;
+        BitPlanes();
+        void resize(uint32_t mbCount);
+        uint8_t* acpred;
+        uint8_t* fieldtx;
+        uint8_t* overflags;
+        uint8_t* mvtypemb;
+        uint8_t* skipmb;
+        uint8_t* directmb;
+        uint8_t* forwardmb;
+
+    private:
+        std::vector<uint8_t> m_buffer;
+        uint32_t m_planeSize;
+        DISALLOW_COPY_AND_ASSIGN(BitPlanes);
     };
 
     struct FrameHdr {
@@ -235,6 +246,33 @@ namespace VC1 {
         uint32_t macroblock_offset;
     };
 
+    /* reads an EBDU in place, the 00 00 03 escapes are dropped while
+       loading, so no RBDU copy is needed */
+    class EbduReader : public BitReaderT<EpbStrippingPolicy> {
+    public:
+        EbduReader(const uint8_t* data, uint32_t size)
+            : BitReaderT<EpbStrippingPolicy>(data, size)
+        {
+        }
+        /* bits read so far, escapes are not counted */
+        uint64_t getRbduPos() const
+        {
+            return getPos() - (static_cast<uint64_t>(m_droppedBytes) << 3);
+        }
+    };
+
+    /* a VLCTable expanded to one entry for each value of the next
+       maxLength bits, so a code is decoded with a single peek */
+    struct VLCLookup {
+        VLCLookup(const VLCTable* table, uint32_t tableLen);
+        struct Entry {
+            uint8_t index; /*index of the code in the VLCTable*/
+            uint8_t length; /*0 if no code starts with these bits*/
+        };
+        uint32_t maxLength;
+        std::vector<Entry> entries;
+    };
+
     class Parser {
     public:
         Parser();
@@ -252,25 +290,23 @@ namespace VC1 {
         uint32_t m_mbHeight;
 
     private:
-        void mallocBitPlanes();
-        bool getRefDist(BitReader*, uint8_t& refDist);
-        int32_t getFirst01Bit(BitReader*, bool, uint32_t);
-        uint8_t getMVMode(BitReader*, uint8_t, bool);
-        bool decodeBFraction(BitReader*);
-        bool convertToRbdu(uint8_t*&, uint32_t&);
-        bool decodeVLCTable(BitReader*, uint16_t*, const VLCTable*, uint32_t);
-        bool decodeRowskipMode(BitReader*, uint8_t*, uint32_t, uint32_t);
-        bool decodeColskipMode(BitReader*, uint8_t*, uint32_t, uint32_t);
-        bool decodeNorm2Mode(BitReader*, uint8_t*, uint32_t, uint32_t);
-        bool decodeNorm6Mode(BitReader*, uint8_t*, uint32_t, uint32_t);
-        bool decodeBitPlane(BitReader*, uint8_t*, bool*);
+        bool getRefDist(EbduReader*, uint8_t& refDist);
+        int32_t getFirst01Bit(EbduReader*, bool, uint32_t);
+        uint8_t getMVMode(EbduReader*, uint8_t, bool);
+        bool decodeBFraction(EbduReader*);
+        bool findFrameBdu(uint8_t*&, uint32_t&);
+        bool decodeVLCTable(EbduReader*, uint16_t*, const VLCLookup&);
+        bool decodeRowskipMode(EbduReader*, uint8_t*, uint32_t, uint32_t);
+        bool decodeColskipMode(EbduReader*, uint8_t*, uint32_t, uint32_t);
+        bool decodeNorm2Mode(EbduReader*, uint8_t*, uint32_t, uint32_t);
+        bool decodeNorm6Mode(EbduReader*, uint8_t*, uint32_t, uint32_t);
+        bool decodeBitPlane(EbduReader*, uint8_t*, bool*);
         void inverseDiff(uint8_t*, uint32_t, uint32_t, uint32_t);
-        bool parseVopdquant(BitReader*, uint8_t);
+        bool parseVopdquant(EbduReader*, uint8_t);
         bool parseSequenceHeader(const uint8_t*, uint32_t);
         bool parseEntryPointHeader(const uint8_t*, uint32_t);
-        bool parseFrameHeaderSimpleMain(BitReader*);
-        bool parseFrameHeaderAdvanced(BitReader*);
-        std::vector<uint8_t> m_rbdu;
+        bool parseFrameHeaderSimpleMain(EbduReader*);
+        bool parseFrameHeaderAdvanced(EbduReader*);
     };
 }
 }
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vc1Parser.h"
+
+// library headers
+#include "parserBench.h"
+
+// system libraries
+#include <stdlib.h>
+
+namespace YamiParser {
+namespace VC1 {
+
+    /* 1920x1088 main profile, an I frame every 30 frames and mixed mv P
+     * frames in between. The two bitplanes of a P frame cycle through
+     * rowskip, colskip, norm2 and norm6, the modes encoders pick most. */
+    class VC1ParserBench : public ParserBench {
+    public:
+        const char* unit() const { return "frame"; }
+
+        bool setUp()
+        {
+            BitWriter bw(16);
+            writeSequenceHeader(bw);
+            uint8_t* seq = const_cast<uint8_t*>(bw.getBitWriterData());
+            if (!m_parser.parseCodecData(seq, bw.getCodedBitsCount() / 8))
+                return false;
+            /*the size comes from the container, like VaapiDecoderVC1 does*/
+            m_parser.m_seqHdr.coded_width = WIDTH;
+            m_parser.m_seqHdr.coded_height = HEIGHT;
+
+            m_frames.resize(FRAMES);
+            for (uint32_t i = 0; i < FRAMES; i++)
+                writeFrame(m_frames[i], i);
+            return true;
+        }
+
+        bool run(uint64_t& bytes, uint64_t& units)
+        {
+            for (uint32_t i = 0; i < m_frames.size(); i++) {
+                std::vector<uint8_t>& frame = m_frames[i];
+                uint8_t* data = &frame[0];
+                uint32_t size = frame.size();
+                if (!m_parser.parseFrameHeader(data, size))
+                    return false;
+                bytes += frame.size();
+                units++;
+            }
+            return true;
+        }
+
+    private:
+        static const uint32_t FRAMES = 60;
+        static const uint32_t WIDTH = 1920;
+        static const uint32_t HEIGHT = 1088;
+        static const uint32_t MB_WIDTH = WIDTH / 16;
+        static const uint32_t MB_HEIGHT = HEIGHT / 16;
+        static const uint32_t FRAME_DATA_BYTES = 8192;
+
+        /* Table 263: STRUCT_C, variable sized transform on */
+        static void writeSequenceHeader(BitWriter& bw)
+        {
+            bw.writeBits(PROFILE_MAIN, 2);
+            bw.writeBits(0, 2); //reserved
+            bw.writeBits(7, 3); //frmrtq_postproc
+            bw.writeBits(31, 5); //bitrtq_postproc
+            bw.writeBits(1, 1); //loop_filter
+            bw.writeBits(0, 1); //reserved
+            bw.writeBits(0, 1); //multires
+            bw.writeBits(1, 1); //reserved
+            bw.writeBits(1, 1); //fastuvmc
+            bw.writeBits(0, 1); //extended_mv
+            bw.writeBits(0, 2); //dquant
+            bw.writeBits(1, 1); //vstransform
+            bw.writeBits(0, 1); //reserved
+            bw.writeBits(0, 1); //overlap
+            bw.writeBits(0, 1); //syncmarker
+            bw.writeBits(0, 1); //rangered
+            bw.writeBits(0, 3); //max_b_frames
+            bw.writeBits(0, 2); //quantizer
+            bw.writeBits(0, 1); //finterpflag
+            bw.writeBits(1, 1); //reserved
+        }
+
+        /* a random plane, coded in one of the modes */
+        static void writeBitPlane(BitWriter& bw, uint32_t mode)
+        {
+            /*Table 69 and Table 80*/
+            static const uint8_t imode[][2] = { { 2, 3 }, { 3, 3 }, { 2, 2 }, { 3, 2 } };
+            static const uint8_t norm2[][2] = { { 0, 1 }, { 4, 3 }, { 5, 3 }, { 3, 2 } };
+            /*Table 81, tiles with one macroblock set*/
+            static const uint8_t norm6[][2] = { { 1, 1 }, { 2, 4 }, { 3, 4 }, { 4, 4 }, { 5, 4 }, { 6, 4 } };
+            bw.writeBits(0, 1); //invert
+            bw.writeBits(imode[mode][0], imode[mode][1]);
+            if (mode == 0) {
+                for (uint32_t j = 0; j < MB_HEIGHT; j++) {
+                    bool coded = rand() % 2;
+                    bw.writeBits(coded, 1);
+                    for (uint32_t i = 0; coded && i < MB_WIDTH; i++)
+                        bw.writeBits(rand() % 2, 1);
+                }
+            }
+            else if (mode == 1) {
+                for (uint32_t i = 0; i < MB_WIDTH; i++) {
+                    bool coded = rand() % 2;
+                    bw.writeBits(coded, 1);
+                    for (uint32_t j = 0; coded && j < MB_HEIGHT; j++)
+                        bw.writeBits(rand() % 2, 1);
+                }
+            }
+            else if (mode == 2) {
+                for (uint32_t i = 0; i < MB_WIDTH * MB_HEIGHT; i += 2) {
+                    uint32_t pair = rand() % 4;
+                    bw.writeBits(norm2[pair][0], norm2[pair][1]);
+                }
+            }
+            else {
+                for (uint32_t i = 0; i < MB_WIDTH * MB_HEIGHT; i += 6) {
+                    uint32_t tile = rand() % 6;
+                    bw.writeBits(norm6[tile][0], norm6[tile][1]);
+                }
+            }
+        }
+
+        /* Table 16 and Table 17, simple/main profile I and P pictures */
+        static void writeFrame(std::vector<uint8_t>& frame, uint32_t index)
+        {
+            bool intra = !(index % 30);
+            BitWriter bw(FRAME_DATA_BYTES + MB_WIDTH * MB_HEIGHT);
+            bw.writeBits(index & 3, 2); //frmcnt
+            bw.writeBits(!intra, 1); //ptype
+            if (intra) {
+                bw.writeBits(0, 7); //bf
+                bw.writeBits(9, 5); //pqindex
+                bw.writeBits(0, 1); //transacfrm
+                bw.writeBits(0, 1); //transacfrm2
+            }
+            else {
+                bw.writeBits(9, 5); //pqindex
+                bw.writeBits(1, 2); //mvmode, mixed mv
+                writeBitPlane(bw, index % 4); //mvtypemb
+                writeBitPlane(bw, (index + 1) % 4); //skipmb
+                bw.writeBits(1, 2); //mvtab
+                bw.writeBits(2, 2); //cbptab
+                bw.writeBits(1, 1); //ttmbf
+                bw.writeBits(0, 2); //ttfrm
+                bw.writeBits(0, 1); //transacfrm
+            }
+            bw.writeBits(1, 1); //transdctab
+            writePayload(bw, FRAME_DATA_BYTES);
+            bw.writeToBytesAligned(true);
+            escape(frame, bw.getBitWriterData(), bw.getCodedBitsCount() / 8);
+        }
+
+        /* the parser reads the ebdu, so the frame needs emulation prevention */
+        static void escape(std::vector<uint8_t>& frame, const uint8_t* data, uint32_t size)
+        {
+            uint32_t zeros = 0;
+            frame.clear();
+            for (uint32_t i = 0; i < size; i++) {
+                if (zeros >= 2 && data[i] <= 3) {
+                    frame.push_back(0x03);
+                    zeros = 0;
+                }
+                frame.push_back(data[i]);
+                zeros = data[i] ? 0 : zeros + 1;
+            }
+        }
+
+        std::vector<std::vector<uint8_t> > m_frames;
+        Parser m_parser;
+
+        static const bool s_registered;
+    };
+
+    const bool VC1ParserBench::s_registered = ParserBenchFactory::register_<VC1ParserBench>("vc1");
+
+} // namespace VC1
+} // namespace YamiParser
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vc1Parser.h"
+
+// system libraries
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+using namespace YamiParser::VC1;
+
+namespace {
+
+/* main profile sequence header (STRUCT_C) and the start of an I frame */
+const uint8_t SEQUENCE_HEADER[] = { 0x4e, 0x39, 0x0a, 0x81, 0x0 };
+const uint8_t FRAME_HEADER[] = { 0x80, 0x6b, 0x97 };
+
+/* The ebdu to rbdu copy the parser did before it read the header in place */
+void legacyConvertToRbdu(std::vector<uint8_t>& rbdu, const uint8_t* data, uint32_t size)
+{
+    const uint8_t startCode[] = { 0x00, 0x00, 0x03 };
+    uint32_t i = 0;
+    rbdu.clear();
+    while (1) {
+        const uint8_t* pos = std::search(data + i, data + size, startCode, startCode + 3);
+        if (pos == data + size) {
+            rbdu.insert(rbdu.end(), data + i, pos);
+            break;
+        }
+        if (pos[3] <= 0x03)
+            rbdu.insert(rbdu.end(), data + i, pos + 2);
+        else
+            rbdu.insert(rbdu.end(), data + i, pos + 3);
+        i = pos - data + 3;
+    }
+}
+
+uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* frame header followed by random payload with escapes, like an encoder
+ * output */
+void fillFrame(std::vector<uint8_t>& frame)
+{
+    std::copy(FRAME_HEADER, FRAME_HEADER + sizeof(FRAME_HEADER), frame.begin());
+    uint32_t zeros = 0;
+    for (size_t i = sizeof(FRAME_HEADER); i < frame.size(); i++) {
+        uint8_t b = (rand() % 8) ? rand() % 256 : 0;
+        if (zeros >= 2 && b <= 3)
+            b = 0x03;
+        zeros = b ? 0 : zeros + 1;
+        frame[i] = b;
+    }
+}
+
+double measure(Parser& parser, const std::vector<uint8_t>& frame, uint32_t loops, bool legacy)
+{
+    std::vector<uint8_t> rbdu;
+    uint32_t offsets = 0;
+    uint64_t start = nowNs();
+    for (uint32_t i = 0; i < loops; i++) {
+        uint8_t* data = const_cast<uint8_t*>(&frame[0]);
+        uint32_t size = frame.size();
+        if (legacy) {
+            legacyConvertToRbdu(rbdu, data, size);
+            data = &rbdu[0];
+            size = rbdu.size();
+        }
+        if (!parser.parseFrameHeader(data, size))
+            fprintf(stderr, "parse failed\n");
+        offsets += parser.m_frameHdr.macroblock_offset;
+    }
+    uint64_t ns = nowNs() - start;
+    /*keep the loop from being optimized out*/
+    if (offsets == 0x12345678)
+        printf(" ");
+    /*frames per second*/
+    return (double)loops * 1000000000 / ns;
+}
+
+} // namespace
+
+int main()
+{
+    static const size_t frameSizes[] = { 4 << 10, 64 << 10, 512 << 10 };
+    /*total bytes to parse per measurement*/
+    const uint64_t budget = 256 << 20;
+
+    Parser parser;
+    uint8_t* seq = const_cast<uint8_t*>(SEQUENCE_HEADER);
+    if (!parser.parseCodecData(seq, sizeof(SEQUENCE_HEADER))) {
+        fprintf(stderr, "bad sequence header\n");
+        return 1;
+    }
+
+    srand(0);
+    printf("%10s %14s %14s %9s\n", "frame", "copy fps", "in place fps", "speedup");
+    for (size_t s = 0; s < sizeof(frameSizes) / sizeof(frameSizes[0]); s++) {
+        std::vector<uint8_t> frame(frameSizes[s]);
+        fillFrame(frame);
+        uint32_t loops = std::max<uint64_t>(1, budget / frame.size());
+        double oldFps = measure(parser, frame, loops, true);
+        double newFps = measure(parser, frame, loops, false);
+        printf("%10zu %14.0f %14.0f %8.2fx\n", frameSizes[s], oldFps, newFps, newFps / oldFps);
+    }
+    return 0;
+}
@@ -21,6 +21,7 @@
 #include "vc1Parser.h"
 
 // library headers
+#include "bitWriter.h"
 #include "common/Array.h"
 #include "common/unittest.h"
 
@@ -635,6 +636,51 @@ namespace VC1 {
 
 #define VC1_PARSER_TEST(name) TEST_F(VC1ParserTest, name)
 
+    /* main profile frames are built by hand, so the bitplanes can be
+       checked against the values that were written */
+    static void setupMainProfile(Parser& parser, uint32_t mbWidth, uint32_t mbHeight)
+    {
+        memset(&(parser.m_seqHdr), 0, sizeof(parser.m_seqHdr));
+        memset(&(parser.m_entryPointHdr), 0, sizeof(parser.m_entryPointHdr));
+        parser.m_seqHdr.profile = PROFILE_MAIN;
+        parser.m_seqHdr.coded_width = mbWidth * 16;
+        parser.m_seqHdr.coded_height = mbHeight * 16;
+    }
+
+    /* FRMCNT, PTYPE, PQINDEX and MVMODE of a P frame, SKIPMB follows */
+    static void writePFrameStart(BitWriter& bw)
+    {
+        bw.writeBits(0, 2);
+        bw.writeBits(1, 1);
+        bw.writeBits(9, 5);
+        bw.writeBits(1, 1);
+    }
+
+    /* MVTAB, CBPTAB, TRANSACFRM and DCTAB, then some macroblock data */
+    static bool parseFrameEnd(Parser& parser, BitWriter& bw)
+    {
+        bw.writeBits(0, 6);
+        bw.writeBits(0xffff, 16);
+        bw.writeToBytesAligned();
+        uint8_t* data = bw.getBitWriterData();
+        uint32_t size = bw.getCodedBitsCount() >> 3;
+        return parser.parseFrameHeader(data, size);
+    }
+
+    static void writeBits(BitWriter& bw, const uint8_t* bits, uint32_t n)
+    {
+        for (uint32_t i = 0; i < n; i++)
+            bw.writeBits(bits[i], 1);
+    }
+
+    static void checkSkipPlane(const Parser& parser, const std::vector<uint8_t>& plane)
+    {
+        EXPECT_FALSE(parser.m_frameHdr.skip_mb);
+        ASSERT_EQ(plane.size(), parser.m_mbWidth * parser.m_mbHeight);
+        for (uint32_t i = 0; i < plane.size(); i++)
+            EXPECT_EQ(plane[i], parser.m_bitPlanes.skipmb[i]) << "at " << i;
+    }
+
     VC1_PARSER_TEST(ParseSequenceHeader)
     {
         Parser parser;
@@ -663,5 +709,187 @@ namespace VC1 {
         checkParamsFrameHeader(parser);
     }
 
+    VC1_PARSER_TEST(EbduReaderDropsEscapes)
+    {
+        const uint8_t data[] = { 0x00, 0x00, 0x03, 0x01, 0xff };
+        EbduReader reader(data, sizeof(data));
+        EXPECT_EQ(0x0u, reader.read(8));
+        EXPECT_EQ(0x0u, reader.read(8));
+        EXPECT_EQ(0x1u, reader.read(8));
+        EXPECT_EQ(24u, reader.getRbduPos());
+        EXPECT_EQ(32u, reader.getPos());
+        EXPECT_EQ(0xffu, reader.read(8));
+        EXPECT_TRUE(reader.end());
+    }
+
+    VC1_PARSER_TEST(ParseFrameHeaderInPlace)
+    {
+        Parser parser;
+        uint8_t* data;
+        uint32_t size;
+        memset(&(parser.m_seqHdr), 0, sizeof(parser.m_seqHdr));
+        memset(&(parser.m_entryPointHdr), 0, sizeof(parser.m_entryPointHdr));
+        data = const_cast<uint8_t*>(SequenceHeader.data());
+        size = SequenceHeader.size();
+        ASSERT_TRUE(parser.parseCodecData(data, size));
+
+        /*an escape right after the header is loaded with it, but it must
+          not be counted in macroblock_offset*/
+        const uint8_t escape[] = { 0x00, 0x00, 0x03, 0x01 };
+        std::vector<uint8_t> frame(g_MainVC1.begin(), g_MainVC1.end());
+        frame.insert(frame.begin() + 3, escape, escape + sizeof(escape));
+        const std::vector<uint8_t> copy(frame);
+
+        data = &frame[0];
+        size = frame.size();
+        ASSERT_TRUE(parser.parseFrameHeader(data, size));
+        checkParamsFrameHeader(parser);
+        EXPECT_EQ(&frame[0], data);
+        EXPECT_EQ(frame.size(), size);
+        EXPECT_TRUE(copy == frame);
+    }
+
+    VC1_PARSER_TEST(DecodeRowskipBitPlane)
+    {
+        Parser parser;
+        /*1080p, rows are longer than a word*/
+        const uint32_t width = 120, height = 68;
+        setupMainProfile(parser, width, height);
+
+        std::vector<uint8_t> plane(width * height);
+        BitWriter bw;
+        writePFrameStart(bw);
+        bw.writeBits(0, 1); /*INVERT*/
+        bw.writeBits(2, 3); /*IMODE rowskip*/
+        for (uint32_t j = 0; j < height; j++) {
+            bool coded = j % 3;
+            bw.writeBits(coded, 1);
+            for (uint32_t i = 0; coded && i < width; i++)
+                plane[j * width + i] = (i * 7 + j) % 5 < 2;
+            if (coded)
+                writeBits(bw, &plane[j * width], width);
+        }
+        ASSERT_TRUE(parseFrameEnd(parser, bw));
+        checkSkipPlane(parser, plane);
+    }
+
+    VC1_PARSER_TEST(DecodeColskipBitPlane)
+    {
+        Parser parser;
+        const uint32_t width = 120, height = 68;
+        setupMainProfile(parser, width, height);
+
+        std::vector<uint8_t> plane(width * height, 1);
+        BitWriter bw;
+        writePFrameStart(bw);
+        bw.writeBits(1, 1); /*INVERT*/
+        bw.writeBits(3, 3); /*IMODE colskip*/
+        for (uint32_t i = 0; i < width; i++) {
+            bool coded = i % 3;
+            bw.writeBits(coded, 1);
+            for (uint32_t j = 0; coded && j < height; j++) {
+                uint8_t bit = (i + j * 3) % 4 == 0;
+                bw.writeBits(bit, 1);
+                plane[j * width + i] = !bit;
+            }
+        }
+        ASSERT_TRUE(parseFrameEnd(parser, bw));
+        checkSkipPlane(parser, plane);
+    }
+
+    VC1_PARSER_TEST(DecodeNorm2BitPlane)
+    {
+        Parser parser;
+        setupMainProfile(parser, 5, 3);
+
+        BitWriter bw;
+        writePFrameStart(bw);
+        bw.writeBits(0, 1); /*INVERT*/
+        bw.writeBits(2, 2); /*IMODE norm2*/
+        /*odd count, the first one is raw*/
+        bw.writeBits(1, 1);
+        bw.writeBits(3, 2);
+        bw.writeBits(0, 1);
+        bw.writeBits(4, 3);
+        bw.writeBits(5, 3);
+        bw.writeBits(0, 1);
+        bw.writeBits(3, 2);
+        bw.writeBits(4, 3);
+        ASSERT_TRUE(parseFrameEnd(parser, bw));
+
+        const uint8_t expected[] = { 1, 1, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 0 };
+        checkSkipPlane(parser, std::vector<uint8_t>(expected, expected + sizeof(expected)));
+    }
+
+    VC1_PARSER_TEST(DecodeNorm6BitPlane)
+    {
+        Parser parser;
+        /*2x3 tiles for columns 1 to 4, column 0 is column skipped*/
+        setupMainProfile(parser, 5, 3);
+
+        BitWriter bw;
+        writePFrameStart(bw);
+        bw.writeBits(0, 1); /*INVERT*/
+        bw.writeBits(3, 2); /*IMODE norm6*/
+        bw.writeBits(7, 6); /*tile 63*/
+        bw.writeBits(1, 1); /*tile 0*/
+        bw.writeBits(1, 1);
+        bw.writeBits(5, 3);
+        ASSERT_TRUE(parseFrameEnd(parser, bw));
+
+        const uint8_t expected[] = {
+            1, 1, 1, 0, 0,
+            0, 1, 1, 0, 0,
+            1, 1, 1, 0, 0
+        };
+        checkSkipPlane(parser, std::vector<uint8_t>(expected, expected + sizeof(expected)));
+    }
+
+    VC1_PARSER_TEST(DecodeBFraction)
+    {
+        Parser parser;
+        setupMainProfile(parser, 5, 3);
+        parser.m_seqHdr.max_b_frames = 1;
+
+        BitWriter bw;
+        bw.writeBits(0, 2); /*FRMCNT*/
+        bw.writeBits(0, 2); /*PTYPE B*/
+        bw.writeBits(3, 3); /*BFRACTION 1/4*/
+        bw.writeBits(9, 5); /*PQINDEX*/
+        bw.writeBits(1, 1); /*MVMODE*/
+        bw.writeBits(0, 5); /*DIRECTMB raw*/
+        bw.writeBits(0, 5); /*SKIPMB raw*/
+        ASSERT_TRUE(parseFrameEnd(parser, bw));
+        EXPECT_EQ(FRAME_B, parser.m_frameHdr.picture_type);
+        EXPECT_EQ(3, parser.m_frameHdr.bfraction);
+        EXPECT_TRUE(parser.m_frameHdr.direct_mb);
+        EXPECT_TRUE(parser.m_frameHdr.skip_mb);
+    }
+
+    VC1_PARSER_TEST(BitPlanesReused)
+    {
+        Parser parser;
+        setupMainProfile(parser, 5, 3);
+        BitWriter first;
+        writePFrameStart(first);
+        first.writeBits(0, 5); /*SKIPMB raw*/
+        ASSERT_TRUE(parseFrameEnd(parser, first));
+        const uint8_t* skipmb = parser.m_bitPlanes.skipmb;
+
+        BitWriter second;
+        writePFrameStart(second);
+        second.writeBits(0, 5);
+        ASSERT_TRUE(parseFrameEnd(parser, second));
+        EXPECT_EQ(skipmb, parser.m_bitPlanes.skipmb);
+
+        /*a smaller frame fits too*/
+        setupMainProfile(parser, 4, 3);
+        BitWriter third;
+        writePFrameStart(third);
+        third.writeBits(0, 5);
+        ASSERT_TRUE(parseFrameEnd(parser, third));
+        EXPECT_EQ(skipmb, parser.m_bitPlanes.skipmb);
+    }
+
 } // namespace VC1
 } // namespace YamiParser
@@ -81,35 +81,14 @@ namespace YamiParser {
 
 #define CHAR_BIT 8
 
-#define VP8_BD_VALUE_BIT \
-  static_cast<int>(sizeof(Vp8BoolDecoder::value_) * CHAR_BIT)
+#define VP8_BD_VALUE_BIT Vp8BoolDecoder::kValueBits
 
 static const int kDefaultProbability = 0x80;  // 0x80 / 256 = 0.5
 
 // This is meant to be a large, positive constant that can still be efficiently
 // loaded as an immediate (on platforms like ARM, for example). Even relatively
 // modest values like 100 would work fine.
-#define VP8_LOTS_OF_BITS (0x40000000)
-
-// The number of leading zeros.
-static const unsigned char kVp8Norm[256] = {
-    0, 7, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4, 4, 4, 4, 4,
-    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
-    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-};
+#define VP8_LOTS_OF_BITS Vp8BoolDecoder::kLotsOfBits
 
 Vp8BoolDecoder::Vp8BoolDecoder()
     : user_buffer_(NULL),
@@ -139,6 +118,20 @@ void Vp8BoolDecoder::FillDecoder() {
   int x = static_cast<int>(shift + CHAR_BIT - bits_left);
   int loop_end = 0;
 
+  if (bytes_left >= sizeof(size_t)) {
+    // Same as the loop below, which reads (shift / 8 + 1) bytes, but with
+    // one big-endian word load. Bytes after them are masked out.
+    size_t bytes = (shift >> 3) + 1;
+    size_t word = 0;
+    for (size_t i = 0; i < sizeof(size_t); ++i)
+      word = (word << CHAR_BIT) | user_buffer_[i];
+    word &= ~static_cast<size_t>(0) << (VP8_BD_VALUE_BIT - bytes * CHAR_BIT);
+    value_ |= word >> (VP8_BD_VALUE_BIT - CHAR_BIT - shift);
+    user_buffer_ += bytes;
+    count_ += static_cast<int>(bytes) * CHAR_BIT;
+    return;
+  }
+
   if (x >= 0) {
     count_ += VP8_LOTS_OF_BITS;
     loop_end = x;
@@ -154,41 +147,48 @@ void Vp8BoolDecoder::FillDecoder() {
   }
 }
 
-int Vp8BoolDecoder::ReadBit(int probability) {
-  int bit = 0;
-  size_t split = 1 + (((range_ - 1) * probability) >> 8);
-  if (count_ < 0)
-    FillDecoder();
-  size_t bigsplit = static_cast<size_t>(split) << (VP8_BD_VALUE_BIT - 8);
-
-  if (value_ >= bigsplit) {
-    range_ -= split;
-    value_ -= bigsplit;
-    bit = 1;
-  } else {
-    range_ = split;
+int Vp8BoolDecoder::ReadLiteralBits(size_t num_bits) {
+  int value = 0;
+  while (num_bits > 0) {
+    if (count_ < 0)
+      FillDecoder();
+    // With probability 1/2, |range_| is at least 64 after a bit, so a bit
+    // shifts out one bit at most, and count_ + 1 bits can be read before
+    // the next fill.
+    size_t bits = std::min(num_bits, static_cast<size_t>(count_) + 1);
+    num_bits -= bits;
+    for (; bits > 0; --bits) {
+      // 1 + (((range_ - 1) * kDefaultProbability) >> 8)
+      size_t split = (range_ + 1) >> 1;
+      size_t bigsplit = split << (VP8_BD_VALUE_BIT - 8);
+      // Literal bits are random, update the state with a mask instead of
+      // a branch: range_ - split and value_ - bigsplit for 1, split and
+      // value_ for 0.
+      int bit = value_ >= bigsplit;
+      size_t mask = 0 - static_cast<size_t>(bit);
+      range_ = split + ((range_ - (split << 1)) & mask);
+      value_ -= bigsplit & mask;
+      size_t shift = range_ < 128;
+      range_ <<= shift;
+      value_ <<= shift;
+      count_ -= shift;
+      value = (value << 1) | bit;
+    }
   }
-
-  size_t shift = kVp8Norm[range_];
-  range_ <<= shift;
-  value_ <<= shift;
-  count_ -= shift;
-
-  //DCHECK_EQ(1U, (range_ >> 7));  // In the range [128, 255].
-
-  return bit;
+  return value;
 }
 
 bool Vp8BoolDecoder::ReadLiteral(size_t num_bits, int* out) {
   //DCHECK_LE(num_bits, sizeof(int) * CHAR_BIT);
-  *out = 0;
-  for (; num_bits > 0; --num_bits)
-    *out = (*out << 1) | ReadBit(kDefaultProbability);
+  *out = ReadLiteralBits(num_bits);
   return !OutOfBuffer();
 }
 
-bool Vp8BoolDecoder::ReadBool(bool* out, uint8_t probability) {
-  *out = !!ReadBit(probability);
+bool Vp8BoolDecoder::ReadLiterals(size_t num_bits, uint8_t* out,
+                                  size_t count) {
+  //DCHECK_LE(num_bits, 8);
+  for (size_t i = 0; i < count; ++i)
+    out[i] = static_cast<uint8_t>(ReadLiteralBits(num_bits));
   return !OutOfBuffer();
 }
 
@@ -197,9 +197,9 @@ bool Vp8BoolDecoder::ReadBool(bool* out) {
 }
 
 bool Vp8BoolDecoder::ReadLiteralWithSign(size_t num_bits, int* out) {
-  ReadLiteral(num_bits, out);
+  *out = ReadLiteralBits(num_bits);
   // Read sign.
-  if (ReadBit(kDefaultProbability))
+  if (ReadLiteralBits(1))
     *out = -*out;
   return !OutOfBuffer();
 }
@@ -222,19 +222,4 @@ uint8_t Vp8BoolDecoder::GetBottom() {
   return static_cast<uint8_t>(value_ >> (VP8_BD_VALUE_BIT - 8));
 }
 
-inline bool Vp8BoolDecoder::OutOfBuffer() {
-  // Check if we have reached the end of the buffer.
-  //
-  // Variable |count_| stores the number of bits in the |value_| buffer, minus
-  // 8. The top byte is part of the algorithm and the remainder is buffered to
-  // be shifted into it. So, if |count_| == 8, the top 16 bits of |value_| are
-  // occupied, 8 for the algorithm and 8 in the buffer.
-  //
-  // When reading a byte from the user's buffer, |count_| is filled with 8 and
-  // one byte is filled into the |value_| buffer. When we reach the end of the
-  // data, |count_| is additionally filled with VP8_LOTS_OF_BITS. So when
-  // |count_| == VP8_LOTS_OF_BITS - 1, the user's data has been exhausted.
-  return (count_ > VP8_BD_VALUE_BIT) && (count_ < VP8_LOTS_OF_BITS);
-}
-
 }  // namespace YamiParser
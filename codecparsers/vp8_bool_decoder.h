@@ -108,6 +108,12 @@ class Vp8BoolDecoder {
   // literal.
   bool ReadLiteral(size_t num_bits, int* out);
 
+  // Reads |count| literals of |num_bits| (<= 8) each to |out|. It is the
+  // same as calling ReadLiteral() |count| times, like when a header updates
+  // an array of probabilities. Returns false if it has reached the end of
+  // |data|.
+  bool ReadLiterals(size_t num_bits, uint8_t* out, size_t count);
+
   // Reads a literal with sign from the coded stream. This is similar to
   // the ReadListeral(), it first read a "num_bits"-wide unsigned value, and
   // then read an extra bit as the sign of the literal. Returns false if it has
@@ -141,6 +147,10 @@ class Vp8BoolDecoder {
   // be one is |probability| / 256.
   int ReadBit(int probability);
 
+  // Reads |num_bits| bits with probability 1/2, high-order bit first. It
+  // checks the fill once for all bits that are already in |value_|.
+  int ReadLiteralBits(size_t num_bits);
+
   // Fills more bits from |user_buffer_| to |value_|. We shall keep at least 8
   // bits of the current |user_buffer_| in |value_|.
   void FillDecoder();
@@ -148,6 +158,11 @@ class Vp8BoolDecoder {
   // Returns true iff we have ran out of bits.
   bool OutOfBuffer();
 
+  // Bits of |value_|.
+  static const int kValueBits = sizeof(size_t) * 8;
+  // Added to |count_| once |user_buffer_| is used up.
+  static const int kLotsOfBits = 0x40000000;
+
   const uint8_t* user_buffer_;
   const uint8_t* user_buffer_start_;
   const uint8_t* user_buffer_end_;
@@ -158,6 +173,55 @@ class Vp8BoolDecoder {
   DISALLOW_COPY_AND_ASSIGN(Vp8BoolDecoder);
 };
 
+// ReadBit() and ReadBool() run for every flag of the frame header, they are
+// defined here to be inlined to the parser.
+inline int Vp8BoolDecoder::ReadBit(int probability) {
+  size_t split = 1 + (((range_ - 1) * probability) >> 8);
+  if (count_ < 0)
+    FillDecoder();
+  size_t bigsplit = split << (kValueBits - 8);
+
+  int bit = 0;
+  if (value_ >= bigsplit) {
+    range_ -= split;
+    value_ -= bigsplit;
+    bit = 1;
+  } else {
+    range_ = split;
+  }
+
+  // Normalize |range_| back to [128, 255]. It is in [1, 255] here.
+  size_t shift = __builtin_clz(static_cast<unsigned int>(range_))
+                 - (sizeof(unsigned int) - 1) * 8;
+  range_ <<= shift;
+  value_ <<= shift;
+  count_ -= shift;
+
+  //DCHECK_EQ(1U, (range_ >> 7));  // In the range [128, 255].
+
+  return bit;
+}
+
+inline bool Vp8BoolDecoder::ReadBool(bool* out, uint8_t probability) {
+  *out = !!ReadBit(probability);
+  return !OutOfBuffer();
+}
+
+inline bool Vp8BoolDecoder::OutOfBuffer() {
+  // Check if we have reached the end of the buffer.
+  //
+  // Variable |count_| stores the number of bits in the |value_| buffer, minus
+  // 8. The top byte is part of the algorithm and the remainder is buffered to
+  // be shifted into it. So, if |count_| == 8, the top 16 bits of |value_| are
+  // occupied, 8 for the algorithm and 8 in the buffer.
+  //
+  // When reading a byte from the user's buffer, |count_| is filled with 8 and
+  // one byte is filled into the |value_| buffer. When we reach the end of the
+  // data, |count_| is additionally filled with kLotsOfBits. So when
+  // |count_| == kLotsOfBits - 1, the user's data has been exhausted.
+  return (count_ > kValueBits) && (count_ < kLotsOfBits);
+}
+
 }  // namespace YamiParser
 
 #endif  // VP8_BOOL_DECODER_H_
@@ -0,0 +1,252 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vp8_bool_decoder.h"
+
+// system libraries
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+using namespace YamiParser;
+
+namespace {
+
+/* The decoder before word refills and clz, kept here as reference:
+ * byte by byte refill, table normalization and one ReadBit per literal bit.
+ * The public functions are not inlined, like the ones in the library */
+class LegacyBoolDecoder {
+public:
+    LegacyBoolDecoder(const uint8_t* data, size_t size)
+        : user_buffer_(data)
+        , user_buffer_end_(data + size)
+        , value_(0)
+        , count_(-8)
+        , range_(255)
+    {
+    }
+
+    __attribute__((noinline)) bool ReadBool(bool* out, uint8_t probability)
+    {
+        *out = !!ReadBit(probability);
+        return !OutOfBuffer();
+    }
+
+    __attribute__((noinline)) bool ReadLiteral(size_t num_bits, int* out)
+    {
+        *out = 0;
+        for (; num_bits > 0; --num_bits)
+            *out = (*out << 1) | ReadBit(0x80);
+        return !OutOfBuffer();
+    }
+
+private:
+    static const int VALUE_BITS = sizeof(size_t) * 8;
+    static const int LOTS_OF_BITS = 0x40000000;
+    static const unsigned char kNorm[256];
+
+    void FillDecoder()
+    {
+        int shift = VALUE_BITS - 8 - (count_ + 8);
+        size_t bits_left = (user_buffer_end_ - user_buffer_) * 8;
+        int x = static_cast<int>(shift + 8 - bits_left);
+        int loop_end = 0;
+
+        if (x >= 0) {
+            count_ += LOTS_OF_BITS;
+            loop_end = x;
+        }
+        if (x < 0 || bits_left) {
+            while (shift >= loop_end) {
+                count_ += 8;
+                value_ |= static_cast<size_t>(*user_buffer_) << shift;
+                ++user_buffer_;
+                shift -= 8;
+            }
+        }
+    }
+
+    int ReadBit(int probability)
+    {
+        int bit = 0;
+        size_t split = 1 + (((range_ - 1) * probability) >> 8);
+        if (count_ < 0)
+            FillDecoder();
+        size_t bigsplit = split << (VALUE_BITS - 8);
+        if (value_ >= bigsplit) {
+            range_ -= split;
+            value_ -= bigsplit;
+            bit = 1;
+        }
+        else {
+            range_ = split;
+        }
+        size_t shift = kNorm[range_];
+        range_ <<= shift;
+        value_ <<= shift;
+        count_ -= shift;
+        return bit;
+    }
+
+    bool OutOfBuffer() const
+    {
+        return (count_ > VALUE_BITS) && (count_ < LOTS_OF_BITS);
+    }
+
+    const uint8_t* user_buffer_;
+    const uint8_t* user_buffer_end_;
+    size_t value_;
+    int count_;
+    size_t range_;
+};
+
+const unsigned char LegacyBoolDecoder::kNorm[256] = {
+    0, 7, 6, 6, 5, 5, 5, 5, 4, 4, 4, 4, 4, 4, 4, 4,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    /*the rest is zero*/
+};
+
+/* Vp8BoolDecoder is not copyable and is initialized instead */
+class CurrentBoolDecoder : public Vp8BoolDecoder {
+public:
+    CurrentBoolDecoder(const uint8_t* data, size_t size)
+    {
+        Initialize(data, size);
+    }
+};
+
+uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* like Vp8Parser::ParseTokenProbs(): 4 * 8 * 3 * 11 flags with high
+ * probabilities, and an 8 bits literal for each set flag */
+const size_t kNumTokenProbs = 4 * 8 * 3 * 11;
+std::vector<uint8_t> g_updateProbs;
+
+template <class Decoder>
+uint32_t tokenProbsLoop(const std::vector<uint8_t>& data, size_t frameSize)
+{
+    uint32_t sum = 0;
+    for (size_t offset = 0; offset + frameSize <= data.size(); offset += frameSize) {
+        Decoder bd(&data[offset], frameSize);
+        for (size_t i = 0; i < kNumTokenProbs; i++) {
+            bool update;
+            int prob;
+            if (!bd.ReadBool(&update, g_updateProbs[i]))
+                break;
+            if (update && bd.ReadLiteral(8, &prob))
+                sum += prob;
+        }
+    }
+    return sum;
+}
+
+template <class Decoder>
+uint32_t boolLoop(const std::vector<uint8_t>& data, size_t)
+{
+    Decoder bd(&data[0], data.size());
+    uint32_t sum = 0;
+    bool bit;
+    size_t i = 0;
+    while (bd.ReadBool(&bit, g_updateProbs[i])) {
+        sum += bit;
+        if (++i == kNumTokenProbs)
+            i = 0;
+    }
+    return sum;
+}
+
+template <class Decoder>
+uint32_t literalLoop(const std::vector<uint8_t>& data, size_t)
+{
+    Decoder bd(&data[0], data.size());
+    uint32_t sum = 0;
+    int value;
+    for (uint32_t i = 0; bd.ReadLiteral(1 + (i & 7), &value); i++)
+        sum += value;
+    return sum;
+}
+
+typedef uint32_t (*Loop)(const std::vector<uint8_t>& data, size_t frameSize);
+
+double measure(Loop loop, const std::vector<uint8_t>& data, size_t frameSize,
+    uint32_t loops, uint32_t& sum)
+{
+    sum = 0;
+    uint64_t start = nowNs();
+    for (uint32_t i = 0; i < loops; i++)
+        sum += loop(data, frameSize);
+    uint64_t ns = nowNs() - start;
+    return (double)data.size() * loops * 1000 / ns;
+}
+
+bool report(const char* name, Loop legacy, Loop current,
+    const std::vector<uint8_t>& data, size_t frameSize, uint32_t loops)
+{
+    uint32_t oldSum, newSum;
+    double oldSpeed = measure(legacy, data, frameSize, loops, oldSum);
+    double newSpeed = measure(current, data, frameSize, loops, newSum);
+    printf("%-16s %12.1f %12.1f %8.2fx\n", name, oldSpeed, newSpeed, newSpeed / oldSpeed);
+    if (oldSum != newSum) {
+        fprintf(stderr, "%s: results differ, %u vs %u\n", name, oldSum, newSum);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    const uint32_t size = 1 << 20;
+    const uint32_t loops = 16;
+    /*compressed header of a small frame, the token probs fit in it*/
+    const size_t frameSize = 512;
+    std::vector<uint8_t> data(size);
+
+    srand(0);
+    for (uint32_t i = 0; i < size; i++)
+        data[i] = rand() % 256;
+    g_updateProbs.resize(kNumTokenProbs);
+    for (size_t i = 0; i < kNumTokenProbs; i++)
+        g_updateProbs[i] = 176 + rand() % 80;
+
+    bool ok = true;
+    printf("%-16s %12s %12s %9s\n", "case", "old MB/s", "new MB/s", "speedup");
+    ok &= report("token probs", tokenProbsLoop<LegacyBoolDecoder>,
+        tokenProbsLoop<CurrentBoolDecoder>, data, frameSize, loops);
+    ok &= report("bools", boolLoop<LegacyBoolDecoder>,
+        boolLoop<CurrentBoolDecoder>, data, frameSize, loops);
+    ok &= report("literals", literalLoop<LegacyBoolDecoder>,
+        literalLoop<CurrentBoolDecoder>, data, frameSize, loops);
+    return ok ? 0 : -1;
+}
@@ -158,4 +158,25 @@ TEST_F(Vp8BoolDecoderTest, DecodeBoolsWithParitiesAndIncreasingProbabilities) {
   }
 }
 
+TEST_F(Vp8BoolDecoderTest, DecodeLiteralsInBatch) {
+  INITIALIZE(kDataParitiesAndIncreasingProbabilities);
+  Vp8BoolDecoder bd;
+  ASSERT_TRUE(bd.Initialize(kDataParitiesAndIncreasingProbabilities,
+                            sizeof(kDataParitiesAndIncreasingProbabilities)));
+
+  uint8_t values[16];
+  ASSERT_TRUE(bd_.ReadLiterals(7, values, 4));
+  ASSERT_TRUE(bd_.ReadLiterals(8, values + 4, 12));
+  for (size_t i = 0; i < 16; ++i) {
+    int value;
+    ASSERT_TRUE(bd.ReadLiteral(i < 4 ? 7 : 8, &value));
+    EXPECT_EQ(value, values[i]);
+  }
+  EXPECT_EQ(bd.BitOffset(), bd_.BitOffset());
+  EXPECT_EQ(bd.GetRange(), bd_.GetRange());
+  EXPECT_EQ(bd.GetBottom(), bd_.GetBottom());
+
+  EXPECT_FALSE(bd_.ReadLiterals(8, values, 16));
+}
+
 }  // namespace YamiParser
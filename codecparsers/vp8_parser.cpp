@@ -811,8 +811,8 @@ bool Vp8Parser::ParseIntraProbs(Vp8EntropyHeader* ehdr,
     bool intra_16x16_prob_update_flag;
     BD_READ_BOOL_OR_RETURN(&intra_16x16_prob_update_flag);
     if (intra_16x16_prob_update_flag) {
-      for (size_t i = 0; i < kNumYModeProbs; ++i)
-        BD_READ_UNSIGNED_OR_RETURN(8, &ehdr->y_mode_probs[i]);
+      if (!bd_.ReadLiterals(8, ehdr->y_mode_probs, kNumYModeProbs))
+        ERROR_RETURN(ehdr->y_mode_probs);
 
       if (update_curr_probs) {
         memcpy(curr_entropy_hdr_.y_mode_probs, ehdr->y_mode_probs,
@@ -823,8 +823,8 @@ bool Vp8Parser::ParseIntraProbs(Vp8EntropyHeader* ehdr,
     bool intra_chroma_prob_update_flag;
     BD_READ_BOOL_OR_RETURN(&intra_chroma_prob_update_flag);
     if (intra_chroma_prob_update_flag) {
-      for (size_t i = 0; i < kNumUVModeProbs; ++i)
-        BD_READ_UNSIGNED_OR_RETURN(8, &ehdr->uv_mode_probs[i]);
+      if (!bd_.ReadLiterals(8, ehdr->uv_mode_probs, kNumUVModeProbs))
+        ERROR_RETURN(ehdr->uv_mode_probs);
 
       if (update_curr_probs) {
         memcpy(curr_entropy_hdr_.uv_mode_probs, ehdr->uv_mode_probs,
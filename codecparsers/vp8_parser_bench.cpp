@@ -0,0 +1,102 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vp8_parser.h"
+
+// library headers
+#include "parserBench.h"
+
+// system libraries
+#include <stdlib.h>
+
+namespace YamiParser {
+
+/* 1920x1080, a key frame every 30 frames. The first partition is random,
+ * so the bool decoder goes through random header fields and plenty of
+ * token probability updates. The partition sizes after it are made up
+ * for the largest partition count, so any count the header gives works. */
+class Vp8ParserBench : public ParserBench {
+public:
+    const char* unit() const { return "frame"; }
+
+    bool setUp()
+    {
+        m_frames.resize(FRAMES);
+        for (uint32_t i = 0; i < FRAMES; i++)
+            writeFrame(m_frames[i], !(i % 30));
+        return true;
+    }
+
+    bool run(uint64_t& bytes, uint64_t& units)
+    {
+        Vp8FrameHeader hdr;
+        for (uint32_t i = 0; i < m_frames.size(); i++) {
+            const std::vector<uint8_t>& frame = m_frames[i];
+            if (m_parser.ParseFrame(&frame[0], frame.size(), &hdr) != VP8_PARSER_OK)
+                return false;
+            bytes += frame.size();
+            units++;
+        }
+        return true;
+    }
+
+private:
+    static const uint32_t FRAMES = 60;
+    static const uint32_t FIRST_PART_BYTES = 1024;
+    static const uint32_t DCT_PART_BYTES = 2048;
+
+    static void writeFrame(std::vector<uint8_t>& frame, bool key)
+    {
+        const uint32_t sizeBytes = (kMaxDCTPartitions - 1) * 3;
+        frame.clear();
+        /*frame tag: version 0, show_frame, first_part_size*/
+        uint32_t tag = (key ? 0 : 1) | (1 << 4) | (FIRST_PART_BYTES << 5);
+        frame.push_back(tag & 0xff);
+        frame.push_back((tag >> 8) & 0xff);
+        frame.push_back(tag >> 16);
+        if (key) {
+            const uint8_t startCode[] = { 0x9d, 0x01, 0x2a };
+            frame.insert(frame.end(), startCode, startCode + sizeof(startCode));
+            frame.push_back(1920 & 0xff);
+            frame.push_back(1920 >> 8);
+            frame.push_back(1080 & 0xff);
+            frame.push_back(1080 >> 8);
+        }
+        for (uint32_t i = 0; i < FIRST_PART_BYTES; i++)
+            frame.push_back(rand() % 256);
+        for (uint32_t i = 0; i < sizeBytes; i += 3) {
+            frame.push_back(DCT_PART_BYTES & 0xff);
+            frame.push_back(DCT_PART_BYTES >> 8);
+            frame.push_back(0);
+        }
+        for (uint32_t i = 0; i < DCT_PART_BYTES * kMaxDCTPartitions; i++)
+            frame.push_back(rand() % 256);
+    }
+
+    std::vector<std::vector<uint8_t> > m_frames;
+    Vp8Parser m_parser;
+
+    static const bool s_registered;
+};
+
+const bool Vp8ParserBench::s_registered = ParserBenchFactory::register_<Vp8ParserBench>("vp8");
+
+} // namespace YamiParser
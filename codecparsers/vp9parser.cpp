@@ -38,31 +38,6 @@ using YamiParser::BitReader;
 #define MAX_LOOP_FILTER 63
 #define MAX_PROB 255
 
-typedef struct _ReferenceSize
-{
-  uint32_t width;
-  uint32_t height;
-}ReferenceSize;
-
-typedef struct _Vp9ParserPrivate
-{
-  int8_t   y_dc_delta_q;
-  int8_t   uv_dc_delta_q;
-  int8_t   uv_ac_delta_q;
-
-  int16_t   y_dequant[QINDEX_RANGE][2];
-  int16_t   uv_dequant[QINDEX_RANGE][2];
-
-  /* for loop filters */
-  int8_t    ref_deltas[VP9_MAX_REF_LF_DELTAS];
-  int8_t    mode_deltas[VP9_MAX_MODE_LF_DELTAS];
-
-  BOOL segmentation_abs_delta;
-  Vp9SegmentationInfoData segmentation[VP9_MAX_SEGMENTS];
-
-  ReferenceSize reference[VP9_REF_FRAMES];
-} Vp9ParserPrivate;
-
 void init_dequantizer(Vp9Parser* parser);
 
 static void init_vp9_parser(Vp9Parser* parser)
@@ -483,7 +458,7 @@ static void reference_update(Vp9Parser* parser, const Vp9FrameHdr* const frame_h
   uint8_t refresh_frame_flags;
   int i;
   Vp9ParserPrivate* priv = (Vp9ParserPrivate*)parser->priv;
-  ReferenceSize* reference = priv->reference;
+  Vp9ReferenceSize* reference = priv->reference;
   if (frame_hdr->frame_type == VP9_KEY_FRAME) {
     refresh_frame_flags = 0xff;
   } else {
@@ -545,30 +520,27 @@ static Vp9ParseResult vp9_parser_update(Vp9Parser* parser, Vp9FrameHdr* const fr
   return VP9_PARSER_OK;
 }
 
-Vp9ParseResult
-vp9_parse_frame_header (Vp9Parser* parser, Vp9FrameHdr * frame_hdr, const uint8_t * data, uint32_t size)
+/* uncompressed header until the frame size, parser is not changed */
+static BOOL read_frame_info(const Vp9Parser* parser, Vp9FrameHdr* frame_hdr, BitReader* br)
 {
-#define FRAME_CONTEXTS_BITS 2
-  BitReader bit_reader(data, size);
-  BitReader* br = &bit_reader;
   memset(frame_hdr, 0, sizeof(*frame_hdr));
   /* Uncompressed Data Chunk */
   if (!verify_frame_marker(br))
-    goto error;
+    return FALSE;
   frame_hdr->profile = read_profile(br);
   if (frame_hdr->profile > MAX_VP9_PROFILES)
-    goto error;
+    return FALSE;
   frame_hdr->show_existing_frame = vp9_read_bit(br);
   if (frame_hdr->show_existing_frame) {
     frame_hdr->frame_to_show = vp9_read_bits(br, VP9_REF_FRAMES_LOG2);
-    return VP9_PARSER_OK;
+    return TRUE;
   }
   frame_hdr->frame_type = (VP9_FRAME_TYPE)vp9_read_bit(br);
   frame_hdr->show_frame = vp9_read_bit(br);
   frame_hdr->error_resilient_mode = vp9_read_bit(br);
   if (frame_hdr->frame_type == VP9_KEY_FRAME) {
     if (!verify_sync_code(br))
-      goto error;
+      return FALSE;
     if (frame_hdr->profile > VP9_PROFILE_1)
       frame_hdr->bit_depth = (VP9_BIT_DEPTH)vp9_read_bit(br);
     frame_hdr->color_space = (VP9_COLOR_SPACE)vp9_read_bits(br, 3);
@@ -579,7 +551,7 @@ vp9_parse_frame_header (Vp9Parser* parser, Vp9FrameHdr * frame_hdr, const uint8_
         frame_hdr->subsampling_y = vp9_read_bit(br);
         if (vp9_read_bit(br)) {
           ERROR("reserved bit");
-          goto error;
+          return FALSE;
         }
       } else {
         frame_hdr->subsampling_y = frame_hdr->subsampling_x = 1;
@@ -595,7 +567,7 @@ vp9_parse_frame_header (Vp9Parser* parser, Vp9FrameHdr * frame_hdr, const uint8_
       0 : vp9_read_bits(br, 2);
     if (frame_hdr->intra_only) {
       if (!verify_sync_code(br))
-        goto error;
+        return FALSE;
       frame_hdr->refresh_frame_flags = vp9_read_bits(br, VP9_REF_FRAMES);
       read_frame_size(br, &frame_hdr->width, &frame_hdr->height);
       read_display_frame_size(frame_hdr, br);
@@ -615,6 +587,19 @@ vp9_parse_frame_header (Vp9Parser* parser, Vp9FrameHdr * frame_hdr, const uint8_
       frame_hdr->mcomp_filter_type = read_interp_filter(br);
     }
   }
+  return TRUE;
+}
+
+Vp9ParseResult
+vp9_parse_frame_header (Vp9Parser* parser, Vp9FrameHdr * frame_hdr, const uint8_t * data, uint32_t size)
+{
+#define FRAME_CONTEXTS_BITS 2
+  BitReader bit_reader(data, size);
+  BitReader* br = &bit_reader;
+  if (!read_frame_info(parser, frame_hdr, br))
+    goto error;
+  if (frame_hdr->show_existing_frame)
+    return VP9_PARSER_OK;
   if (!frame_hdr->error_resilient_mode) {
     frame_hdr->refresh_frame_context = vp9_read_bit(br);
     frame_hdr->frame_parallel_decoding_mode = vp9_read_bit(br);
@@ -635,3 +620,95 @@ vp9_parse_frame_header (Vp9Parser* parser, Vp9FrameHdr * frame_hdr, const uint8_
 error:
   return VP9_PARSER_ERROR;
 }
+
+namespace YamiParser {
+
+Vp9SuperFrame::Vp9SuperFrame(const uint8_t* data, uint32_t size)
+    : m_data(data)
+    , m_index(NULL)
+    , m_size(size)
+    , m_frames(1)
+    , m_mag(0)
+    , m_current(0)
+    , m_offset(0)
+    , m_valid(data && size)
+{
+  if (!m_valid)
+    return;
+  const uint8_t marker = data[size - 1];
+  if ((marker & 0xe0) != 0xc0)
+    return;
+  m_frames = (marker & 0x7) + 1;
+  m_mag = ((marker >> 3) & 0x3) + 1;
+  const uint32_t indexSize = 2 + m_mag * m_frames;
+  if (size < indexSize || data[size - indexSize] != marker) {
+    m_valid = false;
+    return;
+  }
+  m_index = data + size - indexSize + 1;
+  m_size = size - indexSize;
+
+  /* check the sizes once, so next() only walks */
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < m_frames; i++)
+    total += frameSize(i);
+  if (total > m_size)
+    m_valid = false;
+}
+
+uint32_t Vp9SuperFrame::frameSize(uint32_t i) const
+{
+  const uint8_t* p = m_index + i * m_mag;
+  uint32_t size = 0;
+  for (uint32_t j = 0; j < m_mag; j++)
+    size |= p[j] << (j * 8);
+  return size;
+}
+
+bool Vp9SuperFrame::next(const uint8_t*& frame, uint32_t& size)
+{
+  if (!m_valid || m_current >= m_frames)
+    return false;
+  size = m_index ? frameSize(m_current) : m_size;
+  frame = m_data + m_offset;
+  m_offset += size;
+  m_current++;
+  return true;
+}
+
+Vp9Parser::Vp9Parser()
+{
+  priv = &m_priv;
+  init_vp9_parser(this);
+}
+
+void Vp9Parser::reset()
+{
+  init_vp9_parser(this);
+}
+
+bool Vp9Parser::parse(Vp9FrameHdr* hdr, const uint8_t* data, uint32_t size)
+{
+  return vp9_parse_frame_header(this, hdr, data, size) == VP9_PARSER_OK;
+}
+
+bool Vp9Parser::probe(Vp9FrameInfo& info, const uint8_t* data, uint32_t size) const
+{
+  if (!data || !size)
+    return false;
+  BitReader br(data, size);
+  Vp9FrameHdr hdr;
+  if (!read_frame_info(this, &hdr, &br))
+    return false;
+  info.profile = hdr.profile;
+  info.show_existing_frame = hdr.show_existing_frame;
+  info.frame_to_show = hdr.frame_to_show;
+  info.frame_type = hdr.frame_type;
+  info.show_frame = hdr.show_frame;
+  info.intra_only = hdr.intra_only;
+  info.width = hdr.width;
+  info.height = hdr.height;
+  return true;
+}
+
+} /*namespace YamiParser*/
@@ -23,6 +23,7 @@ extern "C" {
 
 #include <stdint.h>
 #include "common/common_def.h"
+#include "vp9quant.h"
 
 #define VP9_REFS_PER_FRAME 3
 
@@ -49,6 +50,8 @@ typedef struct _Vp9LoopFilter   Vp9LoopFilter;
 typedef struct _Vp9Segmentation Vp9Segmentation;
 typedef struct _Vp9SegmentationInfo Vp9SegmentationInfo;
 typedef struct _Vp9SegmentationInfoData Vp9SegmentationInfoData;
+typedef struct _Vp9ReferenceSize Vp9ReferenceSize;
+typedef struct _Vp9ParserPrivate Vp9ParserPrivate;
 
 /**
  * Vp9ParseResult:
@@ -224,6 +227,32 @@ struct _Vp9Segmentation
   BOOL      reference_skip;
 };
 
+struct _Vp9ReferenceSize
+{
+  uint32_t width;
+  uint32_t height;
+};
+
+/* state kept between frames, only used by vp9parser.cpp */
+struct _Vp9ParserPrivate
+{
+  int8_t   y_dc_delta_q;
+  int8_t   uv_dc_delta_q;
+  int8_t   uv_ac_delta_q;
+
+  int16_t   y_dequant[QINDEX_RANGE][2];
+  int16_t   uv_dequant[QINDEX_RANGE][2];
+
+  /* for loop filters */
+  int8_t    ref_deltas[VP9_MAX_REF_LF_DELTAS];
+  int8_t    mode_deltas[VP9_MAX_MODE_LF_DELTAS];
+
+  BOOL segmentation_abs_delta;
+  Vp9SegmentationInfoData segmentation[VP9_MAX_SEGMENTS];
+
+  Vp9ReferenceSize reference[VP9_REF_FRAMES];
+};
+
 struct _Vp9Parser
 {
   BOOL      lossless_flag;
@@ -247,4 +276,73 @@ void vp9_parser_free(Vp9Parser* parser);
 }
 #endif /* __cplusplus */
 
+#ifdef __cplusplus
+#include "common/NonCopyable.h"
+
+namespace YamiParser {
+
+/* what Vp9Parser::probe() gets from the uncompressed header.
+ * width and height are not valid for show_existing_frame */
+struct Vp9FrameInfo {
+    VP9_PROFILE profile;
+    bool show_existing_frame;
+    uint8_t frame_to_show;
+    VP9_FRAME_TYPE frame_type;
+    bool show_frame;
+    bool intra_only;
+    uint32_t width;
+    uint32_t height;
+};
+
+/* Iterate the frames of a vp9 chunk. The superframe index is read in place
+ * and frames are returned as pointers into the chunk, nothing is copied.
+ * A chunk without superframe index has one frame. */
+class Vp9SuperFrame {
+public:
+    Vp9SuperFrame(const uint8_t* data, uint32_t size);
+
+    /* false if the superframe index is corrupted */
+    bool isValid() const { return m_valid; }
+    uint32_t getFrameCount() const { return m_frames; }
+
+    /* get the next frame, return false if no more frames */
+    bool next(const uint8_t*& frame, uint32_t& size);
+
+private:
+    uint32_t frameSize(uint32_t i) const;
+
+    const uint8_t* m_data;
+    const uint8_t* m_index; /*first frame size in the index, NULL if no index*/
+    uint32_t m_size; /*frame data size, the index is not included*/
+    uint32_t m_frames;
+    uint32_t m_mag; /*bytes per frame size*/
+    uint32_t m_current;
+    uint32_t m_offset;
+    bool m_valid;
+};
+
+/* The parser with its private data in place. It can be embedded by value,
+ * so no allocation is needed per stream. */
+class Vp9Parser : public ::_Vp9Parser {
+public:
+    Vp9Parser();
+
+    /* back to the state of a new parser */
+    void reset();
+
+    bool parse(Vp9FrameHdr* hdr, const uint8_t* data, uint32_t size);
+
+    /* read the uncompressed header until the frame size,
+     * the parser state is not changed */
+    bool probe(Vp9FrameInfo& info, const uint8_t* data, uint32_t size) const;
+
+private:
+    Vp9ParserPrivate m_priv;
+
+    DISALLOW_COPY_AND_ASSIGN(Vp9Parser);
+};
+
+} /*namespace YamiParser*/
+#endif /* __cplusplus */
+
 #endif /* __VP9_PARSER_H__ */
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vp9parser.h"
+
+// library headers
+#include "parserBench.h"
+
+namespace YamiParser {
+
+/* 1920x1080, a key frame and chunks of a hidden inter frame and a shown
+ * one in a superframe, like libvpx does with alt ref frames. Chunks are
+ * split with Vp9SuperFrame and each frame is parsed. */
+class Vp9ParserBench : public ParserBench {
+public:
+    const char* unit() const { return "frame"; }
+
+    bool setUp()
+    {
+        m_chunks.resize(CHUNKS);
+        keyFrame(m_chunks[0]);
+        for (uint32_t i = 1; i < CHUNKS; i++) {
+            std::vector<uint8_t> hidden, shown;
+            interFrame(hidden, false);
+            interFrame(shown, true);
+            superFrame(m_chunks[i], hidden, shown);
+        }
+        return true;
+    }
+
+    bool run(uint64_t& bytes, uint64_t& units)
+    {
+        Vp9FrameHdr hdr;
+        for (uint32_t i = 0; i < m_chunks.size(); i++) {
+            const std::vector<uint8_t>& chunk = m_chunks[i];
+            Vp9SuperFrame superFrame(&chunk[0], chunk.size());
+            const uint8_t* frame;
+            uint32_t size;
+            if (!superFrame.isValid())
+                return false;
+            while (superFrame.next(frame, size)) {
+                if (!m_parser.parse(&hdr, frame, size))
+                    return false;
+                units++;
+            }
+            bytes += chunk.size();
+        }
+        return true;
+    }
+
+private:
+    static const uint32_t CHUNKS = 30;
+    static const uint32_t FRAME_DATA_BYTES = 16384;
+
+    static void writeFrameStart(BitWriter& bw)
+    {
+        bw.writeBits(2, 2); //frame_marker
+        bw.writeBits(0, 2); //profile 0
+        bw.writeBits(0, 1); //show_existing_frame
+    }
+
+    /* loop filter deltas, quantizer and tiles, the same for all frames */
+    static void writeFrameEnd(BitWriter& bw, std::vector<uint8_t>& data)
+    {
+        bw.writeBits(1, 1); //refresh_frame_context
+        bw.writeBits(0, 1); //frame_parallel_decoding_mode
+        bw.writeBits(0, 2); //frame_context_idx
+        bw.writeBits(36, 6); //filter_level
+        bw.writeBits(0, 3); //sharpness_level
+        bw.writeBits(1, 1); //mode_ref_delta_enabled
+        bw.writeBits(1, 1); //mode_ref_delta_update
+        for (uint32_t i = 0; i < VP9_MAX_REF_LF_DELTAS; i++) {
+            bw.writeBits(1, 1);
+            bw.writeBits(i, 6);
+            bw.writeBits(i & 1, 1); //sign
+        }
+        for (uint32_t i = 0; i < VP9_MAX_MODE_LF_DELTAS; i++)
+            bw.writeBits(0, 1);
+        bw.writeBits(120, 8); //base_qindex
+        bw.writeBits(0, 3); //no delta q
+        bw.writeBits(0, 1); //segmentation enabled
+        bw.writeBits(1, 1); //two tile columns
+        bw.writeBits(0, 1);
+        bw.writeBits(0, 1); //tile rows
+        bw.writeBits(512, 16); //first_partition_size
+        bw.writeToBytesAligned();
+        writePayload(bw, FRAME_DATA_BYTES);
+        const uint8_t* p = bw.getBitWriterData();
+        data.assign(p, p + (bw.getCodedBitsCount() >> 3));
+    }
+
+    static void keyFrame(std::vector<uint8_t>& data)
+    {
+        BitWriter bw(FRAME_DATA_BYTES + 256);
+        writeFrameStart(bw);
+        bw.writeBits(VP9_KEY_FRAME, 1);
+        bw.writeBits(1, 1); //show_frame
+        bw.writeBits(0, 1); //error_resilient_mode
+        bw.writeBits(0x498342, 24); //sync code
+        bw.writeBits(VP9_BT_601, 3);
+        bw.writeBits(0, 1); //color_range
+        bw.writeBits(1920 - 1, 16);
+        bw.writeBits(1080 - 1, 16);
+        bw.writeBits(0, 1); //display_size_enabled
+        writeFrameEnd(bw, data);
+    }
+
+    /* an inter frame takes the size of reference 1 */
+    static void interFrame(std::vector<uint8_t>& data, bool show)
+    {
+        BitWriter bw(FRAME_DATA_BYTES + 256);
+        writeFrameStart(bw);
+        bw.writeBits(VP9_INTER_FRAME, 1);
+        bw.writeBits(show, 1); //show_frame
+        bw.writeBits(0, 1); //error_resilient_mode
+        if (!show)
+            bw.writeBits(0, 1); //intra_only
+        bw.writeBits(0, 2); //reset_frame_context
+        bw.writeBits(show ? 1 : 4, 8); //refresh_frame_flags
+        for (int i = 0; i < VP9_REFS_PER_FRAME; i++) {
+            bw.writeBits(i, 3);
+            bw.writeBits(0, 1);
+        }
+        bw.writeBits(1, 1); //size from the first reference
+        bw.writeBits(0, 1); //display_size_enabled
+        bw.writeBits(1, 1); //allow_high_precision_mv
+        bw.writeBits(1, 1); //switchable interp filter
+        writeFrameEnd(bw, data);
+    }
+
+    /* two frames and an index with 2 bytes sizes */
+    static void superFrame(std::vector<uint8_t>& chunk,
+        const std::vector<uint8_t>& first, const std::vector<uint8_t>& second)
+    {
+        const uint8_t marker = 0xc0 | (1 << 3) | 1;
+        chunk = first;
+        chunk.insert(chunk.end(), second.begin(), second.end());
+        chunk.push_back(marker);
+        chunk.push_back(first.size() & 0xff);
+        chunk.push_back(first.size() >> 8);
+        chunk.push_back(second.size() & 0xff);
+        chunk.push_back(second.size() >> 8);
+        chunk.push_back(marker);
+    }
+
+    std::vector<std::vector<uint8_t> > m_chunks;
+    Vp9Parser m_parser;
+
+    static const bool s_registered;
+};
+
+const bool Vp9ParserBench::s_registered = ParserBenchFactory::register_<Vp9ParserBench>("vp9");
+
+} // namespace YamiParser
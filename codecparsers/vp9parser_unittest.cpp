@@ -0,0 +1,241 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vp9parser.h"
+
+// library headers
+#include "bitWriter.h"
+#include "common/unittest.h"
+
+// system libraries
+#include <algorithm>
+#include <vector>
+
+namespace YamiParser {
+
+class Vp9ParserTest
+    : public ::testing::Test {
+protected:
+    static void writeFrameStart(BitWriter& bw, bool showExisting)
+    {
+        bw.writeBits(2, 2); //frame_marker
+        bw.writeBits(0, 2); //profile 0
+        bw.writeBits(showExisting, 1);
+    }
+
+    static void keyFrame(std::vector<uint8_t>& data, uint32_t width, uint32_t height)
+    {
+        BitWriter bw;
+        writeFrameStart(bw, false);
+        bw.writeBits(VP9_KEY_FRAME, 1);
+        bw.writeBits(1, 1); //show_frame
+        bw.writeBits(0, 1); //error_resilient_mode
+        bw.writeBits(0x498342, 24); //sync code
+        bw.writeBits(VP9_BT_601, 3);
+        bw.writeBits(0, 1); //color_range
+        bw.writeBits(width - 1, 16);
+        bw.writeBits(height - 1, 16);
+        bw.writeBits(0, 1); //display_size_enabled
+        bw.writeBits(1, 1); //refresh_frame_context
+        bw.writeBits(0, 1); //frame_parallel_decoding_mode
+        bw.writeBits(0, 2); //frame_context_idx
+        bw.writeBits(10, 6); //filter_level
+        bw.writeBits(0, 3); //sharpness_level
+        bw.writeBits(0, 1); //mode_ref_delta_enabled
+        bw.writeBits(60, 8); //base_qindex
+        bw.writeBits(0, 3); //no delta q
+        bw.writeBits(0, 1); //segmentation enabled
+        bw.writeBits(0, 1); //tile rows, no bits for tile columns at 352
+        bw.writeBits(100, 16); //first_partition_size
+        finish(bw, data);
+    }
+
+    /* an inter frame takes the size of reference 1 */
+    static void interFrame(std::vector<uint8_t>& data)
+    {
+        BitWriter bw;
+        writeFrameStart(bw, false);
+        bw.writeBits(VP9_INTER_FRAME, 1);
+        bw.writeBits(0, 1); //show_frame
+        bw.writeBits(0, 1); //error_resilient_mode
+        bw.writeBits(0, 1); //intra_only
+        bw.writeBits(0, 2); //reset_frame_context
+        bw.writeBits(1, 8); //refresh_frame_flags
+        for (int i = 0; i < VP9_REFS_PER_FRAME; i++) {
+            bw.writeBits(i + 1, 3);
+            bw.writeBits(0, 1);
+        }
+        bw.writeBits(1, 1); //size from the first reference
+        bw.writeBits(0, 1); //display_size_enabled
+        finish(bw, data);
+    }
+
+    static void showExistingFrame(std::vector<uint8_t>& data, uint8_t idx)
+    {
+        BitWriter bw;
+        writeFrameStart(bw, true);
+        bw.writeBits(idx, 3);
+        finish(bw, data);
+    }
+
+    static void finish(BitWriter& bw, std::vector<uint8_t>& data)
+    {
+        bw.writeToBytesAligned();
+        const uint8_t* p = bw.getBitWriterData();
+        data.assign(p, p + (bw.getCodedBitsCount() >> 3));
+        /*some bytes for the compressed header*/
+        data.resize(data.size() + 128);
+    }
+};
+
+#define VP9PARSER_TEST(name) \
+    TEST_F(Vp9ParserTest, name)
+
+VP9PARSER_TEST(SuperFrameWithoutIndex)
+{
+    const uint8_t data[] = { 0x82, 0x49, 0x83, 0x42, 0x00 };
+    Vp9SuperFrame superFrame(data, sizeof(data));
+    ASSERT_TRUE(superFrame.isValid());
+    EXPECT_EQ(1u, superFrame.getFrameCount());
+
+    const uint8_t* frame;
+    uint32_t size;
+    ASSERT_TRUE(superFrame.next(frame, size));
+    EXPECT_EQ(data, frame);
+    EXPECT_EQ(sizeof(data), size);
+    EXPECT_FALSE(superFrame.next(frame, size));
+}
+
+VP9PARSER_TEST(SuperFrameIndex)
+{
+    //3 frames, 2 bytes per frame size
+    const uint8_t marker = 0xc0 | (1 << 3) | 2;
+    const uint8_t index[] = { marker, 3, 0, 2, 1, 1, 0, marker };
+    std::vector<uint8_t> data(3 + 0x102 + 1 + sizeof(index), 0x55);
+    std::copy(index, index + sizeof(index), data.end() - sizeof(index));
+
+    Vp9SuperFrame superFrame(&data[0], data.size());
+    ASSERT_TRUE(superFrame.isValid());
+    EXPECT_EQ(3u, superFrame.getFrameCount());
+
+    const uint32_t sizes[] = { 3, 0x102, 1 };
+    const uint8_t* expected = &data[0];
+    const uint8_t* frame;
+    uint32_t size;
+    for (size_t i = 0; i < N_ELEMENTS(sizes); i++) {
+        ASSERT_TRUE(superFrame.next(frame, size));
+        EXPECT_EQ(expected, frame);
+        EXPECT_EQ(sizes[i], size);
+        expected += size;
+    }
+    EXPECT_FALSE(superFrame.next(frame, size));
+}
+
+VP9PARSER_TEST(SuperFrameCorruptedIndex)
+{
+    const uint8_t marker = 0xc0 | 1;
+    const uint8_t* frame;
+    uint32_t size;
+
+    //the first byte of the index is not the marker
+    const uint8_t badMarker[] = { 1, 2, 3, 0xc2, 1, 2, marker };
+    Vp9SuperFrame superFrame(badMarker, sizeof(badMarker));
+    EXPECT_FALSE(superFrame.isValid());
+
+    //frame sizes are larger than the chunk
+    const uint8_t badSize[] = { 1, 2, 3, marker, 1, 3, marker };
+    Vp9SuperFrame superFrame2(badSize, sizeof(badSize));
+    EXPECT_FALSE(superFrame2.isValid());
+    EXPECT_FALSE(superFrame2.next(frame, size));
+
+    //index is larger than the chunk
+    const uint8_t shortChunk[] = { marker, 1, marker };
+    Vp9SuperFrame superFrame3(shortChunk, sizeof(shortChunk));
+    EXPECT_FALSE(superFrame3.isValid());
+}
+
+VP9PARSER_TEST(ProbeKeyFrame)
+{
+    std::vector<uint8_t> data;
+    keyFrame(data, 352, 288);
+
+    Vp9Parser parser;
+    Vp9FrameInfo info;
+    ASSERT_TRUE(parser.probe(info, &data[0], data.size()));
+    EXPECT_EQ(VP9_PROFILE_0, info.profile);
+    EXPECT_FALSE(info.show_existing_frame);
+    EXPECT_EQ(VP9_KEY_FRAME, info.frame_type);
+    EXPECT_TRUE(info.show_frame);
+    EXPECT_EQ(352u, info.width);
+    EXPECT_EQ(288u, info.height);
+
+    Vp9FrameHdr hdr;
+    ASSERT_TRUE(parser.parse(&hdr, &data[0], data.size()));
+    EXPECT_EQ(352u, hdr.width);
+    EXPECT_EQ(288u, hdr.height);
+    EXPECT_EQ(60, hdr.base_qindex);
+    EXPECT_EQ(100u, hdr.first_partition_size);
+}
+
+VP9PARSER_TEST(ProbeShowExistingFrame)
+{
+    std::vector<uint8_t> data;
+    showExistingFrame(data, 5);
+
+    Vp9Parser parser;
+    Vp9FrameInfo info;
+    ASSERT_TRUE(parser.probe(info, &data[0], data.size()));
+    EXPECT_TRUE(info.show_existing_frame);
+    EXPECT_EQ(5, info.frame_to_show);
+}
+
+VP9PARSER_TEST(ProbeInterFrameSizeFromReference)
+{
+    std::vector<uint8_t> key, inter;
+    keyFrame(key, 352, 288);
+    interFrame(inter);
+
+    Vp9Parser parser;
+    Vp9FrameHdr hdr;
+    ASSERT_TRUE(parser.parse(&hdr, &key[0], key.size()));
+
+    Vp9FrameInfo info;
+    ASSERT_TRUE(parser.probe(info, &inter[0], inter.size()));
+    EXPECT_EQ(VP9_INTER_FRAME, info.frame_type);
+    EXPECT_FALSE(info.show_frame);
+    EXPECT_EQ(352u, info.width);
+    EXPECT_EQ(288u, info.height);
+
+    //after reset, the reference sizes are gone
+    parser.reset();
+    ASSERT_TRUE(parser.probe(info, &inter[0], inter.size()));
+    EXPECT_EQ(0u, info.width);
+    EXPECT_EQ(0u, info.height);
+}
+
+VP9PARSER_TEST(ProbeInvalidFrameMarker)
+{
+    const uint8_t data[] = { 0x40, 0, 0, 0 };
+    Vp9Parser parser;
+    Vp9FrameInfo info;
+    EXPECT_FALSE(parser.probe(info, data, sizeof(data)));
+}
+}
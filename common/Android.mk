@@ -6,7 +6,8 @@ LOCAL_SRC_FILES := \
         log.cpp \
         utils.cpp \
         nalreader.cpp \
-        surfacepool.cpp
+        surfacepool.cpp \
+        workerpool.cpp
 
 LOCAL_C_INCLUDES:= \
         $(LOCAL_PATH)/.. \
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef fixedvector_h
+#define fixedvector_h
+
+#include <algorithm>
+#include <assert.h>
+#include <stddef.h>
+
+namespace YamiMediaCodec {
+
+/* A vector with its elements in place, for small lists rebuilt often,
+ * like the reference lists of a slice. It never allocates, all N
+ * elements are constructed with the vector; the ones past size() are
+ * kept default valued, so removed smart pointers are released at once.
+ * push_back() and insert() on a full vector do nothing and return false. */
+template <class T, size_t N>
+class FixedVector {
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef size_t size_type;
+
+    FixedVector()
+        : m_size(0)
+    {
+    }
+
+    iterator begin() { return m_data; }
+    iterator end() { return m_data + m_size; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return !m_size; }
+    bool full() const { return m_size == N; }
+    static size_t capacity() { return N; }
+
+    T& operator[](size_t i)
+    {
+        assert(i < m_size);
+        return m_data[i];
+    }
+    const T& operator[](size_t i) const
+    {
+        assert(i < m_size);
+        return m_data[i];
+    }
+    T& front() { return (*this)[0]; }
+    T& back() { return (*this)[m_size - 1]; }
+
+    bool push_back(const T& value)
+    {
+        if (full())
+            return false;
+        m_data[m_size++] = value;
+        return true;
+    }
+
+    void pop_back()
+    {
+        assert(m_size);
+        m_data[--m_size] = T();
+    }
+
+    bool insert(iterator pos, const T& value)
+    {
+        assert(pos >= begin() && pos <= end());
+        if (full())
+            return false;
+        std::move_backward(pos, end(), end() + 1);
+        *pos = value;
+        m_size++;
+        return true;
+    }
+
+    template <class I>
+    void insert(iterator pos, I first, I last)
+    {
+        for (; first != last; ++first, ++pos) {
+            if (!insert(pos, *first))
+                break;
+        }
+    }
+
+    iterator erase(iterator pos)
+    {
+        assert(pos >= begin() && pos < end());
+        std::move(pos + 1, end(), pos);
+        pop_back();
+        return pos;
+    }
+
+    /* keep the first n elements, grow with default values */
+    void resize(size_t n)
+    {
+        assert(n <= N);
+        while (m_size > n)
+            pop_back();
+        while (m_size < n)
+            m_data[m_size++] = T();
+    }
+
+    void clear() { resize(0); }
+
+    bool operator==(const FixedVector& other) const
+    {
+        return m_size == other.m_size
+            && std::equal(begin(), end(), other.begin());
+    }
+
+private:
+    T m_data[N];
+    size_t m_size;
+};
+}
+
+#endif //fixedvector_h
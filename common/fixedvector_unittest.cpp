@@ -0,0 +1,114 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "fixedvector.h"
+
+// library headers
+#include "common/unittest.h"
+
+// system headers
+#include <algorithm>
+#include <memory>
+
+#define FIXEDVECTOR_TEST(name) \
+    TEST(FixedVectorTest, name)
+
+using namespace YamiMediaCodec;
+
+FIXEDVECTOR_TEST(PushAndInsert)
+{
+    FixedVector<int, 4> v;
+    EXPECT_TRUE(v.empty());
+    EXPECT_EQ(4u, v.capacity());
+
+    EXPECT_TRUE(v.push_back(1));
+    EXPECT_TRUE(v.push_back(3));
+    EXPECT_TRUE(v.insert(v.begin() + 1, 2));
+    EXPECT_TRUE(v.insert(v.begin(), 0));
+    ASSERT_EQ(4u, v.size());
+    for (int i = 0; i < 4; i++)
+        EXPECT_EQ(i, v[i]);
+
+    //full, nothing changes
+    EXPECT_FALSE(v.push_back(4));
+    EXPECT_FALSE(v.insert(v.begin(), 4));
+    EXPECT_EQ(4u, v.size());
+    EXPECT_EQ(0, v.front());
+    EXPECT_EQ(3, v.back());
+}
+
+FIXEDVECTOR_TEST(EraseAndResize)
+{
+    FixedVector<int, 8> v;
+    for (int i = 0; i < 6; i++)
+        v.push_back(i);
+
+    FixedVector<int, 8>::iterator it = v.erase(v.begin() + 2);
+    EXPECT_EQ(3, *it);
+    ASSERT_EQ(5u, v.size());
+    EXPECT_EQ(4, v[3]);
+
+    v.resize(2);
+    ASSERT_EQ(2u, v.size());
+    EXPECT_EQ(1, v.back());
+
+    //grown elements are default valued, not the removed ones
+    v.resize(4);
+    EXPECT_EQ(0, v[2]);
+    EXPECT_EQ(0, v[3]);
+
+    v.clear();
+    EXPECT_TRUE(v.empty());
+    EXPECT_TRUE(v.begin() == v.end());
+}
+
+FIXEDVECTOR_TEST(ReleaseRemoved)
+{
+    std::shared_ptr<int> p(new int(1));
+    FixedVector<std::shared_ptr<int>, 4> v;
+    v.push_back(p);
+    v.push_back(p);
+    EXPECT_EQ(3, p.use_count());
+
+    v.erase(v.begin());
+    EXPECT_EQ(2, p.use_count());
+    v.clear();
+    EXPECT_EQ(1, p.use_count());
+}
+
+FIXEDVECTOR_TEST(Algorithms)
+{
+    FixedVector<int, 8> a, b;
+    const int values[] = { 5, 1, 4, 2, 3 };
+    a.insert(a.end(), values, values + 5);
+    ASSERT_EQ(5u, a.size());
+
+    std::sort(a.begin(), a.end());
+    for (int i = 0; i < 5; i++)
+        EXPECT_EQ(i + 1, a[i]);
+
+    b = a;
+    EXPECT_TRUE(a == b);
+    std::swap(b[0], b[1]);
+    EXPECT_FALSE(a == b);
+    b.pop_back();
+    EXPECT_EQ(4u, b.size());
+}
@@ -18,11 +18,112 @@
 #include "config.h"
 #endif
 
-#include <algorithm>
 #include "nalreader.h"
 
+#include <algorithm>
+#include <assert.h>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define NALREADER_USE_SIMD
+#include <immintrin.h>
+#endif
+
 namespace YamiMediaCodec{
 
+const uint8_t* findStartCodeC(const uint8_t* start, const uint8_t* end)
+{
+    const uint8_t* p = start;
+    /*p[2] decides how far we can jump: if it's bigger than 1, no start code
+      can begin at p, p + 1 or p + 2*/
+    while (end - p >= 3) {
+        if (p[2] > 1)
+            p += 3;
+        else if (p[1])
+            p += 2;
+        else if (p[0] || p[2] != 1)
+            p++;
+        else
+            return p;
+    }
+    return end;
+}
+
+#ifdef NALREADER_USE_SIMD
+
+/*a start code begins with a zero byte, so a block without zero bytes can be
+  skipped as a whole; blocks with zeros get the exact 00 00 01 check on all
+  positions at once*/
+__attribute__((target("sse2")))
+static const uint8_t* findStartCodeSSE2(const uint8_t* start, const uint8_t* end)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    const uint8_t* p = start;
+
+    /*we test 16 positions a time, and the last one needs 2 more bytes*/
+    while (end - p >= 16 + 2) {
+        __m128i b0 = _mm_loadu_si128((const __m128i*)p);
+        __m128i z0 = _mm_cmpeq_epi8(b0, zero);
+        if (_mm_movemask_epi8(z0)) {
+            __m128i b1 = _mm_loadu_si128((const __m128i*)(p + 1));
+            __m128i b2 = _mm_loadu_si128((const __m128i*)(p + 2));
+            __m128i m = _mm_and_si128(z0, _mm_cmpeq_epi8(b1, zero));
+            m = _mm_and_si128(m, _mm_cmpeq_epi8(b2, one));
+            int mask = _mm_movemask_epi8(m);
+            if (mask)
+                return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+    return findStartCodeC(p, end);
+}
+
+__attribute__((target("avx2")))
+static const uint8_t* findStartCodeAVX2(const uint8_t* start, const uint8_t* end)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    const uint8_t* p = start;
+
+    while (end - p >= 32 + 2) {
+        __m256i b0 = _mm256_loadu_si256((const __m256i*)p);
+        __m256i z0 = _mm256_cmpeq_epi8(b0, zero);
+        if (_mm256_movemask_epi8(z0)) {
+            __m256i b1 = _mm256_loadu_si256((const __m256i*)(p + 1));
+            __m256i b2 = _mm256_loadu_si256((const __m256i*)(p + 2));
+            __m256i m = _mm256_and_si256(z0, _mm256_cmpeq_epi8(b1, zero));
+            m = _mm256_and_si256(m, _mm256_cmpeq_epi8(b2, one));
+            uint32_t mask = _mm256_movemask_epi8(m);
+            if (mask)
+                return p + __builtin_ctz(mask);
+        }
+        p += 32;
+    }
+    return findStartCodeC(p, end);
+}
+
+#endif //NALREADER_USE_SIMD
+
+typedef const uint8_t* (*StartCodeFinder)(const uint8_t* start, const uint8_t* end);
+
+static StartCodeFinder selectStartCodeFinder()
+{
+#ifdef NALREADER_USE_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return findStartCodeAVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return findStartCodeSSE2;
+#endif
+    return findStartCodeC;
+}
+
+const uint8_t* findStartCode(const uint8_t* start, const uint8_t* end)
+{
+    static const StartCodeFinder finder = selectStartCodeFinder();
+    return finder(start, end);
+}
+
 NalReader::NalReader(const uint8_t* buf, int32_t size, uint32_t nalLengthSize, bool asWhole)
 {
     m_begin = buf;
@@ -52,13 +153,11 @@ bool NalReader::read(const uint8_t*& nal, int32_t& nalSize)
     return true;
 }
 
-static const uint8_t START_CODE[] = { 0, 0, 1 };
 static const int START_CODE_SIZE = 3;
-static const uint8_t* START_CODE_END = START_CODE + START_CODE_SIZE;
 
 const uint8_t* NalReader::searchStartCode()
 {
-    m_begin = std::search(m_next, m_end, START_CODE, START_CODE_END);
+    m_begin = findStartCode(m_next, m_end);
 
     if (m_begin != m_end) {
         m_next = m_begin + START_CODE_SIZE;
@@ -90,4 +189,257 @@ const uint8_t* NalReader::searchNalStart()
 
     return m_begin;
 }
+NalAssembler::NalAssembler(uint32_t nalLengthSize)
+{
+    reset(nalLengthSize);
+}
+
+void NalAssembler::reset(uint32_t nalLengthSize)
+{
+    m_nalLengthSize = nalLengthSize;
+    m_chunk = m_next = m_end = NULL;
+    m_timeStamp = 0;
+    m_pending.clear();
+    m_pendingTimeStamp = 0;
+    m_pendingTaken = false;
+    m_inNal = false;
+    m_flushing = false;
+    m_unread = false;
+    m_lastNal = NULL;
+    m_lastNalSize = 0;
+    m_lastTimeStamp = 0;
+}
+
+void NalAssembler::feed(const uint8_t* data, int32_t size, int64_t timeStamp)
+{
+    const uint8_t* nal;
+    int32_t nalSize;
+    int64_t nalTimeStamp;
+
+    /*skip the nal units caller did not read, this also moves the
+      straddling nal to m_pending*/
+    m_unread = false;
+    while (read(nal, nalSize, nalTimeStamp))
+        ;
+    if (m_pendingTaken) {
+        m_pending.clear();
+        m_pendingTaken = false;
+    }
+    m_chunk = m_next = data;
+    m_end = data + size;
+    m_timeStamp = timeStamp;
+}
+
+void NalAssembler::resume(const uint8_t* data, int32_t size)
+{
+    assert(size == m_end - m_chunk);
+    if (m_lastNal >= m_chunk && m_lastNal < m_end)
+        m_lastNal = data + (m_lastNal - m_chunk);
+    m_next = data + (m_next - m_chunk);
+    m_chunk = data;
+    m_end = data + size;
+}
+
+bool NalAssembler::read(const uint8_t*& nal, int32_t& nalSize, int64_t& timeStamp)
+{
+    if (m_unread) {
+        m_unread = false;
+        nal = m_lastNal;
+        nalSize = m_lastNalSize;
+        timeStamp = m_lastTimeStamp;
+        return true;
+    }
+    if (m_pendingTaken) {
+        m_pending.clear();
+        m_pendingTaken = false;
+    }
+    bool ret;
+    if (m_nalLengthSize)
+        ret = readLengthPrefixed(nal, nalSize, timeStamp);
+    else
+        ret = readAnnexB(nal, nalSize, timeStamp);
+    if (ret) {
+        m_lastNal = nal;
+        m_lastNalSize = nalSize;
+        m_lastTimeStamp = timeStamp;
+    }
+    return ret;
+}
+
+void NalAssembler::unread()
+{
+    m_unread = true;
+}
+
+void NalAssembler::flush()
+{
+    m_flushing = true;
+}
+
+/*a start code begins in the last 2 bytes of m_pending and ends in the chunk*/
+bool NalAssembler::startCodeAtBoundary(uint32_t& nalEnd, uint32_t& chunkSkip) const
+{
+    size_t size = m_pending.size();
+    ptrdiff_t avail = m_end - m_chunk;
+    if (size >= 2 && avail >= 1
+        && !m_pending[size - 2] && !m_pending[size - 1] && m_chunk[0] == 1) {
+        nalEnd = size - 2;
+        chunkSkip = 1;
+        return true;
+    }
+    if (size >= 1 && avail >= 2
+        && !m_pending[size - 1] && !m_chunk[0] && m_chunk[1] == 1) {
+        nalEnd = size - 1;
+        chunkSkip = 2;
+        return true;
+    }
+    return false;
+}
+
+/*the nal ends at end, give it out in place if nothing is pending*/
+bool NalAssembler::takePending(const uint8_t* end, const uint8_t*& nal, int32_t& nalSize, int64_t& timeStamp)
+{
+    if (m_pending.empty()) {
+        nal = m_next;
+        nalSize = end - m_next;
+        timeStamp = m_timeStamp;
+    } else {
+        m_pending.insert(m_pending.end(), m_next, end);
+        nal = &m_pending[0];
+        nalSize = m_pending.size();
+        timeStamp = m_pendingTimeStamp;
+        m_pendingTaken = true;
+    }
+    m_next = end;
+    return nalSize > 0;
+}
+
+/*copy the unfinished nal, or the bytes which may start a start code*/
+void NalAssembler::keepPending(const uint8_t* end)
+{
+    if (m_inNal) {
+        if (m_pending.empty())
+            m_pendingTimeStamp = m_timeStamp;
+        m_pending.insert(m_pending.end(), m_next, end);
+    } else {
+        const size_t keep = START_CODE_SIZE - 1;
+        const uint8_t* from = (size_t)(end - m_next) > keep ? end - keep : m_next;
+        m_pending.insert(m_pending.end(), from, end);
+        if (m_pending.size() > keep)
+            m_pending.erase(m_pending.begin(), m_pending.end() - keep);
+    }
+    m_next = end;
+}
+
+bool NalAssembler::readAnnexB(const uint8_t*& nal, int32_t& nalSize, int64_t& timeStamp)
+{
+    while (true) {
+        uint32_t nalEnd, chunkSkip;
+        if (m_next == m_chunk && startCodeAtBoundary(nalEnd, chunkSkip)) {
+            m_next = m_chunk + chunkSkip;
+            if (m_inNal && nalEnd) {
+                m_pending.resize(nalEnd);
+                nal = &m_pending[0];
+                nalSize = nalEnd;
+                timeStamp = m_pendingTimeStamp;
+                m_pendingTaken = true;
+                return true;
+            }
+            m_inNal = true;
+            m_pending.clear();
+            continue;
+        }
+
+        const uint8_t* start = findStartCode(m_next, m_end);
+        if (start == m_end) {
+            if (!m_flushing) {
+                keepPending(m_end);
+                return false;
+            }
+            /*the last nal ends with the stream*/
+            bool ret = m_inNal && takePending(m_end, nal, nalSize, timeStamp);
+            if (!ret)
+                m_pending.clear();
+            m_next = m_end;
+            m_inNal = false;
+            m_flushing = false;
+            return ret;
+        }
+        if (!m_inNal) {
+            m_inNal = true;
+            m_pending.clear();
+            m_next = start + START_CODE_SIZE;
+            continue;
+        }
+        bool ret = takePending(start, nal, nalSize, timeStamp);
+        m_next = start + START_CODE_SIZE;
+        if (ret)
+            return true;
+    }
+}
+
+static uint32_t readNalLength(const uint8_t* p, uint32_t nalLengthSize)
+{
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < nalLengthSize; i++)
+        size = (size << 8) | p[i];
+    return size;
+}
+
+bool NalAssembler::readLengthPrefixed(const uint8_t*& nal, int32_t& nalSize, int64_t& timeStamp)
+{
+    while (true) {
+        if (m_pending.empty()) {
+            uint32_t avail = m_end - m_next;
+            if (avail >= m_nalLengthSize) {
+                uint32_t size = readNalLength(m_next, m_nalLengthSize);
+                if (avail - m_nalLengthSize >= size) {
+                    nal = m_next + m_nalLengthSize;
+                    nalSize = size;
+                    timeStamp = m_timeStamp;
+                    m_next = nal + size;
+                    if (size)
+                        return true;
+                    continue;
+                }
+            }
+            /*a truncated nal at the end of stream is dropped*/
+            if (avail && !m_flushing) {
+                m_pendingTimeStamp = m_timeStamp;
+                m_pending.assign(m_next, m_end);
+            }
+            m_next = m_end;
+            m_flushing = false;
+            return false;
+        }
+
+        /*complete the length first, then the nal*/
+        bool hasLength = m_pending.size() >= m_nalLengthSize;
+        uint32_t need = m_nalLengthSize;
+        if (hasLength)
+            need += readNalLength(&m_pending[0], m_nalLengthSize);
+        uint32_t copy = std::min<size_t>(need - m_pending.size(), m_end - m_next);
+        m_pending.insert(m_pending.end(), m_next, m_next + copy);
+        m_next += copy;
+        if (m_pending.size() < need) {
+            if (m_flushing) {
+                m_pending.clear();
+                m_flushing = false;
+            }
+            return false;
+        }
+        if (!hasLength)
+            continue;
+        if (need == m_nalLengthSize) {
+            m_pending.clear();
+            continue;
+        }
+        nal = &m_pending[m_nalLengthSize];
+        nalSize = need - m_nalLengthSize;
+        timeStamp = m_pendingTimeStamp;
+        m_pendingTaken = true;
+        return true;
+    }
+}
+
 } //namespace YamiMediaCodec
@@ -14,9 +14,15 @@
  * limitations under the License.
  */
 #include <stdint.h>
+#include <vector>
 
 namespace YamiMediaCodec{
 
+/*return the first 00 00 01 in [start, end), or end if there is none*/
+const uint8_t* findStartCode(const uint8_t* start, const uint8_t* end);
+/*plain C version of findStartCode, used when no SIMD is available*/
+const uint8_t* findStartCodeC(const uint8_t* start, const uint8_t* end);
+
 class NalReader
 {
 public:
@@ -36,4 +42,60 @@ private:
     uint32_t m_size;
 };
 
+/* NalAssembler gives out complete nal units from a stream fed in arbitrary
+ * chunks, like ts payloads or rtp packets. A nal unit inside a chunk is
+ * pointed to in place, only the nal unit straddling chunks is copied. */
+class NalAssembler
+{
+public:
+    NalAssembler(uint32_t nalLengthSize = 0);
+
+    /*add next chunk, it must be valid until next feed().
+      complete nal units left in previous chunk are dropped*/
+    void feed(const uint8_t* data, int32_t size, int64_t timeStamp);
+
+    /*same chunk as last feed(), at another address, read() goes on where it was*/
+    void resume(const uint8_t* data, int32_t size);
+
+    /*nal is valid until next read() or feed(), timeStamp is the one of the
+      chunk where nal starts*/
+    bool read(const uint8_t*& nal, int32_t& nalSize, int64_t& timeStamp);
+
+    /*next read() will return the last nal again*/
+    void unread();
+
+    /*no more data, next read() returns the pending nal*/
+    void flush();
+
+    /*drop everything, and switch to nalLengthSize*/
+    void reset(uint32_t nalLengthSize = 0);
+
+private:
+    bool readAnnexB(const uint8_t*& nal, int32_t& nalSize, int64_t& timeStamp);
+    bool readLengthPrefixed(const uint8_t*& nal, int32_t& nalSize, int64_t& timeStamp);
+    bool startCodeAtBoundary(uint32_t& nalEnd, uint32_t& chunkSkip) const;
+    bool takePending(const uint8_t* end, const uint8_t*& nal, int32_t& nalSize, int64_t& timeStamp);
+    void keepPending(const uint8_t* end);
+
+    uint32_t m_nalLengthSize;
+    const uint8_t* m_chunk;
+    const uint8_t* m_next;
+    const uint8_t* m_end;
+    int64_t m_timeStamp;
+
+    /*bytes of the nal straddling chunks, without start code*/
+    std::vector<uint8_t> m_pending;
+    int64_t m_pendingTimeStamp;
+    /*m_pending went out with last read()*/
+    bool m_pendingTaken;
+    /*we found a start code, so the data belongs to a nal*/
+    bool m_inNal;
+    bool m_flushing;
+
+    bool m_unread;
+    const uint8_t* m_lastNal;
+    int32_t m_lastNalSize;
+    int64_t m_lastTimeStamp;
+};
+
 } //namespace YamiMediaCodec
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "nalreader.h"
+
+// system libraries
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+using namespace YamiMediaCodec;
+
+static const uint8_t START_CODE[] = { 0, 0, 1 };
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* fake annex b stream: start code + random payload, nalSize bytes per nal.
+ * payload is made emulation free like a real encoder output */
+static void fillStream(std::vector<uint8_t>& data, size_t nalSize)
+{
+    uint32_t zeros = 0;
+    for (size_t i = 0; i < data.size(); i++) {
+        if (i % nalSize == 0 && i + 3 <= data.size()) {
+            data[i] = 0;
+            data[i + 1] = 0;
+            data[i + 2] = 1;
+            i += 2;
+            zeros = 0;
+            continue;
+        }
+        /*cabac output has plenty of zero bytes, keep some of them*/
+        uint8_t b = (rand() % 8) ? rand() % 256 : 0;
+        if (zeros >= 2 && b <= 3)
+            b = 0x03;
+        zeros = b ? 0 : zeros + 1;
+        data[i] = b;
+    }
+}
+
+static const uint8_t* stdSearch(const uint8_t* start, const uint8_t* end)
+{
+    return std::search(start, end, START_CODE, START_CODE + sizeof(START_CODE));
+}
+
+typedef const uint8_t* (*Finder)(const uint8_t* start, const uint8_t* end);
+
+static double measure(Finder finder, const std::vector<uint8_t>& data, uint32_t loops)
+{
+    const uint8_t* begin = &data[0];
+    const uint8_t* end = begin + data.size();
+    uint32_t found = 0;
+
+    uint64_t start = nowNs();
+    for (uint32_t i = 0; i < loops; i++) {
+        const uint8_t* p = begin;
+        while ((p = finder(p, end)) != end) {
+            found++;
+            p += sizeof(START_CODE);
+        }
+    }
+    uint64_t ns = nowNs() - start;
+    if (!found)
+        fprintf(stderr, "no start code found\n");
+    /*bytes per ns * 1000 = MB/s*/
+    return (double)data.size() * loops * 1000 / ns;
+}
+
+static double measureNalReader(const std::vector<uint8_t>& data, uint32_t loops)
+{
+    const uint8_t* nal;
+    int32_t nalSize;
+    uint32_t nals = 0;
+
+    uint64_t start = nowNs();
+    for (uint32_t i = 0; i < loops; i++) {
+        NalReader reader(&data[0], data.size());
+        while (reader.read(nal, nalSize))
+            nals++;
+    }
+    uint64_t ns = nowNs() - start;
+    if (!nals)
+        fprintf(stderr, "no nal found\n");
+    return (double)data.size() * loops * 1000 / ns;
+}
+
+int main()
+{
+    static const size_t streamSizes[] = { 4 << 10, 64 << 10, 1 << 20, 16 << 20 };
+    static const size_t nalSizes[] = { 256, 16 << 10 };
+    /*total bytes to scan per measurement*/
+    const uint64_t budget = 256 << 20;
+
+    srand(0);
+    printf("%10s %10s %12s %12s %12s %12s\n", "stream", "nal", "std MB/s",
+        "C MB/s", "simd MB/s", "reader MB/s");
+    for (size_t s = 0; s < sizeof(streamSizes) / sizeof(streamSizes[0]); s++) {
+        for (size_t n = 0; n < sizeof(nalSizes) / sizeof(nalSizes[0]); n++) {
+            std::vector<uint8_t> data(streamSizes[s]);
+            fillStream(data, nalSizes[n]);
+            uint32_t loops = std::max<uint64_t>(1, budget / data.size());
+            printf("%10zu %10zu %12.1f %12.1f %12.1f %12.1f\n",
+                streamSizes[s], nalSizes[n],
+                measure(stdSearch, data, loops),
+                measure(findStartCodeC, data, loops),
+                measure(findStartCode, data, loops),
+                measureNalReader(data, loops));
+        }
+    }
+    return 0;
+}
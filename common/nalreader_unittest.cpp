@@ -23,8 +23,14 @@
 
 // library headers
 #include "common/Array.h"
+#include "common/common_def.h"
 #include "common/unittest.h"
 
+// system libraries
+#include <algorithm>
+#include <stdlib.h>
+#include <vector>
+
 namespace YamiMediaCodec {
 
 #define NALREADER_TEST(name) \
@@ -112,4 +118,174 @@ NALREADER_TEST(ReadNoPrefix) {
     EXPECT_FALSE(reader.read(nal, size));
 }
 
+NALREADER_TEST(FindStartCode) {
+    static const uint8_t startCode[] = { 0, 0, 1 };
+    std::vector<uint8_t> data(300);
+
+    srand(0x5eed);
+    for (int round(0); round < 50; ++round) {
+        /*mostly small values, so zero runs and start codes show up often*/
+        for (size_t i(0); i < data.size(); ++i)
+            data[i] = (rand() % 4) ? rand() % 3 : rand() % 256;
+
+        const uint8_t* base = &data[0];
+        for (size_t begin(0); begin < 40; ++begin) {
+            for (size_t end(begin); end <= data.size(); end += 7) {
+                const uint8_t* expected = std::search(base + begin, base + end,
+                    startCode, startCode + sizeof(startCode));
+                EXPECT_EQ(expected, findStartCode(base + begin, base + end));
+                EXPECT_EQ(expected, findStartCodeC(base + begin, base + end));
+            }
+        }
+    }
+}
+
+NALREADER_TEST(FindStartCodeAtBlockEdges) {
+    std::vector<uint8_t> data(100, 0xff);
+    const uint8_t* base = &data[0];
+
+    for (size_t pos(0); pos + 3 <= data.size(); ++pos) {
+        std::fill(data.begin(), data.end(), 0xff);
+        data[pos] = 0;
+        data[pos + 1] = 0;
+        data[pos + 2] = 1;
+        EXPECT_EQ(base + pos, findStartCode(base, base + data.size()));
+        /*a truncated start code at the end is not a start code*/
+        EXPECT_EQ(base + pos + 2, findStartCode(base, base + pos + 2));
+    }
+}
+
+typedef std::vector<uint8_t> Nal;
+
+/*nal units from feeding data in chunks of random size, up to maxChunk*/
+static std::vector<Nal> assemble(const std::vector<uint8_t>& data,
+    uint32_t nalLengthSize, uint32_t maxChunk)
+{
+    NalAssembler assembler(nalLengthSize);
+    std::vector<Nal> nals;
+    const uint8_t* nal;
+    int32_t size;
+    int64_t timeStamp;
+    size_t pos = 0;
+
+    while (pos < data.size()) {
+        size_t chunk = std::min<size_t>(rand() % maxChunk + 1, data.size() - pos);
+        /*a copy, so the assembler can't look at the bytes around the chunk*/
+        std::vector<uint8_t> copy(data.begin() + pos, data.begin() + pos + chunk);
+        assembler.feed(&copy[0], chunk, pos);
+        while (assembler.read(nal, size, timeStamp))
+            nals.push_back(Nal(nal, nal + size));
+        pos += chunk;
+    }
+    assembler.flush();
+    while (assembler.read(nal, size, timeStamp))
+        nals.push_back(Nal(nal, nal + size));
+    return nals;
+}
+
+static std::vector<Nal> readAll(const std::vector<uint8_t>& data, uint32_t nalLengthSize)
+{
+    NalReader reader(&data[0], data.size(), nalLengthSize);
+    std::vector<Nal> nals;
+    const uint8_t* nal;
+    int32_t size;
+
+    while (reader.read(nal, size)) {
+        if (size)
+            nals.push_back(Nal(nal, nal + size));
+    }
+    return nals;
+}
+
+NALREADER_TEST(AssembleAnnexB) {
+    std::vector<uint8_t> data;
+
+    srand(3);
+    for (uint32_t i = 0; i < 1000; i++) {
+        if (rand() % 2)
+            data.push_back(0);
+        data.push_back(0);
+        data.push_back(0);
+        data.push_back(1);
+        uint32_t size = rand() % 64;
+        uint32_t zeros = 0;
+        for (uint32_t j = 0; j < size; j++) {
+            uint8_t b = (rand() % 3) ? 0 : rand() % 256;
+            if (zeros >= 2 && b <= 3)
+                b = 3;
+            zeros = b ? 0 : zeros + 1;
+            data.push_back(b);
+        }
+    }
+
+    std::vector<Nal> expected = readAll(data, 0);
+    const uint32_t maxChunks[] = { 1, 2, 3, 7, 64, 1316 };
+    for (size_t i = 0; i < N_ELEMENTS(maxChunks); i++)
+        EXPECT_TRUE(expected == assemble(data, 0, maxChunks[i])) << maxChunks[i];
+}
+
+NALREADER_TEST(AssembleLengthPrefixed) {
+    std::vector<uint8_t> data;
+
+    srand(4);
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint32_t size = rand() % 300;
+        data.push_back(0);
+        data.push_back(0);
+        data.push_back(size >> 8);
+        data.push_back(size & 0xff);
+        for (uint32_t j = 0; j < size; j++)
+            data.push_back(rand() % 256);
+    }
+
+    std::vector<Nal> expected = readAll(data, 4);
+    const uint32_t maxChunks[] = { 1, 2, 5, 64, 1316 };
+    for (size_t i = 0; i < N_ELEMENTS(maxChunks); i++)
+        EXPECT_TRUE(expected == assemble(data, 4, maxChunks[i])) << maxChunks[i];
+}
+
+NALREADER_TEST(AssembleTimeStampAndUnread) {
+    const uint8_t chunk0[] = { 0xff, 0x00, 0x00, 0x01, 0x09, 0x10, 0x00 };
+    const uint8_t chunk1[] = { 0x00, 0x01, 0x67, 0x42 };
+    const uint8_t chunk2[] = { 0x00, 0x00, 0x01, 0x68 };
+    NalAssembler assembler;
+    const uint8_t* nal;
+    int32_t size;
+    int64_t timeStamp;
+
+    assembler.feed(chunk0, sizeof(chunk0), 10);
+    EXPECT_FALSE(assembler.read(nal, size, timeStamp));
+
+    /*the start code straddles chunk0 and chunk1*/
+    assembler.feed(chunk1, sizeof(chunk1), 11);
+    ASSERT_TRUE(assembler.read(nal, size, timeStamp));
+    EXPECT_EQ(2, size);
+    EXPECT_EQ(0x09, nal[0]);
+    EXPECT_EQ(0x10, nal[1]);
+    EXPECT_EQ(10, timeStamp);
+    EXPECT_FALSE(assembler.read(nal, size, timeStamp));
+
+    assembler.feed(chunk2, sizeof(chunk2), 12);
+    ASSERT_TRUE(assembler.read(nal, size, timeStamp));
+    EXPECT_EQ(2, size);
+    EXPECT_EQ(0x67, nal[0]);
+    EXPECT_EQ(11, timeStamp);
+
+    /*caller gets it again, even from a copy of the chunk*/
+    assembler.unread();
+    std::vector<uint8_t> copy(chunk2, chunk2 + sizeof(chunk2));
+    assembler.resume(&copy[0], copy.size());
+    ASSERT_TRUE(assembler.read(nal, size, timeStamp));
+    EXPECT_EQ(2, size);
+    EXPECT_EQ(0x42, nal[1]);
+    EXPECT_FALSE(assembler.read(nal, size, timeStamp));
+
+    assembler.flush();
+    ASSERT_TRUE(assembler.read(nal, size, timeStamp));
+    EXPECT_EQ(1, size);
+    EXPECT_EQ(0x68, nal[0]);
+    EXPECT_EQ(12, timeStamp);
+    EXPECT_FALSE(assembler.read(nal, size, timeStamp));
+}
+
 }
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef objectpool_h
+#define objectpool_h
+
+#include "VideoCommonDefs.h"
+#include "common/common_def.h"
+#include "common/lock.h"
+#include <new>
+#include <vector>
+
+namespace YamiMediaCodec {
+
+/* Fixed size memory blocks kept for reuse. It is for the control blocks
+ * of SharedPtr with a deleter, which the SharedPtr would allocate each
+ * time: SharedPtr<T>(p, deleter, BlockAllocator<T>(blocks)).
+ * Blocks of the first size asked are kept, other sizes go to the heap. */
+class BlockPool {
+public:
+    BlockPool()
+        : m_size(0)
+        , m_created(0)
+    {
+    }
+
+    ~BlockPool()
+    {
+        for (size_t i = 0; i < m_blocks.size(); i++)
+            ::operator delete(m_blocks[i]);
+    }
+
+    void* alloc(size_t size)
+    {
+        {
+            AutoLock lock(m_lock);
+            if (!m_size)
+                m_size = size;
+            if (size == m_size) {
+                if (!m_blocks.empty()) {
+                    void* block = m_blocks.back();
+                    m_blocks.pop_back();
+                    return block;
+                }
+                //room for all blocks, free() must not allocate
+                m_blocks.reserve(++m_created);
+            }
+        }
+        return ::operator new(size);
+    }
+
+    void free(void* block, size_t size)
+    {
+        {
+            AutoLock lock(m_lock);
+            if (size == m_size) {
+                m_blocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+private:
+    Lock m_lock;
+    std::vector<void*> m_blocks;
+    size_t m_size;
+    size_t m_created;
+
+    DISALLOW_COPY_AND_ASSIGN(BlockPool);
+};
+
+/* allocator of SharedPtr control blocks from a BlockPool. It holds the
+ * pool, since the control block is freed after its deleter is gone */
+template <class T>
+struct BlockAllocator {
+    typedef T value_type;
+
+    BlockAllocator(const SharedPtr<BlockPool>& pool)
+        : m_pool(pool)
+    {
+    }
+    template <class U>
+    BlockAllocator(const BlockAllocator<U>& other)
+        : m_pool(other.m_pool)
+    {
+    }
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(m_pool->alloc(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n)
+    {
+        m_pool->free(p, n * sizeof(T));
+    }
+    template <class U>
+    bool operator==(const BlockAllocator<U>& other) const
+    {
+        return m_pool == other.m_pool;
+    }
+    template <class U>
+    bool operator!=(const BlockAllocator<U>& other) const
+    {
+        return m_pool != other.m_pool;
+    }
+
+    SharedPtr<BlockPool> m_pool;
+};
+
+/* Objects that are reset and reused instead of destroyed, like the
+ * pictures and output frames of a decoder.
+ * alloc() returns a free object, or a new one when all are in use, in a
+ * SharedPtr that brings it back to the pool. The control blocks of these
+ * SharedPtr come from a BlockPool, so once the pool has grown to the
+ * number of objects the user holds at most, alloc() and the release of
+ * an object do not touch the heap.
+ * T::reset() is called when an object comes back. It must drop what the
+ * object holds, surfaces for example, and leave it like a new one.
+ * alloc() and the release can be called from any thread. */
+template <class T>
+class ObjectPool : public EnableSharedFromThis<ObjectPool<T> > {
+    typedef SharedPtr<ObjectPool<T> > PoolPtr;
+
+public:
+    static PoolPtr create()
+    {
+        return PoolPtr(new ObjectPool<T>());
+    }
+
+    ~ObjectPool()
+    {
+        for (size_t i = 0; i < m_objects.size(); i++)
+            delete m_objects[i];
+    }
+
+    SharedPtr<T> alloc()
+    {
+        T* object = NULL;
+        {
+            AutoLock lock(m_lock);
+            if (!m_objects.empty()) {
+                object = m_objects.back();
+                m_objects.pop_back();
+            } else {
+                //room for all objects, recycle() must not allocate
+                m_objects.reserve(++m_created);
+            }
+        }
+        if (!object)
+            object = new T();
+        return SharedPtr<T>(object, Recycler(this->shared_from_this()),
+            BlockAllocator<T>(m_blocks));
+    }
+
+    /* objects created so far */
+    size_t created()
+    {
+        AutoLock lock(m_lock);
+        return m_created;
+    }
+
+private:
+    ObjectPool()
+        : m_created(0)
+        , m_blocks(new BlockPool)
+    {
+    }
+
+    void recycle(T* object)
+    {
+        //reset may release other objects of this pool, not under the lock
+        object->reset();
+        AutoLock lock(m_lock);
+        m_objects.push_back(object);
+    }
+
+    struct Recycler {
+        Recycler(const PoolPtr& pool)
+            : m_pool(pool)
+        {
+        }
+        void operator()(T* object) const { m_pool->recycle(object); }
+
+    private:
+        PoolPtr m_pool;
+    };
+
+    Lock m_lock;
+    std::vector<T*> m_objects;
+    size_t m_created;
+    SharedPtr<BlockPool> m_blocks;
+
+    DISALLOW_COPY_AND_ASSIGN(ObjectPool);
+};
+}
+
+#endif //objectpool_h
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "objectpool.h"
+
+// library headers
+#include "common/unittest.h"
+
+#define OBJECTPOOL_TEST(name) \
+    TEST(ObjectPoolTest, name)
+
+using namespace YamiMediaCodec;
+
+namespace {
+
+struct Object {
+    Object()
+        : value(0)
+        , resets(0)
+    {
+    }
+    void reset()
+    {
+        value = 0;
+        held.reset();
+        resets++;
+    }
+    int value;
+    SharedPtr<Object> held;
+    int resets;
+};
+
+typedef ObjectPool<Object> Pool;
+}
+
+OBJECTPOOL_TEST(Reuse)
+{
+    SharedPtr<Pool> pool = Pool::create();
+    SharedPtr<Object> a = pool->alloc();
+    SharedPtr<Object> b = pool->alloc();
+    ASSERT_TRUE(a && b);
+    EXPECT_NE(a.get(), b.get());
+    EXPECT_EQ(2u, pool->created());
+
+    Object* p = a.get();
+    a->value = 1;
+    a.reset();
+    EXPECT_EQ(1, p->resets);
+    EXPECT_EQ(0, p->value);
+
+    //the released one comes back, nothing new
+    a = pool->alloc();
+    EXPECT_EQ(p, a.get());
+    EXPECT_EQ(2u, pool->created());
+}
+
+OBJECTPOOL_TEST(ResetReleasesHeld)
+{
+    SharedPtr<Pool> pool = Pool::create();
+    SharedPtr<Object> a = pool->alloc();
+    Object* p = a.get();
+    {
+        SharedPtr<Object> b = pool->alloc();
+        b->held = a;
+        a.reset();
+        EXPECT_EQ(0, p->resets);
+    }
+    //b took a with it
+    EXPECT_EQ(1, p->resets);
+    EXPECT_EQ(2u, pool->created());
+    a = pool->alloc();
+    SharedPtr<Object> b = pool->alloc();
+    EXPECT_EQ(2u, pool->created());
+}
+
+OBJECTPOOL_TEST(OutlivePool)
+{
+    SharedPtr<Object> a;
+    {
+        SharedPtr<Pool> pool = Pool::create();
+        a = pool->alloc();
+    }
+    //the pool lives with its objects
+    a->value = 1;
+    a.reset();
+}
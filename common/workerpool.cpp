@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2016 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "workerpool.h"
+
+#include "common/log.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+namespace YamiMediaCodec {
+
+WorkerPool::WorkerPool(uint32_t threads)
+    : m_hasJob(m_lock)
+    , m_finished(m_lock)
+    , m_job(NULL)
+    , m_count(0)
+    , m_next(0)
+    , m_done(0)
+    , m_quit(false)
+{
+    for (uint32_t i = 0; i < threads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, start, this)) {
+            ERROR("create worker thread failed, %d threads created", i);
+            break;
+        }
+        m_threads.push_back(thread);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        AutoLock lock(m_lock);
+        m_quit = true;
+        m_hasJob.broadcast();
+    }
+    for (size_t i = 0; i < m_threads.size(); i++)
+        pthread_join(m_threads[i], NULL);
+}
+
+uint32_t WorkerPool::suggestThreads(uint32_t maxThreads)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus <= 1)
+        return 0;
+    return std::min<uint32_t>(cpus - 1, maxThreads);
+}
+
+bool WorkerPool::takeJob(uint32_t& index)
+{
+    if (m_next >= m_count)
+        return false;
+    index = m_next++;
+    return true;
+}
+
+void WorkerPool::finishJob()
+{
+    if (++m_done == m_count)
+        m_finished.signal();
+}
+
+void WorkerPool::run(const Job& job, uint32_t count)
+{
+    if (!count)
+        return;
+    uint32_t index;
+    AutoLock lock(m_lock);
+    m_job = &job;
+    m_count = count;
+    m_next = 0;
+    m_done = 0;
+    if (count > 1)
+        m_hasJob.broadcast();
+    while (takeJob(index)) {
+        m_lock.release();
+        job(index);
+        m_lock.acquire();
+        finishJob();
+    }
+    while (m_done < m_count)
+        m_finished.wait();
+    m_job = NULL;
+    m_count = 0;
+}
+
+void* WorkerPool::start(void* pool)
+{
+    static_cast<WorkerPool*>(pool)->loop();
+    return NULL;
+}
+
+void WorkerPool::loop()
+{
+    uint32_t index;
+    AutoLock lock(m_lock);
+    while (!m_quit) {
+        if (!takeJob(index)) {
+            m_hasJob.wait();
+            continue;
+        }
+        const Job& job = *m_job;
+        m_lock.release();
+        job(index);
+        m_lock.acquire();
+        finishJob();
+    }
+}
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2016 Intel Corporation. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef workerpool_h
+#define workerpool_h
+
+#include "common/Functional.h"
+#include "common/NonCopyable.h"
+#include "common/condition.h"
+#include "common/lock.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+namespace YamiMediaCodec {
+
+/* A few threads to run independent jobs of one batch, like parsing the
+ * slice headers of a picture. run() blocks until the whole batch is done,
+ * and the calling thread takes jobs too, so a pool of n threads
+ * runs n + 1 jobs at a time. */
+class WorkerPool {
+public:
+    typedef std::function<void(uint32_t)> Job;
+
+    explicit WorkerPool(uint32_t threads);
+    ~WorkerPool();
+
+    /* run job(0) ... job(count - 1), return after all of them finished */
+    void run(const Job& job, uint32_t count);
+
+    uint32_t getThreadCount() const { return m_threads.size(); }
+
+    /* threads worth to create on this machine, capped by maxThreads.
+     * the calling thread is not counted */
+    static uint32_t suggestThreads(uint32_t maxThreads);
+
+private:
+    static void* start(void* pool);
+    void loop();
+    /* get next job of the batch, m_lock is held */
+    bool takeJob(uint32_t& index);
+    void finishJob();
+
+    std::vector<pthread_t> m_threads;
+    Lock m_lock;
+    Condition m_hasJob;
+    Condition m_finished;
+    const Job* m_job;
+    uint32_t m_count;
+    uint32_t m_next;
+    uint32_t m_done;
+    bool m_quit;
+
+    DISALLOW_COPY_AND_ASSIGN(WorkerPool);
+};
+}
+
+#endif //workerpool_h
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "workerpool.h"
+
+// library headers
+#include "common/unittest.h"
+
+// system headers
+#include <vector>
+
+#define WORKERPOOL_TEST(name) \
+    TEST(WorkerPoolTest, name)
+
+using namespace YamiMediaCodec;
+
+namespace {
+
+void square(std::vector<uint32_t>& out, uint32_t index)
+{
+    out[index] = index * index;
+}
+
+}
+
+WORKERPOOL_TEST(RunAllJobs)
+{
+    WorkerPool pool(3);
+    EXPECT_EQ(3u, pool.getThreadCount());
+
+    for (uint32_t count = 0; count < 100; count++) {
+        std::vector<uint32_t> out(count, 0xffffffff);
+        pool.run(std::bind(square, std::ref(out), std::placeholders::_1), count);
+        for (uint32_t i = 0; i < count; i++)
+            EXPECT_EQ(i * i, out[i]);
+    }
+}
+
+WORKERPOOL_TEST(NoThreads)
+{
+    //the calling thread runs all jobs
+    WorkerPool pool(0);
+    std::vector<uint32_t> out(16);
+    pool.run(std::bind(square, std::ref(out), std::placeholders::_1), out.size());
+    EXPECT_EQ(225u, out[15]);
+}
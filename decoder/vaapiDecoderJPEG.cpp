@@ -36,7 +36,9 @@ using ::YamiParser::JPEG::HuffTables;
 using ::YamiParser::JPEG::Parser;
 using ::YamiParser::JPEG::QuantTable;
 using ::YamiParser::JPEG::QuantTables;
+using ::YamiParser::JPEG::ScanData;
 using ::YamiParser::JPEG::ScanHeader;
+using ::YamiParser::JPEG::ScanLayout;
 using ::YamiParser::JPEG::Defaults;
 using ::std::function;
 using ::std::bind;
@@ -44,14 +46,6 @@ using ::std::ref;
 
 namespace YamiMediaCodec {
 
-struct Slice {
-    Slice() : data(NULL), start(0) , length(0) { }
-
-    const uint8_t* data;
-    uint32_t start;
-    uint32_t length;
-};
-
 class VaapiDecoderJPEG::Impl
 {
 public:
@@ -64,7 +58,8 @@ public:
         , m_dcHuffmanTables(Defaults::instance().dcHuffTables())
         , m_acHuffmanTables(Defaults::instance().acHuffTables())
         , m_quantizationTables(Defaults::instance().quantTables())
-        , m_slice()
+        , m_data(NULL)
+        , m_scanLayout()
         , m_decodeStatus(YAMI_SUCCESS)
     {
     }
@@ -84,7 +79,7 @@ public:
          * we are continuing after previously suspending due to an SOF
          * YAMI_DECODE_FORMAT_CHANGE.
          */
-        if (m_slice.data != data)
+        if (m_data != data)
             m_parser.reset();
 
         if (!m_parser) { /* First call or new data */
@@ -92,8 +87,9 @@ public:
                 bind(&Impl::onMarker, ref(*this));
             Parser::Callback sofCallback =
                 bind(&Impl::onStartOfFrame, ref(*this));
-            m_slice.data = data;
+            m_data = data;
             m_parser.reset(new Parser(data, size));
+            m_parser->setScanLayout(&m_scanLayout);
             m_parser->registerCallback(M_SOI, defaultCallback);
             m_parser->registerCallback(M_EOI, defaultCallback);
             m_parser->registerCallback(M_SOS, defaultCallback);
@@ -113,11 +109,6 @@ public:
         return m_parser->frameHeader();
     }
 
-    const ScanHeader::Shared& scanHeader() const
-    {
-        return m_parser->scanHeader();
-    }
-
     const unsigned restartInterval() const
     {
         return m_parser->restartInterval();
@@ -126,7 +117,10 @@ public:
     const HuffTables& dcHuffmanTables() const { return m_dcHuffmanTables; }
     const HuffTables& acHuffmanTables() const { return m_acHuffmanTables; }
     const QuantTables& quantTables() const { return m_quantizationTables; }
-    const Slice& slice() const { return m_slice; }
+    const uint8_t* data() const { return m_data; }
+
+    /* byte ranges of the scans, the storage is reused between images */
+    const ScanLayout& scanLayout() const { return m_scanLayout; }
 
 private:
     Parser::CallbackResult onMarker()
@@ -137,15 +131,9 @@ private:
 
         switch(m_parser->current().marker) {
         case M_SOI:
-            m_slice.start = 0;
-            m_slice.length = 0;
-            break;
         case M_SOS:
-            m_slice.start = m_parser->current().position + 1
-                + m_parser->current().length;
             break;
         case M_EOI:
-            m_slice.length = m_parser->current().position - m_slice.start;
             m_decodeStatus = m_finishHandler();
             break;
         case M_DQT:
@@ -180,7 +168,8 @@ private:
     HuffTables m_acHuffmanTables;
     QuantTables m_quantizationTables;
 
-    Slice m_slice;
+    const uint8_t* m_data;
+    ScanLayout m_scanLayout;
 
     YamiStatus m_decodeStatus;
 };
@@ -223,14 +212,14 @@ YamiStatus VaapiDecoderJPEG::fillPictureParam()
     return YAMI_SUCCESS;
 }
 
-YamiStatus VaapiDecoderJPEG::fillSliceParam()
+YamiStatus VaapiDecoderJPEG::fillSliceParam(const ScanData& scanData)
 {
-    const ScanHeader::Shared scan = m_impl->scanHeader();
+    const ScanHeader::Shared& scan = scanData.header;
     const FrameHeader::Shared frame = m_impl->frameHeader();
-    const Slice& slice = m_impl->slice();
     VASliceParameterBufferJPEGBaseline *sliceParam(NULL);
 
-    if (!m_picture->newSlice(sliceParam, slice.data + slice.start, slice.length))
+    if (!m_picture->newSlice(sliceParam,
+            m_impl->data() + scanData.range.offset, scanData.range.size))
         return YAMI_FAIL;
 
     for (size_t i(0); i < scan->numComponents; ++i) {
@@ -448,7 +437,8 @@ YamiStatus VaapiDecoderJPEG::finish()
         return YAMI_FAIL;
     }
 
-    if (!m_impl->scanHeader()) {
+    const std::vector<ScanData>& scans = m_impl->scanLayout().scans;
+    if (scans.empty()) {
         ERROR("Start of Scan (SOS) not found");
         return YAMI_FAIL;
     }
@@ -463,10 +453,13 @@ YamiStatus VaapiDecoderJPEG::finish()
 
     YamiStatus status;
 
-    status = fillSliceParam();
-    if (status !=  YAMI_SUCCESS) {
-        ERROR("Failed to load VAAPI slice parameters.");
-        return status;
+    /* one slice per scan, straight from the scan layout */
+    for (size_t i(0); i < scans.size(); ++i) {
+        status = fillSliceParam(scans[i]);
+        if (status !=  YAMI_SUCCESS) {
+            ERROR("Failed to load VAAPI slice parameters.");
+            return status;
+        }
     }
 
     status = fillPictureParam();
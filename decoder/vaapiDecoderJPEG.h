@@ -21,6 +21,12 @@
 #include "vaapidecpicture.h"
 #include "vaapidecoder_base.h"
 
+namespace YamiParser {
+namespace JPEG {
+struct ScanData;
+}
+}
+
 namespace YamiMediaCodec {
 
 class VaapiDecoderJPEG
@@ -40,7 +46,7 @@ private:
     class Impl;
 
     YamiStatus fillPictureParam();
-    YamiStatus fillSliceParam();
+    YamiStatus fillSliceParam(const YamiParser::JPEG::ScanData&);
 
     YamiStatus loadQuantizationTables();
     YamiStatus loadHuffmanTables();
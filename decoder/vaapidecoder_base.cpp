@@ -22,6 +22,7 @@
 #include "common/log.h"
 #include "vaapi/vaapisurfaceallocator.h"
 #include "vaapi/vaapicontext.h"
+#include "vaapi/vaapibufferrecycler.h"
 #include "vaapi/vaapidisplay.h"
 #include "vaapi/VaapiUtils.h"
 #include "vaapidecsurfacepool.h"
@@ -40,6 +41,8 @@ inline void unrefAllocator(SurfaceAllocator* allocator)
 VaapiDecoderBase::VaapiDecoderBase()
     : m_VAStarted(false)
     , m_currentPTS(INVALID_PTS)
+    , m_picturePool(ObjectPool<VaapiDecPicture>::create())
+    , m_framePool(ObjectPool<OutputFrame>::create())
 {
     INFO("base: construct()");
     m_externalDisplay.handle = 0,
@@ -65,7 +68,8 @@ PicturePtr VaapiDecoderBase::createPicture(int64_t timeStamp /* , VaapiPictureSt
         return picture;
     }
 
-    picture.reset(new VaapiDecPicture(m_context, surface, timeStamp));
+    picture = m_picturePool->alloc();
+    picture->init(m_context, surface, timeStamp);
     return picture;
 }
 
@@ -164,33 +168,37 @@ void VaapiDecoderBase::flush(void)
     m_currentPTS = INVALID_PTS;
 }
 
-struct BufferRecycler
+/* frame of getOutput(), the surface goes back to the pool with it */
+struct VaapiDecoderBase::OutputFrame : public VideoFrame
 {
-    BufferRecycler(const DecSurfacePoolPtr&  pool, VideoRenderBuffer* buffer)
-        :m_pool(pool), m_buffer(buffer)
+    OutputFrame()
+        : m_buffer(NULL)
     {
     }
-    void operator()(VideoFrame* frame)
+    void reset()
     {
-        m_pool->recycle(m_buffer);
-        delete frame;
+        if (m_buffer)
+            m_pool->recycle(m_buffer);
+        m_pool.reset();
+        m_buffer = NULL;
     }
 
-private:
     DecSurfacePoolPtr  m_pool;
     VideoRenderBuffer* m_buffer;
 };
 
 SharedPtr<VideoFrame> VaapiDecoderBase::getOutput()
 {
-    SharedPtr<VideoFrame> frame;
+    SharedPtr<OutputFrame> frame;
     DecSurfacePoolPtr pool = m_surfacePool;
     if (!pool)
         return frame;
     VideoRenderBuffer *buffer = pool->getOutput();
     if (buffer) {
-        frame.reset(new VideoFrame, BufferRecycler(pool, buffer));
-        memset(frame.get(), 0, sizeof(VideoFrame));
+        frame = m_framePool->alloc();
+        frame->m_pool = pool;
+        frame->m_buffer = buffer;
+        memset(static_cast<VideoFrame*>(frame.get()), 0, sizeof(VideoFrame));
         frame->surface = (intptr_t)buffer->surface;
         frame->timeStamp = buffer->timeStamp;
         frame->crop = buffer->crop;
@@ -199,6 +207,14 @@ SharedPtr<VideoFrame> VaapiDecoderBase::getOutput()
     return frame;
 }
 
+const VideoSeiInfo* VaapiDecoderBase::getSei(const VideoFrame* frame)
+{
+    DecSurfacePoolPtr pool = m_surfacePool;
+    if (!frame || !pool)
+        return NULL;
+    return pool->getSei((VASurfaceID)frame->surface);
+}
+
 const VideoFormatInfo *VaapiDecoderBase::getFormatInfo(void)
 {
     INFO("base: getFormatInfo()");
@@ -267,6 +283,7 @@ VaapiDecoderBase::setupVA(uint32_t numSurface, VAProfile profile)
         ERROR("create context failed");
         return YAMI_FAIL;
     }
+    m_context->enableBufferRecycling();
 
     m_videoFormatInfo.surfaceWidth = m_videoFormatInfo.width;
     m_videoFormatInfo.surfaceHeight = m_videoFormatInfo.height;
@@ -281,6 +298,14 @@ YamiStatus VaapiDecoderBase::terminateVA(void)
     m_surfacePool.reset();
     m_allocator.reset();
     DEBUG("surface pool is reset");
+#ifdef __ENABLE_DEBUG__
+    if (m_context && m_context->getBufferRecycler()) {
+        VaapiBufferRecycler::Counters counters = m_context->getBufferRecycler()->getCounters();
+        INFO("va buffers: %llu created, %llu destroyed, %llu reused",
+            (unsigned long long)counters.created, (unsigned long long)counters.destroyed,
+            (unsigned long long)counters.reused);
+    }
+#endif
     m_context.reset();
     m_display.reset();
 
@@ -322,7 +347,7 @@ YamiStatus VaapiDecoderBase::outputPicture(const PicturePtr& picture)
 {
     //TODO: reorder poc
     return m_surfacePool->output(picture->getSurface(),
-               picture->m_timeStamp)
+               picture->m_timeStamp, picture->m_sei)
         ? YAMI_SUCCESS
         : YAMI_FAIL;
 }
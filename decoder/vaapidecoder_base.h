@@ -20,6 +20,7 @@
 
 #include "common/log.h"
 #include "common/common_def.h"
+#include "common/objectpool.h"
 #include "VideoDecoderInterface.h"
 #include "vaapi/vaapiptrs.h"
 #include "vaapidecpicture.h"
@@ -56,6 +57,7 @@ class VaapiDecoderBase:public IVideoDecoder {
     virtual void flush(void);
     virtual const VideoFormatInfo *getFormatInfo(void);
     virtual SharedPtr<VideoFrame> getOutput();
+    virtual const VideoSeiInfo* getSei(const VideoFrame*);
 
     /* native window related functions */
     void setNativeDisplay(NativeDisplay * nativeDisplay);
@@ -96,6 +98,11 @@ class VaapiDecoderBase:public IVideoDecoder {
 #ifdef __ENABLE_DEBUG__
     int renderPictureCount;
 #endif
+    struct OutputFrame;
+
+    /* pictures of createPicture() and frames of getOutput() are reused */
+    SharedPtr<ObjectPool<VaapiDecPicture> > m_picturePool;
+    SharedPtr<ObjectPool<OutputFrame> > m_framePool;
 
 };
 }
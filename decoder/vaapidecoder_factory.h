@@ -20,9 +20,46 @@
 #include "common/factory.h"
 #include "VideoDecoderInterface.h"
 
+#include <map>
+#include <string>
+
 namespace YamiMediaCodec {
 
 typedef Factory<IVideoDecoder> VaapiDecoderFactory;
 
+/* fills VideoFormatInfo from the stream headers, see probeVideoStream() */
+typedef YamiStatus (*VideoStreamProbe)(const uint8_t* data, size_t size,
+    VideoFormatInfo* info);
+
+/**
+ * Probes are registered with the decoder of the same mime type, they run
+ * the codec parser only and never touch libva.
+ */
+class VaapiDecoderProbes {
+public:
+    static bool register_(const std::string& mimeType, VideoStreamProbe probe)
+    {
+        return getProbes().insert(std::make_pair(mimeType, probe)).second;
+    }
+
+    /* NULL if no probe for the mime type */
+    static VideoStreamProbe find(const std::string& mimeType)
+    {
+        const Probes& probes = getProbes();
+        const Probes::const_iterator it = probes.find(mimeType);
+        if (it != probes.end())
+            return it->second;
+        return NULL;
+    }
+
+private:
+    typedef std::map<std::string, VideoStreamProbe> Probes;
+    static Probes& getProbes()
+    {
+        static Probes probes;
+        return probes;
+    }
+};
+
 } // namespace YamiMediaCodec
 #endif // vaapidecoder_factory_h
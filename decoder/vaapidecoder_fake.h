@@ -35,6 +35,8 @@ class VaapiDecoderFake:public VaapiDecoderBase {
     virtual YamiStatus decode(VideoDecodeBuffer*);
 
   private:
+    friend class VaapiDecoderFakeTest;
+
     int32_t m_width;
     int32_t m_height;
     bool    m_first;
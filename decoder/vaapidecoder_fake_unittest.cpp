@@ -0,0 +1,167 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vaapidecoder_fake.h"
+
+// library headers
+#include "common/unittest.h"
+#include "vaapidecsurfacepool.h"
+
+// system headers
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+/* allocation counting hook: the heap allocations of a thread are counted
+ * while s_countAllocations is set */
+static thread_local bool s_countAllocations = false;
+static thread_local uint32_t s_allocations = 0;
+
+void* operator new(size_t size)
+{
+    if (s_countAllocations)
+        s_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+namespace YamiMediaCodec {
+
+/* the pool never touches the surfaces, fake ids are enough */
+static const intptr_t FAKE_SURFACE_BASE = 0x1000;
+
+static YamiStatus fakeAlloc(SurfaceAllocator*, SurfaceAllocParams* params)
+{
+    params->surfaces = new intptr_t[params->size];
+    for (uint32_t i = 0; i < params->size; i++)
+        params->surfaces[i] = FAKE_SURFACE_BASE + i;
+    return YAMI_SUCCESS;
+}
+
+static YamiStatus fakeFree(SurfaceAllocator*, SurfaceAllocParams* params)
+{
+    delete[] params->surfaces;
+    params->surfaces = NULL;
+    return YAMI_SUCCESS;
+}
+
+static void fakeUnref(SurfaceAllocator*)
+{
+}
+
+class VaapiDecoderFakeTest : public ::testing::Test {
+protected:
+    /* like start(), but with fake surfaces and no va context, so the test
+     * runs without a gpu */
+    void startWithoutVa(VaapiDecoderFake& decoder, uint32_t surfaces)
+    {
+        SharedPtr<SurfaceAllocator> allocator(new SurfaceAllocator);
+        allocator->user = NULL;
+        allocator->alloc = fakeAlloc;
+        allocator->free = fakeFree;
+        allocator->unref = fakeUnref;
+
+        VideoConfigBuffer config;
+        memset(&config, 0, sizeof(config));
+        config.surfaceWidth = 320;
+        config.surfaceHeight = 240;
+        config.fourcc = YAMI_FOURCC_NV12;
+        config.surfaceNumber = surfaces;
+        decoder.m_surfacePool = VaapiDecSurfacePool::create(DisplayPtr(), &config, allocator);
+        ASSERT_TRUE(bool(decoder.m_surfacePool));
+    }
+
+    DecSurfacePoolPtr getSurfacePool(VaapiDecoderFake& decoder)
+    {
+        return decoder.m_surfacePool;
+    }
+};
+
+#define VAAPIDECODER_FAKE_TEST(name) \
+    TEST_F(VaapiDecoderFakeTest, name)
+
+VAAPIDECODER_FAKE_TEST(NoAllocationInSteadyState)
+{
+    VaapiDecoderFake decoder(320, 240);
+    startWithoutVa(decoder, FAKE_EXTRA_SURFACE_NUMBER);
+
+    VideoDecodeBuffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    EXPECT_EQ(YAMI_DECODE_FORMAT_CHANGE, decoder.decode(&buffer));
+
+    //the renderer holds a few frames, like a display queue
+    const uint32_t held = 3;
+    SharedPtr<VideoFrame> frames[held];
+    const uint32_t warmUp = 16;
+    const uint32_t steady = 1000;
+    for (uint32_t i = 0; i < warmUp + steady; i++) {
+        if (i == warmUp) {
+            s_allocations = 0;
+            s_countAllocations = true;
+        }
+        buffer.timeStamp = i;
+        ASSERT_EQ(YAMI_SUCCESS, decoder.decode(&buffer));
+        SharedPtr<VideoFrame>& frame = frames[i % held];
+        frame = decoder.getOutput();
+        ASSERT_TRUE(bool(frame));
+        EXPECT_EQ((int64_t)i, frame->timeStamp);
+    }
+    s_countAllocations = false;
+    EXPECT_EQ(0u, s_allocations);
+}
+
+VAAPIDECODER_FAKE_TEST(SeiOfOutputFrame)
+{
+    VaapiDecoderFake decoder(320, 240);
+    startWithoutVa(decoder, FAKE_EXTRA_SURFACE_NUMBER);
+    DecSurfacePoolPtr pool = getSurfacePool(decoder);
+
+    //like a decoder outputs a picture with sei
+    SharedPtr<VideoSeiInfo> sei(new VideoSeiInfo);
+    memset(sei.get(), 0, sizeof(VideoSeiInfo));
+    sei->present = VIDEO_SEI_RECOVERY_POINT;
+    SurfacePtr surface = pool->acquireWithWait();
+    ASSERT_TRUE(bool(surface));
+    ASSERT_TRUE(pool->output(surface, 0, sei));
+    surface.reset();
+
+    SharedPtr<VideoFrame> frame = decoder.getOutput();
+    ASSERT_TRUE(bool(frame));
+    EXPECT_EQ(sei.get(), decoder.getSei(frame.get()));
+
+    //not a frame of the decoder
+    VideoFrame other = *frame;
+    other.surface = 0;
+    EXPECT_EQ(NULL, decoder.getSei(&other));
+
+    //recycled, the surface is not out any more
+    other.surface = frame->surface;
+    frame.reset();
+    EXPECT_EQ(NULL, decoder.getSei(&other));
+}
+}
@@ -22,6 +22,7 @@
 
 #include "common/log.h"
 #include "common/nalreader.h"
+#include "common/workerpool.h"
 #include "vaapidecoder_factory.h"
 
 #include "vaapi/vaapiptrs.h"
@@ -33,103 +34,15 @@
 
 namespace YamiMediaCodec {
 typedef VaapiDecoderH264::PicturePtr PicturePtr;
+typedef VaapiDecoderH264::RefSet RefSet;
 using std::bind;
 using std::placeholders::_1;
 using std::ref;
 using std::vector;
 using namespace YamiParser::H264;
 
-class VaapiDecPictureH264 : public VaapiDecPicture {
-public:
-    VaapiDecPictureH264(const ContextPtr& context, const SurfacePtr& surface,
-                        int64_t timeStamp)
-        : VaapiDecPicture(context, surface, timeStamp)
-        , m_idrFlag(false)
-        , m_picStructure(VAAPI_PICTURE_FRAME)
-        , m_longTermRefFlag(false)
-        , m_shortTermRefFlag(false)
-        , m_topFieldOrderCnt(0)
-        , m_bottomFieldOrderCnt(0)
-        , m_pocMsb(0)
-        , m_pocLsb(0)
-        , m_poc(0)
-        , m_frameNumOffset(0)
-        , m_frameNum(0)
-        , m_frameNumWrap(0)
-        , m_picNum(0)
-        , m_longTermFrameIdx(0)
-        , m_longTermPicNum(0)
-        , m_picOutputFlag(true)
-        , m_isReference(false)
-        , m_hasMmco5(false)
-        , m_isSecondField(false)
-    {
-    }
-    VaapiDecPictureH264() {}
-
-    PicturePtr allocPicture()
-    {
-        PicturePtr picture(
-            new VaapiDecPictureH264(m_context, m_surface, m_timeStamp));
-        assert(picture);
-        return picture;
-    }
-
-    PicturePtr allocField(bool isBottomField)
-    {
-        PicturePtr field = allocPicture();
-        *field = *this;
-
-        field->m_picStructure = VAAPI_PICTURE_TOP_FIELD;
-        field->m_poc = this->m_topFieldOrderCnt;
-
-        if (isBottomField) {
-            field->m_picStructure = VAAPI_PICTURE_BOTTOM_FIELD;
-            field->m_poc = this->m_bottomFieldOrderCnt;
-        }
-
-        return field;
-    }
-
-    PicturePtr allocDummyPicture(int32_t frameNum)
-    {
-        PicturePtr picture = allocPicture();
-        *picture = *this;
-
-        picture->m_picStructure = VAAPI_PICTURE_FRAME;
-        picture->m_frameNum = frameNum;
-        picture->m_picOutputFlag = false;
-        picture->m_idrFlag = false;
-        picture->m_poc = 0x7fffffff;
-
-        picture->m_isReference = true;
-        picture->m_longTermRefFlag = false;
-        picture->m_shortTermRefFlag = true;
-
-        return picture;
-    }
-
-    bool m_idrFlag;
-    VaapiPictureType m_picStructure;
-    bool m_longTermRefFlag;
-    bool m_shortTermRefFlag;
-    int32_t m_topFieldOrderCnt;
-    int32_t m_bottomFieldOrderCnt;
-    int32_t m_pocMsb;
-    uint16_t m_pocLsb;
-    int32_t m_poc;
-    int32_t m_frameNumOffset;
-    int32_t m_frameNum;
-    int32_t m_frameNumWrap;
-    int32_t m_picNum;
-    int32_t m_longTermFrameIdx;
-    int32_t m_longTermPicNum;
-    bool m_picOutputFlag;
-    bool m_isReference;
-    bool m_hasMmco5;
-    bool m_isSecondField;
-    PicturePtr m_complementField;
-};
+//threads to parse slice headers, besides the decoding one
+static const uint32_t SLICE_PARSING_THREADS = 3;
 
 static bool isISlice(uint32_t sliceType)
 {
@@ -312,12 +225,6 @@ inline bool ascComparePoc(const PicturePtr& picture1,
     return picture1->m_poc < picture2->m_poc;
 }
 
-inline bool VaapiDecoderH264::DPB::PocLess::
-operator()(const PicturePtr& left, const PicturePtr& right) const
-{
-    return left->m_poc <= right->m_poc;
-}
-
 bool checkMMCO5(DecRefPicMarking decRefPicMarking)
 {
     for (uint32_t i = 0; i < decRefPicMarking.n_ref_pic_marking; i++) {
@@ -346,12 +253,43 @@ void VaapiDecoderH264::DPB::removeUnused()
     PictureList::iterator it;
     for (it = m_pictures.begin(); it != m_pictures.end();) {
         if (isUnusedPicture(*it))
-            m_pictures.erase(it++);
+            it = m_pictures.erase(it);
         else
             ++it;
     }
 }
 
+/* insert before the pictures of same poc, like m_pictures */
+template <class L>
+static bool insertByPoc(L& pictures, const PicturePtr& picture)
+{
+    return pictures.insert(std::lower_bound(pictures.begin(), pictures.end(),
+                                            picture, ascComparePoc),
+                           picture);
+}
+
+void VaapiDecoderH264::DPB::addToReferenceIndex(const PicturePtr& picture)
+{
+    if (isShortTermReference(picture))
+        insertByPoc(m_shortTermRefs, picture);
+    else if (isLongTermReference(picture))
+        insertByPoc(m_longTermRefs, picture);
+}
+
+void VaapiDecoderH264::DPB::updateReferenceIndex()
+{
+    m_shortTermRefs.clear();
+    m_longTermRefs.clear();
+    //m_pictures is in poc order already, keep the order of same pocs
+    PictureList::iterator it;
+    for (it = m_pictures.begin(); it != m_pictures.end(); ++it) {
+        if (isShortTermReference(*it))
+            m_shortTermRefs.push_back(*it);
+        else if (isLongTermReference(*it))
+            m_longTermRefs.push_back(*it);
+    }
+}
+
 void VaapiDecoderH264::DPB::clearRefSet()
 {
     m_shortTermList.clear();
@@ -400,9 +338,10 @@ void VaapiDecoderH264::DPB::printRefList()
     }
 }
 
-static void calcShortTermPicNum(vector<PicturePtr>& shortRefSet,
+static void calcShortTermPicNum(RefSet& shortRefSet,
                                 const PicturePtr& picture,
-                                PicturePtr& refPicture, uint32_t maxFrameNum)
+                                const PicturePtr& refPicture,
+                                uint32_t maxFrameNum)
 {
     if (refPicture->m_frameNum > picture->m_frameNum)
         refPicture->m_frameNumWrap = refPicture->m_frameNum - maxFrameNum;
@@ -417,15 +356,15 @@ static void calcShortTermPicNum(vector<PicturePtr>& shortRefSet,
         refPicture->m_picNum = 2 * refPicture->m_frameNumWrap;
 
     if (isField(picture) && isFrame(refPicture)) {
-        shortRefSet.push_back(refPicture->allocField(false));
-        shortRefSet.push_back(refPicture->allocField(true));
+        shortRefSet.push_back(refPicture->getField(false));
+        shortRefSet.push_back(refPicture->getField(true));
     } else
         shortRefSet.push_back(refPicture);
 }
 
-static void calcLongTermPicNum(vector<PicturePtr>& longRefSet,
+static void calcLongTermPicNum(RefSet& longRefSet,
                                const PicturePtr& picture,
-                               PicturePtr& refPicture)
+                               const PicturePtr& refPicture)
 {
     if (isFrame(refPicture))
         refPicture->m_longTermPicNum = refPicture->m_longTermFrameIdx;
@@ -435,8 +374,8 @@ static void calcLongTermPicNum(vector<PicturePtr>& longRefSet,
         refPicture->m_longTermPicNum = 2 * refPicture->m_longTermFrameIdx;
 
     if (isField(picture) && isFrame(refPicture)) {
-        longRefSet.push_back(refPicture->allocField(false));
-        longRefSet.push_back(refPicture->allocField(true));
+        longRefSet.push_back(refPicture->getField(false));
+        longRefSet.push_back(refPicture->getField(true));
     } else
         longRefSet.push_back(refPicture);
 }
@@ -445,7 +384,6 @@ void VaapiDecoderH264::DPB::calcPicNum(const PicturePtr& picture,
                                        const SliceHeader* const slice)
 {
     PictureList::iterator it;
-    PicturePtr refPicture;
 
     m_shortTermList.clear();
     m_longTermList.clear();
@@ -453,28 +391,25 @@ void VaapiDecoderH264::DPB::calcPicNum(const PicturePtr& picture,
     picture->m_picNum = isFrame(picture) ? picture->m_frameNum
                                          : 2 * picture->m_frameNum + 1;
 
-    for (it = m_pictures.begin(); it != m_pictures.end(); it++) {
-        refPicture = *it;
-        if (isShortTermReference(refPicture)) {
-            calcShortTermPicNum(m_shortTermList, picture, refPicture,
-                                m_maxFrameNum);
-        } else if (isLongTermReference(refPicture))
-            calcLongTermPicNum(m_longTermList, picture, refPicture);
-    }
+    for (it = m_shortTermRefs.begin(); it != m_shortTermRefs.end(); it++)
+        calcShortTermPicNum(m_shortTermList, picture, *it, m_maxFrameNum);
+    for (it = m_longTermRefs.begin(); it != m_longTermRefs.end(); it++)
+        calcLongTermPicNum(m_longTermList, picture, *it);
 }
 
-void partitionAndInterleave(const PicturePtr& picture,
-                            vector<PicturePtr>& refSet)
+void partitionAndInterleave(const PicturePtr& picture, RefSet& refSet)
 {
-    vector<PicturePtr> refSet1, refSet2;
-    vector<PicturePtr>::iterator it;
+    RefSet refSet1, refSet2;
+    RefSet::iterator it;
     uint32_t i, n;
 
-    // refset has been sorted, use stable_partition to keep the sequence.
-    it = std::stable_partition(refSet.begin(), refSet.end(),
-                               bind(matchPicStructure, _1, picture));
-    refSet1.insert(refSet1.end(), refSet.begin(), it);
-    refSet2.insert(refSet2.end(), it, refSet.end());
+    // refset has been sorted, split it in the same sequence.
+    for (it = refSet.begin(); it != refSet.end(); it++) {
+        if (matchPicStructure(*it, picture))
+            refSet1.push_back(*it);
+        else
+            refSet2.push_back(*it);
+    }
     refSet.clear();
 
     for (i = 0; i < refSet1.size(); i++) {
@@ -596,6 +531,17 @@ void VaapiDecoderH264::DPB::initReference(const PicturePtr& picture,
         m_refList1.resize(slice->num_ref_idx_l1_active_minus1 + 1);
 }
 
+/* refList is cut to num_ref_idx_lX_active_minus1 + 1 (32 at most) after
+ * the modification, and one insert moves an entry by one only. A full list
+ * can drop its last entry, it would be cut anyway */
+static void insertReference(RefSet& refList, uint32_t refIdx,
+                            const PicturePtr& picture)
+{
+    if (refList.full())
+        refList.pop_back();
+    refList.insert(refList.begin() + refIdx, picture);
+}
+
 bool VaapiDecoderH264::DPB::modifyReferenceList(const PicturePtr& picture,
                                                 const SliceHeader* const slice,
                                                 RefSet& refList, uint8_t refIdx)
@@ -657,7 +603,7 @@ bool VaapiDecoderH264::DPB::modifyReferenceList(const PicturePtr& picture,
                          bind(matchPicNum, _1, picNumLx));
 
             if (it != m_shortTermList.end()) {
-                refList.insert(refList.begin() + refIdxLx, *it);
+                insertReference(refList, refIdxLx, *it);
                 DEBUG(" Insert refList( Poc %d, PicNum %d)", (*it)->m_poc,
                       (*it)->m_picNum);
             } else
@@ -680,7 +626,7 @@ bool VaapiDecoderH264::DPB::modifyReferenceList(const PicturePtr& picture,
                          bind(matchLongTermPicNum, _1, picNumLx));
 
             if (it != m_longTermList.end())
-                refList.insert(refList.begin() + refIdxLx, *it);
+                insertReference(refList, refIdxLx, *it);
             else
                 WARNING("can't find this picture");
 
@@ -803,7 +749,8 @@ bool VaapiDecoderH264::DPB::markReference(const PicturePtr& picture)
     return true;
 }
 
-void VaapiDecoderH264::DPB::forEach(ForEachFunction fn)
+template <class F>
+void VaapiDecoderH264::DPB::forEach(F fn)
 {
     std::for_each(m_pictures.begin(), m_pictures.end(), fn);
 }
@@ -1055,8 +1002,6 @@ void resetPictureHasMmco5(const PicturePtr& picture)
 
 bool VaapiDecoderH264::DPB::add(const PicturePtr& picture)
 {
-    PictureList::iterator it = m_pictures.begin(); // picture with minimum poc
-
     /*(8.2.1)*/
     if (picture->m_hasMmco5)
         resetPictureHasMmco5(picture);
@@ -1079,8 +1024,12 @@ bool VaapiDecoderH264::DPB::add(const PicturePtr& picture)
         bumpAll();
         m_pictures.clear();
     }
+    //marking is done, bump() below only removes non-reference pictures
+    updateReferenceIndex();
 
-    if (!picture->m_isReference && isFull() && picture->m_poc < (*it)->m_poc) {
+    // m_pictures.front() is the picture with minimum poc
+    if (!picture->m_isReference && isFull()
+        && picture->m_poc < m_pictures.front()->m_poc) {
         DEBUG("Derectly output picture(Poc:%d)", picture->m_poc);
         return output(picture);
     }
@@ -1090,9 +1039,13 @@ bool VaapiDecoderH264::DPB::add(const PicturePtr& picture)
             return false;
     }
 
-    if (!isSecondField(picture))
-        m_pictures.insert(picture);
-    else {
+    if (!isSecondField(picture)) {
+        if (!insertByPoc(m_pictures, picture)) {
+            ERROR("dpb is full");
+            return false;
+        }
+        addToReferenceIndex(picture);
+    } else {
         // since the second field use same surface as the first field, no need
         // to add second filed into DPB buffer.
         PicturePtr compPicture = picture->m_complementField;
@@ -1111,6 +1064,8 @@ void VaapiDecoderH264::DPB::flush()
     bumpAll();
     clearRefSet();
     m_pictures.clear();
+    m_shortTermRefs.clear();
+    m_longTermRefs.clear();
     m_prevPicture.reset();
 }
 
@@ -1119,8 +1074,11 @@ VaapiDecoderH264::VaapiDecoderH264()
     , m_endOfSequence(false)
     , m_endOfStream(false)
     , m_dpb(bind(&VaapiDecoderH264::outputPicture, this, _1))
+    , m_picturePool(ObjectPool<VaapiDecPictureH264>::create())
     , m_nalLengthSize(0)
     , m_contextChanged(false)
+    , m_resumeChunk(false)
+    , m_batchFirst(0)
 {
 }
 
@@ -1193,16 +1151,68 @@ YamiStatus VaapiDecoderH264::start(VideoConfigBuffer* buffer)
             return DECODE_FAIL;
         }
     }
+    if (buffer->flag & HAS_CHUNKED_INPUT)
+        m_assembler.reset(new NalAssembler(m_nalLengthSize));
+    if (buffer->flag & HAS_PARALLEL_SLICE_PARSING) {
+        uint32_t threads = WorkerPool::suggestThreads(SLICE_PARSING_THREADS);
+        if (threads)
+            m_slicePool.reset(new WorkerPool(threads));
+    }
+    m_sei.setFlags(buffer->flag);
 
+    return YAMI_SUCCESS;
+}
 
+YamiStatus VaapiDecoderH264::decodeSei(NalUnit* nalu)
+{
+    YamiParser::SeiReader reader(nalu->m_data + nalu->m_nalUnitHeaderBytes,
+        nalu->m_size - nalu->m_nalUnitHeaderBytes);
+    YamiParser::SeiMessage message;
+    while (reader.next(message)) {
+        if (!m_sei.wants(message.payloadType))
+            continue;
+        if (message.payloadType == YamiParser::SEI_RECOVERY_POINT) {
+            SeiRecoveryPoint point;
+            if (m_parser.parseRecoveryPoint(&point, message))
+                m_sei.setRecoveryPoint(point.recovery_frame_cnt,
+                    point.exact_match_flag, point.broken_link_flag);
+        } else if (message.payloadType == YamiParser::SEI_PIC_TIMING) {
+            //the lengths of pic_timing are in the hrd of the sps activated
+            //by the slices of this access unit, parse it when they come
+            m_picTiming.assign(message.payload,
+                message.payload + message.payloadBytes);
+        } else {
+            m_sei.decode(message);
+        }
+    }
+    //a broken sei is not worth to stop the decoding
     return YAMI_SUCCESS;
 }
 
+void VaapiDecoderH264::decodePicTiming(const SharedPtr<SPS>& sps)
+{
+    if (m_picTiming.empty())
+        return;
+    YamiParser::SeiMessage message;
+    message.payloadType = YamiParser::SEI_PIC_TIMING;
+    message.payload = &m_picTiming[0];
+    message.payloadSize = message.payloadBytes = m_picTiming.size();
+    SeiPicTiming timing;
+    if (m_parser.parsePicTiming(&timing, message, sps)) {
+        for (uint8_t i = 0; i < timing.m_numClockTs; i++) {
+            if (timing.clock_timestamp_flag[i]) {
+                m_sei.setTimeCode(timing.clock_timestamp[i]);
+                break;
+            }
+        }
+    }
+    m_picTiming.clear();
+}
+
 YamiStatus VaapiDecoderH264::decodeSps(NalUnit* nalu)
 {
-    SharedPtr<SPS> sps(new SPS());
+    SharedPtr<SPS> sps;
 
-    memset(sps.get(), 0, sizeof(SPS));
     if (!m_parser.parseSps(sps, nalu)) {
         return YAMI_DECODE_INVALID_DATA;
     }
@@ -1212,9 +1222,8 @@ YamiStatus VaapiDecoderH264::decodeSps(NalUnit* nalu)
 
 YamiStatus VaapiDecoderH264::decodePps(NalUnit* nalu)
 {
-    SharedPtr<PPS> pps(new PPS());
+    SharedPtr<PPS> pps;
 
-    memset(pps.get(), 0, sizeof(PPS));
     if (!m_parser.parsePps(pps, nalu)) {
         return YAMI_DECODE_INVALID_DATA;
     }
@@ -1591,16 +1600,21 @@ uint32_t calcMaxDecFrameBufferingNum(const SharedPtr<SPS>& sps)
     return maxDpbFrames;
 }
 
-bool VaapiDecoderH264::isDecodeContextChanged(const SharedPtr<SPS>& sps)
+/* the dpb size we use, the context needs one more surface for current picture */
+static uint32_t getMaxDecFrameBuffering(const SharedPtr<SPS>& sps)
 {
-    uint32_t maxDecFrameBuffering;
-
-    maxDecFrameBuffering = calcMaxDecFrameBufferingNum(sps);
+    uint32_t maxDecFrameBuffering = calcMaxDecFrameBufferingNum(sps);
 
     if (maxDecFrameBuffering > H264_MAX_REFRENCE_SURFACE_NUMBER)
         maxDecFrameBuffering = H264_MAX_REFRENCE_SURFACE_NUMBER;
     else if (maxDecFrameBuffering < sps->num_ref_frames)
         maxDecFrameBuffering = sps->num_ref_frames;
+    return maxDecFrameBuffering;
+}
+
+bool VaapiDecoderH264::isDecodeContextChanged(const SharedPtr<SPS>& sps)
+{
+    uint32_t maxDecFrameBuffering = getMaxDecFrameBuffering(sps);
 
     if (m_configBuffer.surfaceWidth < sps->m_width
         || m_configBuffer.surfaceHeight < sps->m_height
@@ -1624,6 +1638,10 @@ bool VaapiDecoderH264::isResolutionChanged(const SharedPtr<SPS>& sps)
 
 YamiStatus VaapiDecoderH264::ensureContext(const SharedPtr<SPS>& sps)
 {
+    //the parser gives out the same sps for repeated ones
+    if (m_context && sps == m_contextSps)
+        return YAMI_SUCCESS;
+
     bool contextChange = isDecodeContextChanged(sps);
     bool resolutionChange = isResolutionChanged(sps);
 
@@ -1660,7 +1678,10 @@ YamiStatus VaapiDecoderH264::ensureContext(const SharedPtr<SPS>& sps)
         return YAMI_DECODE_FORMAT_CHANGE;
     }
 
-    return (m_context) ? YAMI_SUCCESS : YAMI_FAIL;
+    if (!m_context)
+        return YAMI_FAIL;
+    m_contextSps = sps;
+    return YAMI_SUCCESS;
 }
 
 SurfacePtr VaapiDecoderH264::createSurface(const SliceHeader* const slice)
@@ -1698,9 +1719,16 @@ YamiStatus VaapiDecoderH264::createPicture(const SliceHeader* const slice,
             m_dpb.m_pictures.begin(), m_dpb.m_pictures.end(),
             bind(findComplementaryField, _1, slice->frame_num, picStructure));
         if (it != m_dpb.m_pictures.end()) {
-            m_currPic = (*it)->allocPicture();
+            m_currPic = m_picturePool->alloc();
+            m_currPic->init(m_context, (*it)->getSurface(), (*it)->m_timeStamp);
             m_currPic->m_isSecondField = isSecondField = true;
             m_currPic->m_complementField = *it;
+            //both fields go to the same output frame
+            if (m_sei.enabled()) {
+                if (!(*it)->m_sei)
+                    (*it)->m_sei = m_sei.take();
+                m_currPic->m_sei = (*it)->m_sei;
+            }
         }
     }
 
@@ -1708,8 +1736,10 @@ YamiStatus VaapiDecoderH264::createPicture(const SliceHeader* const slice,
         m_currSurface = createSurface(slice);
         if (!m_currSurface)
             return YAMI_DECODE_NO_SURFACE;
-        m_currPic.reset(
-            new VaapiDecPictureH264(m_context, m_currSurface, m_currentPTS));
+        m_currPic = m_picturePool->alloc();
+        m_currPic->init(m_context, m_currSurface, m_currentPTS);
+        if (m_sei.enabled())
+            m_currPic->m_sei = m_sei.take();
     }
 
     m_currPic->m_picOutputFlag = true;
@@ -1720,8 +1750,8 @@ YamiStatus VaapiDecoderH264::createPicture(const SliceHeader* const slice,
     m_currPic->m_picStructure = picStructure;
 
     if (isIdr(m_currPic)) {
-        m_prevPic.reset(
-            new VaapiDecPictureH264(m_context, m_currSurface, m_currentPTS));
+        m_prevPic = m_picturePool->alloc();
+        m_prevPic->init(m_context, m_currSurface, m_currentPTS);
     }
 
     if (nalu->nal_ref_idc) {
@@ -1741,12 +1771,17 @@ YamiStatus VaapiDecoderH264::decodeSlice(NalUnit* nalu)
 {
     SharedPtr<SliceHeader> currSlice(new SliceHeader);
     SliceHeader* slice = currSlice.get();
-    YamiStatus status;
 
     memset(slice, 0, sizeof(SliceHeader));
 
     if (!slice->parseHeader(&m_parser, nalu))
         return YAMI_DECODE_INVALID_DATA;
+    return decodeSlice(nalu, slice);
+}
+
+YamiStatus VaapiDecoderH264::decodeSlice(NalUnit* nalu, SliceHeader* slice)
+{
+    YamiStatus status;
 
     status = ensureContext(slice->m_pps->m_sps);
     if (status != YAMI_SUCCESS) {
@@ -1758,6 +1793,7 @@ YamiStatus VaapiDecoderH264::decodeSlice(NalUnit* nalu)
         status = decodeCurrent();
         if (status != YAMI_SUCCESS)
             return status;
+        decodePicTiming(slice->m_pps->m_sps);
         status = createPicture(slice, nalu);
         if (status != YAMI_SUCCESS)
             return status;
@@ -1805,6 +1841,10 @@ YamiStatus VaapiDecoderH264::decodeNalu(NalUnit* nalu)
         case NAL_PPS:
             status = decodePps(nalu);
             break;
+        case NAL_SEI:
+            if (m_sei.enabled())
+                status = decodeSei(nalu);
+            break;
         case NAL_STREAM_END:
             m_endOfStream = true;
             break;
@@ -1819,9 +1859,37 @@ YamiStatus VaapiDecoderH264::decodeNalu(NalUnit* nalu)
     return status;
 }
 
+void VaapiDecoderH264::flush(void)
+{
+    /*the chunk held for a format change will not come again*/
+    if (m_assembler) {
+        m_assembler->reset(m_nalLengthSize);
+        m_resumeChunk = false;
+    }
+    /*decoding goes on from an idr or a recovery point somewhere else, as a
+      new stream. the pictures in dpb are dropped with the output of base
+      flush, and the poc of a recovery point comes from a blank picture*/
+    m_currPic.reset();
+    m_currSurface.reset();
+    m_dpb.flush();
+    m_prevPic = m_picturePool->alloc();
+    m_newStream = true;
+    m_endOfStream = false;
+    m_endOfSequence = false;
+    m_sei.reset();
+    m_picTiming.clear();
+    VaapiDecoderBase::flush();
+}
+
 YamiStatus VaapiDecoderH264::decode(VideoDecodeBuffer* buffer)
 {
     if (!buffer || !buffer->data) {
+        if (m_assembler) {
+            m_assembler->flush();
+            decodeAssembledNalus();
+            m_assembler->reset(m_nalLengthSize);
+            m_resumeChunk = false;
+        }
         decodeCurrent();
         m_dpb.flush();
         m_newStream = true;
@@ -1829,6 +1897,14 @@ YamiStatus VaapiDecoderH264::decode(VideoDecodeBuffer* buffer)
         m_endOfSequence = false;
         return YAMI_SUCCESS;
     }
+    if (m_assembler) {
+        if (m_resumeChunk)
+            m_assembler->resume(buffer->data, buffer->size);
+        else
+            m_assembler->feed(buffer->data, buffer->size, buffer->timeStamp);
+        m_resumeChunk = false;
+        return decodeAssembledNalus();
+    }
     m_currentPTS = buffer->timeStamp;
 
     int32_t size;
@@ -1837,6 +1913,8 @@ YamiStatus VaapiDecoderH264::decode(VideoDecodeBuffer* buffer)
     const uint8_t* nal;
     NalReader nr(buffer->data, buffer->size, m_nalLengthSize);
 
+    if (m_slicePool)
+        return decodeBatch(nr);
     while (nr.read(nal, size)) {
         if (nalu.parseNalUnit(nal, size))
             status = decodeNalu(&nalu);
@@ -1846,7 +1924,128 @@ YamiStatus VaapiDecoderH264::decode(VideoDecodeBuffer* buffer)
     return YAMI_SUCCESS;
 }
 
+YamiStatus VaapiDecoderH264::decodeAssembledNalus()
+{
+    const uint8_t* nal;
+    int32_t size;
+    int64_t timeStamp;
+    NalUnit nalu;
+    YamiStatus status;
+    while (m_assembler->read(nal, size, timeStamp)) {
+        if (!nalu.parseNalUnit(nal, size))
+            continue;
+        m_currentPTS = timeStamp;
+        status = decodeNalu(&nalu);
+        if (status != YAMI_SUCCESS) {
+            /*caller sends the same chunk again for format change*/
+            if (status == YAMI_DECODE_FORMAT_CHANGE) {
+                m_assembler->unread();
+                m_resumeChunk = true;
+            }
+            return status;
+        }
+    }
+    return YAMI_SUCCESS;
+}
+
+static bool isSlice(const NalUnit& nalu)
+{
+    return NAL_SLICE_NONIDR <= nalu.nal_unit_type
+        && nalu.nal_unit_type <= NAL_SLICE_IDR;
+}
+
+void VaapiDecoderH264::parseBatchedSlice(uint32_t index)
+{
+    SharedPtr<SliceHeader>& slice = m_batchSlices[index];
+    slice.reset(new SliceHeader);
+    memset(slice.get(), 0, sizeof(SliceHeader));
+    if (!slice->parseHeader(&m_parser, &m_batchNalus[m_batchFirst + index]))
+        slice.reset();
+}
+
+/* The slice headers between two non slice nal units only depend on
+ * the sps and pps parsed before them, so they are parsed together on
+ * m_slicePool. Everything else is decoded in order like decodeNalu. */
+YamiStatus VaapiDecoderH264::decodeBatch(NalReader& nr)
+{
+    const uint8_t* nal;
+    int32_t size;
+    NalUnit nalu;
+    YamiStatus status;
+
+    m_batchNalus.clear();
+    while (nr.read(nal, size)) {
+        if (nalu.parseNalUnit(nal, size))
+            m_batchNalus.push_back(nalu);
+    }
+
+    size_t i = 0;
+    while (i < m_batchNalus.size()) {
+        if (!isSlice(m_batchNalus[i])) {
+            status = decodeNalu(&m_batchNalus[i++]);
+            if (status != YAMI_SUCCESS)
+                return status;
+            continue;
+        }
+        size_t end = i + 1;
+        while (end < m_batchNalus.size() && isSlice(m_batchNalus[end]))
+            end++;
+        m_batchFirst = i;
+        m_batchSlices.resize(end - i);
+        m_slicePool->run(bind(&VaapiDecoderH264::parseBatchedSlice, this, _1), end - i);
+
+        for (; i < end; i++) {
+            SliceHeader* slice = m_batchSlices[i - m_batchFirst].get();
+            if (slice)
+                status = decodeSlice(&m_batchNalus[i], slice);
+            else
+                status = YAMI_DECODE_INVALID_DATA;
+            if (status == YAMI_DECODE_INVALID_DATA) {
+                // same as decodeNalu, skip to next slice
+                m_currPic.reset();
+                status = YAMI_SUCCESS;
+            }
+            if (status != YAMI_SUCCESS)
+                return status;
+        }
+    }
+    return YAMI_SUCCESS;
+}
+
+YamiStatus VaapiDecoderH264::probe(const uint8_t* data, size_t size,
+    VideoFormatInfo* info)
+{
+    Parser parser;
+    NalUnit nalu;
+    const uint8_t* nal;
+    int32_t nalSize;
+    NalReader nr(data, size);
+    while (nr.read(nal, nalSize)) {
+        if (!nalu.parseNalUnit(nal, nalSize) || nalu.nal_unit_type != NAL_SPS)
+            continue;
+        SharedPtr<SPS> sps;
+        if (!parser.parseSps(sps, &nalu))
+            return YAMI_DECODE_INVALID_DATA;
+
+        //same as ensureContext gives to VaapiDecoderBase::start
+        memset(info, 0, sizeof(VideoFormatInfo));
+        info->valid = true;
+        info->width = sps->frame_cropping_flag ? sps->m_cropRectWidth
+                                               : sps->m_width;
+        info->height = sps->frame_cropping_flag ? sps->m_cropRectHeight
+                                                : sps->m_height;
+        info->surfaceWidth = sps->m_width;
+        info->surfaceHeight = sps->m_height;
+        info->surfaceNumber = getMaxDecFrameBuffering(sps) + 1;
+        info->fourcc = YAMI_FOURCC_NV12;
+        return YAMI_SUCCESS;
+    }
+    return YAMI_MORE_DATA;
+}
+
 const bool VaapiDecoderH264::s_registered
     = VaapiDecoderFactory::register_<VaapiDecoderH264>(YAMI_MIME_AVC)
-      && VaapiDecoderFactory::register_<VaapiDecoderH264>(YAMI_MIME_H264);
+      && VaapiDecoderFactory::register_<VaapiDecoderH264>(YAMI_MIME_H264)
+      && VaapiDecoderProbes::register_(YAMI_MIME_AVC, VaapiDecoderH264::probe)
+      && VaapiDecoderProbes::register_(YAMI_MIME_H264, VaapiDecoderH264::probe);
 }
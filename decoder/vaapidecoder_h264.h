@@ -19,20 +19,28 @@
 
 #include "codecparsers/h264Parser.h"
 #include "common/Functional.h"
+#include "common/fixedvector.h"
 #include "vaapidecoder_base.h"
 #include "vaapidecpicture.h"
+#include "vaapidecsei.h"
 
-#include <set>
+#include <assert.h>
+#include <vector>
 
 namespace YamiMediaCodec {
 
 #define H264_MAX_REFRENCE_SURFACE_NUMBER 16
+/* 32 fields, and one more for the insert of 8.2.4.3 */
+#define H264_MAX_REFERENCE_LIST_SIZE 33
 
 class VaapiDecPictureH264;
+class NalAssembler;
+class NalReader;
+class WorkerPool;
 class VaapiDecoderH264 : public VaapiDecoderBase {
 public:
     typedef SharedPtr<VaapiDecPictureH264> PicturePtr;
-    typedef std::vector<PicturePtr> RefSet;
+    typedef FixedVector<PicturePtr, H264_MAX_REFERENCE_LIST_SIZE> RefSet;
     typedef YamiParser::H264::SliceHeader SliceHeader;
     typedef YamiParser::H264::NalUnit NalUnit;
     typedef YamiParser::H264::SPS SPS;
@@ -41,6 +49,10 @@ public:
     virtual ~VaapiDecoderH264();
     virtual YamiStatus start(VideoConfigBuffer*);
     virtual YamiStatus decode(VideoDecodeBuffer*);
+    virtual void flush(void);
+
+    /* see probeVideoStream(), the first sps gives the format */
+    static YamiStatus probe(const uint8_t* data, size_t size, VideoFormatInfo* info);
 
 private:
     friend class FactoryTest<IVideoDecoder, VaapiDecoderH264>;
@@ -50,15 +62,12 @@ private:
         typedef VaapiDecoderH264::RefSet RefSet;
         typedef std::function<YamiStatus(const PicturePtr&)>
             OutputCallback;
-        typedef std::function<void(const PicturePtr&)> ForEachFunction;
 
     public:
         typedef VaapiDecoderH264::PicturePtr PicturePtr;
-        struct PocLess {
-            inline bool operator()(const PicturePtr& left,
-                                   const PicturePtr& right) const;
-        };
-        typedef std::set<PicturePtr, PocLess> PictureList;
+        /* sorted by poc, a new picture goes before the ones of same poc */
+        typedef FixedVector<PicturePtr, H264_MAX_REFRENCE_SURFACE_NUMBER + 1>
+            PictureList;
 
         DPB(OutputCallback output);
         bool init(const PicturePtr&, const PicturePtr&,
@@ -75,7 +84,7 @@ private:
         PictureList m_pictures;
 
     private:
-        void forEach(ForEachFunction);
+        template <class F> void forEach(F);
 
         template <class P> void findAndMarkUnusedReference(P);
 
@@ -100,6 +109,8 @@ private:
 
         bool isFull();
         void removeUnused();
+        void updateReferenceIndex();
+        void addToReferenceIndex(const PicturePtr&);
         void clearRefSet();
 
         bool calcPoc(const PicturePtr&, const SliceHeader* const);
@@ -116,6 +127,12 @@ private:
         // generate m_refList1
         RefSet m_longTermList;
 
+        /* short and long term references of m_pictures, in poc order.
+         * updated when pictures are marked and added, instead of
+         * looking through m_pictures for every slice */
+        PictureList m_shortTermRefs;
+        PictureList m_longTermRefs;
+
         PicturePtr m_prevPicture;
         OutputCallback m_output;
         PicturePtr m_dummy;
@@ -127,9 +144,15 @@ private:
     };
 
     YamiStatus decodeNalu(NalUnit*);
+    YamiStatus decodeAssembledNalus();
+    YamiStatus decodeBatch(NalReader&);
+    void parseBatchedSlice(uint32_t index);
     YamiStatus decodeSps(NalUnit*);
     YamiStatus decodePps(NalUnit*);
+    YamiStatus decodeSei(NalUnit*);
+    void decodePicTiming(const SharedPtr<SPS>& sps);
     YamiStatus decodeSlice(NalUnit*);
+    YamiStatus decodeSlice(NalUnit*, SliceHeader*);
 
     YamiStatus ensureContext(const SharedPtr<SPS>& sps);
     bool fillPicture(const PicturePtr&, const SliceHeader* const);
@@ -162,11 +185,188 @@ private:
     bool m_endOfSequence;
     bool m_endOfStream;
     DPB m_dpb;
+    SharedPtr<ObjectPool<VaapiDecPictureH264> > m_picturePool;
     uint32_t m_nalLengthSize;
     SurfacePtr m_currSurface;
     bool m_contextChanged;
+    SharedPtr<SPS> m_contextSps; //the sps checked by ensureContext
+    /*valid when input comes in chunks, see HAS_CHUNKED_INPUT*/
+    SharedPtr<NalAssembler> m_assembler;
+    /*caller will send last chunk again*/
+    bool m_resumeChunk;
+    /*valid with HAS_PARALLEL_SLICE_PARSING*/
+    SharedPtr<WorkerPool> m_slicePool;
+    /*nal units of current buffer, and slice headers parsed by m_slicePool*/
+    std::vector<NalUnit> m_batchNalus;
+    std::vector<SharedPtr<SliceHeader> > m_batchSlices;
+    size_t m_batchFirst;
+    /*sei messages for next picture, see HAS_SEI_RECOVERY_POINT*/
+    VaapiDecSei m_sei;
+    /*pic_timing payload waiting for the sps of the slices after it*/
+    std::vector<uint8_t> m_picTiming;
     static const bool s_registered; // VaapiDecoderFactory registration result
 };
+
+class VaapiDecPictureH264 : public VaapiDecPicture {
+public:
+    typedef VaapiDecoderH264::PicturePtr PicturePtr;
+
+    VaapiDecPictureH264(const ContextPtr& context, const SurfacePtr& surface,
+                        int64_t timeStamp)
+        : VaapiDecPicture(context, surface, timeStamp)
+        , m_idrFlag(false)
+        , m_picStructure(VAAPI_PICTURE_FRAME)
+        , m_longTermRefFlag(false)
+        , m_shortTermRefFlag(false)
+        , m_topFieldOrderCnt(0)
+        , m_bottomFieldOrderCnt(0)
+        , m_pocMsb(0)
+        , m_pocLsb(0)
+        , m_poc(0)
+        , m_frameNumOffset(0)
+        , m_frameNum(0)
+        , m_frameNumWrap(0)
+        , m_picNum(0)
+        , m_longTermFrameIdx(0)
+        , m_longTermPicNum(0)
+        , m_picOutputFlag(true)
+        , m_isReference(false)
+        , m_hasMmco5(false)
+        , m_isSecondField(false)
+    {
+    }
+    /* no surface, for the dpb's dummy picture and unit tests */
+    VaapiDecPictureH264()
+        : m_idrFlag(false)
+        , m_picStructure(VAAPI_PICTURE_FRAME)
+        , m_longTermRefFlag(false)
+        , m_shortTermRefFlag(false)
+        , m_topFieldOrderCnt(0)
+        , m_bottomFieldOrderCnt(0)
+        , m_pocMsb(0)
+        , m_pocLsb(0)
+        , m_poc(0)
+        , m_frameNumOffset(0)
+        , m_frameNum(0)
+        , m_frameNumWrap(0)
+        , m_picNum(0)
+        , m_longTermFrameIdx(0)
+        , m_longTermPicNum(0)
+        , m_picOutputFlag(true)
+        , m_isReference(false)
+        , m_hasMmco5(false)
+        , m_isSecondField(false)
+    {
+    }
+
+    virtual void reset()
+    {
+        *this = VaapiDecPictureH264();
+    }
+
+    PicturePtr allocPicture()
+    {
+        PicturePtr picture(
+            new VaapiDecPictureH264(m_context, m_surface, m_timeStamp));
+        assert(picture);
+        return picture;
+    }
+
+    /* the frame as one of its fields, for reference lists of field
+     * pictures. The two fields are kept with the frame and refreshed
+     * from it on each call, so slices don't allocate them again */
+    const PicturePtr& getField(bool isBottomField)
+    {
+        PicturePtr& field = m_fields[isBottomField];
+        if (!field) {
+            field.reset(new VaapiDecPictureH264);
+            field->m_display = m_display;
+            field->m_context = m_context;
+            field->m_surface = m_surface;
+            field->m_timeStamp = m_timeStamp;
+        }
+        field->copyState(*this);
+
+        field->m_picStructure = VAAPI_PICTURE_TOP_FIELD;
+        field->m_poc = this->m_topFieldOrderCnt;
+
+        if (isBottomField) {
+            field->m_picStructure = VAAPI_PICTURE_BOTTOM_FIELD;
+            field->m_poc = this->m_bottomFieldOrderCnt;
+        }
+
+        return field;
+    }
+
+    PicturePtr allocDummyPicture(int32_t frameNum)
+    {
+        PicturePtr picture = allocPicture();
+        *picture = *this;
+        //fields of this picture are not the dummy one's
+        picture->m_fields[0].reset();
+        picture->m_fields[1].reset();
+
+        picture->m_picStructure = VAAPI_PICTURE_FRAME;
+        picture->m_frameNum = frameNum;
+        picture->m_picOutputFlag = false;
+        picture->m_idrFlag = false;
+        picture->m_poc = 0x7fffffff;
+
+        picture->m_isReference = true;
+        picture->m_longTermRefFlag = false;
+        picture->m_shortTermRefFlag = true;
+
+        return picture;
+    }
+
+    bool m_idrFlag;
+    VaapiPictureType m_picStructure;
+    bool m_longTermRefFlag;
+    bool m_shortTermRefFlag;
+    int32_t m_topFieldOrderCnt;
+    int32_t m_bottomFieldOrderCnt;
+    int32_t m_pocMsb;
+    uint16_t m_pocLsb;
+    int32_t m_poc;
+    int32_t m_frameNumOffset;
+    int32_t m_frameNum;
+    int32_t m_frameNumWrap;
+    int32_t m_picNum;
+    int32_t m_longTermFrameIdx;
+    int32_t m_longTermPicNum;
+    bool m_picOutputFlag;
+    bool m_isReference;
+    bool m_hasMmco5;
+    bool m_isSecondField;
+    PicturePtr m_complementField;
+
+private:
+    /* the h264 part only, slice and parameter buffers are not copied */
+    void copyState(const VaapiDecPictureH264& other)
+    {
+        m_idrFlag = other.m_idrFlag;
+        m_picStructure = other.m_picStructure;
+        m_longTermRefFlag = other.m_longTermRefFlag;
+        m_shortTermRefFlag = other.m_shortTermRefFlag;
+        m_topFieldOrderCnt = other.m_topFieldOrderCnt;
+        m_bottomFieldOrderCnt = other.m_bottomFieldOrderCnt;
+        m_pocMsb = other.m_pocMsb;
+        m_pocLsb = other.m_pocLsb;
+        m_poc = other.m_poc;
+        m_frameNumOffset = other.m_frameNumOffset;
+        m_frameNum = other.m_frameNum;
+        m_frameNumWrap = other.m_frameNumWrap;
+        m_picNum = other.m_picNum;
+        m_longTermFrameIdx = other.m_longTermFrameIdx;
+        m_longTermPicNum = other.m_longTermPicNum;
+        m_picOutputFlag = other.m_picOutputFlag;
+        m_isReference = other.m_isReference;
+        m_hasMmco5 = other.m_hasMmco5;
+        m_isSecondField = other.m_isSecondField;
+    }
+
+    PicturePtr m_fields[2];
+};
 };
 
 #endif
@@ -35,8 +35,12 @@
 #include "vaapidecoder_h264.h"
 
 // library headers
+#include "codecparsers/bitWriter.h"
 #include "common/Array.h"
 
+// system headers
+#include <vector>
+
 namespace YamiMediaCodec {
 
 const static std::array<uint8_t, 998> g_SimpleH264 = {
@@ -130,17 +134,177 @@ class VaapiDecoderH264Test
     : public FactoryTest<IVideoDecoder, VaapiDecoderH264>
 {
 protected:
+    typedef VaapiDecoderH264::DPB DPB;
+    typedef VaapiDecoderH264::PicturePtr PicturePtr;
+    typedef VaapiDecoderH264::RefSet RefSet;
+    typedef VaapiDecoderH264::NalUnit NalUnit;
+    typedef YamiParser::H264::SPS SPS;
+    typedef YamiParser::H264::PPS PPS;
+    typedef YamiParser::H264::SliceHeader SliceHeader;
+
     /* invoked by gtest before the test */
     virtual void SetUp() {
-        return;
+        //max frame num 16, max poc lsb 64
+        m_sps.reset(new SPS());
+        m_sps->log2_max_frame_num_minus4 = 0;
+        m_sps->log2_max_pic_order_cnt_lsb_minus4 = 2;
+        m_sps->num_ref_frames = 4;
+        m_pps.reset(new PPS());
+        m_pps->m_sps = m_sps;
+
+        m_dpb.reset(new DPB(std::bind(&VaapiDecoderH264Test::output, this,
+            std::placeholders::_1)));
+        m_outputs.clear();
     }
 
     /* invoked by gtest after the test */
     virtual void TearDown() {
         return;
     }
+
+    /* the dpb part of the decoder, pictures have no surface so
+     * nothing here needs va */
+    void initSlice(SliceHeader& slice, uint32_t sliceType, uint16_t frameNum,
+                   uint16_t pocLsb, VaapiPictureType structure = VAAPI_PICTURE_FRAME)
+    {
+        slice.slice_type = sliceType;
+        slice.m_pps = m_pps;
+        slice.frame_num = frameNum;
+        slice.field_pic_flag = structure != VAAPI_PICTURE_FRAME;
+        slice.bottom_field_flag = structure == VAAPI_PICTURE_BOTTOM_FIELD;
+        slice.pic_order_cnt_lsb = pocLsb;
+        slice.delta_pic_order_cnt_bottom = 0;
+        slice.delta_pic_order_cnt[0] = slice.delta_pic_order_cnt[1] = 0;
+        slice.num_ref_idx_l0_active_minus1 = 15;
+        slice.num_ref_idx_l1_active_minus1 = 15;
+        slice.ref_pic_list_modification_flag_l0 = false;
+        slice.n_ref_pic_list_modification_l0 = 0;
+        slice.ref_pic_list_modification_flag_l1 = false;
+        slice.n_ref_pic_list_modification_l1 = 0;
+        memset(&slice.dec_ref_pic_marking, 0, sizeof(slice.dec_ref_pic_marking));
+    }
+
+    /* like createPicture() and the dpb calls of decodeSlice() */
+    PicturePtr startPicture(const SliceHeader& slice, bool isReference,
+                            bool isIdr = false)
+    {
+        PicturePtr picture(new VaapiDecPictureH264);
+        picture->m_idrFlag = isIdr;
+        picture->m_frameNum = slice.frame_num;
+        picture->m_pocLsb = slice.pic_order_cnt_lsb;
+        if (slice.field_pic_flag) {
+            picture->m_picStructure = slice.bottom_field_flag
+                ? VAAPI_PICTURE_BOTTOM_FIELD : VAAPI_PICTURE_TOP_FIELD;
+        }
+        picture->m_isReference = picture->m_shortTermRefFlag = isReference;
+        if (isIdr || !m_prev)
+            m_prev.reset(new VaapiDecPictureH264);
+
+        EXPECT_TRUE(m_dpb->init(picture, m_prev, &slice, NULL, false, false,
+            H264_MAX_REFRENCE_SURFACE_NUMBER));
+        m_dpb->initReference(picture, &slice);
+        return picture;
+    }
+
+    /* like decodeCurrent() */
+    void finishPicture(const PicturePtr& picture)
+    {
+        EXPECT_TRUE(m_dpb->add(picture));
+        m_prev = picture;
+    }
+
+    void decodePicture(uint32_t sliceType, uint16_t frameNum, uint16_t pocLsb,
+                       bool isReference, bool isIdr = false)
+    {
+        SliceHeader slice;
+        initSlice(slice, sliceType, frameNum, pocLsb);
+        finishPicture(startPicture(slice, isReference, isIdr));
+    }
+
+    static std::vector<int32_t> getPocs(const RefSet& refs)
+    {
+        std::vector<int32_t> pocs;
+        for (size_t i = 0; i < refs.size(); i++)
+            pocs.push_back(refs[i]->m_poc);
+        return pocs;
+    }
+
+    void initReference(const PicturePtr& picture, const SliceHeader& slice)
+    {
+        m_dpb->initReference(picture, &slice);
+    }
+
+    const RefSet& refList0() { return m_dpb->m_refList0; }
+    const RefSet& refList1() { return m_dpb->m_refList1; }
+    size_t dpbSize() { return m_dpb->m_pictures.size(); }
+    void flush() { m_dpb->flush(); }
+
+    /* as after a YAMI_DECODE_FORMAT_CHANGE, the decoder waits for the
+     * last chunk again */
+    void holdChunk(VaapiDecoderH264& decoder) { decoder.m_resumeChunk = true; }
+    bool isChunkHeld(VaapiDecoderH264& decoder) { return decoder.m_resumeChunk; }
+
+    /* the dpb of decoder on a picture, as decodeSlice() does */
+    bool initDecoderPicture(VaapiDecoderH264& decoder,
+                            const PicturePtr& picture, const SliceHeader& slice)
+    {
+        if (!decoder.m_prevPic)
+            return false;
+        return decoder.m_dpb.init(picture, decoder.m_prevPic, &slice, NULL,
+            decoder.m_newStream, false, H264_MAX_REFRENCE_SURFACE_NUMBER);
+    }
+    /* as decodeCurrent() leaves it after picture */
+    void setDecoded(VaapiDecoderH264& decoder, const PicturePtr& picture)
+    {
+        decoder.m_prevPic = picture;
+        decoder.m_newStream = false;
+    }
+    bool isNewStream(VaapiDecoderH264& decoder) { return decoder.m_newStream; }
+
+    /* the sei path of the decoder without a va context */
+    void decodeSei(VaapiDecoderH264& decoder, NalUnit* nalu,
+                   const SharedPtr<SPS>& contextSps)
+    {
+        decoder.m_contextSps = contextSps;
+        decoder.decodeSei(nalu);
+    }
+    SharedPtr<VideoSeiInfo> takeSei(VaapiDecoderH264& decoder,
+                                    const SharedPtr<SPS>& sliceSps)
+    {
+        decoder.decodePicTiming(sliceSps);
+        return decoder.m_sei.take();
+    }
+
+    std::vector<int32_t> m_outputs;
+
+private:
+    YamiStatus output(const PicturePtr& picture)
+    {
+        m_outputs.push_back(picture->m_poc);
+        return YAMI_SUCCESS;
+    }
+
+    SharedPtr<SPS> m_sps;
+    SharedPtr<PPS> m_pps;
+    SharedPtr<DPB> m_dpb;
+    PicturePtr m_prev;
 };
 
+static const uint32_t P_SLICE = 0;
+static const uint32_t B_SLICE = 1;
+static const uint32_t I_SLICE = 2;
+
+static std::vector<int32_t> makePocs(int32_t p0, int32_t p1 = -1,
+                                     int32_t p2 = -1, int32_t p3 = -1,
+                                     int32_t p4 = -1)
+{
+    const int32_t all[] = { p0, p1, p2, p3, p4 };
+    std::vector<int32_t> pocs;
+    for (size_t i = 0; i < N_ELEMENTS(all) && all[i] >= 0; i++)
+        pocs.push_back(all[i]);
+    return pocs;
+}
+
 #define VAAPIDECODER_H264_TEST(name) \
     TEST_F(VaapiDecoderH264Test, name)
 
@@ -174,4 +338,233 @@ VAAPIDECODER_H264_TEST(Decode_Simple)
     EXPECT_TRUE(bool(decoder.getOutput()));
 }
 
+VAAPIDECODER_H264_TEST(FlushChunkedInput)
+{
+    VaapiDecoderH264 decoder;
+    VideoConfigBuffer configBuffer;
+    memset(&configBuffer, 0, sizeof(configBuffer));
+    configBuffer.profile = VAProfileNone;
+    configBuffer.flag = HAS_CHUNKED_INPUT;
+    ASSERT_EQ(YAMI_SUCCESS, decoder.start(&configBuffer));
+
+    //sps, pps and the start of the idr slice
+    VideoDecodeBuffer buffer;
+    memset(&buffer, 0, sizeof(buffer));
+    buffer.data = const_cast<uint8_t*>(g_SimpleH264.data());
+    buffer.size = 100;
+    ASSERT_EQ(YAMI_SUCCESS, decoder.decode(&buffer));
+    holdChunk(decoder);
+
+    //a seek, new data comes instead of the held chunk
+    decoder.flush();
+    EXPECT_FALSE(isChunkHeld(decoder));
+    const uint32_t spsPpsSize = 33;
+    buffer.size = spsPpsSize;
+    EXPECT_EQ(YAMI_SUCCESS, decoder.decode(&buffer));
+
+    //the partial slice went with the flush, nothing to decode
+    EXPECT_EQ(YAMI_SUCCESS, decoder.decode(NULL));
+    EXPECT_FALSE(bool(decoder.getOutput()));
+}
+
+VAAPIDECODER_H264_TEST(FlushToRecoveryPoint)
+{
+    VaapiDecoderH264 decoder;
+    PicturePtr prev(new VaapiDecPictureH264);
+    prev->m_frameNum = 3;
+    prev->m_pocMsb = 128;
+    prev->m_pocLsb = 10;
+    setDecoded(decoder, prev);
+
+    //a seek to an I picture with recovery point sei, not an idr
+    decoder.flush();
+    EXPECT_TRUE(isNewStream(decoder));
+    SliceHeader slice;
+    initSlice(slice, I_SLICE, 5, 20);
+    PicturePtr picture(new VaapiDecPictureH264);
+    picture->m_frameNum = slice.frame_num;
+    picture->m_pocLsb = slice.pic_order_cnt_lsb;
+    ASSERT_TRUE(initDecoderPicture(decoder, picture, slice));
+    //nothing of the pictures before the seek
+    EXPECT_EQ(20, picture->m_poc);
+}
+
+VAAPIDECODER_H264_TEST(SeiPicTimingOfSliceSps)
+{
+    VaapiDecoderH264 decoder;
+    VideoConfigBuffer configBuffer;
+    memset(&configBuffer, 0, sizeof(configBuffer));
+    configBuffer.profile = VAProfileNone;
+    configBuffer.flag = HAS_SEI_TIME_CODE;
+    ASSERT_EQ(YAMI_SUCCESS, decoder.start(&configBuffer));
+
+    //the sps of last sequence has hrd and no pic_struct
+    SharedPtr<SPS> contextSps(new SPS);
+    memset(contextSps.get(), 0, sizeof(SPS));
+    contextSps->vui_parameters_present_flag = true;
+    contextSps->m_vui.nal_hrd_parameters_present_flag = true;
+    contextSps->m_vui.nal_hrd_parameters.cpb_removal_delay_length_minus1 = 23;
+    contextSps->m_vui.nal_hrd_parameters.dpb_output_delay_length_minus1 = 4;
+    //the sps of the slices after the sei has pic_struct and no hrd
+    SharedPtr<SPS> sliceSps(new SPS);
+    memset(sliceSps.get(), 0, sizeof(SPS));
+    sliceSps->vui_parameters_present_flag = true;
+    sliceSps->m_vui.pic_struct_present_flag = true;
+
+    YamiParser::BitWriter bw;
+    bw.writeBits(YamiParser::H264::NAL_SEI, 8);
+    bw.writeBits(YamiParser::SEI_PIC_TIMING, 8);
+    bw.writeBits(9, 8); //payloadSize
+    bw.writeBits(0, 4); //pic_struct, frame
+    bw.writeBits(1, 1); //clock_timestamp_flag[0]
+    bw.writeBits(0, 2); //ct_type
+    bw.writeBits(0, 1); //nuit_field_based_flag
+    bw.writeBits(0, 5); //counting_type
+    bw.writeBits(1, 1); //full_timestamp_flag
+    bw.writeBits(0, 1); //discontinuity_flag
+    bw.writeBits(0, 1); //cnt_dropped_flag
+    bw.writeBits(12, 8); //n_frames
+    bw.writeBits(34, 6);
+    bw.writeBits(56, 6);
+    bw.writeBits(7, 5);
+    bw.writeBits(0, 24); //time_offset
+    bw.writeToBytesAligned();
+    bw.writeBits(0x80, 8); //rbsp_trailing_bits
+
+    NalUnit nalu;
+    ASSERT_TRUE(nalu.parseNalUnit(bw.getBitWriterData(),
+        bw.getCodedBitsCount() / 8));
+    decodeSei(decoder, &nalu, contextSps);
+    SharedPtr<VideoSeiInfo> sei = takeSei(decoder, sliceSps);
+    ASSERT_TRUE(bool(sei));
+    EXPECT_TRUE(sei->present & VIDEO_SEI_TIME_CODE);
+    EXPECT_EQ(12, sei->timeCode.frames);
+    EXPECT_EQ(34, sei->timeCode.seconds);
+    EXPECT_EQ(56, sei->timeCode.minutes);
+    EXPECT_EQ(7, sei->timeCode.hours);
+
+    //parsed once, nothing left for next picture
+    EXPECT_FALSE(bool(takeSei(decoder, sliceSps)));
+}
+
+VAAPIDECODER_H264_TEST(Probe)
+{
+    VideoFormatInfo info;
+    ASSERT_EQ(YAMI_SUCCESS, VaapiDecoderH264::probe(g_SimpleH264.data(),
+                                g_SimpleH264.size(), &info));
+    EXPECT_TRUE(info.valid);
+    EXPECT_EQ(352u, info.width);
+    EXPECT_EQ(288u, info.height);
+    EXPECT_EQ(352, info.surfaceWidth);
+    EXPECT_EQ(288, info.surfaceHeight);
+    //level 4.0, 16 frames in dpb and the current one
+    EXPECT_EQ(17, info.surfaceNumber);
+
+    //pps and slice only
+    EXPECT_EQ(YAMI_MORE_DATA, VaapiDecoderH264::probe(g_SimpleH264.data() + 24,
+                                  g_SimpleH264.size() - 24, &info));
+}
+
+VAAPIDECODER_H264_TEST(DpbPSliceReference)
+{
+    decodePicture(I_SLICE, 0, 0, true, true);
+    decodePicture(P_SLICE, 1, 2, true);
+    decodePicture(P_SLICE, 2, 4, true);
+    decodePicture(P_SLICE, 3, 6, true);
+
+    //descending pic num
+    SliceHeader slice;
+    initSlice(slice, P_SLICE, 4, 8);
+    slice.num_ref_idx_l0_active_minus1 = 2;
+    PicturePtr picture = startPicture(slice, true);
+    EXPECT_EQ(makePocs(6, 4, 2), getPocs(refList0()));
+    EXPECT_TRUE(refList1().empty());
+    finishPicture(picture);
+}
+
+VAAPIDECODER_H264_TEST(DpbSlidingWindow)
+{
+    //two reference frames
+    decodePicture(I_SLICE, 0, 0, true, true);
+    SliceHeader slice;
+    initSlice(slice, P_SLICE, 1, 2);
+    slice.m_pps->m_sps->num_ref_frames = 2;
+    finishPicture(startPicture(slice, true));
+    decodePicture(P_SLICE, 2, 4, true);
+
+    initSlice(slice, P_SLICE, 3, 6);
+    PicturePtr picture = startPicture(slice, true);
+    EXPECT_EQ(makePocs(4, 2), getPocs(refList0()));
+    finishPicture(picture);
+
+    //nothing is output yet, all pictures are kept
+    EXPECT_EQ(4u, dpbSize());
+    flush();
+    EXPECT_EQ(makePocs(0, 2, 4, 6), m_outputs);
+    EXPECT_EQ(0u, dpbSize());
+}
+
+VAAPIDECODER_H264_TEST(DpbBSliceReference)
+{
+    decodePicture(I_SLICE, 0, 0, true, true);
+    decodePicture(P_SLICE, 1, 8, true);
+
+    SliceHeader slice;
+    initSlice(slice, B_SLICE, 2, 4);
+    PicturePtr picture = startPicture(slice, false);
+    EXPECT_EQ(makePocs(0, 8), getPocs(refList0()));
+    EXPECT_EQ(makePocs(8, 0), getPocs(refList1()));
+    finishPicture(picture);
+
+    decodePicture(B_SLICE, 2, 2, false);
+    decodePicture(B_SLICE, 2, 6, false);
+
+    //output in poc order
+    flush();
+    EXPECT_EQ(makePocs(0, 2, 4, 6, 8), m_outputs);
+}
+
+VAAPIDECODER_H264_TEST(DpbReferenceModification)
+{
+    decodePicture(I_SLICE, 0, 0, true, true);
+    decodePicture(P_SLICE, 1, 2, true);
+    decodePicture(P_SLICE, 2, 4, true);
+    decodePicture(P_SLICE, 3, 6, true);
+
+    //move pic num 4 - 3 = 1 to the front
+    SliceHeader slice;
+    initSlice(slice, P_SLICE, 4, 8);
+    slice.ref_pic_list_modification_flag_l0 = true;
+    slice.n_ref_pic_list_modification_l0 = 1;
+    slice.ref_pic_list_modification_l0[0].modification_of_pic_nums_idc = 0;
+    slice.ref_pic_list_modification_l0[0].abs_diff_pic_num_minus1 = 2;
+    slice.num_ref_idx_l0_active_minus1 = 3;
+    PicturePtr picture = startPicture(slice, true);
+    EXPECT_EQ(makePocs(2, 6, 4, 0), getPocs(refList0()));
+    finishPicture(picture);
+}
+
+VAAPIDECODER_H264_TEST(DpbFieldReference)
+{
+    decodePicture(I_SLICE, 0, 0, true, true);
+    decodePicture(P_SLICE, 1, 4, true);
+
+    //reference frames are used as fields, same parity first
+    SliceHeader slice;
+    initSlice(slice, P_SLICE, 2, 8, VAAPI_PICTURE_TOP_FIELD);
+    PicturePtr picture = startPicture(slice, true);
+    const RefSet& refs = refList0();
+    ASSERT_EQ(4u, refs.size());
+    EXPECT_EQ(VAAPI_PICTURE_TOP_FIELD, refs[0]->m_picStructure);
+    EXPECT_EQ(VAAPI_PICTURE_BOTTOM_FIELD, refs[1]->m_picStructure);
+    EXPECT_EQ(VAAPI_PICTURE_TOP_FIELD, refs[2]->m_picStructure);
+    EXPECT_EQ(VAAPI_PICTURE_BOTTOM_FIELD, refs[3]->m_picStructure);
+    EXPECT_EQ(makePocs(4, 4, 0, 0), getPocs(refs));
+
+    //the next slice gets the same fields
+    RefSet first = refs;
+    initReference(picture, slice);
+    EXPECT_TRUE(first == refList0());
+    finishPicture(picture);
+}
 }
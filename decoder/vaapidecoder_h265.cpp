@@ -22,6 +22,7 @@
 #include "codecparsers/h265Parser.h"
 #include "common/log.h"
 #include "common/nalreader.h"
+#include "common/workerpool.h"
 #include "vaapidecoder_factory.h"
 
 #include "vaapi/vaapiptrs.h"
@@ -41,6 +42,9 @@ using std::ref;
 
 using namespace YamiParser::H265;
 
+//threads to parse slice headers, besides the decoding one
+static const uint32_t SLICE_PARSING_THREADS = 3;
+
 bool isIdr(const NalUnit* const nalu)
 {
     return nalu->nal_unit_type == NalUnit::IDR_W_RADL
@@ -93,38 +97,32 @@ bool isSublayerNoRef(const NalUnit* const nalu)
     return std::binary_search(noRef, end, nalu->nal_unit_type);
 }
 
-class VaapiDecPictureH265 : public VaapiDecPicture
+inline bool VaapiDecoderH265::DPB::PocLess::operator()(const PicturePtr& left, const PicturePtr& right) const
 {
-public:
-    VaapiDecPictureH265(const ContextPtr& context, const SurfacePtr& surface, int64_t timeStamp):
-        VaapiDecPicture(context, surface, timeStamp)
-    {
-    }
-    VaapiDecPictureH265()
-    {
-    }
-    int32_t     m_poc;
-    uint16_t    m_pocLsb;
-    bool        m_noRaslOutputFlag;
-    bool        m_picOutputFlag;
-    uint32_t    m_picLatencyCount;
+    return left->m_poc < right->m_poc;
+}
 
-    //is unused reference picture
-    bool        m_isUnusedReference;
-    //is this picture ref able?
-    bool        m_isReference;
+VaapiDecoderH265::DPB::DPB(OutputCallback output):
+    m_output(output)
+{
+}
 
-};
+void VaapiDecoderH265::DPB::insert(const PicturePtr& picture)
+{
+    if (m_pictures.insert(picture).second)
+        m_pocIndex.insert(picture->m_poc, picture.get());
+}
 
-inline bool VaapiDecoderH265::DPB::PocLess::operator()(const PicturePtr& left, const PicturePtr& right) const
+void VaapiDecoderH265::DPB::erase(PictureList::iterator it)
 {
-    return left->m_poc < right->m_poc;
+    m_pocIndex.erase((*it)->m_poc);
+    m_pictures.erase(it);
 }
 
-VaapiDecoderH265::DPB::DPB(OutputCallback output):
-    m_output(output),
-    m_dummy(new VaapiDecPictureH265)
+void VaapiDecoderH265::DPB::clear()
 {
+    m_pictures.clear();
+    m_pocIndex.clear();
 }
 
 bool VaapiDecoderH265::DPB::initShortTermRef(RefSet& ref, int32_t currPoc,
@@ -151,14 +149,7 @@ bool VaapiDecoderH265::DPB::initShortTermRef(RefSet& ref, int32_t currPoc,
 bool VaapiDecoderH265::DPB::initShortTermRef(const PicturePtr& picture,
                                              const SliceHeader* const slice)
 {
-    const PPS *const pps = slice->pps.get();
-    const SPS *const sps = pps->sps.get();
-
-    const ShortTermRefPicSet* stRef;
-    if (!slice->short_term_ref_pic_set_sps_flag)
-        stRef = &slice->short_term_ref_pic_sets;
-    else
-        stRef = &sps->short_term_ref_pic_set[slice->short_term_ref_pic_set_idx];
+    const ShortTermRefPicSet* stRef = slice->getStRps();
 
     //clear it here
     m_stFoll.clear();
@@ -251,7 +242,7 @@ void VaapiDecoderH265::DPB::removeUnused()
     PictureList::iterator it;
     for (it = m_pictures.begin(); it != m_pictures.end();) {
         if (isUnusedPicture(*it))
-            m_pictures.erase(it++);
+            erase(it++);
         else
             ++it;
     }
@@ -286,20 +277,22 @@ bool matchPocLsb(const PicturePtr& picture, int32_t poc)
 
 VaapiDecPictureH265* VaapiDecoderH265::DPB::getPic(int32_t poc, bool hasMsb)
 {
-    PictureList::iterator it;
+    VaapiDecPictureH265* picture = NULL;
     if (hasMsb) {
-        m_dummy->m_poc = poc;
-        it = m_pictures.find(m_dummy);
+        VaapiDecPictureH265** found = m_pocIndex.find(poc);
+        if (found)
+            picture = *found;
     } else {
-        it = find_if(m_pictures.begin(), m_pictures.end(), bind(matchPocLsb, _1, poc));
+        //long term reference without msb, rare
+        PictureList::iterator it = find_if(m_pictures.begin(), m_pictures.end(),
+            bind(matchPocLsb, _1, poc));
+        if (it != m_pictures.end())
+            picture = it->get();
     }
-    if (it != m_pictures.end()) {
-        const PicturePtr& picture = *it;
-        if (picture->m_isReference) {
-            //use by current decode picture
-            picture->m_isUnusedReference = false;
-            return picture.get();
-        }
+    if (picture && picture->m_isReference) {
+        //use by current decode picture
+        picture->m_isUnusedReference = false;
+        return picture;
     }
     return NULL;
 }
@@ -359,7 +352,7 @@ bool VaapiDecoderH265::DPB::init(const PicturePtr& picture,
             removeUnused();
             bumpAll();
         }
-        m_pictures.clear();
+        clear();
         return true;
     }
     removeUnused();
@@ -388,7 +381,7 @@ bool VaapiDecoderH265::DPB::bump()
         return false;
     bool success = output(*it);
     if (!isReference(*it))
-        m_pictures.erase(it);
+        erase(it);
     return success;
 }
 
@@ -412,7 +405,7 @@ bool VaapiDecoderH265::DPB::add(const PicturePtr& picture, const SliceHeader* co
     forEach(addLatency);
     picture->m_picLatencyCount = 0;
     picture->m_isReference = true;
-    m_pictures.insert(picture);
+    insert(picture);
     while (checkReorderPics(sps) || checkLatency(sps))
         bump();
     return true;
@@ -423,16 +416,20 @@ void VaapiDecoderH265::DPB::flush()
 {
     bumpAll();
     clearRefSet();
-    m_pictures.clear();
+    clear();
 }
 
 VaapiDecoderH265::VaapiDecoderH265():
     m_prevPicOrderCntMsb(0),
     m_prevPicOrderCntLsb(0),
     m_nalLengthSize(0),
+    m_associatedIrapNoRaslOutputFlag(false),
     m_newStream(true),
     m_endOfSequence(false),
-    m_dpb(bind(&VaapiDecoderH265::outputPicture, this, _1))
+    m_dpb(bind(&VaapiDecoderH265::outputPicture, this, _1)),
+    m_picturePool(ObjectPool<VaapiDecPictureH265>::create()),
+    m_resumeChunk(false),
+    m_batchFirst(0)
 {
     m_parser.reset(new Parser());
     m_prevSlice.reset(new SliceHeader());
@@ -451,7 +448,46 @@ YamiStatus VaapiDecoderH265::start(VideoConfigBuffer* buffer)
             return DECODE_FAIL;
         }
     }
+    if (buffer->flag & HAS_CHUNKED_INPUT)
+        m_assembler.reset(new NalAssembler(m_nalLengthSize));
+    if (buffer->flag & HAS_PARALLEL_SLICE_PARSING) {
+        uint32_t threads = WorkerPool::suggestThreads(SLICE_PARSING_THREADS);
+        if (threads)
+            m_slicePool.reset(new WorkerPool(threads));
+    }
+    m_sei.setFlags(buffer->flag);
+
+    return YAMI_SUCCESS;
+}
 
+YamiStatus VaapiDecoderH265::decodeSei(NalUnit* nalu)
+{
+    YamiParser::SeiReader reader(nalu->m_data + NalUnit::NALU_HEAD_SIZE,
+        nalu->m_size - NalUnit::NALU_HEAD_SIZE);
+    YamiParser::SeiMessage message;
+    while (reader.next(message)) {
+        if (!m_sei.wants(message.payloadType))
+            continue;
+        if (message.payloadType == YamiParser::SEI_RECOVERY_POINT) {
+            SeiRecoveryPoint point;
+            if (m_parser->parseRecoveryPoint(&point, message))
+                m_sei.setRecoveryPoint(point.recovery_poc_cnt,
+                    point.exact_match_flag, point.broken_link_flag);
+        } else if (message.payloadType == YamiParser::SEI_TIME_CODE) {
+            SeiTimeCode timeCode;
+            if (!m_parser->parseTimeCode(&timeCode, message))
+                continue;
+            for (uint8_t i = 0; i < timeCode.num_clock_ts; i++) {
+                if (timeCode.clock_timestamp_flag[i]) {
+                    m_sei.setTimeCode(timeCode.clock_timestamp[i]);
+                    break;
+                }
+            }
+        } else {
+            m_sei.decode(message);
+        }
+    }
+    //a broken sei is not worth to stop the decoding
     return YAMI_SUCCESS;
 }
 
@@ -563,7 +599,7 @@ void VaapiDecoderH265::fillReference(VAPictureHEVC* refs, int32_t& n,
         r->flags = flags;
 
         //record for late use
-        m_pocToIndex[pic->m_poc] = n;
+        m_pocToIndex.insert(pic->m_poc, n);
 
         n++;
 
@@ -741,7 +777,8 @@ bool VaapiDecoderH265::getRefPicList(RefSet& refset, const RefSet& stCurr0, cons
 
 uint8_t  VaapiDecoderH265::getIndex(int32_t poc)
 {
-    return m_pocToIndex[poc];
+    const uint8_t* index = m_pocToIndex.find(poc);
+    return index ? *index : 0;
 }
 
 void VaapiDecoderH265::fillReferenceIndexForList(VASliceParameterBufferHEVC* sliceParam,
@@ -911,9 +948,14 @@ bool VaapiDecoderH265::fillSlice(const PicturePtr& picture,
     return true;
 }
 
+static uint8_t getSurfaceNumber(const SPS* const sps)
+{
+    return sps->sps_max_dec_pic_buffering_minus1[0] + 1;
+}
+
 YamiStatus VaapiDecoderH265::ensureContext(const SPS* const sps)
 {
-    uint8_t surfaceNumber = sps->sps_max_dec_pic_buffering_minus1[0] + 1;
+    uint8_t surfaceNumber = getSurfaceNumber(sps);
     if (m_configBuffer.surfaceWidth < sps->width
         || m_configBuffer.surfaceHeight <  sps->height
         || m_configBuffer.surfaceNumber < surfaceNumber) {
@@ -993,29 +1035,47 @@ PicturePtr VaapiDecoderH265::createPicture(const SliceHeader* const slice,
     SurfacePtr surface = createSurface(slice);
     if (!surface)
         return picture;
-    picture.reset(new VaapiDecPictureH265(m_context, surface, m_currentPTS));
+    picture = m_picturePool->alloc();
+    picture->init(m_context, surface, m_currentPTS);
+    if (m_sei.enabled())
+        picture->m_sei = m_sei.take();
+    initPicture(picture, slice, nalu);
+    return picture;
+}
 
+void VaapiDecoderH265::initPicture(const PicturePtr& picture,
+    const SliceHeader* const slice, const NalUnit* const nalu)
+{
     picture->m_noRaslOutputFlag = isIdr(nalu) || isBla(nalu) ||
                                   m_newStream || m_endOfSequence;
-    m_noRaslOutputFlag = picture->m_noRaslOutputFlag;
     if (isIrap(nalu))
         m_associatedIrapNoRaslOutputFlag = picture->m_noRaslOutputFlag;
     picture->m_picOutputFlag
         = (isRasl(nalu) && m_associatedIrapNoRaslOutputFlag) ? false : slice->pic_output_flag;
 
     getPoc(picture, slice, nalu);
+}
 
-    return picture;
+/* 8.1.3, the rasl pictures of an irap that starts the decoding, or a new
+ * sequence, refer to pictures not decoded */
+bool VaapiDecoderH265::isSkippedRasl(const NalUnit* const nalu)
+{
+    return isRasl(nalu) && m_associatedIrapNoRaslOutputFlag;
 }
 
 YamiStatus VaapiDecoderH265::decodeSlice(NalUnit* nalu)
 {
     SharedPtr<SliceHeader> currSlice(new SliceHeader());
-    SliceHeader* slice = currSlice.get();
-    YamiStatus status;
 
-    if (!m_parser->parseSlice(nalu, slice))
+    if (!m_parser->parseSlice(nalu, currSlice.get()))
         return YAMI_DECODE_INVALID_DATA;
+    return decodeSlice(nalu, currSlice);
+}
+
+YamiStatus VaapiDecoderH265::decodeSlice(NalUnit* nalu, SharedPtr<SliceHeader> currSlice)
+{
+    SliceHeader* slice = currSlice.get();
+    YamiStatus status;
 
     status = ensureContext(slice->pps->sps.get());
     if (status != YAMI_SUCCESS) {
@@ -1025,9 +1085,11 @@ YamiStatus VaapiDecoderH265::decodeSlice(NalUnit* nalu)
         status = decodeCurrent();
         if (status != YAMI_SUCCESS)
             return status;
+    }
+    if (isSkippedRasl(nalu))
+        return YAMI_SUCCESS;
+    if (slice->first_slice_segment_in_pic_flag) {
         m_current = createPicture(slice, nalu);
-        if (m_noRaslOutputFlag && isRasl(nalu))
-            return YAMI_SUCCESS;
         if (!m_current || !m_dpb.init(m_current, slice, nalu, m_newStream))
             return YAMI_DECODE_INVALID_DATA;
         if (!fillPicture(m_current, slice) || !fillIqMatrix(m_current, slice))
@@ -1071,9 +1133,13 @@ YamiStatus VaapiDecoderH265::decodeNalu(NalUnit* nalu)
             case NalUnit::EOS_NUT:
                 m_endOfSequence = true;
                 break;
+            case NalUnit::PREFIX_SEI_NUT:
+                //all the payloads we decode are prefix sei
+                if (m_sei.enabled())
+                    status = decodeSei(nalu);
+                break;
             case NalUnit::AUD_NUT:
             case NalUnit::FD_NUT:
-            case NalUnit::PREFIX_SEI_NUT:
             case NalUnit::SUFFIX_SEI_NUT:
             default:
                 break;
@@ -1083,9 +1149,35 @@ YamiStatus VaapiDecoderH265::decodeNalu(NalUnit* nalu)
     return status;
 }
 
+void VaapiDecoderH265::flush(void)
+{
+    /*the chunk held for a format change will not come again*/
+    if (m_assembler) {
+        m_assembler->reset(m_nalLengthSize);
+        m_resumeChunk = false;
+    }
+    /*decoding goes on from an irap somewhere else, as a new stream.
+      the pictures in dpb are dropped with the output of base flush*/
+    m_current.reset();
+    m_dpb.flush();
+    m_prevPicOrderCntMsb = 0;
+    m_prevPicOrderCntLsb = 0;
+    m_associatedIrapNoRaslOutputFlag = false;
+    m_newStream = true;
+    m_endOfSequence = false;
+    m_sei.reset();
+    VaapiDecoderBase::flush();
+}
+
 YamiStatus VaapiDecoderH265::decode(VideoDecodeBuffer* buffer)
 {
     if (!buffer || !buffer->data) {
+        if (m_assembler) {
+            m_assembler->flush();
+            decodeAssembledNalus();
+            m_assembler->reset(m_nalLengthSize);
+            m_resumeChunk = false;
+        }
         decodeCurrent();
         m_dpb.flush();
         m_prevPicOrderCntMsb = 0;
@@ -1094,9 +1186,20 @@ YamiStatus VaapiDecoderH265::decode(VideoDecodeBuffer* buffer)
         m_endOfSequence = false;
         return YAMI_SUCCESS;
     }
+    if (m_assembler) {
+        if (m_resumeChunk)
+            m_assembler->resume(buffer->data, buffer->size);
+        else
+            m_assembler->feed(buffer->data, buffer->size, buffer->timeStamp);
+        m_resumeChunk = false;
+        return decodeAssembledNalus();
+    }
     m_currentPTS = buffer->timeStamp;
 
     NalReader nr(buffer->data, buffer->size, m_nalLengthSize);
+    if (m_slicePool)
+        return decodeBatch(nr);
+
     const uint8_t* nal;
     int32_t size;
     YamiStatus status;
@@ -1111,6 +1214,93 @@ YamiStatus VaapiDecoderH265::decode(VideoDecodeBuffer* buffer)
     return YAMI_SUCCESS;
 }
 
+YamiStatus VaapiDecoderH265::decodeAssembledNalus()
+{
+    const uint8_t* nal;
+    int32_t size;
+    int64_t timeStamp;
+    YamiStatus status;
+    while (m_assembler->read(nal, size, timeStamp)) {
+        NalUnit nalu;
+        if (!nalu.parseNaluHeader(nal, size))
+            continue;
+        m_currentPTS = timeStamp;
+        status = decodeNalu(&nalu);
+        if (status != YAMI_SUCCESS) {
+            /*caller sends the same chunk again for format change*/
+            if (status == YAMI_DECODE_FORMAT_CHANGE) {
+                m_assembler->unread();
+                m_resumeChunk = true;
+            }
+            return status;
+        }
+    }
+    return YAMI_SUCCESS;
+}
+
+static bool isSlice(const NalUnit* const nalu)
+{
+    return NalUnit::TRAIL_N <= nalu->nal_unit_type
+        && nalu->nal_unit_type <= NalUnit::CRA_NUT;
+}
+
+void VaapiDecoderH265::parseBatchedSlice(uint32_t index)
+{
+    SharedPtr<SliceHeader>& slice = m_batchSlices[index];
+    slice.reset(new SliceHeader());
+    if (!m_parser->parseSlice(m_batchNalus[m_batchFirst + index].get(), slice.get()))
+        slice.reset();
+}
+
+/* The slice headers between two non slice nal units only depend on
+ * the parameter sets parsed before them, so they are parsed together
+ * on m_slicePool. Everything else is decoded in order like decodeNalu. */
+YamiStatus VaapiDecoderH265::decodeBatch(NalReader& nr)
+{
+    const uint8_t* nal;
+    int32_t size;
+    YamiStatus status;
+
+    m_batchNalus.clear();
+    while (nr.read(nal, size)) {
+        SharedPtr<NalUnit> nalu(new NalUnit);
+        if (nalu->parseNaluHeader(nal, size))
+            m_batchNalus.push_back(nalu);
+    }
+
+    size_t i = 0;
+    while (i < m_batchNalus.size()) {
+        if (!isSlice(m_batchNalus[i].get())) {
+            status = decodeNalu(m_batchNalus[i++].get());
+            if (status != YAMI_SUCCESS)
+                return status;
+            continue;
+        }
+        size_t end = i + 1;
+        while (end < m_batchNalus.size() && isSlice(m_batchNalus[end].get()))
+            end++;
+        m_batchFirst = i;
+        m_batchSlices.resize(end - i);
+        m_slicePool->run(bind(&VaapiDecoderH265::parseBatchedSlice, this, _1), end - i);
+
+        for (; i < end; i++) {
+            const SharedPtr<SliceHeader>& slice = m_batchSlices[i - m_batchFirst];
+            if (slice)
+                status = decodeSlice(m_batchNalus[i].get(), slice);
+            else
+                status = YAMI_DECODE_INVALID_DATA;
+            if (status == YAMI_DECODE_INVALID_DATA) {
+                //same as decodeNalu, skip to next slice
+                m_current.reset();
+                status = YAMI_SUCCESS;
+            }
+            if (status != YAMI_SUCCESS)
+                return status;
+        }
+    }
+    return YAMI_SUCCESS;
+}
+
 bool VaapiDecoderH265::decodeHevcRecordData(uint8_t* buf, int32_t bufSize)
 {
     if (buf == NULL || bufSize == 0) {
@@ -1163,8 +1353,45 @@ bool VaapiDecoderH265::decodeHevcRecordData(uint8_t* buf, int32_t bufSize)
     return true;
 }
 
+YamiStatus VaapiDecoderH265::probe(const uint8_t* data, size_t size,
+    VideoFormatInfo* info)
+{
+    Parser parser;
+    const uint8_t* nal;
+    int32_t nalSize;
+    NalReader nr(data, size);
+    while (nr.read(nal, nalSize)) {
+        NalUnit nalu;
+        if (!nalu.parseNaluHeader(nal, nalSize))
+            continue;
+        if (nalu.nal_unit_type == NalUnit::VPS_NUT) {
+            if (!parser.parseVps(&nalu))
+                return YAMI_DECODE_INVALID_DATA;
+            continue;
+        }
+        if (nalu.nal_unit_type != NalUnit::SPS_NUT)
+            continue;
+        SharedPtr<SPS> sps;
+        if (!parser.parseSps(&nalu, sps))
+            return YAMI_DECODE_INVALID_DATA;
+
+        //same as ensureContext gives to VaapiDecoderBase::start
+        memset(info, 0, sizeof(VideoFormatInfo));
+        info->valid = true;
+        info->width = sps->conformance_window_flag ? sps->croppedWidth : sps->width;
+        info->height = sps->conformance_window_flag ? sps->croppedHeight : sps->height;
+        info->surfaceWidth = sps->width;
+        info->surfaceHeight = sps->height;
+        info->surfaceNumber = getSurfaceNumber(sps.get());
+        info->fourcc = YAMI_FOURCC_NV12;
+        return YAMI_SUCCESS;
+    }
+    return YAMI_MORE_DATA;
+}
+
 const bool VaapiDecoderH265::s_registered =
-    VaapiDecoderFactory::register_<VaapiDecoderH265>(YAMI_MIME_H265);
+    VaapiDecoderFactory::register_<VaapiDecoderH265>(YAMI_MIME_H265)
+    && VaapiDecoderProbes::register_(YAMI_MIME_H265, VaapiDecoderH265::probe);
 
 }
 
@@ -20,9 +20,11 @@
 #include "common/Functional.h"
 #include "vaapidecoder_base.h"
 #include "vaapidecpicture.h"
+#include "vaapidecpocindex.h"
+#include "vaapidecsei.h"
 
 #include <set>
-#include <map>
+#include <vector>
 #include <va/va_dec_hevc.h>
 
 namespace YamiParser {
@@ -37,6 +39,9 @@ namespace H265 {
 namespace YamiMediaCodec {
 
 class VaapiDecPictureH265;
+class NalAssembler;
+class NalReader;
+class WorkerPool;
 class VaapiDecoderH265:public VaapiDecoderBase {
     typedef YamiParser::H265::SPS SPS;
     typedef YamiParser::H265::SliceHeader SliceHeader;
@@ -50,10 +55,15 @@ public:
     virtual ~VaapiDecoderH265();
     virtual YamiStatus start(VideoConfigBuffer*);
     virtual YamiStatus decode(VideoDecodeBuffer*);
+    virtual void flush(void);
+
+    /* see probeVideoStream(), the first sps gives the format */
+    static YamiStatus probe(const uint8_t* data, size_t size, VideoFormatInfo* info);
 
 private:
     friend class FactoryTest<IVideoDecoder, VaapiDecoderH265>;
     friend class VaapiDecoderH265Test;
+    friend class VaapiDecoderH265Benchmark;
 
     class DPB {
         typedef VaapiDecoderH265::RefSet     RefSet;
@@ -107,13 +117,23 @@ private:
             inline bool operator()(const PicturePtr& left, const PicturePtr& right) const;
         };
         typedef std::set<PicturePtr, PocLess> PictureList;
+        void insert(const PicturePtr&);
+        void erase(PictureList::iterator);
+        void clear();
+
         PictureList     m_pictures;
+        /*poc to picture of m_pictures, for rps lookup*/
+        PocIndex<VaapiDecPictureH265*> m_pocIndex;
         OutputCallback  m_output;
-        PicturePtr      m_dummy;
     };
     YamiStatus decodeNalu(NalUnit*);
+    YamiStatus decodeAssembledNalus();
+    YamiStatus decodeBatch(NalReader&);
+    void parseBatchedSlice(uint32_t index);
     YamiStatus decodeParamSet(NalUnit*);
+    YamiStatus decodeSei(NalUnit*);
     YamiStatus decodeSlice(NalUnit*);
+    YamiStatus decodeSlice(NalUnit*, SharedPtr<SliceHeader>);
 
     YamiStatus ensureContext(const SPS* const);
     bool fillPicture(const PicturePtr& , const SliceHeader* const );
@@ -136,6 +156,9 @@ private:
 
     SurfacePtr createSurface(const SliceHeader* const);
     PicturePtr createPicture(const SliceHeader* const, const NalUnit* const nalu);
+    void initPicture(const PicturePtr&, const SliceHeader* const,
+            const NalUnit* const);
+    bool isSkippedRasl(const NalUnit* const);
     void getPoc(const PicturePtr&, const SliceHeader* const,
             const NalUnit* const);
     YamiStatus decodeCurrent();
@@ -147,17 +170,70 @@ private:
     int32_t     m_prevPicOrderCntLsb;
     int32_t     m_nalLengthSize;
     bool        m_associatedIrapNoRaslOutputFlag;
-    bool        m_noRaslOutputFlag;
     bool        m_newStream;
     bool        m_endOfSequence;
     DPB         m_dpb;
-    std::map<int32_t, uint8_t> m_pocToIndex;
+    SharedPtr<ObjectPool<VaapiDecPictureH265> > m_picturePool;
+    /*poc to index of ReferenceFrames, for RefPicList*/
+    PocIndex<uint8_t> m_pocToIndex;
     SharedPtr<SliceHeader> m_prevSlice;
-
+    /*valid when input comes in chunks, see HAS_CHUNKED_INPUT*/
+    SharedPtr<NalAssembler> m_assembler;
+    /*caller will send last chunk again*/
+    bool        m_resumeChunk;
+    /*valid with HAS_PARALLEL_SLICE_PARSING*/
+    SharedPtr<WorkerPool> m_slicePool;
+    /*nal units of current buffer, and slice headers parsed by m_slicePool*/
+    std::vector<SharedPtr<NalUnit> > m_batchNalus;
+    std::vector<SharedPtr<SliceHeader> > m_batchSlices;
+    size_t      m_batchFirst;
+    /*sei messages for next picture, see HAS_SEI_RECOVERY_POINT*/
+    VaapiDecSei m_sei;
 
     static const bool s_registered; // VaapiDecoderFactory registration result
 };
 
+class VaapiDecPictureH265 : public VaapiDecPicture
+{
+public:
+    VaapiDecPictureH265(const ContextPtr& context, const SurfacePtr& surface, int64_t timeStamp):
+        VaapiDecPicture(context, surface, timeStamp)
+        , m_poc(0)
+        , m_pocLsb(0)
+        , m_noRaslOutputFlag(false)
+        , m_picOutputFlag(false)
+        , m_picLatencyCount(0)
+        , m_isUnusedReference(false)
+        , m_isReference(false)
+    {
+    }
+    VaapiDecPictureH265()
+        : m_poc(0)
+        , m_pocLsb(0)
+        , m_noRaslOutputFlag(false)
+        , m_picOutputFlag(false)
+        , m_picLatencyCount(0)
+        , m_isUnusedReference(false)
+        , m_isReference(false)
+    {
+    }
+    virtual void reset()
+    {
+        *this = VaapiDecPictureH265();
+    }
+    int32_t     m_poc;
+    uint16_t    m_pocLsb;
+    bool        m_noRaslOutputFlag;
+    bool        m_picOutputFlag;
+    uint32_t    m_picLatencyCount;
+
+    //is unused reference picture
+    bool        m_isUnusedReference;
+    //is this picture ref able?
+    bool        m_isReference;
+
+};
+
 };
 
 #endif
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vaapidecoder_h265.h"
+
+// library headers
+#include "codecparsers/h265Parser.h"
+
+// system libraries
+#include <algorithm>
+#include <stdio.h>
+#include <time.h>
+
+namespace YamiMediaCodec {
+
+using namespace YamiParser::H265;
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* drives the dpb with synthetic slice headers, a low delay stream that
+ * references the previous refs pictures from every picture. The pictures
+ * have no surface, the dpb only looks at their poc and flags. */
+class VaapiDecoderH265Benchmark {
+    typedef VaapiDecoderH265::DPB DPB;
+    typedef VaapiDecoderH265::PicturePtr PicturePtr;
+
+public:
+    VaapiDecoderH265Benchmark(uint8_t refs)
+        : m_dpb(std::bind(&VaapiDecoderH265Benchmark::output, this,
+              std::placeholders::_1))
+        , m_sps(new SPS())
+        , m_pps(new PPS())
+        , m_outputs(0)
+    {
+        m_sps->log2_max_pic_order_cnt_lsb_minus4 = 12;
+        m_sps->sps_max_dec_pic_buffering_minus1[0] = refs;
+        m_pps->sps = m_sps;
+
+        m_slice.pps = m_pps;
+        ShortTermRefPicSet& rps = m_slice.short_term_ref_pic_sets;
+        for (uint8_t i = 0; i < refs; i++) {
+            rps.DeltaPocS0[i] = -(i + 1);
+            rps.UsedByCurrPicS0[i] = 1;
+        }
+        m_refs = refs;
+    }
+
+    /* ns per picture for init and add, and the references found */
+    double measure(uint32_t pictures, uint32_t& found)
+    {
+        NalUnit nalu;
+        ShortTermRefPicSet& rps = m_slice.short_term_ref_pic_sets;
+        found = 0;
+        uint64_t start = nowNs();
+        for (uint32_t i = 0; i < pictures; i++) {
+            nalu.nal_unit_type = i ? NalUnit::TRAIL_R : NalUnit::IDR_W_RADL;
+            //only the pictures after the idr exist
+            rps.NumNegativePics = std::min(i, m_refs);
+            rps.NumDeltaPocs = rps.NumUsedByCurrPic = rps.NumNegativePics;
+            PicturePtr picture(new VaapiDecPictureH265);
+            picture->m_poc = i;
+            picture->m_pocLsb = i & 0xffff;
+            picture->m_noRaslOutputFlag = !i;
+            picture->m_picOutputFlag = true;
+            m_dpb.init(picture, &m_slice, &nalu, !i);
+            found += m_dpb.m_stCurrBefore.size();
+            m_dpb.add(picture, &m_slice);
+        }
+        uint64_t ns = nowNs() - start;
+        m_dpb.flush();
+        return (double)ns / pictures;
+    }
+
+    uint32_t outputs() const { return m_outputs; }
+
+private:
+    YamiStatus output(const PicturePtr&)
+    {
+        m_outputs++;
+        return YAMI_SUCCESS;
+    }
+
+    DPB m_dpb;
+    SharedPtr<SPS> m_sps;
+    SharedPtr<PPS> m_pps;
+    SliceHeader m_slice;
+    uint32_t m_refs;
+    uint32_t m_outputs;
+};
+}
+
+using namespace YamiMediaCodec;
+
+int main()
+{
+    static const uint8_t refs[] = { 1, 2, 4, 8, 15 };
+    const uint32_t pictures = 200000;
+
+    printf("%10s %14s %14s\n", "refs", "ns/picture", "refs/picture");
+    for (size_t i = 0; i < sizeof(refs) / sizeof(refs[0]); i++) {
+        VaapiDecoderH265Benchmark bench(refs[i]);
+        uint32_t found;
+        double ns = bench.measure(pictures, found);
+        if (bench.outputs() != pictures)
+            fprintf(stderr, "output %u of %u pictures\n", bench.outputs(), pictures);
+        printf("%10u %14.1f %14.2f\n", refs[i], ns, (double)found / pictures);
+    }
+    return 0;
+}
@@ -34,21 +34,110 @@
 // primary header
 #include "vaapidecoder_h265.h"
 
+// library headers
+#include "codecparsers/h265Parser.h"
+
 namespace YamiMediaCodec {
 
 class VaapiDecoderH265Test
     : public FactoryTest<IVideoDecoder, VaapiDecoderH265>
 {
 protected:
+    typedef VaapiDecoderH265::DPB DPB;
+    typedef VaapiDecoderH265::PicturePtr PicturePtr;
+    typedef YamiParser::H265::SPS SPS;
+    typedef YamiParser::H265::PPS PPS;
+    typedef YamiParser::H265::SliceHeader SliceHeader;
+    typedef YamiParser::H265::NalUnit NalUnit;
+
     /* invoked by gtest before the test */
     virtual void SetUp() {
-        return;
+        m_sps.reset(new SPS());
+        m_sps->log2_max_pic_order_cnt_lsb_minus4 = 4;
+        m_sps->sps_max_dec_pic_buffering_minus1[0] = 4;
+        m_sps->sps_max_num_reorder_pics[0] = 0;
+        m_pps.reset(new PPS());
+        m_pps->sps = m_sps;
+
+        m_dpb.reset(new DPB(std::bind(&VaapiDecoderH265Test::output, this,
+            std::placeholders::_1)));
+        m_outputs.clear();
     }
 
     /* invoked by gtest after the test */
     virtual void TearDown() {
         return;
     }
+
+    YamiStatus output(const PicturePtr& picture)
+    {
+        m_outputs.push_back(picture->m_poc);
+        return YAMI_SUCCESS;
+    }
+
+    /* decode poc, referencing the pictures at the negative deltas */
+    bool decodePicture(int32_t poc, const std::vector<int32_t>& deltas,
+        uint8_t nalType = NalUnit::TRAIL_R)
+    {
+        SliceHeader slice;
+        slice.pps = m_pps;
+        YamiParser::H265::ShortTermRefPicSet& rps = slice.short_term_ref_pic_sets;
+        rps.NumNegativePics = deltas.size();
+        for (size_t i = 0; i < deltas.size(); i++) {
+            rps.DeltaPocS0[i] = deltas[i];
+            rps.UsedByCurrPicS0[i] = 1;
+        }
+        NalUnit nalu;
+        nalu.nal_unit_type = nalType;
+
+        PicturePtr picture(new VaapiDecPictureH265);
+        picture->m_poc = poc;
+        picture->m_pocLsb = poc & 0xf;
+        picture->m_noRaslOutputFlag = (nalType != NalUnit::TRAIL_R);
+        picture->m_picOutputFlag = true;
+        if (!m_dpb->init(picture, &slice, &nalu, m_outputs.empty()))
+            return false;
+        return m_dpb->add(picture, &slice);
+    }
+
+    std::vector<int32_t> stCurrBefore()
+    {
+        std::vector<int32_t> pocs;
+        for (size_t i = 0; i < m_dpb->m_stCurrBefore.size(); i++)
+            pocs.push_back(m_dpb->m_stCurrBefore[i]->m_poc);
+        return pocs;
+    }
+
+    void flush() { m_dpb->flush(); }
+
+    /* the flags and poc createPicture() gives, no surface needed */
+    PicturePtr initDecoderPicture(VaapiDecoderH265& decoder, uint8_t nalType,
+        uint16_t pocLsb)
+    {
+        SliceHeader slice;
+        slice.pps = m_pps;
+        slice.slice_pic_order_cnt_lsb = pocLsb;
+        slice.pic_output_flag = true;
+        NalUnit nalu;
+        nalu.nal_unit_type = nalType;
+        nalu.nuh_temporal_id_plus1 = 1;
+        PicturePtr picture(new VaapiDecPictureH265);
+        decoder.initPicture(picture, &slice, &nalu);
+        return picture;
+    }
+    bool isSkippedRasl(VaapiDecoderH265& decoder)
+    {
+        NalUnit nalu;
+        nalu.nal_unit_type = NalUnit::RASL_N;
+        return decoder.isSkippedRasl(&nalu);
+    }
+    /* as decodeCurrent() leaves it */
+    void setDecoded(VaapiDecoderH265& decoder) { decoder.m_newStream = false; }
+
+    SharedPtr<SPS> m_sps;
+    SharedPtr<PPS> m_pps;
+    SharedPtr<DPB> m_dpb;
+    std::vector<int32_t> m_outputs;
 };
 
 #define VAAPIDECODER_H265_TEST(name) \
@@ -60,4 +149,54 @@ VAAPIDECODER_H265_TEST(Factory) {
     doFactoryTest(mimeTypes);
 }
 
+VAAPIDECODER_H265_TEST(FlushToCra) {
+    VaapiDecoderH265 decoder;
+    PicturePtr picture = initDecoderPicture(decoder, NalUnit::IDR_W_RADL, 0);
+    setDecoded(decoder);
+    initDecoderPicture(decoder, NalUnit::TRAIL_R, 100);
+    initDecoderPicture(decoder, NalUnit::TRAIL_R, 200);
+    picture = initDecoderPicture(decoder, NalUnit::TRAIL_R, 40);
+    EXPECT_EQ(296, picture->m_poc);
+
+    //a seek to a cra, it starts the decoding as at the stream start
+    decoder.flush();
+    picture = initDecoderPicture(decoder, NalUnit::CRA_NUT, 100);
+    EXPECT_TRUE(picture->m_noRaslOutputFlag);
+    EXPECT_EQ(100, picture->m_poc);
+    EXPECT_TRUE(isSkippedRasl(decoder));
+    setDecoded(decoder);
+    picture = initDecoderPicture(decoder, NalUnit::TRAIL_R, 101);
+    EXPECT_EQ(101, picture->m_poc);
+
+    //a cra in the stream keeps its leading pictures
+    picture = initDecoderPicture(decoder, NalUnit::CRA_NUT, 120);
+    EXPECT_FALSE(picture->m_noRaslOutputFlag);
+    EXPECT_FALSE(isSkippedRasl(decoder));
+}
+
+VAAPIDECODER_H265_TEST(DpbShortTermReference) {
+    std::vector<int32_t> none, deltas;
+    ASSERT_TRUE(decodePicture(0, none, NalUnit::IDR_W_RADL));
+    ASSERT_TRUE(decodePicture(1, std::vector<int32_t>(1, -1)));
+
+    deltas.push_back(-1);
+    deltas.push_back(-2);
+    ASSERT_TRUE(decodePicture(2, deltas));
+    std::vector<int32_t> expected;
+    expected.push_back(1);
+    expected.push_back(0);
+    EXPECT_EQ(expected, stCurrBefore());
+
+    //poc 0 and 1 are dropped by picture 3, they must not be found again
+    ASSERT_TRUE(decodePicture(3, std::vector<int32_t>(1, -1)));
+    deltas[1] = -3;
+    ASSERT_TRUE(decodePicture(4, deltas));
+    EXPECT_EQ(std::vector<int32_t>(1, 3), stCurrBefore());
+
+    flush();
+    EXPECT_EQ(5u, m_outputs.size());
+    for (int32_t i = 0; i < 5; i++)
+        EXPECT_EQ(i, m_outputs[i]);
+}
+
 }
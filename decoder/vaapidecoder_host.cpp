@@ -61,4 +61,19 @@ std::vector<std::string> getVideoDecoderMimeTypes()
 {
     return VaapiDecoderFactory::keys();
 }
+
+YamiStatus probeVideoStream(const char *mimeType, const uint8_t *data, size_t size, VideoFormatInfo *info)
+{
+    if (!mimeType || !data || !size || !info) {
+        ERROR("invalid param for probe");
+        return YAMI_INVALID_PARAM;
+    }
+
+    VideoStreamProbe probe = VaapiDecoderProbes::find(mimeType);
+    if (!probe) {
+        ERROR("Failed to probe for mimeType: '%s'", mimeType);
+        return YAMI_UNSUPPORTED;
+    }
+    return probe(data, size, info);
+}
 } // extern "C"
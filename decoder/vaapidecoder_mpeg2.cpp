@@ -485,8 +485,8 @@ YamiStatus VaapiDecoderMPEG2::processDecodeBuffer()
                 }
                 m_canCreatePicture = false;
             }
-            INFO("processSlice on next_code %x", next_code);
-            status = processSlice();
+            INFO("processSlices on next_code %x", next_code);
+            status = processSlices();
             if (status != YAMI_SUCCESS) {
                 return status;
             }
@@ -590,23 +590,33 @@ bool VaapiDecoderMPEG2::isSliceCode(YamiParser::MPEG2::StartCodeType next_code)
     return false;
 }
 
-YamiStatus VaapiDecoderMPEG2::processSlice()
+YamiStatus VaapiDecoderMPEG2::processSlices()
 {
-    const Slice* slice;
-    YamiStatus status = YAMI_DECODE_PARSER_FAIL;
-
-    if (m_parser->parseSlice(m_stream.get())) {
-        slice = m_parser->getMPEG2Slice();
-        if (!m_currentPicture->newSlice(mpeg2SliceParams,
-                slice->sliceData, slice->sliceDataSize)) {
-            DEBUG("picture->newSlice failed");
-            return YAMI_FAIL;
-        }
-        fillSliceParams(mpeg2SliceParams, slice);
-        status = YAMI_SUCCESS;
+    VASliceParameterBufferMPEG2* sliceParams;
+
+    // all slices up to the next non slice start code are parsed in one
+    // pass, decode() goes on after the last one
+    if (!m_parser->parseSlices(m_stream.get(), m_slices))
+        return YAMI_DECODE_PARSER_FAIL;
+
+    // one data buffer from the first slice to the end of the last, the
+    // start codes in between are skipped by the offsets
+    const uint8_t* base = m_slices.front().sliceData;
+    const Slice& last = m_slices.back();
+    uint32_t dataSize = last.sliceData + last.sliceDataSize - base;
+    if (!m_currentPicture->newSlices(sliceParams, m_slices.size(), base,
+            dataSize)) {
+        DEBUG("picture->newSlices failed");
+        return YAMI_FAIL;
+    }
+    for (size_t i = 0; i < m_slices.size(); i++) {
+        const Slice& slice = m_slices[i];
+        fillSliceParams(&sliceParams[i], &slice);
+        sliceParams[i].slice_data_offset = slice.sliceData - base;
+        sliceParams[i].slice_data_size = slice.sliceDataSize;
     }
 
-    return status;
+    return YAMI_SUCCESS;
 }
 
 inline bool findTempReference(const PicturePtr& picture,
@@ -957,6 +967,11 @@ YamiStatus VaapiDecoderMPEG2::decode(VideoDecodeBuffer* buffer)
                 if (status != YAMI_SUCCESS) {
                     return status;
                 }
+                // the whole run of slices is taken, skip over it
+                const Slice& last = m_slices.back();
+                const uint8_t* next = last.sliceData + last.sliceDataSize;
+                nalReader = NalReader(next,
+                    m_stream->data + m_stream->streamSize - next);
             }
             break;
         }
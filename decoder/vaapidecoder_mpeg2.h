@@ -120,7 +120,7 @@ private:
     YamiStatus processDecodeBuffer();
 
     YamiStatus preDecode(StreamHdrPtr shdr);
-    YamiStatus processSlice();
+    YamiStatus processSlices();
     YamiStatus decodeGOP();
     YamiStatus assignSurface();
     YamiStatus assignPicture();
@@ -142,7 +142,8 @@ private:
     const YamiParser::MPEG2::PictureCodingExtension* m_pictureCodingExtension;
     const YamiParser::MPEG2::QuantMatrixExtension* m_quantMatrixExtension;
     DPB m_DPB;
-    VASliceParameterBufferMPEG2* mpeg2SliceParams;
+    // slices of the current picture, kept to reuse the memory
+    std::vector<YamiParser::MPEG2::Slice> m_slices;
 
     bool m_VAStart;
     bool m_isParsingSlices;
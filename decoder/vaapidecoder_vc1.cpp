@@ -85,23 +85,23 @@ bool VaapiDecoderVC1::makeBitPlanes(PicturePtr& picture, VAPictureParameterBuffe
     if ((m_parser.m_frameHdr.picture_type == FRAME_I)
         || (m_parser.m_frameHdr.picture_type == FRAME_BI)) {
         if (param->bitplane_present.flags.bp_ac_pred)
-            bitPlanes[1] = &m_parser.m_bitPlanes.acpred[0];
+            bitPlanes[1] = m_parser.m_bitPlanes.acpred;
         if (param->bitplane_present.flags.bp_overflags)
-            bitPlanes[2] = &m_parser.m_bitPlanes.overflags[0];
+            bitPlanes[2] = m_parser.m_bitPlanes.overflags;
     }
     else if (m_parser.m_frameHdr.picture_type == FRAME_P) {
         if (param->bitplane_present.flags.bp_direct_mb)
-            bitPlanes[0] = &m_parser.m_bitPlanes.directmb[0];
+            bitPlanes[0] = m_parser.m_bitPlanes.directmb;
         if (param->bitplane_present.flags.bp_skip_mb)
-            bitPlanes[1] = &m_parser.m_bitPlanes.skipmb[0];
+            bitPlanes[1] = m_parser.m_bitPlanes.skipmb;
         if (param->bitplane_present.flags.bp_mv_type_mb)
-            bitPlanes[2] = &m_parser.m_bitPlanes.mvtypemb[0];
+            bitPlanes[2] = m_parser.m_bitPlanes.mvtypemb;
     }
     else if (m_parser.m_frameHdr.picture_type == FRAME_B) {
         if (param->bitplane_present.flags.bp_direct_mb)
-            bitPlanes[0] = &m_parser.m_bitPlanes.directmb[0];
+            bitPlanes[0] = m_parser.m_bitPlanes.directmb;
         if (param->bitplane_present.flags.bp_skip_mb)
-            bitPlanes[1] = &m_parser.m_bitPlanes.skipmb[0];
+            bitPlanes[1] = m_parser.m_bitPlanes.skipmb;
     }
     picture->editBitPlane(bitPlanesPayLoad, (m_parser.m_mbWidth * m_parser.m_mbHeight + 1) >> 1);
     if (!bitPlanesPayLoad)
@@ -27,10 +27,14 @@
 
 namespace YamiMediaCodec{
 typedef VaapiDecoderVP9::PicturePtr PicturePtr;
+using YamiParser::Vp9FrameInfo;
+using YamiParser::Vp9SuperFrame;
+
+//8 reference frame
+static const int32_t VP9_SURFACE_NUMBER = 8;
 
 VaapiDecoderVP9::VaapiDecoderVP9()
 {
-    m_parser.reset(vp9_parser_new(), vp9_parser_free);
     m_reference.resize(VP9_REF_FRAMES);
 }
 
@@ -45,8 +49,7 @@ YamiStatus VaapiDecoderVP9::start(VideoConfigBuffer* buffer)
           buffer->height);
 
     buffer->profile = VAProfileVP9Profile0;
-    //8 reference frame
-    buffer->surfaceNumber = 8;
+    buffer->surfaceNumber = VP9_SURFACE_NUMBER;
 
 
     DEBUG("disable native graphics buffer");
@@ -80,7 +83,7 @@ void VaapiDecoderVP9::stop(void)
 
 void VaapiDecoderVP9::flush(void)
 {
-    m_parser.reset(vp9_parser_new(), vp9_parser_free);
+    m_parser.reset();
     m_reference.clear();
     m_reference.resize(VP9_REF_FRAMES);
     VaapiDecoderBase::flush();
@@ -193,7 +196,7 @@ bool VaapiDecoderVP9::ensurePicture(const PicturePtr& picture, const Vp9FrameHdr
     param->pic_fields.bits.segmentation_enabled = hdr->segmentation.enabled;
     param->pic_fields.bits.segmentation_temporal_update = hdr->segmentation.temporal_update;
     param->pic_fields.bits.segmentation_update_map = hdr->segmentation.update_map;
-    param->pic_fields.bits.lossless_flag = m_parser->lossless_flag;
+    param->pic_fields.bits.lossless_flag = m_parser.lossless_flag;
 
     param->filter_level = hdr->loopfilter.filter_level;
     param->sharpness_level = hdr->loopfilter.sharpness_level;
@@ -205,10 +208,10 @@ bool VaapiDecoderVP9::ensurePicture(const PicturePtr& picture, const Vp9FrameHdr
     FILL_FIELD(frame_header_length_in_bytes)
     FILL_FIELD(first_partition_size)
 #undef FILL_FIELD
-    assert(sizeof(param->mb_segment_tree_probs) == sizeof(m_parser->mb_segment_tree_probs));
-    assert(sizeof(param->segment_pred_probs) == sizeof(m_parser->segment_pred_probs));
-    memcpy(param->mb_segment_tree_probs, m_parser->mb_segment_tree_probs, sizeof(m_parser->mb_segment_tree_probs));
-    memcpy(param->segment_pred_probs, m_parser->segment_pred_probs, sizeof(m_parser->segment_pred_probs));
+    assert(sizeof(param->mb_segment_tree_probs) == sizeof(m_parser.mb_segment_tree_probs));
+    assert(sizeof(param->segment_pred_probs) == sizeof(m_parser.segment_pred_probs));
+    memcpy(param->mb_segment_tree_probs, m_parser.mb_segment_tree_probs, sizeof(m_parser.mb_segment_tree_probs));
+    memcpy(param->segment_pred_probs, m_parser.segment_pred_probs, sizeof(m_parser.segment_pred_probs));
 
     return true;
 }
@@ -222,7 +225,7 @@ bool VaapiDecoderVP9::ensureSlice(const PicturePtr& picture, const void* data, i
         return false;
     for (int i = 0; i < VP9_MAX_SEGMENTS; i++) {
         VASegmentParameterVP9& vaseg = slice->seg_param[i];
-        Vp9Segmentation& seg = m_parser->segmentation[i];
+        Vp9Segmentation& seg = m_parser.segmentation[i];
         memcpy(vaseg.filter_level, seg.filter_level, sizeof(seg.filter_level));
         FILL_FIELD(luma_ac_quant_scale)
         FILL_FIELD(luma_dc_quant_scale)
@@ -250,16 +253,6 @@ YamiStatus VaapiDecoderVP9::decode(const Vp9FrameHdr* hdr, const uint8_t* data,
     if (!picture)
         return YAMI_OUT_MEMORY;
 
-    if (hdr->show_existing_frame) {
-        SurfacePtr& surface = m_reference[hdr->frame_to_show];
-        if (!surface) {
-            ERROR("frame to show is invalid, idx = %d", hdr->frame_to_show);
-            return YAMI_SUCCESS;
-        }
-        picture->setSurface(surface);
-        return outputPicture(picture);
-    }
-
     if (!picture->getSurface()->setCrop(0, 0, hdr->width, hdr->height)) {
         ERROR("resize to %dx%d failed", hdr->width, hdr->height);
         return YAMI_OUT_MEMORY;
@@ -277,33 +270,27 @@ YamiStatus VaapiDecoderVP9::decode(const Vp9FrameHdr* hdr, const uint8_t* data,
     return YAMI_SUCCESS;
 }
 
-static bool parse_super_frame(std::vector<uint32_t>& frameSize, const uint8_t* data, const size_t size)
+YamiStatus VaapiDecoderVP9::showExistingFrame(uint8_t frameToShow, uint64_t timeStamp)
 {
-    if (!data || !size)
-        return false;
-    uint8_t marker;
-    marker =  *(data + size - 1);
-    if ((marker & 0xe0) != 0xc0) {
-        frameSize.push_back(size);
-        return true;
+    SurfacePtr& surface = m_reference[frameToShow];
+    if (!surface) {
+        ERROR("frame to show is invalid, idx = %d", frameToShow);
+        return YAMI_SUCCESS;
     }
-    const uint32_t frames = (marker & 0x7) + 1;
-    const uint32_t mag = ((marker >> 3) & 0x3) + 1;
-    const size_t indexSz = 2 + mag * frames;
-    if (size < indexSz)
-        return false;
-    data += size - indexSz;
-    const uint8_t marker2 = *data++;
-    if (marker != marker2)
-        return false;
-    for (uint32_t i = 0; i < frames; i++) {
-        uint32_t sz = 0;
-        for (uint32_t j = 0; j < mag; j++) {
-            sz |= (*data++) << (j * 8);
-        }
-        frameSize.push_back(sz);
+    PicturePtr picture = createPicture(timeStamp);
+    if (!picture)
+        return YAMI_OUT_MEMORY;
+    picture->setSurface(surface);
+    return outputPicture(picture);
+}
+
+bool VaapiDecoderVP9::hasReference() const
+{
+    for (size_t i = 0; i < m_reference.size(); i++) {
+        if (m_reference[i])
+            return true;
     }
-    return true;
+    return false;
 }
 
 YamiStatus VaapiDecoderVP9::decode(VideoDecodeBuffer* buffer)
@@ -311,37 +298,69 @@ YamiStatus VaapiDecoderVP9::decode(VideoDecodeBuffer* buffer)
     YamiStatus status;
     if (!buffer)
         return YAMI_DECODE_INVALID_DATA;
-    uint8_t* data = buffer->data;
-    size_t  size = buffer->size;
-    uint8_t* end = data + size;
-    std::vector<uint32_t> frameSize;
-    if (!parse_super_frame(frameSize, data, size))
+    Vp9SuperFrame superFrame(buffer->data, buffer->size);
+    if (!superFrame.isValid())
         return YAMI_DECODE_INVALID_DATA;
-    for (size_t i = 0; i < frameSize.size(); i++) {
-        uint32_t sz = frameSize[i];
-        if (data + sz > end)
-            return YAMI_DECODE_INVALID_DATA;
-        status = decode(data, sz, buffer->timeStamp);
+    const uint8_t* data;
+    uint32_t size;
+    while (superFrame.next(data, size)) {
+        status = decode(data, size, buffer->timeStamp);
         if (status != YAMI_SUCCESS)
             return status;
-        data += sz;
     }
     return YAMI_SUCCESS;
 }
 
 YamiStatus VaapiDecoderVP9::decode(const uint8_t* data, uint32_t size, uint64_t timeStamp)
 {
+    //one parse, the header tells which frames need no decoding
     Vp9FrameHdr hdr;
-    if (!m_parser)
-        return YAMI_OUT_MEMORY;
-    if (vp9_parse_frame_header(m_parser.get(), &hdr, data, size) != VP9_PARSER_OK)
+    if (!m_parser.parse(&hdr, data, size))
         return YAMI_DECODE_INVALID_DATA;
+    if (hdr.show_existing_frame)
+        return showExistingFrame(hdr.frame_to_show, timeStamp);
+    if (hdr.frame_type != VP9_KEY_FRAME && !hdr.intra_only && !hasReference()) {
+        DEBUG("no reference for inter frame, skip it");
+        return YAMI_SUCCESS;
+    }
     if (hdr.first_partition_size + hdr.frame_header_length_in_bytes > size)
         return YAMI_DECODE_INVALID_DATA;
     return decode(&hdr, data, size, timeStamp);
 }
 
+YamiStatus VaapiDecoderVP9::probe(const uint8_t* data, size_t size,
+    VideoFormatInfo* info)
+{
+    Vp9SuperFrame superFrame(data, size);
+    if (!superFrame.isValid())
+        return YAMI_DECODE_INVALID_DATA;
+    YamiParser::Vp9Parser parser;
+    const uint8_t* frame;
+    uint32_t frameSize;
+    while (superFrame.next(frame, frameSize)) {
+        Vp9FrameInfo frameInfo;
+        if (!parser.probe(frameInfo, frame, frameSize))
+            return YAMI_DECODE_INVALID_DATA;
+        if (frameInfo.show_existing_frame
+            || (frameInfo.frame_type != VP9_KEY_FRAME && !frameInfo.intra_only))
+            continue;
+
+        //same as ensureContext gives to VaapiDecoderBase::start
+        memset(info, 0, sizeof(VideoFormatInfo));
+        info->valid = true;
+        info->width = frameInfo.width;
+        info->height = frameInfo.height;
+        info->surfaceWidth = ALIGN8(frameInfo.width);
+        info->surfaceHeight = ALIGN32(frameInfo.height);
+        info->surfaceNumber = VP9_SURFACE_NUMBER;
+        info->fourcc = YAMI_FOURCC_NV12;
+        return YAMI_SUCCESS;
+    }
+    return YAMI_MORE_DATA;
+}
+
 const bool VaapiDecoderVP9::s_registered =
-    VaapiDecoderFactory::register_<VaapiDecoderVP9>(YAMI_MIME_VP9);
+    VaapiDecoderFactory::register_<VaapiDecoderVP9>(YAMI_MIME_VP9)
+    && VaapiDecoderProbes::register_(YAMI_MIME_VP9, VaapiDecoderVP9::probe);
 
 }
@@ -36,6 +36,9 @@ class VaapiDecoderVP9:public VaapiDecoderBase {
     virtual void flush(void);
     virtual YamiStatus decode(VideoDecodeBuffer*);
 
+    /* see probeVideoStream(), the first key or intra only frame gives the format */
+    static YamiStatus probe(const uint8_t* data, size_t size, VideoFormatInfo* info);
+
   private:
     friend class FactoryTest<IVideoDecoder, VaapiDecoderVP9>;
     friend class VaapiDecoderVP9Test;
@@ -43,14 +46,15 @@ class VaapiDecoderVP9:public VaapiDecoderBase {
     YamiStatus ensureContext(const Vp9FrameHdr*);
     YamiStatus decode(const uint8_t* data, uint32_t size, uint64_t timeStamp);
     YamiStatus decode(const Vp9FrameHdr* hdr, const uint8_t* data, uint32_t size, uint64_t timeStamp);
+    YamiStatus showExistingFrame(uint8_t frameToShow, uint64_t timeStamp);
     bool ensureSlice(const PicturePtr& , const void* data, int size);
     bool ensurePicture(const PicturePtr& , const Vp9FrameHdr* );
     //reference related
     bool fillReference(VADecPictureParameterBufferVP9* , const Vp9FrameHdr*);
     void updateReference(const PicturePtr&, const Vp9FrameHdr*);
+    bool hasReference() const;
 
-    typedef SharedPtr<Vp9Parser> ParserPtr;
-    ParserPtr m_parser;
+    YamiParser::Vp9Parser m_parser;
     std::vector<SurfacePtr> m_reference;
 
     static const bool s_registered; // VaapiDecoderFactory registration result
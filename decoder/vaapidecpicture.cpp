@@ -21,6 +21,7 @@
 #include "vaapidecpicture.h"
 
 #include "common/log.h"
+#include "vaapi/vaapicontext.h"
 
 namespace YamiMediaCodec{
 VaapiDecPicture::VaapiDecPicture(const ContextPtr& context,
@@ -33,6 +34,23 @@ VaapiDecPicture::VaapiDecPicture()
 {
 }
 
+void VaapiDecPicture::init(const ContextPtr& context,
+    const SurfacePtr& surface, int64_t timeStamp)
+{
+    //no context for the fake decoder in unit tests
+    if (context)
+        m_display = context->getDisplay();
+    m_context = context;
+    m_surface = surface;
+    m_timeStamp = timeStamp;
+}
+
+void VaapiDecPicture::reset()
+{
+    //the assignment keeps the capacity of m_slices
+    *this = VaapiDecPicture();
+}
+
 bool VaapiDecPicture::decode()
 {
     return render();
@@ -17,6 +17,7 @@
 #define vaapidecpicture_h
 
 #include "vaapi/vaapipicture.h"
+#include "VideoCommonDefs.h"
 
 namespace YamiMediaCodec{
 class VaapiDecPicture : public VaapiPicture
@@ -44,10 +45,27 @@ public:
     template <class T>
     bool newSlice(T*& sliceParam, const void* sliceData, uint32_t sliceSize);
 
+    /* numSlices parameters in one buffer, sliceData holds the data of all
+     * of them. The caller sets slice_data_offset and slice_data_size */
+    template <class T>
+    bool newSlices(T*& sliceParams, uint32_t numSlices, const void* sliceData, uint32_t dataSize);
+
     bool decode();
 
+    /* like the constructor, for a picture from an ObjectPool */
+    void init(const ContextPtr&, const SurfacePtr&, int64_t timeStamp);
+
+    /* drop the surface and buffers, so the ObjectPool can reuse it.
+     * pictures with more state reset it too */
+    virtual void reset();
+
+    /* sei messages sent with this picture, see VaapiDecSei */
+    SharedPtr<VideoSeiInfo> m_sei;
+
 protected:
     VaapiDecPicture();
+    template <class T>
+    friend class ObjectPool;
 
 private:
     virtual bool doRender();
@@ -113,5 +131,14 @@ bool VaapiDecPicture::newSlice(T*& sliceParam, const void* sliceData, uint32_t s
 
     return false;
 }
+
+template <class T>
+bool VaapiDecPicture::newSlices(T*& sliceParams, uint32_t numSlices, const void* sliceData, uint32_t dataSize)
+{
+    BufObjectPtr data = createBufferObject(VASliceDataBufferType, dataSize, sliceData, NULL);
+    BufObjectPtr param = createBufferObject(VASliceParameterBufferType, sliceParams, numSlices);
+
+    return addObject(m_slices, param, data) && sliceParams;
+}
 }
 #endif //#ifndef vaapidecpicture_h
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef vaapidecpocindex_h
+#define vaapidecpocindex_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace YamiMediaCodec {
+
+/* poc to value for the pictures of a dpb, open addressed with linear
+ * probing in a fixed table. A dpb has 16 pictures at most, far less than
+ * the table, so probes are short and it never allocates. */
+template <class T>
+class PocIndex {
+    enum {
+        BITS = 6,
+        SIZE = 1 << BITS,
+        MASK = SIZE - 1,
+    };
+
+public:
+    PocIndex() { clear(); }
+
+    void clear()
+    {
+        for (uint32_t i = 0; i < SIZE; i++)
+            m_slots[i].used = false;
+        m_size = 0;
+    }
+
+    /* set value of poc, return false if the index is full */
+    bool insert(int32_t poc, const T& value)
+    {
+        uint32_t i = hash(poc);
+        for (; m_slots[i].used; i = (i + 1) & MASK) {
+            if (m_slots[i].poc == poc) {
+                m_slots[i].value = value;
+                return true;
+            }
+        }
+        //keep one slot free, so a probe always ends
+        if (m_size == SIZE - 1)
+            return false;
+        m_slots[i].used = true;
+        m_slots[i].poc = poc;
+        m_slots[i].value = value;
+        m_size++;
+        return true;
+    }
+
+    /* NULL if poc is not in the index */
+    T* find(int32_t poc)
+    {
+        int32_t i = findSlot(poc);
+        return i < 0 ? NULL : &m_slots[i].value;
+    }
+
+    bool erase(int32_t poc)
+    {
+        int32_t found = findSlot(poc);
+        if (found < 0)
+            return false;
+        uint32_t i = found;
+        m_slots[i].used = false;
+        m_slots[i].value = T();
+        m_size--;
+
+        //move back the entries after the hole, if their probe passes it
+        for (uint32_t j = (i + 1) & MASK; m_slots[j].used; j = (j + 1) & MASK) {
+            uint32_t k = hash(m_slots[j].poc);
+            bool stay = (i < j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (stay)
+                continue;
+            m_slots[i] = m_slots[j];
+            m_slots[j].used = false;
+            m_slots[j].value = T();
+            i = j;
+        }
+        return true;
+    }
+
+    size_t size() const { return m_size; }
+
+private:
+    int32_t findSlot(int32_t poc) const
+    {
+        for (uint32_t i = hash(poc); m_slots[i].used; i = (i + 1) & MASK) {
+            if (m_slots[i].poc == poc)
+                return i;
+        }
+        return -1;
+    }
+
+    static uint32_t hash(int32_t poc)
+    {
+        return ((uint32_t)poc * 2654435761u) >> (32 - BITS);
+    }
+
+    struct Slot {
+        int32_t poc;
+        bool used;
+        T value;
+    };
+    Slot m_slots[SIZE];
+    size_t m_size;
+};
+}
+
+#endif //vaapidecpocindex_h
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vaapidecpocindex.h"
+
+// library headers
+#include "common/common_def.h"
+#include "common/unittest.h"
+
+// system headers
+#include <memory>
+
+#define POCINDEX_TEST(name) \
+    TEST(PocIndexTest, name)
+
+using namespace YamiMediaCodec;
+
+POCINDEX_TEST(InsertAndFind)
+{
+    PocIndex<int> index;
+    EXPECT_EQ(0u, index.size());
+    EXPECT_TRUE(NULL == index.find(0));
+
+    //negative pocs are common after an idr
+    static const int32_t pocs[] = { 0, -2, -4, 8, 16, 1024, -65536 };
+    for (size_t i = 0; i < N_ELEMENTS(pocs); i++)
+        EXPECT_TRUE(index.insert(pocs[i], i));
+    EXPECT_EQ(N_ELEMENTS(pocs), index.size());
+    for (size_t i = 0; i < N_ELEMENTS(pocs); i++) {
+        int* value = index.find(pocs[i]);
+        ASSERT_TRUE(value);
+        EXPECT_EQ((int)i, *value);
+    }
+    EXPECT_TRUE(NULL == index.find(2));
+
+    //same poc again replaces the value
+    EXPECT_TRUE(index.insert(8, 100));
+    EXPECT_EQ(N_ELEMENTS(pocs), index.size());
+    EXPECT_EQ(100, *index.find(8));
+
+    index.clear();
+    EXPECT_EQ(0u, index.size());
+    EXPECT_TRUE(NULL == index.find(8));
+}
+
+POCINDEX_TEST(EraseKeepsProbes)
+{
+    //a full table has long collision chains, erase from their middle
+    PocIndex<int32_t> index;
+    int32_t n = 0;
+    while (index.insert(n * 2, n))
+        n++;
+    EXPECT_EQ(63, n);
+    EXPECT_EQ(63u, index.size());
+
+    for (int32_t i = 0; i < n; i += 3)
+        EXPECT_TRUE(index.erase(i * 2));
+    EXPECT_FALSE(index.erase(1));
+    EXPECT_FALSE(index.erase(0));
+
+    for (int32_t i = 0; i < n; i++) {
+        int32_t* value = index.find(i * 2);
+        if (i % 3) {
+            ASSERT_TRUE(value);
+            EXPECT_EQ(i, *value);
+        } else {
+            EXPECT_TRUE(NULL == value);
+        }
+    }
+
+    //the freed slots are reusable
+    EXPECT_TRUE(index.insert(-1, -1));
+    EXPECT_EQ(-1, *index.find(-1));
+}
+
+POCINDEX_TEST(ReleaseErased)
+{
+    std::shared_ptr<int> p(new int(1));
+    PocIndex<std::shared_ptr<int> > index;
+    index.insert(1, p);
+    EXPECT_EQ(2, p.use_count());
+    index.erase(1);
+    EXPECT_EQ(1, p.use_count());
+}
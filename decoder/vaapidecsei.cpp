@@ -0,0 +1,136 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "vaapidecsei.h"
+
+#include "VideoDecoderDefs.h"
+#include <string.h>
+
+namespace YamiMediaCodec {
+
+using namespace YamiParser;
+
+VaapiDecSei::VaapiDecSei()
+    : m_types(0)
+{
+    memset(&m_info, 0, sizeof(m_info));
+}
+
+void VaapiDecSei::setFlags(uint32_t flags)
+{
+    m_types = 0;
+    if (flags & HAS_SEI_RECOVERY_POINT)
+        m_types |= VIDEO_SEI_RECOVERY_POINT;
+    if (flags & HAS_SEI_TIME_CODE)
+        m_types |= VIDEO_SEI_TIME_CODE;
+    if (flags & HAS_SEI_MASTERING_DISPLAY)
+        m_types |= VIDEO_SEI_MASTERING_DISPLAY;
+    if (flags & HAS_SEI_CONTENT_LIGHT_LEVEL)
+        m_types |= VIDEO_SEI_CONTENT_LIGHT_LEVEL;
+    reset();
+}
+
+bool VaapiDecSei::wants(uint32_t payloadType) const
+{
+    switch (payloadType) {
+    case SEI_RECOVERY_POINT:
+        return m_types & VIDEO_SEI_RECOVERY_POINT;
+    case SEI_PIC_TIMING:
+    case SEI_TIME_CODE:
+        return m_types & VIDEO_SEI_TIME_CODE;
+    case SEI_MASTERING_DISPLAY_COLOUR_VOLUME:
+        return m_types & VIDEO_SEI_MASTERING_DISPLAY;
+    case SEI_CONTENT_LIGHT_LEVEL_INFO:
+        return m_types & VIDEO_SEI_CONTENT_LIGHT_LEVEL;
+    default:
+        return false;
+    }
+}
+
+bool VaapiDecSei::decode(const SeiMessage& message)
+{
+    if (message.payloadType == SEI_MASTERING_DISPLAY_COLOUR_VOLUME) {
+        SeiMasteringDisplayColourVolume mdcv;
+        if (!parseMasteringDisplayColourVolume(&mdcv, message))
+            return false;
+        for (int c = 0; c < 3; c++) {
+            m_info.masteringDisplay.primariesX[c] = mdcv.display_primaries_x[c];
+            m_info.masteringDisplay.primariesY[c] = mdcv.display_primaries_y[c];
+        }
+        m_info.masteringDisplay.whitePointX = mdcv.white_point_x;
+        m_info.masteringDisplay.whitePointY = mdcv.white_point_y;
+        m_info.masteringDisplay.maxLuminance = mdcv.max_display_mastering_luminance;
+        m_info.masteringDisplay.minLuminance = mdcv.min_display_mastering_luminance;
+        m_info.present |= VIDEO_SEI_MASTERING_DISPLAY;
+        return true;
+    }
+    if (message.payloadType == SEI_CONTENT_LIGHT_LEVEL_INFO) {
+        SeiContentLightLevelInfo cll;
+        if (!parseContentLightLevelInfo(&cll, message))
+            return false;
+        m_info.contentLightLevel.maxContentLightLevel = cll.max_content_light_level;
+        m_info.contentLightLevel.maxPicAverageLightLevel = cll.max_pic_average_light_level;
+        m_info.present |= VIDEO_SEI_CONTENT_LIGHT_LEVEL;
+        return true;
+    }
+    return false;
+}
+
+void VaapiDecSei::setRecoveryPoint(int32_t recoveryCount, bool exactMatch, bool brokenLink)
+{
+    m_info.recoveryPoint.recoveryCount = recoveryCount;
+    m_info.recoveryPoint.exactMatch = exactMatch;
+    m_info.recoveryPoint.brokenLink = brokenLink;
+    m_info.present |= VIDEO_SEI_RECOVERY_POINT;
+}
+
+void VaapiDecSei::setTimeCode(const SeiClockTimestamp& ts)
+{
+    /* the fields not sent keep the value of the last time code */
+    if (ts.seconds_flag)
+        m_info.timeCode.seconds = ts.seconds_value;
+    if (ts.minutes_flag)
+        m_info.timeCode.minutes = ts.minutes_value;
+    if (ts.hours_flag)
+        m_info.timeCode.hours = ts.hours_value;
+    m_info.timeCode.frames = ts.n_frames;
+    m_info.timeCode.countingType = ts.counting_type;
+    m_info.timeCode.dropFrame = ts.cnt_dropped_flag;
+    m_info.timeCode.discontinuity = ts.discontinuity_flag;
+    m_info.timeCode.timeOffset = ts.time_offset_value;
+    m_info.present |= VIDEO_SEI_TIME_CODE;
+}
+
+SharedPtr<VideoSeiInfo> VaapiDecSei::take()
+{
+    SharedPtr<VideoSeiInfo> info;
+    if (!m_info.present)
+        return info;
+    info.reset(new VideoSeiInfo(m_info));
+    m_info.present = 0;
+    return info;
+}
+
+void VaapiDecSei::reset()
+{
+    memset(&m_info, 0, sizeof(m_info));
+}
+
+} //namespace YamiMediaCodec
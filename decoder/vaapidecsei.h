@@ -0,0 +1,66 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef vaapidecsei_h
+#define vaapidecsei_h
+
+#include "codecparsers/seiParser.h"
+#include "common/common_def.h"
+#include "common/NonCopyable.h"
+#include "VideoCommonDefs.h"
+
+namespace YamiMediaCodec {
+
+/**
+ * \class VaapiDecSei
+ * \brief sei messages of one access unit, for the h264 and h265 decoder
+ * <pre>
+ * the decoder asks wants() for every message header, and only decodes the
+ * payload types set by HAS_SEI_XXX of VideoConfigBuffer. take() hands the
+ * collected messages to the next picture. Nothing is allocated if no flag
+ * is set or no message found.
+ * </pre>
+ */
+class VaapiDecSei {
+public:
+    VaapiDecSei();
+
+    /* HAS_SEI_XXX of VideoConfigBuffer.flag */
+    void setFlags(uint32_t flags);
+    bool enabled() const { return m_types; }
+    bool wants(uint32_t payloadType) const;
+
+    /* the payload types h264 and h265 code in the same way */
+    bool decode(const YamiParser::SeiMessage&);
+
+    void setRecoveryPoint(int32_t recoveryCount, bool exactMatch, bool brokenLink);
+    void setTimeCode(const YamiParser::SeiClockTimestamp&);
+
+    /* info for the current picture, null if nothing collected since last take */
+    SharedPtr<VideoSeiInfo> take();
+    void reset();
+
+private:
+    /* VIDEO_SEI_XXX asked by the client */
+    uint32_t m_types;
+    VideoSeiInfo m_info;
+
+    DISALLOW_COPY_AND_ASSIGN(VaapiDecSei);
+};
+
+} //namespace YamiMediaCodec
+
+#endif //vaapidecsei_h
@@ -57,25 +57,33 @@ bool VaapiDecSurfacePool::init(const DisplayPtr& display, VideoConfigBuffer* con
     uint32_t fourcc = config->fourcc;
 
     m_renderBuffers.resize(size);
+    m_output.resize(size);
+    std::vector<Slot> slots(size);
+    m_slots.swap(slots);
+    m_freed.init(size);
     for (uint32_t i = 0; i < size; i++) {
         SurfacePtr s(new VaapiSurface(m_allocParams.surfaces[i], width, height, fourcc));
-        VASurfaceID id = s->getID();
 
-        m_renderBuffers[i].display = m_display->getID();
-        m_renderBuffers[i].surface = id;
+        //no display for fake surfaces, like in the benchmark
+        m_renderBuffers[i].display = m_display ? m_display->getID() : NULL;
+        m_renderBuffers[i].surface = s->getID();
         m_renderBuffers[i].timeStamp = 0;
 
-        m_renderMap[id] = &m_renderBuffers[i];
-        m_surfaceMap[id] = s.get();
-        m_freed.push_back(id);
-        m_surfaces.push_back(s);
+        m_slots[i].surface = s;
+        m_slots[i].state = SURFACE_FREE;
+        m_freed.push(i);
     }
     return true;
 }
 
 VaapiDecSurfacePool::VaapiDecSurfacePool()
-    :m_cond(m_lock),
-    m_flushing(false)
+    : m_allocated(0)
+    , m_outputHead(0)
+    , m_outputSize(0)
+    , m_surfaceBlocks(new BlockPool)
+    , m_cond(m_lock)
+    , m_flushing(false)
+    , m_waiting(false)
 {
     memset(&m_allocParams, 0, sizeof(m_allocParams));
 }
@@ -98,75 +106,149 @@ void VaapiDecSurfacePool::getSurfaceIDs(std::vector<VASurfaceID>& ids)
         ids.push_back(m_renderBuffers[i].surface);
 }
 
+void VaapiDecSurfacePool::FreeRing::init(uint32_t size)
+{
+    uint32_t capacity = 1;
+    while (capacity < size)
+        capacity <<= 1;
+    std::vector<Cell> cells(capacity);
+    m_cells.swap(cells);
+    for (uint32_t i = 0; i < capacity; i++)
+        m_cells[i].sequence = i;
+    m_mask = capacity - 1;
+    m_tail = 0;
+    m_head = 0;
+}
+
+void VaapiDecSurfacePool::FreeRing::push(uint32_t index)
+{
+    uint32_t pos = m_tail.fetch_add(1);
+    Cell& cell = m_cells[pos & m_mask];
+    //the cell was consumed, since the ring holds no more than the pool size
+    assert(cell.sequence.load(std::memory_order_acquire) == pos);
+    cell.index = index;
+    cell.sequence.store(pos + 1);
+}
+
+bool VaapiDecSurfacePool::FreeRing::pop(uint32_t& index)
+{
+    Cell& cell = m_cells[m_head & m_mask];
+    //empty, or the producer of this cell has not finished
+    if (cell.sequence.load() != m_head + 1)
+        return false;
+    index = cell.index;
+    cell.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+    m_head++;
+    return true;
+}
+
 struct VaapiDecSurfacePool::SurfaceRecycler
 {
-    SurfaceRecycler(const DecSurfacePoolPtr& pool): m_pool(pool) {}
-    void operator()(VaapiSurface* surface) { m_pool->recycle(surface->getID(), SURFACE_DECODING);}
+    SurfaceRecycler(const DecSurfacePoolPtr& pool, uint32_t index): m_pool(pool), m_index(index) {}
+    void operator()(VaapiSurface* surface) { m_pool->recycle(m_index, SURFACE_DECODING);}
+    uint32_t getIndex() const { return m_index; }
 private:
     DecSurfacePoolPtr m_pool;
+    uint32_t m_index;
 };
 
-SurfacePtr VaapiDecSurfacePool::acquireWithWait()
+bool VaapiDecSurfacePool::FreeRing::empty() const
 {
-    SurfacePtr surface;
-    AutoLock lock(m_lock);
-    while (m_freed.empty() && !m_flushing) {
-        DEBUG("wait because there is no available surface from pool");
-        m_cond.wait();
+    return m_cells[m_head & m_mask].sequence.load() != m_head + 1;
+}
+
+bool VaapiDecSurfacePool::waitFree(uint32_t& index)
+{
+    while (!m_flushing) {
+        if (m_freed.pop(index))
+            return true;
+        AutoLock lock(m_lock);
+        //recycle() signals only if it sees m_waiting, check again after setting it
+        m_waiting = true;
+        if (!m_flushing && m_freed.empty()) {
+            DEBUG("wait because there is no available surface from pool");
+            m_cond.wait();
+        }
+        m_waiting = false;
     }
+    return false;
+}
 
-    if (m_flushing) {
+SurfacePtr VaapiDecSurfacePool::acquireWithWait()
+{
+    SurfacePtr surface;
+    uint32_t index;
+    if (!waitFree(index)) {
         DEBUG("input flushing, return nil surface");
         return surface;
     }
 
-    assert(!m_freed.empty());
-    VASurfaceID id = m_freed.front();
-    m_freed.pop_front();
-    m_allocated[id] = SURFACE_DECODING;
-    VaapiSurface* s = m_surfaceMap[id];
-    surface.reset(s, SurfaceRecycler(shared_from_this()));
+    Slot& slot = m_slots[index];
+    assert(slot.state == SURFACE_FREE);
+    slot.state = SURFACE_DECODING;
+    m_allocated++;
+    surface.reset(slot.surface.get(), SurfaceRecycler(shared_from_this(), index),
+        BlockAllocator<VaapiSurface>(m_surfaceBlocks));
     return surface;
 }
 
-bool VaapiDecSurfacePool::output(const SurfacePtr& surface, int64_t timeStamp)
+bool VaapiDecSurfacePool::output(const SurfacePtr& surface, int64_t timeStamp,
+    const SharedPtr<VideoSeiInfo>& sei)
 {
-    VASurfaceID id = surface->getID();
-
-    AutoLock lock(m_lock);
-    const Allocated::iterator it = m_allocated.find(id);
-    if (it == m_allocated.end())
+    //surfaces of the pool carry their slot in the deleter
+    const SurfaceRecycler* recycler = std::get_deleter<SurfaceRecycler>(surface);
+    if (!recycler)
         return false;
-    assert(it->second == SURFACE_DECODING);
-    it->second |= SURFACE_TO_RENDER;
-    VideoRenderBuffer* buffer = m_renderMap[id];
+    uint32_t index = recycler->getIndex();
+    uint32_t state = m_slots[index].state.fetch_or(SURFACE_TO_RENDER);
+    assert(state == SURFACE_DECODING);
+    (void)state;
+    VideoRenderBuffer* buffer = &m_renderBuffers[index];
 
     VideoRect& crop = buffer->crop;
     surface->getCrop(crop.x, crop.y, crop.width, crop.height);
     buffer->fourcc = surface->getFourcc();
 
     buffer->timeStamp = timeStamp;
+    buffer->sei = sei;
     DEBUG("surface=0x%x is output-able with timeStamp=%ld", surface->getID(), timeStamp);
-    m_output.push_back(buffer);
+    AutoLock lock(m_lock);
+    assert(m_outputSize < m_output.size());
+    m_output[(m_outputHead + m_outputSize++) % m_output.size()] = buffer;
     return true;
 }
 
 VideoRenderBuffer* VaapiDecSurfacePool::getOutput()
 {
-    AutoLock lock(m_lock);
-    if (m_output.empty())
-        return NULL;
-    VideoRenderBuffer* buffer = m_output.front();
-    m_output.pop_front();
-    const Allocated::iterator it = m_allocated.find(buffer->surface);
-    assert(it != m_allocated.end());
-    assert(it->second & SURFACE_TO_RENDER);
-    assert(!(it->second & SURFACE_RENDERING));
+    VideoRenderBuffer* buffer;
+    {
+        AutoLock lock(m_lock);
+        if (!m_outputSize)
+            return NULL;
+        buffer = m_output[m_outputHead];
+        m_outputHead = (m_outputHead + 1) % m_output.size();
+        m_outputSize--;
+    }
     //clear SURFACE_TO_RENDER and set SURFACE_RENDERING
-    it->second ^= SURFACE_RENDERING | SURFACE_TO_RENDER;
+    uint32_t state = m_slots[buffer - &m_renderBuffers[0]].state.fetch_xor(SURFACE_RENDERING | SURFACE_TO_RENDER);
+    assert(state & SURFACE_TO_RENDER);
+    assert(!(state & SURFACE_RENDERING));
+    (void)state;
     return buffer;
 }
 
+const VideoSeiInfo* VaapiDecSurfacePool::getSei(VASurfaceID surface) const
+{
+    //the buffer keeps its sei until the next output of the slot, which
+    //comes only after the client recycles it
+    for (size_t i = 0; i < m_renderBuffers.size(); i++) {
+        const VideoRenderBuffer& buffer = m_renderBuffers[i];
+        if (buffer.surface == surface && (m_slots[i].state & SURFACE_RENDERING))
+            return buffer.sei.get();
+    }
+    return NULL;
+}
+
 struct VaapiDecSurfacePool::SurfaceRecyclerRender
 {
     SurfaceRecyclerRender(const DecSurfacePoolPtr& pool, VideoRenderBuffer* buffer): m_pool(pool), m_buffer(buffer) {}
@@ -181,46 +263,49 @@ void VaapiDecSurfacePool::setWaitable(bool waitable)
     m_flushing = !waitable;
 
     if (!waitable) {
+        AutoLock lock(m_lock);
         m_cond.signal();
     }
 }
 
 void VaapiDecSurfacePool::flush()
 {
-    AutoLock lock(m_lock);
-    for (OutputQueue::iterator it = m_output.begin();
-        it != m_output.end(); ++it) {
-        recycleLocked((*it)->surface, SURFACE_TO_RENDER);
+    std::vector<VideoRenderBuffer*> output;
+    {
+        AutoLock lock(m_lock);
+        for (; m_outputSize; m_outputSize--) {
+            output.push_back(m_output[m_outputHead]);
+            m_outputHead = (m_outputHead + 1) % m_output.size();
+        }
     }
-    m_output.clear();
-    //still have unreleased surface
-    if (!m_allocated.empty())
-        m_flushing = true;
+    //set before recycling, so the last recycle() clears it
+    m_flushing = true;
+    for (size_t i = 0; i < output.size(); i++)
+        recycle(output[i] - &m_renderBuffers[0], SURFACE_TO_RENDER);
+    //no unreleased surface
+    if (!m_allocated)
+        m_flushing = false;
 }
 
-void VaapiDecSurfacePool::recycleLocked(VASurfaceID id, SurfaceState flag)
+void VaapiDecSurfacePool::recycle(uint32_t index, SurfaceState flag)
 {
-    const Allocated::iterator it = m_allocated.find(id);
-    if (it == m_allocated.end()) {
-        ERROR("try to recycle %u from state %d, it's not an allocated buffer", id, flag);
+    uint32_t state = m_slots[index].state.fetch_and(~flag);
+    if (!(state & flag)) {
+        ERROR("try to recycle %u from state %d, it's not an allocated buffer",
+            m_renderBuffers[index].surface, flag);
         return;
     }
-    it->second &= ~flag;
-    if (it->second == SURFACE_FREE) {
-        m_allocated.erase(it);
-        m_freed.push_back(id);
-        if (m_flushing && m_allocated.size() == 0)
-            m_flushing = false;
+    if (state != (uint32_t)flag)
+        return;
+    m_freed.push(index);
+    if (!--m_allocated)
+        m_flushing = false;
+    if (m_waiting) {
+        AutoLock lock(m_lock);
         m_cond.signal();
     }
 }
 
-void VaapiDecSurfacePool::recycle(VASurfaceID id, SurfaceState flag)
-{
-    AutoLock lock(m_lock);
-    recycleLocked(id,flag);
-}
-
 void VaapiDecSurfacePool::recycle(const VideoRenderBuffer * renderBuf)
 {
     if (renderBuf < &m_renderBuffers[0]
@@ -228,7 +313,7 @@ void VaapiDecSurfacePool::recycle(const VideoRenderBuffer * renderBuf)
         ERROR("recycle invalid render buffer");
         return;
     }
-    recycle(renderBuf->surface, SURFACE_RENDERING);
+    recycle(renderBuf - &m_renderBuffers[0], SURFACE_RENDERING);
 }
 
 } //namespace YamiMediaCodec
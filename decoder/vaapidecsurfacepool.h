@@ -21,11 +21,11 @@
 #include "common/condition.h"
 #include "common/common_def.h"
 #include "common/lock.h"
+#include "common/objectpool.h"
 #include "vaapi/vaapiptrs.h"
 #include "VideoCommonDefs.h"
 #include "VideoDecoderDefs.h"
-#include <deque>
-#include <map>
+#include <atomic>
 #include <vector>
 #include <va/va.h>
 
@@ -37,6 +37,7 @@ typedef struct {
     int64_t timeStamp; // presentation time stamp
     VideoRect crop;
     uint32_t fourcc;
+    SharedPtr<VideoSeiInfo> sei;
 } VideoRenderBuffer;
 
 /***
@@ -53,6 +54,9 @@ typedef struct {
  *  if no flag is set, the buffer/surface can be reused -- associate with a new VaapiPicture
  * 2. the free surface is in a first-in-first-out queue to be friendly to graphics fence
  * 3. most functions in this class do not support multithread except recycle.
+ *    recycle does not take the lock: the state is atomic in the slot of the surface,
+ *    and freed slots go to a ring with many producers and one consumer.
+ *    acquireWithWait is the only consumer, it takes the lock only to wait.
  * 4. flush need called in decoder thread and it will make all following acuireWithWait return null surface.
  *    until all surface recycled.
  *</pre>
@@ -67,9 +71,12 @@ public:
     /// it always return null buffer if it's flushed.
     SurfacePtr acquireWithWait();
     /// push surface to output queue
-    bool output(const SurfacePtr&, int64_t timetamp);
+    bool output(const SurfacePtr&, int64_t timetamp,
+        const SharedPtr<VideoSeiInfo>& sei = SharedPtr<VideoSeiInfo>());
     /// get surface from output queue
     VideoRenderBuffer* getOutput();
+    /// sei of a surface given out by getOutput and not recycled yet, or null
+    const VideoSeiInfo* getSei(VASurfaceID surface) const;
     /// recycle to surface pool
     void recycle(const VideoRenderBuffer * renderBuf);
     /// recycle exported video frame to surface/image pool
@@ -96,30 +103,61 @@ private:
               VideoConfigBuffer* config,
               const SharedPtr<SurfaceAllocator>& allocator);
 
-    void recycleLocked(VASurfaceID, SurfaceState);
-    void recycle(VASurfaceID, SurfaceState);
+    bool waitFree(uint32_t& index);
+    void recycle(uint32_t index, SurfaceState);
+
+    /* a surface of the pool, m_renderBuffers[i] is for m_slots[i] */
+    struct Slot {
+        SurfacePtr surface;
+        std::atomic<uint32_t> state;
+    };
+
+    /* bounded ring of free slot indexes, recycle() is the producer and
+     * acquireWithWait() is the consumer. It never holds more than the pool
+     * size, so push() always has room. */
+    class FreeRing {
+    public:
+        void init(uint32_t size);
+        void push(uint32_t index);
+        bool pop(uint32_t& index);
+        bool empty() const;
+
+    private:
+        struct Cell {
+            //the position the cell is ready for, position + 1 when it has data
+            std::atomic<uint32_t> sequence;
+            uint32_t index;
+        };
+        std::vector<Cell> m_cells;
+        uint32_t m_mask;
+        std::atomic<uint32_t> m_tail;
+        //only the consumer touches it
+        uint32_t m_head;
+    };
 
     //following member only change in constructor.
     DisplayPtr m_display;
     std::vector<VideoRenderBuffer> m_renderBuffers;
-    std::vector<SurfacePtr> m_surfaces;
-    typedef std::map<VASurfaceID, VideoRenderBuffer*> RenderMap;
-    RenderMap m_renderMap;
-    typedef std::map<VASurfaceID, VaapiSurface*> SurfaceMap;
-    SurfaceMap m_surfaceMap;
+    std::vector<Slot> m_slots;
 
     //free and allocted.
-    std::deque<VASurfaceID> m_freed;
-    typedef std::map<VASurfaceID, uint32_t> Allocated;
-    Allocated m_allocated;
+    FreeRing m_freed;
+    std::atomic<uint32_t> m_allocated;
+
+    /* output queue, a ring of m_renderBuffers.size() since a surface
+     * is queued once at most. Guarded by m_lock */
+    std::vector<VideoRenderBuffer*> m_output;
+    uint32_t m_outputHead;
+    uint32_t m_outputSize;
 
-    /* output queue*/
-    typedef std::deque<VideoRenderBuffer*> OutputQueue;
-    OutputQueue m_output;
+    /* control blocks of the SurfacePtr given by acquireWithWait */
+    SharedPtr<BlockPool> m_surfaceBlocks;
 
     Lock m_lock;
     Condition m_cond;
-    bool m_flushing;
+    std::atomic<bool> m_flushing;
+    //acquireWithWait is waiting on m_cond
+    std::atomic<bool> m_waiting;
 
     //for external allocator
     SharedPtr<SurfaceAllocator> m_allocator;
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// primary header
+#include "vaapidecsurfacepool.h"
+
+// library headers
+#include "vaapi/VaapiSurface.h"
+
+// system libraries
+#include <atomic>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+using namespace YamiMediaCodec;
+
+/* the pool never touches the surfaces, fake ids are enough to run
+ * without a gpu */
+static const intptr_t FAKE_SURFACE_BASE = 0x1000;
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static YamiStatus fakeAlloc(SurfaceAllocator*, SurfaceAllocParams* params)
+{
+    params->surfaces = new intptr_t[params->size];
+    for (uint32_t i = 0; i < params->size; i++)
+        params->surfaces[i] = FAKE_SURFACE_BASE + i;
+    return YAMI_SUCCESS;
+}
+
+static YamiStatus fakeFree(SurfaceAllocator*, SurfaceAllocParams* params)
+{
+    delete[] params->surfaces;
+    params->surfaces = NULL;
+    return YAMI_SUCCESS;
+}
+
+static void fakeUnref(SurfaceAllocator*)
+{
+}
+
+struct Bench {
+    DecSurfacePoolPtr pool;
+    uint32_t frames;
+    std::atomic<bool> decodeDone;
+    /* frames a render thread holds before recycling, like a display queue */
+    uint32_t holdFrames;
+};
+
+/* acquire, output and drop, like a decoder with no reference */
+static void* decodeThread(void* arg)
+{
+    Bench* bench = (Bench*)arg;
+    for (uint32_t i = 0; i < bench->frames; i++) {
+        SurfacePtr surface = bench->pool->acquireWithWait();
+        if (!surface) {
+            fprintf(stderr, "acquire failed at frame %u\n", i);
+            break;
+        }
+        bench->pool->output(surface, i);
+    }
+    bench->decodeDone = true;
+    return NULL;
+}
+
+/* get output frames and recycle them from this thread */
+static void* renderThread(void* arg)
+{
+    Bench* bench = (Bench*)arg;
+    std::vector<VideoRenderBuffer*> held;
+    while (true) {
+        //no more output once decoding is done and the queue is empty
+        bool done = bench->decodeDone;
+        VideoRenderBuffer* buffer = bench->pool->getOutput();
+        if (!buffer) {
+            if (done)
+                break;
+            //let the decoder run
+            if (held.size()) {
+                bench->pool->recycle(held.front());
+                held.erase(held.begin());
+            } else {
+                sched_yield();
+            }
+            continue;
+        }
+        held.push_back(buffer);
+        if (held.size() > bench->holdFrames) {
+            bench->pool->recycle(held.front());
+            held.erase(held.begin());
+        }
+    }
+    for (size_t i = 0; i < held.size(); i++)
+        bench->pool->recycle(held[i]);
+    return NULL;
+}
+
+/* all in one thread, the cost of the pool without contention */
+static void* decodeAndRenderThread(void* arg)
+{
+    Bench* bench = (Bench*)arg;
+    for (uint32_t i = 0; i < bench->frames; i++) {
+        SurfacePtr surface = bench->pool->acquireWithWait();
+        bench->pool->output(surface, i);
+        surface.reset();
+        bench->pool->recycle(bench->pool->getOutput());
+    }
+    return NULL;
+}
+
+/* renderThreads is 0 for decodeAndRenderThread */
+static double measure(uint32_t poolSize, uint32_t renderThreads, uint32_t frames)
+{
+    SharedPtr<SurfaceAllocator> allocator(new SurfaceAllocator);
+    allocator->user = NULL;
+    allocator->alloc = fakeAlloc;
+    allocator->free = fakeFree;
+    allocator->unref = fakeUnref;
+
+    VideoConfigBuffer config;
+    memset(&config, 0, sizeof(config));
+    config.surfaceWidth = 1920;
+    config.surfaceHeight = 1088;
+    config.fourcc = YAMI_FOURCC_NV12;
+    config.surfaceNumber = poolSize;
+
+    Bench bench;
+    bench.pool = VaapiDecSurfacePool::create(DisplayPtr(), &config, allocator);
+    bench.frames = frames;
+    bench.decodeDone = false;
+    bench.holdFrames = poolSize / (renderThreads + 1);
+    if (!bench.pool) {
+        fprintf(stderr, "create pool failed\n");
+        return 0;
+    }
+
+    uint64_t start = nowNs();
+    pthread_t decoder;
+    std::vector<pthread_t> renders(renderThreads);
+    pthread_create(&decoder, NULL, renderThreads ? decodeThread : decodeAndRenderThread, &bench);
+    for (uint32_t i = 0; i < renderThreads; i++)
+        pthread_create(&renders[i], NULL, renderThread, &bench);
+    pthread_join(decoder, NULL);
+    for (uint32_t i = 0; i < renderThreads; i++)
+        pthread_join(renders[i], NULL);
+    uint64_t ns = nowNs() - start;
+    return (double)ns / frames;
+}
+
+int main()
+{
+    static const uint32_t poolSizes[] = { 8, 24 };
+    static const uint32_t threads[] = { 0, 1, 2, 4 };
+    const uint32_t frames = 200000;
+
+    printf("%10s %10s %14s\n", "surfaces", "renders", "ns/frame");
+    for (size_t p = 0; p < sizeof(poolSizes) / sizeof(poolSizes[0]); p++) {
+        for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+            printf("%10u %10u %14.1f\n", poolSizes[p], threads[t],
+                measure(poolSizes[p], threads[t], frames));
+        }
+    }
+    return 0;
+}
@@ -49,6 +49,7 @@ using std::vector;
 #define H264_FRAME_FR 172
 #define H264_MIN_CR 2
 #define H264_NAL_START_CODE 0x000001
+#define H264_MAX_SLICE_HEADER_SIZE 0x1000
 
 #define VAAPI_ENCODER_H264_NAL_REF_IDC_NONE        0
 #define VAAPI_ENCODER_H264_NAL_REF_IDC_LOW         1
@@ -192,34 +193,13 @@ static uint8_t h264_get_profile_idc(VideoProfile profile)
 BOOL
 bit_writer_put_ue(BitWriter *bitwriter, uint32_t value)
 {
-    uint32_t  size_in_bits = 0;
-    uint32_t  tmp_value = ++value;
-
-    while (tmp_value) {
-        ++size_in_bits;
-        tmp_value >>= 1;
-    }
-    if (size_in_bits > 1
-        && !bitwriter->writeBits(0, size_in_bits - 1))
-        return FALSE;
-    if (!bitwriter->writeBits(value, size_in_bits))
-        return FALSE;
-    return TRUE;
+    return bitwriter->writeUe(value);
 }
 
 BOOL
 bit_writer_put_se(BitWriter *bitwriter, int32_t value)
 {
-    uint32_t new_val;
-
-    if (value <= 0)
-        new_val = -(value<<1);
-    else
-        new_val = (value<<1) - 1;
-
-    if (!bit_writer_put_ue(bitwriter, new_val))
-        return FALSE;
-    return TRUE;
+    return bitwriter->writeSe(value);
 }
 
 
@@ -1541,9 +1521,15 @@ bool VaapiEncoderH264::addPackedSliceHeader(
     const PicturePtr& picture,
     const VAEncSliceParameterBufferH264* const sliceParam) const
 {
-    bool ret = true;
     uint32_t i = 0;
-    BitWriter bs;
+    uint8_t* data;
+    uint32_t* bitSize;
+
+    /* write the header to the mapped va buffer directly */
+    if (!picture->newPackedHeader(VAEncPackedHeaderSlice,
+                                  H264_MAX_SLICE_HEADER_SIZE, data, bitSize))
+        return false;
+    BitWriter bs(data, H264_MAX_SLICE_HEADER_SIZE);
     bs.writeBits(H264_NAL_START_CODE, 32);
 
     if (sliceParam->slice_type == H264_SLICE_TYPE_I) {
@@ -1693,15 +1679,11 @@ bool VaapiEncoderH264::addPackedSliceHeader(
         bs.writeToBytesAligned(true);
     }
 
-    uint8_t* codedData = bs.getBitWriterData();
-    ASSERT(codedData);
-
-    if (!picture->addPackedHeader(VAEncPackedHeaderSlice, codedData,
-                                  bs.getCodedBitsCount())) {
-        ret = false;
-    }
+    if (!bs.getBitWriterData())
+        return false;
+    *bitSize = bs.getCodedBitsCount();
 
-    return ret;
+    return true;
 }
 
 /* Adds slice headers to picture */
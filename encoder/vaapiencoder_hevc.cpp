@@ -46,6 +46,7 @@ using std::deque;
 #define MAX_IDR_PERIOD 2000
 
 #define HEVC_NAL_START_CODE 0x000001
+#define HEVC_MAX_SLICE_HEADER_SIZE 0x1000
 
 #define HEVC_SLICE_TYPE_I            2
 #define HEVC_SLICE_TYPE_P           1
@@ -166,34 +167,13 @@ static uint8_t hevc_get_profile_idc(VideoProfile profile)
 static BOOL
 bit_writer_put_ue(BitWriter *bitwriter, uint32_t value)
 {
-    uint32_t  size_in_bits = 0;
-    uint32_t  tmp_value = ++value;
-
-    while (tmp_value) {
-        ++size_in_bits;
-        tmp_value >>= 1;
-    }
-    if (size_in_bits > 1
-        && !bitwriter->writeBits(0, size_in_bits - 1))
-        return FALSE;
-    if (!bitwriter->writeBits(value, size_in_bits))
-        return FALSE;
-    return TRUE;
+    return bitwriter->writeUe(value);
 }
 
 static BOOL
 bit_writer_put_se(BitWriter *bitwriter, int32_t value)
 {
-    uint32_t new_val;
-
-    if (value <= 0)
-        new_val = -(value<<1);
-    else
-        new_val = (value<<1) - 1;
-
-    if (!bit_writer_put_ue(bitwriter, new_val))
-        return FALSE;
-    return TRUE;
+    return bitwriter->writeSe(value);
 }
 
 static BOOL
@@ -1498,8 +1478,14 @@ bool VaapiEncoderHEVC::addPackedSliceHeader(const PicturePtr& picture,
                                         const VAEncSliceParameterBufferHEVC* const sliceParam,
                                         uint32_t sliceIndex) const
 {
-    bool ret = true;
-    BitWriter bs;
+    uint8_t* data;
+    uint32_t* bitSize;
+
+    /* write the header to the mapped va buffer directly */
+    if (!picture->newPackedHeader(VAEncPackedHeaderSlice,
+                                  HEVC_MAX_SLICE_HEADER_SIZE, data, bitSize))
+        return false;
+    BitWriter bs(data, HEVC_MAX_SLICE_HEADER_SIZE);
     BOOL short_term_ref_pic_set_sps_flag = !!m_shortRFS.num_short_term_ref_pic_sets;
     HevcNalUnitType nalUnitType = (picture->isIdr() ? IDR_W_RADL : TRAIL_R );
     bs.writeBits(HEVC_NAL_START_CODE, 32);
@@ -1569,14 +1555,11 @@ bool VaapiEncoderHEVC::addPackedSliceHeader(const PicturePtr& picture,
 
     bit_writer_write_trailing_bits(&bs);
 
-    uint8_t* codedData = bs.getBitWriterData();
-    ASSERT(codedData);
-
-    if (!picture->addPackedHeader(VAEncPackedHeaderSlice, codedData, bs.getCodedBitsCount())) {
-        ret = false;
-    }
+    if (!bs.getBitWriterData())
+        return false;
+    *bitSize = bs.getCodedBitsCount();
 
-    return ret;
+    return true;
 }
 
 /* Add slice headers to picture */
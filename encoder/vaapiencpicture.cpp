@@ -75,6 +75,29 @@ addPackedHeader(VAEncPackedHeaderType packedHeaderType, const void *header,
     return false;
 }
 
+bool VaapiEncPicture::
+newPackedHeader(VAEncPackedHeaderType packedHeaderType, uint32_t maxBytes,
+                uint8_t * &data, uint32_t * &headerBitSize)
+{
+    VAEncPackedHeaderParameterBuffer *packedHeader;
+    BufObjectPtr param =
+        createBufferObject(VAEncPackedHeaderParameterBufferType,
+                           packedHeader);
+    data = NULL;
+    BufObjectPtr dataObject =
+        createBufferObject(VAEncPackedHeaderDataBufferType,
+                           maxBytes, NULL, (void **) &data);
+    bool ret = addObject(m_packedHeaders, param, dataObject);
+    if (ret && packedHeader && data) {
+        packedHeader->type = packedHeaderType;
+        packedHeader->bit_length = 0;
+        packedHeader->has_emulation_bytes = 0;
+        headerBitSize = &packedHeader->bit_length;
+        return true;
+    }
+    return false;
+}
+
 YamiStatus VaapiEncPicture::getOutput(VideoEncOutputBuffer* outBuffer)
 {
     ASSERT(outBuffer);
@@ -51,6 +51,11 @@ class VaapiEncPicture:public VaapiPicture {
     bool addPackedHeader(VAEncPackedHeaderType, const void *header,
                          uint32_t headerBitSize);
 
+    /* map a packed header data buffer with maxBytes to data, so the header
+     * can be written in place. set *headerBitSize before encode() */
+    bool newPackedHeader(VAEncPackedHeaderType, uint32_t maxBytes,
+                         uint8_t * &data, uint32_t * &headerBitSize);
+
     bool encode();
 
     // give subclass a chance to convert codec buffer to they wanted format.
@@ -222,6 +222,63 @@ typedef struct VideoRect
     uint32_t height;
 } VideoRect;
 
+// bits of VideoSeiInfo.present
+#define VIDEO_SEI_RECOVERY_POINT 0x01
+#define VIDEO_SEI_TIME_CODE 0x02
+#define VIDEO_SEI_MASTERING_DISPLAY 0x04
+#define VIDEO_SEI_CONTENT_LIGHT_LEVEL 0x08
+
+/**
+ * sei messages of the access unit a frame decoded from, see
+ * IVideoDecoder::getSei(). decoder only decodes the ones asked by
+ * HAS_SEI_XXX in VideoConfigBuffer
+ */
+typedef struct VideoSeiInfo {
+    /**
+     * VIDEO_SEI_XXX of the valid fields
+     */
+    uint32_t present;
+
+    struct {
+        // recovery_frame_cnt for h264, recovery_poc_cnt for h265
+        int32_t recoveryCount;
+        bool exactMatch;
+        bool brokenLink;
+    } recoveryPoint;
+
+    /**
+     * the first clock timestamp of h264 pic_timing or h265 time_code,
+     * fields not in the message keep the value of last one
+     */
+    struct {
+        uint8_t hours;
+        uint8_t minutes;
+        uint8_t seconds;
+        uint16_t frames;
+        uint8_t countingType;
+        bool dropFrame;
+        bool discontinuity;
+        int32_t timeOffset;
+    } timeCode;
+
+    /**
+     * chromaticity in units of 0.00002, luminance in units of 0.0001 cd/m2
+     */
+    struct {
+        uint16_t primariesX[3];
+        uint16_t primariesY[3];
+        uint16_t whitePointX;
+        uint16_t whitePointY;
+        uint32_t maxLuminance;
+        uint32_t minLuminance;
+    } masteringDisplay;
+
+    struct {
+        uint16_t maxContentLightLevel;
+        uint16_t maxPicAverageLightLevel;
+    } contentLightLevel;
+} VideoSeiInfo;
+
 /**
  * slim version of VideoFrameRawData, only useful information here
  * hope we can use this for decode, encode and vpp in final.
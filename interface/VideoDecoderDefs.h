@@ -33,6 +33,22 @@ typedef enum {
 
     // indicate whether profile field in the VideoConfigBuffer is valid
     HAS_VA_PROFILE = 0x08,
+
+    // set in the VideoConfigBuffer, VideoDecodeBuffer can be any chunk of the
+    // stream instead of whole nal units. only h264 and h265 support it now
+    HAS_CHUNKED_INPUT = 0x10,
+
+    // set in the VideoConfigBuffer, slice headers of one VideoDecodeBuffer
+    // are parsed on a few threads. only h264 and h265 support it now
+    HAS_PARALLEL_SLICE_PARSING = 0x20,
+
+    // set in the VideoConfigBuffer, decode the sei message and give it by
+    // IVideoDecoder::getSei(). other sei messages are skipped without reading the
+    // payload. only h264 and h265 support it now
+    HAS_SEI_RECOVERY_POINT = 0x40,
+    HAS_SEI_TIME_CODE = 0x80,
+    HAS_SEI_MASTERING_DISPLAY = 0x100,
+    HAS_SEI_CONTENT_LIGHT_LEVEL = 0x200,
 } VIDEO_BUFFER_FLAG;
 
 typedef struct {
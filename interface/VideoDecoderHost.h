@@ -37,7 +37,20 @@ void releaseVideoDecoder(YamiMediaCodec::IVideoDecoder * p);
 */
 std::vector<std::string> getVideoDecoderMimeTypes();
 
+/** \fn YamiStatus probeVideoStream(const char *mimeType, const uint8_t *data, size_t size, VideoFormatInfo *info)
+ * \brief get the format of a stream without creating a decoder
+ *
+ * only the codec parser runs on data, libva is not touched. data is the same
+ * as VideoDecodeBuffer.data of decode(), h264 and h265 take annex b byte
+ * stream here. info gets what getFormatInfo() gives after
+ * YAMI_DECODE_FORMAT_CHANGE, surfaceNumber included.
+ * return YAMI_SUCCESS if info filled, YAMI_MORE_DATA if no sequence header
+ * in data, YAMI_UNSUPPORTED if the mime type can't be probed.
+ */
+YamiStatus probeVideoStream(const char *mimeType, const uint8_t *data, size_t size, VideoFormatInfo *info);
+
 typedef YamiMediaCodec::IVideoDecoder *(*YamiCreateVideoDecoderFuncPtr) (const char *mimeType);
 typedef void (*YamiReleaseVideoDecoderFuncPtr)(YamiMediaCodec::IVideoDecoder * p);
+typedef YamiStatus (*YamiProbeVideoStreamFuncPtr)(const char *mimeType, const uint8_t *data, size_t size, VideoFormatInfo *info);
 }
 #endif                          /* VIDEO_DECODER_HOST_H_ */
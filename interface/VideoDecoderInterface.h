@@ -68,6 +68,12 @@ public:
     /*deprecated*/
     ///do not use this, we will remove this in near future
     virtual VADisplay getDisplayID() = 0;
+
+    /** \brief sei messages asked by HAS_SEI_XXX flags for a frame of #getOutput.
+    * it is valid while the client holds the frame, NULL if nothing asked or found.
+    * added in yami api 0.2.13, VideoFrame is kept as it was for binary compatibility.
+    */
+    virtual const VideoSeiInfo* getSei(const VideoFrame* /*frame*/) { return NULL; }
 };
 }
 #endif                          /* VIDEO_DECODER_INTERFACE_H_ */
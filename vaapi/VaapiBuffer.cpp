@@ -24,26 +24,53 @@
 #include "vaapicontext.h"
 #include "vaapidisplay.h"
 
+#include <string.h>
+
 namespace YamiMediaCodec {
 
 BufObjectPtr VaapiBuffer::create(const ContextPtr& context,
     VABufferType type,
     uint32_t size,
     const void* data,
-    void** mapped)
+    void** mapped,
+    uint32_t numElements)
 {
     BufObjectPtr buf;
-    if (!size || !context || !context->getDisplay()){
+    if (!size || !numElements || !context || !context->getDisplay()){
         ERROR("vaapibuffer: can't create buffer");
         return buf;
     }
     DisplayPtr display = context->getDisplay();
     VABufferID id;
-    VAStatus status = vaCreateBuffer(display->getID(), context->getID(),
-        type, size, 1, (void*)data, &id);
-    if (!checkVaapiStatus(status, "vaCreateBuffer"))
-        return buf;
-    buf.reset(new VaapiBuffer(display, id, size));
+    const BufferRecyclerPtr& recycler = context->getBufferRecycler();
+    VaapiBufferRecycler::Key key;
+    if (recycler && VaapiBufferRecycler::getKey(type, size, numElements, key)) {
+        id = recycler->acquire(key);
+        if (id == VA_INVALID_ID)
+            return buf;
+        buf.reset(new VaapiBuffer(display, id, size * numElements));
+        buf->m_recycler = recycler;
+        buf->m_key = key;
+        //the buffer may hold the data of its last use, upload through a
+        //mapping, never through vaCreateBuffer
+        if (data) {
+            void* p = buf->map();
+            if (!p) {
+                buf.reset();
+                return buf;
+            }
+            memcpy(p, data, size * numElements);
+            if (!mapped)
+                buf->unmap();
+        }
+    }
+    else {
+        VAStatus status = vaCreateBuffer(display->getID(), context->getID(),
+            type, size, numElements, (void*)data, &id);
+        if (!checkVaapiStatus(status, "vaCreateBuffer"))
+            return buf;
+        buf.reset(new VaapiBuffer(display, id, size * numElements));
+    }
     if (mapped) {
         *mapped = buf->map();
         if (!*mapped)
@@ -92,6 +119,9 @@ VaapiBuffer::VaapiBuffer(const DisplayPtr& display, VABufferID id, uint32_t size
 VaapiBuffer::~VaapiBuffer()
 {
     unmap();
-    checkVaapiStatus(vaDestroyBuffer(m_display->getID(), m_id), "vaDestroyBuffer");
+    if (m_recycler)
+        m_recycler->release(m_key, m_id);
+    else
+        checkVaapiStatus(vaDestroyBuffer(m_display->getID(), m_id), "vaDestroyBuffer");
 }
 }
@@ -19,6 +19,7 @@
 
 #include "common/NonCopyable.h"
 #include "vaapiptrs.h"
+#include "vaapibufferrecycler.h"
 
 #include <va/va.h>
 #include <stdint.h>
@@ -27,15 +28,20 @@ namespace YamiMediaCodec {
 
 class VaapiBuffer {
 public:
+    /* size is the size of one element, a buffer can hold numElements
+     * of them, like the slice parameters of a whole picture.
+     * If the context recycles buffers, the buffer may be a reused one,
+     * its content is only defined where data is given. */
     static BufObjectPtr create(const ContextPtr&,
         VABufferType,
         uint32_t size,
         const void* data = 0,
-        void** mapped = 0);
+        void** mapped = 0,
+        uint32_t numElements = 1);
 
     template <class T>
     static BufObjectPtr create(const ContextPtr&,
-        VABufferType, T*& mapped);
+        VABufferType, T*& mapped, uint32_t numElements = 1);
 
     void* map();
     void unmap();
@@ -49,17 +55,20 @@ private:
     VABufferID m_id;
     void* m_data;
     uint32_t m_size;
+    //where the buffer goes back instead of vaDestroyBuffer, may be null
+    BufferRecyclerPtr m_recycler;
+    VaapiBufferRecycler::Key m_key;
     DISALLOW_COPY_AND_ASSIGN(VaapiBuffer);
 };
 
 template <class T>
 BufObjectPtr VaapiBuffer::create(const ContextPtr& context,
-    VABufferType type, T*& mapped)
+    VABufferType type, T*& mapped, uint32_t numElements)
 {
-    BufObjectPtr p = create(context, type, sizeof(T), NULL, (void**)&mapped);
+    BufObjectPtr p = create(context, type, sizeof(T), NULL, (void**)&mapped, numElements);
     if (p) {
         if (mapped) {
-            memset(mapped, 0, sizeof(T));
+            memset(mapped, 0, sizeof(T) * numElements);
         }
         else {
             //bug
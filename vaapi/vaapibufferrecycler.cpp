@@ -0,0 +1,195 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "vaapibufferrecycler.h"
+
+#include "VaapiUtils.h"
+#include "vaapidisplay.h"
+
+#include <algorithm>
+
+namespace YamiMediaCodec {
+
+//acquires between two trims of the free buffers
+static const uint32_t TRIM_PERIOD = 256;
+//smallest size class of slice data
+static const uint32_t MIN_DATA_SIZE = 4096;
+
+VaapiBufferRecycler::VaapiBufferRecycler(const DisplayPtr& display, VAContextID context)
+    : m_display(display)
+    , m_context(context)
+    , m_acquires(0)
+    , m_closed(false)
+{
+    m_counters.created = 0;
+    m_counters.destroyed = 0;
+    m_counters.reused = 0;
+}
+
+VaapiBufferRecycler::~VaapiBufferRecycler()
+{
+    close();
+}
+
+bool VaapiBufferRecycler::getKey(VABufferType type, uint32_t size,
+    uint32_t numElements, Key& key)
+{
+    switch (type) {
+    case VAPictureParameterBufferType:
+    case VAIQMatrixBufferType:
+    case VABitPlaneBufferType:
+    case VASliceParameterBufferType:
+    case VAHuffmanTableBufferType:
+    case VAProbabilityBufferType:
+        key.type = type;
+        key.size = size;
+        key.numElements = numElements;
+        return true;
+    case VASliceDataBufferType: {
+        uint64_t total = (uint64_t)size * numElements;
+        if (total > (1u << 31))
+            return false;
+        uint32_t classSize = MIN_DATA_SIZE;
+        while (classSize < total)
+            classSize <<= 1;
+        key.type = type;
+        key.size = classSize;
+        key.numElements = 1;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+VaapiBufferRecycler::Entry& VaapiBufferRecycler::getEntry(const Key& key)
+{
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        if (m_entries[i].key == key)
+            return m_entries[i];
+    }
+    Entry entry;
+    entry.key = key;
+    entry.inUse = 0;
+    entry.peak = 0;
+    entry.highWater = 0;
+    m_entries.push_back(entry);
+    return m_entries.back();
+}
+
+VABufferID VaapiBufferRecycler::acquire(const Key& key)
+{
+    {
+        AutoLock lock(m_lock);
+        if (++m_acquires == TRIM_PERIOD)
+            trim();
+        Entry& entry = getEntry(key);
+        entry.inUse++;
+        entry.peak = std::max(entry.peak, entry.inUse);
+        if (!entry.free.empty()) {
+            VABufferID id = entry.free.back();
+            entry.free.pop_back();
+            m_counters.reused++;
+            return id;
+        }
+    }
+    VABufferID id = createBuffer(key);
+    AutoLock lock(m_lock);
+    if (id == VA_INVALID_ID)
+        getEntry(key).inUse--;
+    else
+        m_counters.created++;
+    return id;
+}
+
+void VaapiBufferRecycler::release(const Key& key, VABufferID id)
+{
+    AutoLock lock(m_lock);
+    Entry& entry = getEntry(key);
+    entry.inUse--;
+    uint32_t keep = std::max(entry.peak, entry.highWater);
+    if (m_closed || entry.inUse + entry.free.size() >= keep)
+        destroy(id);
+    else
+        entry.free.push_back(id);
+}
+
+void VaapiBufferRecycler::trim()
+{
+    m_acquires = 0;
+    std::vector<Entry>::iterator it = m_entries.begin();
+    while (it != m_entries.end()) {
+        Entry& entry = *it;
+        entry.highWater = entry.peak;
+        entry.peak = entry.inUse;
+        while (!entry.free.empty() && entry.inUse + entry.free.size() > entry.highWater) {
+            destroy(entry.free.back());
+            entry.free.pop_back();
+        }
+        if (!entry.inUse && entry.free.empty())
+            it = m_entries.erase(it);
+        else
+            ++it;
+    }
+}
+
+void VaapiBufferRecycler::destroy(VABufferID id)
+{
+    destroyBuffer(id);
+    m_counters.destroyed++;
+}
+
+void VaapiBufferRecycler::close()
+{
+    AutoLock lock(m_lock);
+    if (m_closed)
+        return;
+    m_closed = true;
+    for (size_t i = 0; i < m_entries.size(); i++) {
+        std::vector<VABufferID>& free = m_entries[i].free;
+        for (size_t j = 0; j < free.size(); j++)
+            destroy(free[j]);
+        free.clear();
+    }
+}
+
+VaapiBufferRecycler::Counters VaapiBufferRecycler::getCounters()
+{
+    AutoLock lock(m_lock);
+    return m_counters;
+}
+
+VABufferID VaapiBufferRecycler::createBuffer(const Key& key)
+{
+    //no data here, VaapiBuffer writes it through a mapping for new and
+    //reused buffers alike
+    VABufferID id;
+    VAStatus status = vaCreateBuffer(m_display->getID(), m_context,
+        key.type, key.size, key.numElements, NULL, &id);
+    if (!checkVaapiStatus(status, "vaCreateBuffer"))
+        return VA_INVALID_ID;
+    return id;
+}
+
+void VaapiBufferRecycler::destroyBuffer(VABufferID id)
+{
+    checkVaapiStatus(vaDestroyBuffer(m_display->getID(), id), "vaDestroyBuffer");
+}
+}
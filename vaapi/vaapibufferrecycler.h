@@ -0,0 +1,109 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef vaapibufferrecycler_h
+#define vaapibufferrecycler_h
+
+#include "common/lock.h"
+#include "vaapiptrs.h"
+
+#include <va/va.h>
+#include <stdint.h>
+#include <vector>
+
+namespace YamiMediaCodec {
+
+/* Va buffers of a context kept for reuse, so a decoder does not call
+ * vaCreateBuffer and vaDestroyBuffer for each parameter and slice of each
+ * frame.
+ * Buffers are kept by key: the type, the element size and the number of
+ * elements. Parameter buffers need an exact match, since the driver reads
+ * the number of elements. Slice data goes in power of two size classes,
+ * the slice parameters tell the driver how much of it is used.
+ * For each key, the buffers kept are bounded by the most in use at the same
+ * time during the last period of acquires, the rest is destroyed.
+ * A reused buffer has the content of its last use, VaapiBuffer writes new
+ * data through vaMapBuffer, which waits for the gpu to finish reading it. */
+class VaapiBufferRecycler {
+public:
+    struct Key {
+        VABufferType type;
+        uint32_t size;
+        uint32_t numElements;
+        bool operator==(const Key& other) const
+        {
+            return type == other.type && size == other.size
+                && numElements == other.numElements;
+        }
+    };
+
+    struct Counters {
+        uint64_t created;
+        uint64_t destroyed;
+        uint64_t reused;
+    };
+
+    VaapiBufferRecycler(const DisplayPtr&, VAContextID);
+    virtual ~VaapiBufferRecycler();
+
+    /* the key for numElements of size bytes, false if the type is not
+     * recycled. The key can be larger than asked. */
+    static bool getKey(VABufferType, uint32_t size, uint32_t numElements, Key&);
+
+    /* a free buffer of the key, or a new one. VA_INVALID_ID on failure */
+    VABufferID acquire(const Key&);
+    /* gives back an unmapped buffer from acquire() */
+    void release(const Key&, VABufferID);
+
+    /* destroys the free buffers, the ones released later are destroyed
+     * right away. For when the context goes, and called by the destructor;
+     * a subclass overriding destroyBuffer() calls it in its own. */
+    void close();
+
+    Counters getCounters();
+
+protected:
+    virtual VABufferID createBuffer(const Key&);
+    virtual void destroyBuffer(VABufferID);
+
+private:
+    struct Entry {
+        Key key;
+        std::vector<VABufferID> free;
+        uint32_t inUse;
+        //most in use in this period, and in the last one
+        uint32_t peak;
+        uint32_t highWater;
+    };
+
+    Entry& getEntry(const Key&);
+    void trim();
+    void destroy(VABufferID);
+
+    DisplayPtr m_display;
+    VAContextID m_context;
+
+    Lock m_lock;
+    std::vector<Entry> m_entries;
+    uint32_t m_acquires;
+    bool m_closed;
+    Counters m_counters;
+
+    DISALLOW_COPY_AND_ASSIGN(VaapiBufferRecycler);
+};
+}
+
+#endif //vaapibufferrecycler_h
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2016 Intel Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+// library headers
+#include "common/unittest.h"
+
+// primary header
+#include "vaapibufferrecycler.h"
+
+// system headers
+#include <set>
+
+namespace YamiMediaCodec {
+
+/* hands out fake ids, so the bookkeeping is tested without a gpu */
+class FakeBufferRecycler : public VaapiBufferRecycler {
+public:
+    FakeBufferRecycler()
+        : VaapiBufferRecycler(DisplayPtr(), VA_INVALID_ID)
+        , m_next(1)
+    {
+    }
+    ~FakeBufferRecycler()
+    {
+        close();
+    }
+    std::set<VABufferID> m_live;
+
+protected:
+    VABufferID createBuffer(const Key&)
+    {
+        m_live.insert(m_next);
+        return m_next++;
+    }
+    void destroyBuffer(VABufferID id)
+    {
+        EXPECT_EQ(1u, m_live.erase(id));
+    }
+
+private:
+    VABufferID m_next;
+};
+
+#define VAAPIBUFFERRECYCLER_TEST(name) \
+    TEST(VaapiBufferRecyclerTest, name)
+
+static VaapiBufferRecycler::Key getKey(VABufferType type, uint32_t size, uint32_t numElements = 1)
+{
+    VaapiBufferRecycler::Key key;
+    EXPECT_TRUE(VaapiBufferRecycler::getKey(type, size, numElements, key));
+    return key;
+}
+
+VAAPIBUFFERRECYCLER_TEST(Keys)
+{
+    VaapiBufferRecycler::Key key;
+    //parameters match exactly
+    key = getKey(VASliceParameterBufferType, 100, 3);
+    EXPECT_EQ(100u, key.size);
+    EXPECT_EQ(3u, key.numElements);
+
+    //slice data goes in size classes
+    key = getKey(VASliceDataBufferType, 100);
+    EXPECT_EQ(4096u, key.size);
+    EXPECT_TRUE(key == getKey(VASliceDataBufferType, 4096));
+    key = getKey(VASliceDataBufferType, 4097);
+    EXPECT_EQ(8192u, key.size);
+    EXPECT_EQ(1u, key.numElements);
+
+    EXPECT_FALSE(VaapiBufferRecycler::getKey(VAImageBufferType, 100, 1, key));
+}
+
+VAAPIBUFFERRECYCLER_TEST(Reuse)
+{
+    FakeBufferRecycler recycler;
+    VaapiBufferRecycler::Key param = getKey(VAPictureParameterBufferType, 64);
+    VaapiBufferRecycler::Key data = getKey(VASliceDataBufferType, 1000);
+
+    const uint32_t frames = 100;
+    for (uint32_t i = 0; i < frames; i++) {
+        VABufferID p = recycler.acquire(param);
+        VABufferID d = recycler.acquire(data);
+        ASSERT_NE(VA_INVALID_ID, p);
+        ASSERT_NE(VA_INVALID_ID, d);
+        EXPECT_NE(p, d);
+        recycler.release(param, p);
+        recycler.release(data, d);
+    }
+    VaapiBufferRecycler::Counters counters = recycler.getCounters();
+    EXPECT_EQ(2u, counters.created);
+    EXPECT_EQ(0u, counters.destroyed);
+    EXPECT_EQ(2 * frames - 2, counters.reused);
+
+    recycler.close();
+    EXPECT_TRUE(recycler.m_live.empty());
+    EXPECT_EQ(2u, recycler.getCounters().destroyed);
+}
+
+VAAPIBUFFERRECYCLER_TEST(TrimToHighWater)
+{
+    FakeBufferRecycler recycler;
+    VaapiBufferRecycler::Key key = getKey(VASliceDataBufferType, 1000);
+
+    //a burst of many slices in one frame
+    const uint32_t burst = 32;
+    std::vector<VABufferID> ids;
+    for (uint32_t i = 0; i < burst; i++)
+        ids.push_back(recycler.acquire(key));
+    for (uint32_t i = 0; i < burst; i++)
+        recycler.release(key, ids[i]);
+    EXPECT_EQ(burst, recycler.m_live.size());
+
+    //then one slice per frame, the burst is trimmed after two periods
+    for (uint32_t i = 0; i < 1000; i++)
+        recycler.release(key, recycler.acquire(key));
+    EXPECT_EQ(1u, recycler.m_live.size());
+    VaapiBufferRecycler::Counters counters = recycler.getCounters();
+    EXPECT_EQ(burst, counters.created);
+    EXPECT_EQ(burst - 1, counters.destroyed);
+}
+
+VAAPIBUFFERRECYCLER_TEST(ReleaseAfterClose)
+{
+    FakeBufferRecycler recycler;
+    VaapiBufferRecycler::Key key = getKey(VAIQMatrixBufferType, 32);
+    VABufferID held = recycler.acquire(key);
+    recycler.release(key, recycler.acquire(key));
+    EXPECT_EQ(2u, recycler.m_live.size());
+
+    recycler.close();
+    EXPECT_EQ(1u, recycler.m_live.size());
+    recycler.release(key, held);
+    EXPECT_TRUE(recycler.m_live.empty());
+}
+}
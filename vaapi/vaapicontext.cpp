@@ -22,6 +22,7 @@
 
 #include "common/log.h"
 #include "common/common_def.h"
+#include "vaapi/vaapibufferrecycler.h"
 #include "vaapi/vaapidisplay.h"
 #include "vaapi/VaapiUtils.h"
 #include <algorithm>
@@ -138,8 +139,17 @@ VaapiContext::VaapiContext(const ConfigPtr& config, VAContextID context)
 {
 }
 
+void VaapiContext::enableBufferRecycling()
+{
+    if (!m_recycler)
+        m_recycler.reset(new VaapiBufferRecycler(getDisplay(), m_context));
+}
+
 VaapiContext::~VaapiContext()
 {
+    //buffers still held are destroyed when they come back
+    if (m_recycler)
+        m_recycler->close();
     vaDestroyContext(m_config->m_display->getID(), m_context);
 }
 }
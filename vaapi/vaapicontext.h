@@ -47,11 +47,16 @@ public:
     VAContextID getID() const { return m_context; }
     DisplayPtr getDisplay() const { return m_config->m_display; }
 
+    /* keep the buffers of this context for reuse, see VaapiBufferRecycler */
+    void enableBufferRecycling();
+    const BufferRecyclerPtr& getBufferRecycler() const { return m_recycler; }
+
     ~VaapiContext();
 private:
     VaapiContext(const ConfigPtr&,  VAContextID);
     ConfigPtr m_config;
     VAContextID m_context;
+    BufferRecyclerPtr m_recycler;
     DISALLOW_COPY_AND_ASSIGN(VaapiContext);
 };
 }
@@ -75,16 +75,16 @@ protected:
     bool addObject(std::vector<BufObjectPtr>& objects, const BufObjectPtr& object);
 
     template<class T>
-    BufObjectPtr createBufferObject(VABufferType, T*& bufPtr);
+    BufObjectPtr createBufferObject(VABufferType, T*& bufPtr, uint32_t numElements = 1);
     inline BufObjectPtr createBufferObject(VABufferType bufType,
         uint32_t size, const void* data, void** mapped);
     VaapiPicture();
 };
 
 template<class T>
-BufObjectPtr VaapiPicture::createBufferObject(VABufferType  bufType, T*& bufPtr)
+BufObjectPtr VaapiPicture::createBufferObject(VABufferType  bufType, T*& bufPtr, uint32_t numElements)
 {
-    return VaapiBuffer::create(m_context, bufType, bufPtr);
+    return VaapiBuffer::create(m_context, bufType, bufPtr, numElements);
 }
 
 BufObjectPtr VaapiPicture::createBufferObject(VABufferType bufType,
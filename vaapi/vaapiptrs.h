@@ -29,6 +29,9 @@ typedef SharedPtr < VaapiCodedBuffer > CodedBufferPtr;
 class VaapiBuffer;
 typedef SharedPtr<VaapiBuffer> BufObjectPtr;
 
+class VaapiBufferRecycler;
+typedef SharedPtr<VaapiBufferRecycler> BufferRecyclerPtr;
+
 class VaapiDisplay;
 typedef SharedPtr < VaapiDisplay > DisplayPtr;
 